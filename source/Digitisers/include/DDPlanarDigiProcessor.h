@@ -15,6 +15,8 @@
 
 #include <TH1F.h>
 
+#include "StageTimers.h"
+
 using namespace lcio ;
 using namespace marlin ;
 
@@ -98,6 +100,16 @@ protected:
   int _nRun ;
   int _nEvt ;
   
+  /** stage timers and counters, enabled with TimeStages
+   */
+  bool _timeStages;
+  std::string _stageTimingCSVFile;
+  StageTimers _timers;
+  int _stageDigitisation;
+  int _countSimHits;
+  int _countCreatedHits;
+  int _countDismissedHits;
+  
   FloatVec _resU ;
   FloatVec _resV ;
   
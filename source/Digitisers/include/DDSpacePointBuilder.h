@@ -9,6 +9,8 @@
 #include <EVENT/TrackerHitPlane.h>
 #include <IMPL/TrackerHitImpl.h>
 
+#include "StageTimers.h"
+
 #include "CLHEP/Vector/ThreeVector.h"
 #include "CLHEP/Vector/Rotation.h"
 
@@ -199,6 +201,16 @@ class DDSpacePointBuilder : public Processor {
 
   int _nRun ;
   int _nEvt ;
+  
+  /** stage timers and counters, enabled with TimeStages
+   */
+  bool _timeStages;
+  std::string _stageTimingCSVFile;
+  StageTimers _timers;
+  int _stageSpacePoints;
+  int _countStripHits;
+  int _countPossibleSpacePoints;
+  int _countCreatedSpacePoints;
 
   unsigned _nOutOfBoundary;
   unsigned _nStripsTooParallel;
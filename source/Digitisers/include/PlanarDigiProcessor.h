@@ -10,6 +10,8 @@
 
 #include <gsl/gsl_rng.h>
 
+#include "StageTimers.h"
+
 
 using namespace lcio ;
 using namespace marlin ;
@@ -85,6 +87,16 @@ protected:
   int _nRun ;
   int _nEvt ;
   
+  /** stage timers and counters, enabled with TimeStages
+   */
+  bool _timeStages;
+  std::string _stageTimingCSVFile;
+  StageTimers _timers;
+  int _stageDigitisation;
+  int _countSimHits;
+  int _countCreatedHits;
+  int _countDismissedHits;
+  
   // float _resU ;
   // float _resV ;
   FloatVec _resU ;
@@ -104,6 +104,16 @@ DDPlanarDigiProcessor::DDPlanarDigiProcessor() : Processor("DDPlanarDigiProcesso
                               _forceHitsOntoSurface ,
                               bool(false) );
 
+  registerProcessorParameter( "TimeStages",
+                             "Measure the time spent in the main processing stages and print a summary per run in end()",
+                             _timeStages,
+                             bool(false));
+  
+  registerProcessorParameter( "StageTimingCSVFile",
+                             "If set together with TimeStages, write the stage times and counters of every event to this CSV file",
+                             _stageTimingCSVFile,
+                             std::string(""));
+
   
   // setup the list of supported detectors
   
@@ -162,6 +172,12 @@ void DDPlanarDigiProcessor::init() {
   streamlog_out( DEBUG3 ) << " DDPlanarDigiProcessor::init(): found " << _map->size() 
                           << " surfaces for detector:" <<  _subDetName << std::endl ;
 
+  _timers.init( name(), _timeStages, _stageTimingCSVFile );
+  _stageDigitisation = _timers.addStage( "Digitisation" );
+  _countSimHits = _timers.addCounter( "SimHits" );
+  _countCreatedHits = _timers.addCounter( "CreatedHits" );
+  _countDismissedHits = _timers.addCounter( "DismissedHits" );
+
   
 }
 
@@ -171,6 +187,8 @@ void DDPlanarDigiProcessor::processRunHeader( LCRunHeader* run) {
 } 
 
 void DDPlanarDigiProcessor::processEvent( LCEvent * evt ) { 
+  
+  _timers.startEvent( evt->getRunNumber(), evt->getEventNumber() );
 
 
 
@@ -202,6 +220,10 @@ void DDPlanarDigiProcessor::processEvent( LCEvent * evt ) {
   
   if( STHcol != 0 ){    
     
+    StageTimers::Scope timeDigitisation( _timers, _stageDigitisation );
+    
+    _timers.count( _countSimHits, STHcol->getNumberOfElements() );
+    
 
 
     unsigned nCreatedHits=0;
@@ -450,12 +472,17 @@ void DDPlanarDigiProcessor::processEvent( LCEvent * evt ) {
     // Add collection to event
     //**************************************************************************    
     
+    timeDigitisation.stop();
+    _timers.count( _countCreatedHits, nCreatedHits );
+    _timers.count( _countDismissedHits, nDismissedHits );
+    
     evt->addCollection( trkhitVec , _outColName ) ;
     evt->addCollection( relCol , _outRelColName ) ;
     
     streamlog_out(DEBUG4) << "Created " << nCreatedHits << " hits, " << nDismissedHits << " hits  dismissed as not on sensitive element\n";
     
   }
+  _timers.endEvent();
   _nEvt ++ ;
 }
 
@@ -468,6 +495,8 @@ void DDPlanarDigiProcessor::check( LCEvent * evt ) {
 
 void DDPlanarDigiProcessor::end(){ 
   
+  _timers.printSummary();
+  
   streamlog_out(MESSAGE) << " end()  " << name() 
   << " processed " << _nEvt << " events in " << _nRun << " runs "
   << std::endl ;
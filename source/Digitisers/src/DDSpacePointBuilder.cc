@@ -101,6 +101,16 @@ DDSpacePointBuilder::DDSpacePointBuilder() : Processor("DDSpacePointBuilder") {
                              _subDetName ,
                               std::string("SIT") );
   
+  registerProcessorParameter( "TimeStages",
+                             "Measure the time spent in the main processing stages and print a summary per run in end()",
+                             _timeStages,
+                             bool(false));
+  
+  registerProcessorParameter( "StageTimingCSVFile",
+                             "If set together with TimeStages, write the stage times and counters of every event to this CSV file",
+                             _stageTimingCSVFile,
+                             std::string(""));
+  
 }
 
 
@@ -155,6 +165,12 @@ void DDSpacePointBuilder::init() {
 
 
   
+  _timers.init( name(), _timeStages, _stageTimingCSVFile );
+  _stageSpacePoints = _timers.addStage( "SpacePoints" );
+  _countStripHits = _timers.addCounter( "StripHits" );
+  _countPossibleSpacePoints = _timers.addCounter( "PossibleSpacePoints" );
+  _countCreatedSpacePoints = _timers.addCounter( "CreatedSpacePoints" );
+  
 }
 
 
@@ -167,6 +183,8 @@ void DDSpacePointBuilder::processRunHeader( LCRunHeader* run) {
 
 void DDSpacePointBuilder::processEvent( LCEvent * evt ) { 
 
+  _timers.startEvent( evt->getRunNumber(), evt->getEventNumber() );
+
   LCCollection* col = 0 ;
   LCRelationNavigator* nav = 0 ; 
 
@@ -187,6 +205,8 @@ void DDSpacePointBuilder::processEvent( LCEvent * evt ) {
     
   if( col != NULL && nav != NULL ){
     
+    StageTimers::Scope timeSpacePoints( _timers, _stageSpacePoints );
+    
     
     unsigned createdSpacePoints = 0;
     unsigned rawStripHits = 0;
@@ -401,6 +421,11 @@ void DDSpacePointBuilder::processEvent( LCEvent * evt ) {
       
     }
     
+    timeSpacePoints.stop();
+    _timers.count( _countStripHits, rawStripHits );
+    _timers.count( _countPossibleSpacePoints, possibleSpacePoints );
+    _timers.count( _countCreatedSpacePoints, createdSpacePoints );
+    
     evt->addCollection( spCol, _SpacePointsCollection);
     evt->addCollection( relCol , _relColName ) ;
     
@@ -420,6 +445,7 @@ void DDSpacePointBuilder::processEvent( LCEvent * evt ) {
   }
 
 
+  _timers.endEvent();
   _nEvt ++ ;
   
   delete nav;
@@ -435,6 +461,7 @@ void DDSpacePointBuilder::check( LCEvent * evt ) {}
 
 void DDSpacePointBuilder::end(){
    
+   _timers.printSummary();
    
 }
 
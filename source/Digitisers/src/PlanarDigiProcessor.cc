@@ -96,6 +96,16 @@ PlanarDigiProcessor::PlanarDigiProcessor() : Processor("PlanarDigiProcessor") {
                            _outRelColName,
                            std::string("VTXTrackerHitRelations"));
   
+  registerProcessorParameter( "TimeStages",
+                             "Measure the time spent in the main processing stages and print a summary per run in end()",
+                             _timeStages,
+                             bool(false));
+  
+  registerProcessorParameter( "StageTimingCSVFile",
+                             "If set together with TimeStages, write the stage times and counters of every event to this CSV file",
+                             _stageTimingCSVFile,
+                             std::string(""));
+
  
   
 }
@@ -139,6 +149,12 @@ void PlanarDigiProcessor::init() {
   //FIXME:SJA gear surface store has now been filled so we can dispose of the MarlinTrkSystem
   //delete trksystem;
 
+  _timers.init( name(), _timeStages, _stageTimingCSVFile );
+  _stageDigitisation = _timers.addStage( "Digitisation" );
+  _countSimHits = _timers.addCounter( "SimHits" );
+  _countCreatedHits = _timers.addCounter( "CreatedHits" );
+  _countDismissedHits = _timers.addCounter( "DismissedHits" );
+
   
 }
 
@@ -148,6 +164,8 @@ void PlanarDigiProcessor::processRunHeader( LCRunHeader* run) {
 
 void PlanarDigiProcessor::processEvent( LCEvent * evt ) { 
   
+  _timers.startEvent( evt->getRunNumber(), evt->getEventNumber() );
+  
   gsl_rng_set( _rng, Global::EVENTSEEDER->getSeed(this) ) ;   
   streamlog_out( DEBUG4 ) << "seed set to " << Global::EVENTSEEDER->getSeed(this) << std::endl;
   
@@ -164,6 +182,10 @@ void PlanarDigiProcessor::processEvent( LCEvent * evt ) {
   
   if( nSimHits != 0){    
     
+    StageTimers::Scope timeDigitisation( _timers, _stageDigitisation );
+    
+    _timers.count( _countSimHits, STHcol->getNumberOfElements() );
+    
     unsigned nCreatedHits=0;
     unsigned nDismissedHits=0;
     
@@ -391,12 +413,17 @@ void PlanarDigiProcessor::processEvent( LCEvent * evt ) {
     }      
     
     
+    timeDigitisation.stop();
+    _timers.count( _countCreatedHits, nCreatedHits );
+    _timers.count( _countDismissedHits, nDismissedHits );
+    
     evt->addCollection( trkhitVec , _outColName ) ;
     evt->addCollection( relCol , _outRelColName ) ;
     
     streamlog_out(DEBUG4) << "Created " << nCreatedHits << " hits, " << nDismissedHits << " hits got dismissed for being out of boundary\n";
     
   }
+  _timers.endEvent();
   _nEvt ++ ;
 }
 
@@ -409,6 +436,8 @@ void PlanarDigiProcessor::check( LCEvent * evt ) {
 
 void PlanarDigiProcessor::end(){ 
   
+  _timers.printSummary();
+  
   streamlog_out(MESSAGE) << " end()  " << name() 
   << " processed " << _nEvt << " events in " << _nRun << " runs "
   << std::endl ;
@@ -100,6 +100,15 @@ SpacePointBuilder::SpacePointBuilder() : Processor("SpacePointBuilder") {
                              float(0.1));
 
 
+  registerProcessorParameter( "TimeStages",
+                             "Measure the time spent in the main processing stages and print a summary per run in end()",
+                             _timeStages,
+                             bool(false));
+  
+  registerProcessorParameter( "StageTimingCSVFile",
+                             "If set together with TimeStages, write the stage times and counters of every event to this CSV file",
+                             _stageTimingCSVFile,
+                             std::string(""));
   
 }
 
@@ -134,6 +143,12 @@ void SpacePointBuilder::init() {
   //delete trksystem;
 
   
+  _timers.init( name(), _timeStages, _stageTimingCSVFile );
+  _stageSpacePoints = _timers.addStage( "SpacePoints" );
+  _countStripHits = _timers.addCounter( "StripHits" );
+  _countPossibleSpacePoints = _timers.addCounter( "PossibleSpacePoints" );
+  _countCreatedSpacePoints = _timers.addCounter( "CreatedSpacePoints" );
+  
 }
 
 
@@ -146,6 +161,8 @@ void SpacePointBuilder::processRunHeader( LCRunHeader* run) {
 
 void SpacePointBuilder::processEvent( LCEvent * evt ) { 
 
+  _timers.startEvent( evt->getRunNumber(), evt->getEventNumber() );
+
 
   LCCollection* col = 0 ;
   LCRelationNavigator* nav = 0 ; 
@@ -167,6 +184,8 @@ void SpacePointBuilder::processEvent( LCEvent * evt ) {
     
   if( col != NULL && nav != NULL ){
     
+    StageTimers::Scope timeSpacePoints( _timers, _stageSpacePoints );
+    
     
     unsigned createdSpacePoints = 0;
     unsigned rawStripHits = 0;
@@ -376,6 +395,11 @@ void SpacePointBuilder::processEvent( LCEvent * evt ) {
       
     }
     
+    timeSpacePoints.stop();
+    _timers.count( _countStripHits, rawStripHits );
+    _timers.count( _countPossibleSpacePoints, possibleSpacePoints );
+    _timers.count( _countCreatedSpacePoints, createdSpacePoints );
+    
     evt->addCollection( spCol, _SpacePointsCollection);
     evt->addCollection( relCol , _relColName ) ;
     
@@ -395,6 +419,7 @@ void SpacePointBuilder::processEvent( LCEvent * evt ) {
   }
 
 
+  _timers.endEvent();
   _nEvt ++ ;
   
   delete nav;
@@ -410,6 +435,7 @@ void SpacePointBuilder::check( LCEvent * evt ) {}
 
 void SpacePointBuilder::end(){
    
+   _timers.printSummary();
    
 }
 
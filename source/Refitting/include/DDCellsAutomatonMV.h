@@ -2,6 +2,7 @@
 #define DDCellsAutomatonMV_h 1
 
 #include <algorithm>
+#include <deque>
 #include "Math/ProbFunc.h"
 
 #include <marlin/Processor.h>
@@ -36,6 +37,7 @@
 #include "ILDImpl/SectorSystemVXD.h"
 #include "Tools/VXDHelixFitter.h"
 #include "ILDImpl/MiniVectorHit01.h"
+#include "SplitSectorConnector.h"
 
 
 
@@ -62,6 +64,9 @@
 #include "EVENT/TrackerHit.h"
 #include "lcio.h"
 
+#include "StageTimers.h"
+#include "TaskPool.h"
+
 
 
 using namespace lcio;
@@ -116,6 +121,30 @@ class DDCellsAutomatonMV : public Processor {
 
   int nEvt;
 
+  /** stage timers and counters, enabled with TimeStages
+   */
+  bool _timeStages;
+  std::string _stageTimingCSVFile;
+  StageTimers _timers;
+  int _stageInitialiseVTX;
+  int _stageCreateMiniVectors;
+  int _stageAutomaton;
+  int _stageConnectionGraph;
+  int _stageAutomatonRound;
+  int _stageTrackFitting;
+  int _stageBestSubset;
+  int _stageFinalise;
+  int _countHits;
+  int _countRawTracks;
+  int _countAutomatonRounds;
+  int _countTrackCandidates;
+  int _countOutputTracks;
+
+  /** threads used for the creation of the mini-vectors of the sectors
+   */
+  int _nThreads;
+  TaskPool _taskPool;
+
   int _nDivisionsInPhi;
   int _nDivisionsInTheta;
   int _nDivisionsInPhiMV;
@@ -140,13 +169,57 @@ class DDCellsAutomatonMV : public Processor {
   void InitialiseVTX(LCEvent * evt, EVENT::TrackerHitVec HitsTemp);
   void setupGeom() ;
   bool setCriteria( unsigned round );
+  
+  /** Splits the sectors of _map_sector_spacepoints with more than _maxHitsPerSector hits into the
+   *  sub-sectors of connector, as few times as needed for none of them to overflow. Sectors which still
+   *  overflow after _maxSectorSplits splits are not split.
+   */
+  void splitSectors( SplitSectorConnector& connector );
+  
+  /** The sub-sector of connector of a hit of the given sector of _map_sector_spacepoints */
+  int splitSector( TrackerHit* hit, int sector, const SplitSectorConnector& connector ) const;
+  
+  /** The phi and theta indices of a hit of the given sector in the sectors split the given number of times */
+  void splitPhiTheta( TrackerHit* hit, int sector, int split, int& iPhiSplit, int& iThetaSplit ) const;
+  
+  /** The largest number of hits in one sub-sector of connector of a sector of _map_sector_spacepoints */
+  int maxHitsInSplitSector( int sector, const SplitSectorConnector& connector ) const;
+  
+  /** The cut offs of a criterion in the given round, the last ones if there are fewer rounds for it */
+  void getCutOffs( const std::string& critName, unsigned round, float& min, float& max );
+  
+  /** Creates the 2-hit criteria with the loosest cut offs of all rounds in _crit2LooseVec and finds
+   *  the rounds using these cut offs */
+  void setLoosestCriteria();
+  
+  /** The 1-segments and connections of the connection graph, with the values of the 2-hit criteria of
+   *  each connection. The connections are in the order of the segments and their children.
+   */
+  struct ConnectionTable {
+    std::vector< std::vector< IHit* > > hits;
+    std::vector< unsigned > layers;
+    std::vector< int > parent;
+    std::vector< int > child;
+    /** the connections to the parents of segment i are parentConnections[ parentBegin[i] ] to parentConnections[ parentBegin[i+1]-1 ] */
+    std::vector< int > parentBegin;
+    std::vector< int > parentConnections;
+    /** the value of 2-hit criterion k for connection c at c * _crit2LooseVec.size() + k, NaN if the criterion has to be evaluated */
+    std::vector< float > values;
+  };
+  
+  /** Fills table from graph, evaluating the loosest 2-hit criteria once per connection */
+  void buildConnectionTable( Automaton& graph, ConnectionTable& table );
+  
+  /** Fills automaton with new 1-segments of table, connected where the connection of table passes the
+   *  2-hit cut offs of the given round. The order of the segments and connections is kept.
+   */
+  void filterConnections( const ConnectionTable& table, unsigned round, Automaton& automaton );
   void RawTrackFit( std::vector < MarlinTrk::IMarlinTrack* > candMarlinTracks, std::vector< IMPL::TrackImpl* > &finalTracks ) ;
   void FitFunc2( std::vector < RawTrack > rawTracks, std::vector < MarlinTrk::IMarlinTrack* > &candMarlinTracks ) ;
   void finaliseTrack( TrackImpl* trackImpl ) ;   
-  void CreateMiniVectors( int sector ) ;
   bool thetaAgreement( EVENT::TrackerHit *toHit, EVENT::TrackerHit *fromHit ) ;
-  bool thetaAgreementImproved( EVENT::TrackerHit *toHit, EVENT::TrackerHit *fromHit, int layer ) ;
-  double Dist( EVENT::TrackerHit *toHit, EVENT::TrackerHit *fromHit ) ;
+  bool thetaAgreementImproved( double thetaInner, double thetaOuter, int layer ) const ;
+  double Dist( EVENT::TrackerHit *toHit, EVENT::TrackerHit *fromHit ) const ;
 
   unsigned int _nLayersVTX;
   unsigned int _nLayersSIT;
@@ -154,6 +227,72 @@ class DDCellsAutomatonMV : public Processor {
   /** A map to store the hits according to their sectors */
   std::map< int , EVENT::TrackerHitVec > _map_sector_spacepoints;
   std::map< int , std::vector< IHit* > > _map_sector_hits;
+
+  /** A hit of _map_sector_spacepoints with its decoded subdetector, layer (+1 for the IP) and polar angle in degrees,
+   *  and the sector of the mini-vectors starting at it, the sub-sector of the hit if its sector is split. If sectors
+   *  are split in the event, phiIndex and thetaIndex are the indices of the hit in the split sectors.
+   */
+  struct SectorHit {
+    TrackerHit* hit;
+    int sector;
+    bool split;
+    int phiIndex;
+    int thetaIndex;
+    int detID;
+    int layer;
+    double theta;
+  };
+
+  /** If a mini-vector can be made from the hit from to the hit to of its window. The window of a hit of a split
+   *  sector, or towards a hit of one, is counted in the split sectors, as the window of the configured sectors
+   *  in CreateMiniVectors.
+   */
+  static bool inSplitWindow( const SectorHit& from, const SectorHit& to ) {
+    if( !from.split && !to.split ) return true;
+    int dPhi = to.phiIndex - from.phiIndex;
+    int dTheta = to.thetaIndex - from.thetaIndex;
+    return dPhi >= -2 && dPhi < 2 && dTheta >= -2 && dTheta < 2;
+  }
+
+  struct SectorHitSpan {
+    const SectorHit* begin;
+    const SectorHit* end;
+  };
+
+  /** The hits of _map_sector_spacepoints in one array sorted by sector, filled once per event after the
+   *  overflowing sectors are dropped. The hits of sector s are [ _sectorStart[s], _sectorStart[s+1] ).
+   */
+  std::vector< SectorHit > _sectorHits;
+  std::vector< int > _sectorStart;
+  void FillSectorHitStore( const SplitSectorConnector& connector ) ;
+
+  /** the hits of a sector, empty for sectors outside the store */
+  SectorHitSpan sectorHits( int sector ) const {
+    SectorHitSpan span = { 0, 0 };
+    if( sector >= 0 && sector + 1 < int( _sectorStart.size() ) && _sectorStart[sector] < _sectorStart[sector+1] ){
+      span.begin = &_sectorHits[0] + _sectorStart[sector];
+      span.end = &_sectorHits[0] + _sectorStart[sector+1];
+    }
+    return span;
+  }
+
+  /** The mini-vectors made from the hits of one sector. The deques keep the addresses of their elements,
+   *  the pools are cleared at the end of the event and reused in the next one.
+   */
+  struct MiniVectorPool {
+    std::deque< MiniVector > miniVectors;
+    std::deque< MiniVectorHit01 > miniVectorHits;
+    std::vector< int > miniVectorSectors; // the sector of each mini-vector hit in _map_sector_hits
+    int nVXD; // counted in MiniVectors_CutSelection
+    MiniVectorPool() : nVXD(0) {}
+    void clear() { miniVectorHits.clear(); miniVectors.clear(); miniVectorSectors.clear(); nVXD = 0; }
+  };
+  std::deque< MiniVectorPool > _miniVectorPools;
+
+  /** Fills pool with the mini-vectors starting in sector. Only reads the sector hit store, so that the
+   *  sectors can be processed concurrently.
+   */
+  void CreateMiniVectors( int sector, MiniVectorPool& pool ) const ;
   
   /** Names of the used criteria */
   std::vector< std::string > _criteriaNames;
@@ -175,9 +314,18 @@ class DDCellsAutomatonMV : public Processor {
   
   /** A vector of criteria for 4 hits (2 3-hit segments) */
   std::vector <ICriterion*> _crit4Vec;
-
-  std::vector< IHit* > MiniVectorsTemp;
-  std::vector< IHit* > TestMiniVectorsTemp;
+  
+  /** The criteria for 2 hits with the loosest cut offs of all rounds, the connection graph is built with them once per event */
+  std::vector <ICriterion*> _crit2LooseVec;
+  
+  /** Names and loosest cut offs of the criteria of _crit2LooseVec */
+  std::vector< std::string > _crit2LooseNames;
+  std::vector< float > _crit2LooseMin;
+  std::vector< float > _crit2LooseMax;
+  
+  /** The number of rounds of the cut offs, and for each round if its 2-hit cut offs are the loosest ones */
+  unsigned _nCriteriaRounds;
+  std::vector< bool > _roundIsLoosest;
 
   /** Cut for the Kalman Fit (the chi squared probability) */
   double _chi2ProbCut;  
@@ -227,6 +375,15 @@ class DDCellsAutomatonMV : public Processor {
 
   int _maxHitsPerSector ;
   
+  /** split the sectors with more than _maxHitsPerSector hits, at most _maxSectorSplits times */
+  bool _splitOverflowingSectors ;
+  int _maxSectorSplits ;
+  
+  /** events processed, events whose sectors were split and events in which hits were dropped */
+  long _nEvents ;
+  long _nEventsSplit ;
+  long _nEventsDropped ;
+  
   /** Input collection name.
    */
   std::string _VTXHitCollection;
@@ -53,6 +53,8 @@
 #include "MarlinTrk/MarlinTrkUtils.h"
 #include "MarlinTrk/HelixTrack.h"
 
+#include "StageTimers.h"
+
 
 
 
@@ -170,6 +172,18 @@ protected:
   
   int _n_run ;
   int _n_evt ;
+
+  /** stage timers and counters, enabled with TimeStages
+   */
+  bool _timeStages;
+  std::string _stageTimingCSVFile;
+  StageTimers _timers;
+  int _stageFillHitMaps;
+  int _stageExtrapolation;
+  int _stageNotUsedHits;
+  int _countInputTracks;
+  int _countOutputTracks;
+
   int SITHitsFitted ;
   int SITHitsNonFitted ;
   int TotalSITHits ;
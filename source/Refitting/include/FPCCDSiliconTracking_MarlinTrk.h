@@ -498,14 +498,28 @@ protected:
 
   int _sw_theta;//search window theta
   float _chi2FitCut_kalman;
+  bool _incrementalKalFit;
   bool _useClusterRejection;
   float _minDotOf2Clusters;
 
   int getIntersectionEasy(HelixClass_double& helix, TrackerHit* curInmos , int layer, double* isec, double* ref); 
   int getIntersectionEasyTest(HelixClass_double& helix, TrackerHit* basisTrkhit , int layer, std::vector<double> &vec ); 
+  /** same as above for the helix with the given parameters, without constructing it. phiX and zX are the
+   *  azimuthal angle in [0,2pi) and z of the basis hit, isec has to hold 3 values.
+   */
+  int getIntersectionEasyTest(double phi0, double d0, double z0, double omega, double tanL, long double phiX, long double zX, int layer, double* isec); 
+  /** mean radius of each layer used by getIntersectionEasyTest, filled once in init */
+  void InitIntersectionRadii();
+  std::vector<long double> _intersectionRmean;
   int CheckTiltOf2Clusters(TrackerHit* A, TrackerHit* B, int level);
   float DotOf2Clusters(TrackerHit* A, TrackerHit* B);
-  int KalFit(int& ndf, float& Chi2, TrackerHitVec trkHits,TrackerHitVec& hits_in_fit, TrackerHitVec& outliers, float* par , float* epar, HelixClass_double& helix);
+  /** full Kalman fit of trkHits. If keepFit is given the fitted track is handed over to the caller on success */
+  int KalFit(int& ndf, float& Chi2, TrackerHitVec& trkHits,TrackerHitVec& hits_in_fit, TrackerHitVec& outliers, float* par , float* epar, HelixClass_double& helix,
+             MarlinTrk::IMarlinTrack** keepFit = 0);
+  /** adds hit to a track fitted by KalFit with a single filter step and returns the same quantities at the IP.
+   *  If the hit fails the chi2 cut it is returned as the only outlier and the fit is unchanged.
+   */
+  int KalFitAddHit(MarlinTrk::IMarlinTrack* marlinTrk, TrackerHit* hit, int& ndf, float& Chi2, TrackerHitVec& outliers, float* par , float* epar, HelixClass_double& helix);
   int getPhiThetaRegion(TrackExtended* trackAR, int layer, int* Boundaries);
 
   struct GeoData_t {
@@ -573,6 +587,33 @@ protected:
      ClusterStatus(){;}
   };
 
+  /** shape and global direction of an FPCCD cluster, computed once per VXD hit in InitialiseVTX so that
+   *  the cluster rejection in BuildTrack_KalFit needs no ClusterStatus and TVector3 per pair of hits
+   */
+  struct ClusterShape {
+    ClusterShape() : valid(false) {}
+    bool valid;          // false for SIT hits and hits outside of the VXD geometry
+    unsigned int xiwidth;
+    unsigned int zetawidth;
+    unsigned int nPix;
+    unsigned int tilt;
+    double dir[3];       // unit vector along the cluster, as gdirA in DotOf2Clusters
+    double revDir[3];    // unit vector with reversed local xi and zeta, as revgdirA in DotOf2Clusters
+  };
+
+  ClusterShape MakeClusterShape(TrackerHit* hit);
+  static int CheckTiltOf2Clusters(const ClusterShape& a, const ClusterShape& b);
+  static float DotOf2Clusters(const ClusterShape& a, const ClusterShape& b);
+
+  /** tests a block of n candidate clusters against cluster a with the same conditions as BuildTrack_KalFit,
+   *  compatible[i] is set to 1 or 0, or to -1 if b[i] is not valid and the hits have to be compared directly
+   */
+  void CheckClusterCompatibility(const ClusterShape& a, const ClusterShape* b, int n, signed char* compatible);
+
+  // the cluster shapes of the hits in _sectors, indexed in the same way
+  std::vector< std::vector<ClusterShape> > _sectorClusterShapes;
+  std::vector<signed char> _clusterCompatible;
+
   //Old Ver//////////////////
   typedef std::map< std::pair< int, int >, int > RangeMap;
   RangeMap _phiRangeForTriplet;
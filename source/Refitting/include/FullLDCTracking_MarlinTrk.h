@@ -8,6 +8,7 @@
 #include "ClusterExtended.h"
 #include "TrackExtended.h"
 #include "TrackerHitExtended.h"
+#include <EVENT/TrackerHitPlane.h>
 #include "TrackHitPair.h"
 #include "HelixClass.h"
 #include "ClusterShapes.h"
@@ -15,9 +16,13 @@
 //#include "../../BrahmsTracking/include/MarlinTrackFit.h"
 #include <map>
 #include <set>
+#include <deque>
 
 #include "MarlinTrk/IMarlinTrack.h"
 
+#include "StageTimers.h"
+#include "TaskPool.h"
+
 #include <UTIL/BitField64.h>
 #include <UTIL/ILDConf.h>
 
@@ -266,6 +271,19 @@ public:
 protected:
   
   void prepareVectors( LCEvent * evt );
+  
+  /** conversion of a single input hit, called concurrently by prepareVectors. The layer is decoded
+   *  with the given encoder. The FTD and SIT/SET versions return 0 and set error if the hit can not be used.
+   */
+  TrackerHitExtended * ConvertTPCHit(TrackerHit * hit, UTIL::BitField64& encoder, int& layer);
+  TrackerHitExtended * ConvertFTDHit(TrackerHit * hit, bool pixel, UTIL::BitField64& encoder, int& layer, std::string& error);
+  TrackerHitExtended * ConvertSiHit(TrackerHit * hit, const char * det, unsigned nLayers, UTIL::BitField64& encoder, int& layer, std::string& error);
+  TrackerHitExtended * ConvertVTXHit(TrackerHitPlane * hit, UTIL::BitField64& encoder, int& layer);
+  
+  /** conversion of a single input track, called concurrently by prepareVectors. Returns 0 and sets error
+   *  if a hit of the track is not in mapTrackerHits */
+  TrackExtended * ConvertTrack(Track * track, const std::map<TrackerHit*,TrackerHitExtended*>& mapTrackerHits, std::string& error);
+  
   void CleanUp();
   void MergeTPCandSiTracks();
   void MergeTPCandSiTracksII();
@@ -282,28 +300,36 @@ protected:
   void RemoveSplitTracks();
   void AddTrackColToEvt(LCEvent * evt, TrackExtendedVec & trkVec, 
                         std::string TrkColName);
+  struct TrackSummary;
+  
+  /** the comparisons take the summaries of the two tracks from the caller, which looks them up once per track */
   float CompareTrk(TrackExtended * first, TrackExtended * second, 
+                   const TrackSummary& sFirst, const TrackSummary& sSecond,
                    float d0Cut, float z0Cut, int iopt);
   
   float CompareTrkII(TrackExtended * first, TrackExtended * second, 
+                     const TrackSummary& sFirst, const TrackSummary& sSecond,
                      float d0Cut, float z0Cut, int iopt, float &Angle);
   float CompareTrkIII(TrackExtended * first, TrackExtended * second, 
+                      const TrackSummary& sFirst, const TrackSummary& sSecond,
                       float d0Cut, float z0Cut, int iopt, float &Angle);
   
-  void SortingTrackHitPairs(TrackHitPairVec & trackHitPairVec);
-  
-  void AssignSiHitsToTracks(TrackerHitExtendedVec hitVec,
+  void AssignSiHitsToTracks(const TrackerHitExtendedVec& hitVec,
                             float dcut);
   
-  void AssignTPCHitsToTracks(TrackerHitExtendedVec hitVec,
+  void AssignTPCHitsToTracks(const TrackerHitExtendedVec& hitVec,
                              float dcut);
   
-  void AssignOuterHitsToTracks(TrackerHitExtendedVec hitVec, float dcut, int refit);
+  void AssignOuterHitsToTracks(const TrackerHitExtendedVec& hitVec, float dcut, int refit);
   
   void CreateExtrapolations();
   
   void CleanUpExtrapolations();
   
+  void CleanUpIncrementalFits();
+  
+  void DeleteIncrementalFit(TrackExtended * trkExt, MarlinTrk::IMarlinTrack* marlinTrk);
+  
   HelixClass * GetExtrapolationHelix(TrackExtended * track);
   
   void PrintOutMerging(TrackExtended * firstTrackExt, TrackExtended * secondTrackExt, 
@@ -313,10 +339,43 @@ protected:
   
   int SegmentRadialOverlap(TrackExtended* pTracki, TrackExtended* pTrackj);
   bool VetoMerge(TrackExtended* firstTrackExt, TrackExtended* secondTrackExt);
+  
+  int AddTrackSummary(TrackExtended * trk);
+  const TrackSummary& GetTrackSummary(int index);
+  int GetTrackSummaryIndex(TrackExtended * trk);
+  const TrackSummary& GetTrackSummary(TrackExtended * trk) { return GetTrackSummary(GetTrackSummaryIndex(trk)); }
+  const TrackSummary& GetTPCTrackSummary(int iTPC) { return GetTrackSummary(iTPC); }
+  const TrackSummary& GetSiTrackSummary(int iSi) { return GetTrackSummary(int(_allTPCTracks.size())+iSi); }
+  void InvalidateTrackSummary(TrackExtended * trk);
+  void FillTrackSummary(TrackSummary& summary);
    
   int _nRun ;
   int _nEvt ;
   
+  /** stage timers and counters, enabled with TimeStages
+   */
+  bool _timeStages;
+  std::string _stageTimingCSVFile;
+  StageTimers _timers;
+  int _stagePrepareVectors;
+  int _stageMergeTPCandSiTracks;
+  int _stageMergeTPCandSiTracksII;
+  int _stageSorting;
+  int _stageSelectCombinedTracks;
+  int _stageAddNotCombinedTracks;
+  int _stageAddNotAssignedHits;
+  int _stageAssignOuterHitsToTracks;
+  int _stageAssignSiHitsToTracks;
+  int _stageAssignTPCHitsToTracks;
+  int _stageAddTrackColToEvt;
+  int _countCombinedTrackCandidates;
+  int _countOutputTracks;
+  
+  /** threads used for the conversion of the input collections in prepareVectors
+   */
+  int _nThreads;
+  TaskPool _taskPool;
+  
   MarlinTrk::HelixFit* _fastfitter;
   
   /** pointer to the IMarlinTrkSystem instance 
@@ -401,6 +460,7 @@ protected:
   float _initialTrackError_tanL;
   
   double _maxChi2PerHit;
+  bool   _incrementalSiHitAddition;
   double _minChi2ProbForSiliconTracks;
   float  _maxAllowedPercentageOfOutliersForTrackCombination;
   int    _maxAllowedSiHitRejectionsForTrackCombination;
@@ -432,6 +492,46 @@ protected:
   LCEvent * _evt;
   
   std::map<TrackExtended*,HelixClass*> _trackExtrapolatedHelix;
+  
+  /** backward fit of a track kept alive between the assignments of leftover silicon hits,
+   *  so that a further hit inside of r2Min can be added with a single Kalman filter step
+   */
+  struct IncrementalFit {
+    MarlinTrk::IMarlinTrack* marlinTrk;
+    int nHitsInFit;  // number of hits of the track used in fit, including rejected ones
+    int nOutliers;
+    float r2Min;     // r^2 of the innermost hit
+  };
+  
+  std::map<TrackExtended*,IncrementalFit> _incrementalFits;
+  
+  /** quantities of a track used in the pairwise comparisons, computed once per track and event
+   *  instead of once per pair. A summary is added when its track is created, the input tracks
+   *  first in the order of _allTPCTracks followed by _allSiTracks, and is marked invalid wherever
+   *  the hits or the parameters of the track change. The trial combinations of VetoMerge never get one.
+   */
+  struct TrackSummary {
+    TrackExtended * track;
+    bool valid;
+    // track parameters
+    float d0, z0, omega, tanL, phi;
+    // momentum from the helix at the IP
+    float mom[3];
+    float p;
+    float pt;
+    // polar angle and the trigonometric terms of the angle between tracks
+    float q;
+    double sinPhi, cosPhi, sinQ, cosQ;
+    // errors
+    float d0Err, z0Err, phiErr, qErr, sigmaPOverP;
+    // extent in r of the hits of the track
+    int nHits;
+    float rMin, rMax;
+  };
+  
+  // a deque, so that the summaries held by reference stay in place while combined tracks are added
+  std::deque<TrackSummary> _trackSummaries;
+  std::map<TrackExtended*,int> _trackSummaryIndex;
   std::set<TrackExtended*> _candidateCombinedTracks;
   
   UTIL::BitField64* _encoder;
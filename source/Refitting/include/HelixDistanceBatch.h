@@ -0,0 +1,52 @@
+#ifndef HelixDistanceBatch_h
+#define HelixDistanceBatch_h 1
+
+#include <vector>
+
+class HelixClass ;
+
+/** Distance of one helix to a batch of points, for the assignment of leftover hits to tracks.
+ *
+ *  select() first tests the points against the band of the cut width around the x-y circle of
+ *  the helix, in one loop without branches and sqrt over contiguous arrays which the compiler
+ *  vectorises. Only the points inside the band, widened by a margin for the rounding, are passed
+ *  on to HelixClass::getDistanceToPoint, which adds the distance in z. As getDistanceToPoint
+ *  returns the x-y distance itself when it is above the cut, the selected points and their
+ *  distances are the same as when calling it for every point.
+ */
+class HelixDistanceBatch {
+
+public:
+
+  /** For the n points (x[i],y[i]) sets excess[i] <= 0 if the distance to the circle with centre
+   *  (xc,yc) and the given radius can be at most cut[i], and > 0 otherwise
+   */
+  static void bandExcess( float xc, float yc, float radius, const float* x, const float* y, const float* cut, int n, float* excess ) ;
+
+  /** Append to selected the indices of the points (x,y,z)[idx[k]] closer to the helix than cut,
+   *  and their distances to distances.
+   */
+  void select( HelixClass& helix, const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& z,
+               const std::vector<int>& idx, float cut, std::vector<int>& selected, std::vector<float>& distances ) ;
+
+  /** As above with an individual cut for every point, cuts is indexed like x, y and z */
+  void select( HelixClass& helix, const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& z,
+               const std::vector<int>& idx, const std::vector<float>& cuts, std::vector<int>& selected, std::vector<float>& distances ) ;
+
+private:
+
+  void select( HelixClass& helix, const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& z,
+               const std::vector<int>& idx, const float* cuts, bool cutPerPoint, std::vector<int>& selected, std::vector<float>& distances ) ;
+
+  // contiguous copies of the points and cuts of the current batch
+  std::vector<float> _x ;
+  std::vector<float> _y ;
+  std::vector<float> _cut ;
+  std::vector<float> _excess ;
+
+} ;
+
+#endif
+
+
+
@@ -0,0 +1,49 @@
+#ifndef HitGridXY_h
+#define HitGridXY_h 1
+
+#include <vector>
+
+/** Uniform x-y grid of hit positions for the assignment of leftover hits to helices.
+ *
+ *  The hits are indexed once with build(). findNearCircle() then returns the hits which can
+ *  be closer than a given distance to the x-y projection of a helix, by only visiting the
+ *  cells which overlap the band of that width around the circle. As the distance returned
+ *  by HelixClass::getDistanceToPoint is never smaller than the distance in x-y, no hit that
+ *  would pass a cut on it is missed.
+ */
+class HitGridXY {
+
+public:
+
+  HitGridXY() : _xMin(0.), _yMin(0.), _cellSize(1.), _nx(0), _ny(0) {}
+
+  /** Index the n points (x[i],y[i]), the cells are at least minCellSize wide */
+  void build( const std::vector<float>& x, const std::vector<float>& y, float minCellSize ) ;
+
+  /** Append to result the indices of all points which can be within dist of the circle
+   *  with centre (xc,yc) and the given radius. The indices are sorted in ascending order.
+   */
+  void findNearCircle( double xc, double yc, double radius, double dist, std::vector<int>& result ) const ;
+
+  unsigned size() const { return _cellPoints.size() ; }
+
+private:
+
+  int column( double x ) const ;
+
+  double _xMin ;
+  double _yMin ;
+  double _cellSize ;
+  int _nx ;
+  int _ny ;
+
+  // the points of cell c are _cellPoints[ _cellStart[c] ... _cellStart[c+1] )
+  std::vector<int> _cellStart ;
+  std::vector<int> _cellPoints ;
+
+} ;
+
+#endif
+
+
+
@@ -9,6 +9,8 @@
 
 #include <EVENT/TrackerHit.h>
 
+#include "StageTimers.h"
+
 namespace MarlinTrk{
   class IMarlinTrkSystem ;
 }
@@ -116,6 +118,15 @@ protected:
   int _n_run ;
   int _n_evt ;
 
+  /** stage timers and counters, enabled with TimeStages
+   */
+  bool _timeStages;
+  std::string _stageTimingCSVFile;
+  StageTimers _timers;
+  int _stageRefit;
+  int _countInputTracks;
+  int _countOutputTracks;
+
   int _initialTrackState;
   int _fitDirection ; 
 
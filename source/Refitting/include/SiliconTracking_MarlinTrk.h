@@ -15,6 +15,8 @@
 
 #include "MarlinTrk/IMarlinTrack.h"
 
+#include "StageTimers.h"
+
 #include <UTIL/BitField64.h>
 #include <UTIL/ILDConf.h>
 
@@ -218,6 +220,22 @@ protected:
   int _nEvt ;
   EVENT::LCEvent* _current_event;
   
+  /** stage timers and counters, enabled with TimeStages
+   */
+  bool _timeStages;
+  std::string _stageTimingCSVFile;
+  StageTimers _timers;
+  int _stageInitialiseVTX;
+  int _stageInitialiseFTD;
+  int _stageProcessOneSector;
+  int _stageTrackingInFTD;
+  int _stageSorting;
+  int _stageCreateTrack;
+  int _stageAttachRemainingHits;
+  int _stageFinalRefit;
+  int _countTrackCandidates;
+  int _countOutputTracks;
+  
   int _nDivisionsInPhi;
   int _nDivisionsInTheta;
   int _nLayers;
@@ -0,0 +1,73 @@
+#ifndef SplitSectorConnector_h
+#define SplitSectorConnector_h 1
+
+#include <map>
+#include <set>
+
+#include "KiTrack/ISectorConnector.h"
+
+/** Sector connector for a sector system in which single sectors are split into sub-sectors.
+ *
+ *  The sectors of the configured sector system keep their codes. A sector that is split is
+ *  divided 2^split times in phi and theta, and its sub-sectors get codes from
+ *  getSplitSector(), which follow after the codes of the configured sectors. getTargetSectors()
+ *  maps a sub-sector to the sector it was split from, asks the wrapped connector for its
+ *  targets. A configured sector gets all sub-sectors of its split targets. A sub-sector only
+ *  gets the sub-sectors and unsplit sectors that lie inside the phi/theta window of the wrapped
+ *  connector around it, counted in sub-sectors, so a split sector is not connected to the
+ *  whole window of the sector it was split from. Targets on the IP layer are kept as they are.
+ */
+class SplitSectorConnector : public KiTrack::ISectorConnector {
+
+public:
+
+  /** connector is the connector of the configured sector system with nLayers layers and
+   *  nDivisionsInPhi x nDivisionsInTheta sectors in phi and theta
+   */
+  SplitSectorConnector( KiTrack::ISectorConnector* connector, int nLayers, int nDivisionsInPhi, int nDivisionsInTheta ) ;
+
+  /** Sets how often the split sectors are divided in phi and theta, and forgets all split sectors */
+  void setSplit( int split ) ;
+
+  int getSplit() const { return _split ; }
+
+  /** The code of the sub-sector with the given layer and phi and theta indices, counted in the
+   *  sectors divided 2^getSplit() times
+   */
+  int getSplitSector( int layer, int iPhi, int iTheta ) const ;
+
+  /** The configured sector of a sector or sub-sector */
+  int getCoarseSector( int sector ) const ;
+
+  /** Marks the configured sector of splitSector as split, with hits in splitSector */
+  void addSplitSector( int splitSector ) ;
+
+  /** If the configured sector is split */
+  bool isSplit( int sector ) const { return _splitSectors.count( sector ) != 0 ; }
+
+  /** The number of configured sectors that are split */
+  unsigned getNumberOfSplitSectors() const { return _splitSectors.size() ; }
+
+  virtual std::set< int > getTargetSectors( int sector ) ;
+
+private:
+
+  /** the code of the first sub-sector, the sub-sectors follow after the configured sectors */
+  int firstSplitSector() const { return _nLayers*_nDivisionsInPhi*_nDivisionsInTheta ; }
+
+  /** layer and phi and theta indices of a sector or sub-sector, for a sub-sector counted in sub-sectors */
+  void decode( int sector, int& layer, int& iPhi, int& iTheta ) const ;
+
+  KiTrack::ISectorConnector* _connector ;
+
+  int _nLayers ;
+  int _nDivisionsInPhi ;
+  int _nDivisionsInTheta ;
+  int _split ;
+
+  /** the configured sectors that are split, with their sub-sectors that have hits */
+  std::map< int , std::set< int > > _splitSectors ;
+
+} ;
+
+#endif
@@ -14,6 +14,11 @@
 #include <EVENT/LCCollection.h>
 #include "MarlinTrk/IMarlinTrkSystem.h"
 #include "EVENT/TrackerHit.h"
+#include "EVENT/MCParticle.h"
+#include "IMPL/TrackImpl.h"
+
+#include "TruthRelationIndex.h"
+#include "TaskPool.h"
 
 #include <AIDA/AIDA.h>
 
@@ -47,6 +52,9 @@ class TruthTrackFinder : public Processor {
   // Call to get collections
   void getCollection(LCCollection*&, std::string, LCEvent*);
 	
+  // Fit the hits of a particle with the given track system, returns 0 if the fit fails
+  IMPL::TrackImpl* fitParticle( MarlinTrk::IMarlinTrkSystem* factory, EVENT::MCParticle* mcParticle, std::vector<EVENT::TrackerHit*>& trackHits ) ;
+
   // Sort hits by radius
 
 	
@@ -69,6 +77,11 @@ class TruthTrackFinder : public Processor {
   // Track fit factory
   MarlinTrk::IMarlinTrkSystem* trackFactory;
 
+  // Threads fitting the particles, each one with its own track fit factory (the first one is trackFactory)
+  int m_nThreads;
+  TaskPool m_taskPool;
+  std::vector<MarlinTrk::IMarlinTrkSystem*> m_trackFactories;
+
   // Track fit parameters
   double m_initialTrackError_d0;
   double m_initialTrackError_phi0;
@@ -79,6 +92,15 @@ class TruthTrackFinder : public Processor {
   double m_magneticField;
   int m_fitFails;
 
+  // Truth relations, used if no shared index was built for the event
+  TruthRelationIndex m_truthIndex;
+
+  // Particles sorted by pointer with their index in the collection, and per particle index its hits and fit result
+  std::vector<std::pair<EVENT::MCParticle*, int> > m_particleIndex;
+  std::vector<std::vector<EVENT::TrackerHit*> > m_particleHits;
+  std::vector<IMPL::TrackImpl*> m_particleTracks;
+  std::vector<int> m_particleFitFailed;
+
 		
 } ;
 
@@ -12,6 +12,8 @@
 #include <UTIL/BitField64.h>
 #include <UTIL/ILDConf.h>
 
+#include "TruthRelationIndex.h"
+
 namespace EVENT{
   class MCParticle ;
   class Track ;
@@ -135,10 +137,8 @@ protected:
   /** helper function to get collection using try catch block */
   LCCollection* GetCollection(  LCEvent * evt, std::string colName ) ;
   
-  /** helper function to get relations using try catch block */
-  LCRelationNavigator* GetRelations( LCEvent * evt, std::string RelName ) ;
-  
-  /** sets up the different collections */
+  /** sets up the different collections, the truth relations are taken from the
+   *  TruthRelationIndex published by BuildTruthRelationIndex if available */
   void SetupInputCollections( LCEvent * evt ) ;
   
   void createTrack( MCParticle* mcp, UTIL::BitField64& cellID_encoder, std::vector< std::pair<SimTrackerHit*, TrackerHit* > >& hit_list );
@@ -163,7 +163,10 @@ protected:
   std::vector< std::string > _colNamesTrackerHitRelations;
 
   std::vector< LCCollection* > _colTrackerHits;
-  std::vector< LCRelationNavigator* > _navTrackerHitRel;
+  std::vector< const TruthRelationIndex::EntryVec* > _truthTrackerHitRel;
+  
+  /** private truth index, used if no BuildTruthRelationIndex ran for this event */
+  TruthRelationIndex _truthIndex;
   
   /** output track collection 
    */
@@ -6,6 +6,9 @@
 #include <algorithm>
 #include <cmath>
 #include <climits>
+#include <limits>
+#include <list>
+#include <map>
 
 #include <UTIL/BitField64.h>
 // #include <UTIL/ILDConf.h>
@@ -37,6 +40,24 @@ const int DDCellsAutomatonMV::_output_track_col_quality_POOR = 3;
 
 const double DDCellsAutomatonMV::TWOPI = 2*M_PI;
 
+namespace {
+
+  // polar angle of a hit in degrees as used for the theta agreement of the mini-vectors
+  double polarAngleInDegrees( const double* pos ) {
+
+    double rad = sqrt(pos[0]*pos[0]+pos[1]*pos[1]);
+    //BEFORE BAD RANGE - at 90deg possible flip of sign -- fixed track ineff, still bad track
+    double theta = atan2(rad,pos[2]);
+    theta = 2*M_PI-theta;
+    while(theta>=2*M_PI){
+      theta = theta - 2*M_PI; 
+    }
+    return theta*180./M_PI;
+
+  }
+
+}
+
 DDCellsAutomatonMV aDDCellsAutomatonMV ;
 
 DDCellsAutomatonMV::DDCellsAutomatonMV() : Processor("DDCellsAutomatonMV"){
@@ -151,6 +172,16 @@ DDCellsAutomatonMV::DDCellsAutomatonMV() : Processor("DDCellsAutomatonMV"){
 			     _maxHitsPerSector,
 			     int(1000));
   
+  registerProcessorParameter("SplitOverflowingSectors",
+			     "If a sector has more than MaxHitsPerSector hits, split it in phi and theta instead of dropping its hits",
+			     _splitOverflowingSectors,
+			     bool(false));
+  
+  registerProcessorParameter("MaxSectorSplits",
+			     "Maximal number of times an overflowing sector is split in two in phi and theta with SplitOverflowingSectors, its hits are dropped if it still overflows",
+			     _maxSectorSplits,
+			     int(2));
+  
   registerProcessorParameter( "BestSubsetFinder",
 			      "The method used to find the best non overlapping subset of tracks. Available are: SubsetHopfieldNN, SubsetSimple and None",
 			      _bestSubsetFinder,
@@ -259,6 +290,21 @@ DDCellsAutomatonMV::DDCellsAutomatonMV() : Processor("DDCellsAutomatonMV"){
       
   }
   
+  registerProcessorParameter( "NumberOfThreads",
+                             "Number of threads creating the mini-vectors of the sectors, 1 creates them in the calling thread and 0 uses all hardware threads",
+                             _nThreads,
+                             int(1));
+  
+  registerProcessorParameter( "TimeStages",
+                             "Measure the time spent in the main processing stages and print a summary per run in end()",
+                             _timeStages,
+                             bool(false));
+  
+  registerProcessorParameter( "StageTimingCSVFile",
+                             "If set together with TimeStages, write the stage times and counters of every event to this CSV file",
+                             _stageTimingCSVFile,
+                             std::string(""));
+  
 }
 
 void DDCellsAutomatonMV::init() {
@@ -275,18 +321,22 @@ void DDCellsAutomatonMV::init() {
   MiniVectors_sectors = 0 ;
   MiniVectors_CutSelection = 0 ;
 
-  int nDivisionsInPhi = _nDivisionsInPhi ;
-  int nDivisionsInTheta = _nDivisionsInTheta ;
   if (_useSIT==1){
     _nLayers = _nLayersVTX + _nLayersSIT + 1 ;   // + 1 adding a virtual layer for the IP
   }
   else 
     _nLayers = _nLayersVTX + 1 ;  // + 1 adding a virtual layer for the IP
-  _sectorSystemVXD = new SectorSystemVXD( _nLayers, nDivisionsInPhi , nDivisionsInTheta );
   
+  _sectorSystemVXD = new SectorSystemVXD( _nLayers, _nDivisionsInPhi , _nDivisionsInTheta );
   
   _dPhi = TWOPI/_nDivisionsInPhi;
   _dTheta = 2.0/_nDivisionsInTheta;
+  
+  if( _maxSectorSplits < 0 ) throw EVENT::Exception( "DDCellsAutomatonMV: MaxSectorSplits must not be negative" ) ;
+  
+  _nEvents = 0;
+  _nEventsSplit = 0;
+  _nEventsDropped = 0;
 
   /**********************************************************************************************/
   /*       Initialise the MarlinTrkSystem, needed by the tracks for fitting                     */
@@ -312,6 +362,25 @@ void DDCellsAutomatonMV::init() {
   // initialise the tracking system
   _trkSystem->init() ;
   
+  _taskPool.init( _nThreads );
+  
+  setLoosestCriteria();
+  
+  _timers.init( name(), _timeStages, _stageTimingCSVFile );
+  _stageInitialiseVTX = _timers.addStage( "InitialiseVTX" );
+  _stageCreateMiniVectors = _timers.addStage( "CreateMiniVectors" );
+  _stageAutomaton = _timers.addStage( "Automaton" );
+  _stageConnectionGraph = _timers.addStage( "ConnectionGraph" );
+  _stageAutomatonRound = _timers.addStage( "AutomatonRound" );
+  _stageTrackFitting = _timers.addStage( "TrackFitting" );
+  _stageBestSubset = _timers.addStage( "BestSubset" );
+  _stageFinalise = _timers.addStage( "Finalise" );
+  _countHits = _timers.addCounter( "Hits" );
+  _countRawTracks = _timers.addCounter( "RawTracks" );
+  _countAutomatonRounds = _timers.addCounter( "AutomatonRounds" );
+  _countTrackCandidates = _timers.addCounter( "TrackCandidates" );
+  _countOutputTracks = _timers.addCounter( "OutputTracks" );
+  
 }
 
 
@@ -331,8 +400,16 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
   // reset the hit map
   _map_sector_spacepoints.clear();
   _map_sector_hits.clear();
+  
+  _nEvents++;
+
+  _timers.startEvent( evt->getRunNumber(), evt->getEventNumber() );
 
+  StageTimers::Scope timeInitialiseVTX( _timers, _stageInitialiseVTX );
   InitialiseVTX( evt, HitsTemp );
+  timeInitialiseVTX.stop();
+
+  _timers.count( _countHits, HitsTemp.size() );
 
   unsigned round = 0; // the round we are in
   std::vector < RawTrack > rawTracks;
@@ -346,15 +423,42 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
   
   std::map< int , EVENT::TrackerHitVec >::iterator it;
   
+  unsigned layerStepMax = _layerStepMax ; // how many layers to go at max
+  unsigned lastLayerToIP = _lastLayerToIP ;  
+  //bool MiddleLayer = _middleLayer ;
+  //VXDSectorConnector secCon( _sectorSystemVXD , layerStepMax, lastLayerToIP, MiddleLayer );  
+  VXDSectorConnector secCon( _sectorSystemVXD , layerStepMax, lastLayerToIP );
+  
+  // Only the overflowing sectors are split. Their sub-sectors get the window of target sectors of the
+  // configured sectors counted in sub-sectors, the other sectors keep the targets they had.
+  SplitSectorConnector splitSecCon( &secCon, _nLayers, _nDivisionsInPhi, _nDivisionsInTheta );
+  
+  if( _splitOverflowingSectors ){
+    
+    splitSectors( splitSecCon );
+    
+    if( splitSecCon.getNumberOfSplitSectors() > 0 ){
+      
+      streamlog_out(DEBUG4) << " Overflowing sectors, " << splitSecCon.getNumberOfSplitSectors() << " sectors split " << splitSecCon.getSplit() << " times in phi and theta" << std::endl ;
+      
+      _nEventsSplit++;
+      
+    }
+    
+  }
+  
+  bool droppedHits = false;
+  
   for( it=_map_sector_spacepoints.begin(); it != _map_sector_spacepoints.end(); it++ ){
     
     
     int nHits = it->second.size();
     streamlog_out( DEBUG2 ) << "Number of hits in sector " << it->first << " = " << nHits << "\n";
     
-    if( nHits > _maxHitsPerSector ){
+    if( nHits > _maxHitsPerSector && !splitSecCon.isSplit( it->first ) ){
       
       it->second.clear(); //delete the hits in this sector, it will be dropped
+      droppedHits = true;
       
       streamlog_out(ERROR)  << " ### EVENT " << evt->getEventNumber() << " :: RUN " << evt->getRunNumber() << " \n ### Number of Hits in VXD Sector " << it->first << ": " << nHits << " > " << _maxHitsPerSector << " (MaxHitsPerSector)\n : This sector will be dropped from track search, and QualityCode set to \"Poor\" " << std::endl;
       
@@ -363,6 +467,8 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
     }
     
   }
+  
+  if( droppedHits ) _nEventsDropped++;
 
 
   /**********************************************************************************************/
@@ -382,40 +488,107 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
   /**********************************************************************************************/
 
 
+  // The sectors only read the hit store and fill their own pool, so they are processed concurrently.
+  // The mini-vectors are added to _map_sector_hits afterwards in the order of the sectors.
+
+  StageTimers::Scope timeCreateMiniVectors( _timers, _stageCreateMiniVectors );
+  FillSectorHitStore( splitSecCon );
+
+  std::vector< int > sectors;
   for ( std::map< int , EVENT::TrackerHitVec >::iterator itSecHit = _map_sector_spacepoints.begin(); itSecHit != _map_sector_spacepoints.end(); itSecHit++ ){ //over all sectors
-    
-    int sector = itSecHit->first;
-    CreateMiniVectors( sector ); // Process one VXD sector     
-    
+    if( !itSecHit->second.empty() ) sectors.push_back( itSecHit->first );
+  }
+
+  if( _miniVectorPools.size() < sectors.size() ) _miniVectorPools.resize( sectors.size() );
+
+  _taskPool.run( sectors.size(), [&]( int i ){ CreateMiniVectors( sectors[i], _miniVectorPools[i] ); } ); // Process one VXD sector per task
+
+  for ( unsigned i=0; i<sectors.size(); i++ ){
+
+    MiniVectorPool& pool = _miniVectorPools[i];
+    MiniVectors_CutSelection += pool.nVXD;
+
+    for ( unsigned k=0; k<pool.miniVectorHits.size(); k++ ){
+      _map_sector_hits[ pool.miniVectorSectors[k] ].push_back( &pool.miniVectorHits[k] );
+      streamlog_out(DEBUG2) << " making the mini-vector hit " << &pool.miniVectorHits[k] << " at sector " << pool.miniVectorSectors[k] << std::endl ;
+    }
+
   }
+  timeCreateMiniVectors.stop();
 
 
 
+  StageTimers::Scope timeAutomaton( _timers, _stageAutomaton );
+  
+  // The connections between the hits are searched with the loosest 2-hit criteria of all rounds. A round
+  // with these cut offs uses the graph itself. Any other round, and any round after the graph was used,
+  // keeps the connections of the table which pass its own cut offs. The table is only built when the
+  // first such round comes, most events are done with the graph.
+  StageTimers::Scope timeConnectionGraph( _timers, _stageConnectionGraph );
+  
+  SegmentBuilder segBuilder( _map_sector_hits );
+  
+  segBuilder.addCriteria ( _crit2LooseVec ); // Add the criteria on when to connect two hits
+  
+  streamlog_out(DEBUG4) << " _layerStepMax =  " << _layerStepMax << std::endl ;
+  streamlog_out(DEBUG4) << " _lastLayerToIP = " << _lastLayerToIP << std::endl ;
+  
+  segBuilder.addSectorConnector ( & splitSecCon ); // Add the sector connector (so the SegmentBuilder knows what hits from different sectors it is allowed to look for connections)
+  
+  // The graph of the 1-segments with all connections any round can use
+  Automaton graph = segBuilder.get1SegAutomaton();
+  
+  ConnectionTable table;
+  bool tableBuilt = false;
+  bool graphUsed = false;
+  
+  // With too many connections in the graph every round with the loosest cut offs fails
+  const bool graphOverflows = graph.getNumberOfConnections() > unsigned( _maxConnectionsAutomaton );
+  
+  timeConnectionGraph.stop();
+  
+  streamlog_out(DEBUG4) << " graph.getNumberOfConnections() = " << graph.getNumberOfConnections() << std::endl ;
+  
   while( setCriteria( round ) ){
 
     streamlog_out(DEBUG4) << " DO I ENTER IN THE GAME " << std::endl ;
     
+    StageTimers::Scope timeRound( _timers, _stageAutomatonRound );
     
-    round++; // count up the round we are in
-    
-    SegmentBuilder segBuilder( _map_sector_hits );
+    if( graphOverflows && _roundIsLoosest[round] ){
+      
+      round++;
+      
+      streamlog_out(DEBUG4) << "Redo the Automaton with different parameters, because there are too many connections:\n"
+			      << "\tconnections( " << graph.getNumberOfConnections() << " ) > MaxConnectionsAutomaton( " << _maxConnectionsAutomaton << " )\n";
+      continue;
+      
+    }
     
-    segBuilder.addCriteria ( _crit2Vec ); // Add the criteria on when to connect two hits. The vector has been filled by the method setCriteria
+    const bool useGraph = !graphUsed && _roundIsLoosest[round];
     
-    unsigned layerStepMax = _layerStepMax ; // how many layers to go at max
-    unsigned lastLayerToIP = _lastLayerToIP ;  
-    //bool MiddleLayer = _middleLayer ;
-    //VXDSectorConnector secCon( _sectorSystemVXD , layerStepMax, lastLayerToIP, MiddleLayer );  
-    VXDSectorConnector secCon( _sectorSystemVXD , layerStepMax, lastLayerToIP );
+    // The table is taken from the graph as long as no round has changed it, otherwise the graph is searched again
+    if( !useGraph && !tableBuilt ){
+      
+      StageTimers::Scope timeConnectionTable( _timers, _stageConnectionGraph );
+      
+      if( graphUsed ){
+        Automaton rebuilt = segBuilder.get1SegAutomaton();
+        buildConnectionTable( rebuilt, table );
+      }
+      else buildConnectionTable( graph, table );
+      
+      tableBuilt = true;
+      
+    }
     
-
-    streamlog_out(DEBUG4) << " _layerStepMax =  " << _layerStepMax << std::endl ;
-    streamlog_out(DEBUG4) << " _lastLayerToIP = " << _lastLayerToIP << std::endl ;
-
-    segBuilder.addSectorConnector ( & secCon ); // Add the sector connector (so the SegmentBuilder knows what hits from different sectors it is allowed to look for connections)
+    // The Cellular Automaton with the 1-segments connected according to the criteria of this round
+    Automaton filtered;
+    if( !useGraph ) filterConnections( table, round, filtered );
+    Automaton& automaton = useGraph ? graph : filtered;
+    graphUsed = graphUsed || useGraph;
     
-    // And get out the Cellular Automaton with the 1-segments 
-    Automaton automaton = segBuilder.get1SegAutomaton();
+    round++; // count up the round we are in
 
     streamlog_out(DEBUG4) << " automaton.getNumberOfConnections() = " << automaton.getNumberOfConnections() << std::endl ;
     
@@ -490,6 +663,12 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
     }
   }
 
+  timeAutomaton.stop();
+  _timers.count( _countRawTracks, rawTracks.size() );
+  _timers.count( _countAutomatonRounds, round );
+  
+  streamlog_out(DEBUG4) << "Automaton finished after " << round << " rounds\n";
+
   streamlog_out(DEBUG4) << "Automaton returned " << rawTracks.size() << " raw tracks \n";
  
 
@@ -498,6 +677,7 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
   // Track fitting similar to forward tracking
   //*************************************************************************************************************
 
+  StageTimers::Scope timeTrackFitting( _timers, _stageTrackFitting );
   std::vector <ITrack*> trackCandidates;
 
   // for all raw tracks we got from the automaton
@@ -630,6 +810,9 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
   
   
     
+  timeTrackFitting.stop();
+  _timers.count( _countTrackCandidates, trackCandidates.size() );
+
   // FTD like track fitting over. 
   //_________________________________________________________________________________________________
     
@@ -649,6 +832,7 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
 
 
  
+  StageTimers::Scope timeBestSubset( _timers, _stageBestSubset );
   std::vector< ITrack* > GoodTracks;
   std::vector< ITrack* > RejectedTracks;
  
@@ -701,6 +885,7 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
     
   }
   
+  timeBestSubset.stop();
   streamlog_out(DEBUG4) <<  "End of Sorting, Good tracks number: " << GoodTracks.size() <<  std::endl;
 
  
@@ -711,6 +896,7 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
 
   // Finalise the tracks
 
+  StageTimers::Scope timeFinalise( _timers, _stageFinalise );
   for (unsigned int i=0; i < GoodTracks.size(); i++){
     
     VXDTrack* myTrack = dynamic_cast< VXDTrack* >( GoodTracks[i] );
@@ -742,10 +928,13 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
 	}
     }
   }
+  timeFinalise.stop();
   // Finalisation ends
 
   streamlog_out( DEBUG4 ) << "DDCellsAutomatonMV: _CATrackCollection = "<< _CATrackCollection <<"     trackVec->getNumberOfElements() = " << trackVec->getNumberOfElements() << "\n";
 
+  _timers.count( _countOutputTracks, trackVec->getNumberOfElements() );
+
   evt->addCollection( trackVec , _CATrackCollection) ;
 
 
@@ -757,24 +946,14 @@ void DDCellsAutomatonMV::processEvent( LCEvent * evt ) {
   // delete all the created IHits
   for ( unsigned i=0; i<HitsTemp.size(); i++ )  delete HitsTemp[i];
 
-  if ( MiniVectorsTemp.size() > 0 ) {
-    for ( unsigned i=0; i<MiniVectorsTemp.size(); i++ ){
-      delete  MiniVectorsTemp[i] ;
-      MiniVectorsTemp[i] = NULL ;
-    }
-  }
-
-  if ( TestMiniVectorsTemp.size() > 0 ) {
-    for ( unsigned i=0; i<TestMiniVectorsTemp.size(); i++ ){
-      delete  TestMiniVectorsTemp[i] ;
-      TestMiniVectorsTemp[i] = NULL ;
-    }
-  }
+  for ( unsigned i=0; i<_miniVectorPools.size(); i++ ) _miniVectorPools[i].clear();
 
   // cleanup of tracks
   //if ( _bestSubsetFinder != "NoSelection") for (unsigned int i=0; i < GoodTracks.size(); i++){ delete GoodTracks[i]; } 
   //for ( unsigned i=0; i<RejectedTracks.size(); i++){ delete RejectedTracks[i]; }
   //for ( unsigned i=0; i<trackCandidates.size(); i++){ delete trackCandidates[i]; }
+
+  _timers.endEvent();
 }
 
 
@@ -786,15 +965,22 @@ void DDCellsAutomatonMV::check( LCEvent * evt ) {
 
 void DDCellsAutomatonMV::end(){
 
+   _timers.printSummary();
+
    for ( unsigned i=0; i< _crit2Vec.size(); i++) delete _crit2Vec[i];
    for ( unsigned i=0; i< _crit3Vec.size(); i++) delete _crit3Vec[i];
    for ( unsigned i=0; i< _crit4Vec.size(); i++) delete _crit4Vec[i];
+   for ( unsigned i=0; i< _crit2LooseVec.size(); i++) delete _crit2LooseVec[i];
    _crit2Vec.clear();
    _crit3Vec.clear();
    _crit4Vec.clear();
+   _crit2LooseVec.clear();
    
    delete _sectorSystemVXD;
    _sectorSystemVXD = NULL; 
+   
+   streamlog_out(MESSAGE) << "Events with overflowing sectors: " << _nEventsSplit << " of " << _nEvents << " resolved by splitting the sectors, "
+                          << _nEventsDropped << " of " << _nEvents << " with hits dropped" << std::endl ;
 
    //streamlog_out(DEBUG4) << " no of candidate minivectors created with sectors apprach " << MiniVectors_sectors << " no of candidate minivectors created applying a cut selection " <<  MiniVectors_CutSelection  << std::endl ;
 
@@ -1040,13 +1226,54 @@ void DDCellsAutomatonMV::InitialiseVTX( LCEvent * evt, EVENT::TrackerHitVec Hits
 // distance didvided with  the distance of the two sides of the layer. The search is confined in  a number of target sectors
 // of the inner side of the VXD layer.
 
-void DDCellsAutomatonMV::CreateMiniVectors( int sector ) {
+void DDCellsAutomatonMV::FillSectorHitStore( const SplitSectorConnector& connector ) {
+
+  int nSectors = _nLayers*_nDivisionsInPhi*_nDivisionsInTheta;
+  if( !_map_sector_spacepoints.empty() ) nSectors = std::max( nSectors, _map_sector_spacepoints.rbegin()->first + 1 );
+
+  _sectorStart.assign( nSectors + 1, 0 );
+  _sectorHits.clear();
+
+  UTIL::BitField64 encoder( lcio::ILDCellID0::encoder_string ) ; 
+
+  // the map is sorted by sector, so the hits are appended in the order of the store
+  for ( std::map< int , EVENT::TrackerHitVec >::iterator itSecHit = _map_sector_spacepoints.begin(); itSecHit != _map_sector_spacepoints.end(); itSecHit++ ){
+
+    const TrackerHitVec& hits = itSecHit->second;
+    _sectorStart[ itSecHit->first + 1 ] = hits.size();
+
+    const bool split = connector.isSplit( itSecHit->first );
+    const bool anySplit = connector.getNumberOfSplitSectors() > 0;
+
+    for ( unsigned i=0; i<hits.size(); i++ ){
+
+      encoder.setValue( hits[i]->getCellID0() ) ;
+
+      SectorHit sectorHit;
+      sectorHit.hit = hits[i];
+      sectorHit.sector = split ? splitSector( hits[i], itSecHit->first, connector ) : itSecHit->first;
+      sectorHit.split = split;
+      sectorHit.phiIndex = 0;
+      sectorHit.thetaIndex = 0;
+      if( anySplit ) splitPhiTheta( hits[i], itSecHit->first, connector.getSplit(), sectorHit.phiIndex, sectorHit.thetaIndex );
+      sectorHit.detID = encoder[lcio::ILDCellID0::subdet] ; 
+      sectorHit.layer = encoder[lcio::ILDCellID0::layer] + 1 ;  // + 1 if we consider the IP hit
+      sectorHit.theta = polarAngleInDegrees( hits[i]->getPosition() );
+      _sectorHits.push_back( sectorHit );
+
+    }
+
+  }
+
+  for ( int s=0; s<nSectors; s++ ) _sectorStart[s+1] += _sectorStart[s];
+
+}
+
+
+void DDCellsAutomatonMV::CreateMiniVectors( int sector, MiniVectorPool& pool ) const {
 
   int iTheta = sector/(_nLayers*_nDivisionsInPhi) ;
   int iPhi = ((sector - (iTheta*_nLayers*_nDivisionsInPhi)) / _nLayers) ;
-  int layer = sector - (iTheta*_nLayers*_nDivisionsInPhi) - (iPhi*_nLayers) ; 
-
-  streamlog_out(DEBUG4) << " Taking sector " << sector << " of layer " << layer << " Phi sector " << iPhi << " Theta sector " << iTheta << std::endl ;
 
   int iPhi_Up    = iPhi + 2;
   int iPhi_Low   = iPhi - 2;
@@ -1055,25 +1282,14 @@ void DDCellsAutomatonMV::CreateMiniVectors( int sector ) {
   if (iTheta_Low < 0) iTheta_Low = 0;
   if (iTheta_Up  >= _nDivisionsInTheta) iTheta_Up = _nDivisionsInTheta-1;
 
-  TrackerHitVec VXDHits = _map_sector_spacepoints[sector];
+  SectorHitSpan VXDHits = sectorHits( sector );
   
-  for (TrackerHitVec::iterator iter=VXDHits.begin(); iter!=VXDHits.end(); ++iter) {
+  for (const SectorHit* iter=VXDHits.begin; iter!=VXDHits.end; ++iter) {
 
-    TrackerHit *fromHit = *iter ;   // Starting hit
+    TrackerHit *fromHit = iter->hit ;   // Starting hit
 
-    streamlog_out(DEBUG2) << " hit to initiate a MV: " <<  fromHit << std::endl ;
-    
-    int celID = fromHit->getCellID0() ;
-    int detID = 0 ;
-    //int layerID = 0 ;
-    
-    UTIL::BitField64 encoder( lcio::ILDCellID0::encoder_string ) ; 
-    encoder.reset() ;  // reset to 0
-    encoder.setValue(celID) ;
-
-    detID = encoder[lcio::ILDCellID0::subdet] ; 
-    
-    layer = encoder[lcio::ILDCellID0::layer] + 1 ;  // + 1 if we consider the IP hit
+    int detID = iter->detID ;
+    int layer = iter->layer ;
     
     if (detID==lcio::ILDDetID::VXD ){
 
@@ -1095,33 +1311,22 @@ void DDCellsAutomatonMV::CreateMiniVectors( int sector ) {
 	  for (int iTheta = iTheta_Low_mod ; iTheta < iTheta_Up_mod ; iTheta++){
 	    
 	    int target_sector = ( layer-1) + _nLayers*iPhi + _nLayers*_nDivisionsInPhi*iTheta ;
-	    TrackerHitVec targetHitsMod = _map_sector_spacepoints[target_sector];
+	    SectorHitSpan targetHitsMod = sectorHits( target_sector );
 
-	    streamlog_out(DEBUG2) << " Checking with TARGET sector " << target_sector << " of layer " << layer-1 << " Phi sector " << iPhi << " Theta sector " << iTheta << std::endl ;
-
-	    streamlog_out(DEBUG2) << " No of hits in the sector " << targetHitsMod.size() << std::endl ;
-
-	    for (TrackerHitVec::iterator iterMod=targetHitsMod.begin(); iterMod!=targetHitsMod.end(); ++iterMod) {
+	    for (const SectorHit* iterMod=targetHitsMod.begin; iterMod!=targetHitsMod.end; ++iterMod) {
 	      
-	      TrackerHit *toHitMod = *iterMod ;  // Candidate hit to form a mini - vector with the starting hit
+	      TrackerHit *toHitMod = iterMod->hit ;  // Candidate hit to form a mini - vector with the starting hit
 
-	      if (thetaAgreementImproved(toHitMod,fromHit,layer) == true){
+	      if (inSplitWindow(*iter,*iterMod) && thetaAgreementImproved(iterMod->theta,iter->theta,layer) == true){
 		
-		MiniVector *testMiniVectorMod = new MiniVector(fromHit,toHitMod) ;
-		MiniVectorHit01* miniVectorHitMod = new MiniVectorHit01( testMiniVectorMod , _sectorSystemVXD );  
-		MiniVectors_CutSelection++;
-		_map_sector_hits[ sector ].push_back( miniVectorHitMod );
-
-		streamlog_out(DEBUG2) << " making the VXD mini-vector hit " << miniVectorHitMod << " at sector " << sector << std::endl ;
-		
-		MiniVectorsTemp.push_back(miniVectorHitMod);
-		TestMiniVectorsTemp.push_back(testMiniVectorMod);
+		pool.miniVectors.emplace_back( fromHit, toHitMod ) ;
+		pool.miniVectorHits.emplace_back( &pool.miniVectors.back() , _sectorSystemVXD );  
+		pool.miniVectorSectors.push_back( iter->sector );
+		pool.nVXD++;
       
 	      }
 	    }
 	    
-	    targetHitsMod.clear();
-	    
 	  }
 	}
       }
@@ -1141,45 +1346,27 @@ void DDCellsAutomatonMV::CreateMiniVectors( int sector ) {
 	//if (layer==8) {
 	if (layer==7 || layer==9) {
 	  
-	  
-	  //double from_x = fromHit->getPosition()[0] ;
-	  //double from_y = fromHit->getPosition()[1] ;
-	  
 	  for (int iPhi = iPhi_Low ; iPhi < iPhi_Up ; iPhi++){
 	    
-	    int iTheta_Up_mod  = iTheta + 10; 
-	    int iTheta_Low_mod = iTheta - 10;
-	    if (iTheta_Low_mod < 0) iTheta_Low_mod = 0;
-	    if (iTheta_Up_mod  >= _nDivisionsInTheta) iTheta_Up_mod = _nDivisionsInTheta-1;
-	    
 	    for (int iTheta = iTheta_Low ; iTheta < iTheta_Up ; iTheta++){
 	      
 	      int target_sector = ( layer-1) + _nLayers*iPhi + _nLayers*_nDivisionsInPhi*iTheta ;
 	      
-	      //double ThetaAngle = acos(((2*iTheta)/(_nDivisionsInTheta*1.0)) - 1);
-	      
-	      TrackerHitVec targetHits = _map_sector_spacepoints[target_sector];
+	      SectorHitSpan targetHits = sectorHits( target_sector );
 	    
-	      streamlog_out(DEBUG3) << " How many hits on the target sector " << targetHits.size() << std::endl ;
-	      
-	      for (TrackerHitVec::iterator iter2=targetHits.begin(); iter2!=targetHits.end(); ++iter2) {
+	      for (const SectorHit* iter2=targetHits.begin; iter2!=targetHits.end; ++iter2) {
 		
-		TrackerHit *toHit = *iter2 ;
+		TrackerHit *toHit = iter2->hit ;
 		
-		if ( Dist(fromHit,toHit) < _maxDist ){
+		if ( inSplitWindow(*iter,*iter2) && Dist(fromHit,toHit) < _maxDist ){
 		  
-		  MiniVector *sitTestMiniVector = new MiniVector(fromHit,toHit) ;
-		  MiniVectorHit01* sitMiniVectorHit = new MiniVectorHit01( sitTestMiniVector , _sectorSystemVXD );  
+		  pool.miniVectors.emplace_back( fromHit, toHit ) ;
+		  pool.miniVectorHits.emplace_back( &pool.miniVectors.back() , _sectorSystemVXD );  
+		  pool.miniVectorSectors.push_back( iter->sector );
 		  
-		  streamlog_out(DEBUG4) << " making a SIT mini-vector hit at sector " << sector << std::endl ;
-		  
-		  //MiniVectors_sectors++;
-		  
-		  _map_sector_hits[ sector ].push_back( sitMiniVectorHit );
 		}
 	      }
 	      
-	      targetHits.clear();
 	    }
 	  }
 	}
@@ -1190,8 +1377,6 @@ void DDCellsAutomatonMV::CreateMiniVectors( int sector ) {
    
   } // end of looping on VXD -  SIT trackerhits
   
-  VXDHits.clear();
-  
 }
 
 
@@ -1311,6 +1496,339 @@ bool DDCellsAutomatonMV::setCriteria( unsigned round ){
 }
 
 
+void DDCellsAutomatonMV::splitSectors( SplitSectorConnector& connector ){
+   
+   std::vector< int > overflowing;
+   
+   for( std::map< int , EVENT::TrackerHitVec >::const_iterator it=_map_sector_spacepoints.begin(); it != _map_sector_spacepoints.end(); it++ ){
+      
+      if( int( it->second.size() ) > _maxHitsPerSector ) overflowing.push_back( it->first );
+      
+   }
+   
+   if( overflowing.empty() || _maxSectorSplits == 0 ) return;
+   
+   // split as few times as needed for none of the overflowing sectors to overflow, all of them the same number of times
+   for( int split=1; split<=_maxSectorSplits; split++ ){
+      
+      connector.setSplit( split );
+      
+      bool overflows = false;
+      for( unsigned i=0; i<overflowing.size() && !overflows; i++ ) overflows = maxHitsInSplitSector( overflowing[i], connector ) > _maxHitsPerSector;
+      
+      if( !overflows ) break;
+      
+   }
+   
+   // the sectors still overflowing are not split, their hits are dropped
+   for( unsigned i=0; i<overflowing.size(); i++ ){
+      
+      if( maxHitsInSplitSector( overflowing[i], connector ) > _maxHitsPerSector ) continue;
+      
+      const TrackerHitVec& hits = _map_sector_spacepoints[ overflowing[i] ];
+      for( unsigned j=0; j<hits.size(); j++ ) connector.addSplitSector( splitSector( hits[j], overflowing[i], connector ) );
+      
+   }
+   
+}
+
+
+int DDCellsAutomatonMV::splitSector( TrackerHit* hit, int sector, const SplitSectorConnector& connector ) const {
+   
+   int iPhiSplit = 0;
+   int iThetaSplit = 0;
+   splitPhiTheta( hit, sector, connector.getSplit(), iPhiSplit, iThetaSplit );
+   
+   return connector.getSplitSector( sector % _nLayers, iPhiSplit, iThetaSplit );
+   
+}
+
+
+void DDCellsAutomatonMV::splitPhiTheta( TrackerHit* hit, int sector, int split, int& iPhiSplit, int& iThetaSplit ) const {
+   
+   int iPhi = ( sector / _nLayers ) % _nDivisionsInPhi;
+   int iTheta = sector / ( _nLayers*_nDivisionsInPhi );
+   
+   double pos[3];
+   double radius = 0;
+   
+   for (int j=0; j<3; ++j) {
+      pos[j] = hit->getPosition()[j];
+      radius += pos[j]*pos[j];
+   }
+   
+   radius = sqrt(radius);
+   
+   double cosTheta = pos[2]/radius;
+   double Phi = atan2(pos[1],pos[0]);
+   
+   if (Phi < 0.) Phi = Phi + TWOPI;
+   
+   // the sub-sector is kept inside the sector of the hit, also where rounding would move it to a neighbour
+   iPhiSplit = int( Phi/_dPhi*( 1 << split ) );
+   iThetaSplit = int( (cosTheta + double(1.0))/_dTheta*( 1 << split ) );
+   iPhiSplit = std::min( std::max( iPhiSplit, iPhi << split ), ( ( iPhi + 1 ) << split ) - 1 );
+   iThetaSplit = std::min( std::max( iThetaSplit, iTheta << split ), ( ( iTheta + 1 ) << split ) - 1 );
+   
+}
+
+
+int DDCellsAutomatonMV::maxHitsInSplitSector( int sector, const SplitSectorConnector& connector ) const {
+   
+   std::map< int , EVENT::TrackerHitVec >::const_iterator it = _map_sector_spacepoints.find( sector );
+   if( it == _map_sector_spacepoints.end() ) return 0;
+   
+   std::map< int , int > nHits;
+   int maxHits = 0;
+   
+   for( unsigned i=0; i<it->second.size(); i++ ){
+      
+      maxHits = std::max( maxHits, ++nHits[ splitSector( it->second[i], sector, connector ) ] );
+      
+   }
+   
+   return maxHits;
+   
+}
+
+
+void DDCellsAutomatonMV::getCutOffs( const std::string& critName, unsigned round, float& min, float& max ){
+   
+   // as in setCriteria
+   const std::vector<float>& minima = _critMinima[critName];
+   const std::vector<float>& maxima = _critMaxima[critName];
+   
+   min = round < minima.size() ? minima[round] : minima.back();
+   max = round < maxima.size() ? maxima[round] : maxima.back();
+   
+}
+
+
+void DDCellsAutomatonMV::setLoosestCriteria(){
+   
+   for ( unsigned i=0; i< _crit2LooseVec.size(); i++) delete _crit2LooseVec[i];
+   _crit2LooseVec.clear();
+   _crit2LooseNames.clear();
+   _crit2LooseMin.clear();
+   _crit2LooseMax.clear();
+   
+   _nCriteriaRounds = 0;
+   
+   for( unsigned i=0; i<_criteriaNames.size(); i++ ){
+      
+      std::string critName = _criteriaNames[i];
+      
+      const std::vector<float>& minima = _critMinima[critName];
+      const std::vector<float>& maxima = _critMaxima[critName];
+      
+      _nCriteriaRounds = std::max( _nCriteriaRounds, unsigned( std::max( minima.size(), maxima.size() ) ) );
+      
+      // the smallest minimum and largest maximum accept every connection of any round
+      float min = *std::min_element( minima.begin(), minima.end() );
+      float max = *std::max_element( maxima.begin(), maxima.end() );
+      
+      ICriterion* crit = Criteria::createCriterion( critName, min , max );
+      
+      if( crit->getType() == "2Hit" ){
+         
+         streamlog_out(DEBUG4) << "Loosest criterion " << critName << ": Min = " << min << ", Max = " << max << "\n";
+         
+         // the criterion keeps the value it cuts on, buildConnectionTable reads it
+         crit->setSaveValues( true );
+         
+         _crit2LooseVec.push_back( crit );
+         _crit2LooseNames.push_back( critName );
+         _crit2LooseMin.push_back( min );
+         _crit2LooseMax.push_back( max );
+         
+      }
+      else delete crit;
+      
+   }
+   
+   _roundIsLoosest.assign( _nCriteriaRounds, true );
+   
+   for( unsigned round=0; round<_nCriteriaRounds; round++ ){
+      
+      for( unsigned k=0; k<_crit2LooseNames.size(); k++ ){
+         
+         float min = 0.;
+         float max = 0.;
+         getCutOffs( _crit2LooseNames[k], round, min, max );
+         
+         if( min != _crit2LooseMin[k] || max != _crit2LooseMax[k] ) _roundIsLoosest[round] = false;
+         
+      }
+      
+      streamlog_out(DEBUG4) << "Round " << round << ( _roundIsLoosest[round] ? " uses" : " does not use" ) << " the loosest 2-hit cut offs\n";
+      
+   }
+   
+}
+
+
+void DDCellsAutomatonMV::buildConnectionTable( Automaton& graph, ConnectionTable& table ){
+   
+   std::vector< const Segment* > segments = graph.getSegments();
+   const unsigned nSegments = segments.size();
+   const unsigned nCriteria = _crit2LooseVec.size();
+   
+   // the segments sorted by address, to find the index of a child or parent
+   std::vector< std::pair< const Segment* , int > > segmentIndex( nSegments );
+   for( unsigned i=0; i<nSegments; i++ ) segmentIndex[i] = std::make_pair( segments[i] , int(i) );
+   std::sort( segmentIndex.begin(), segmentIndex.end() );
+   
+   table.hits.resize( nSegments );
+   table.layers.resize( nSegments );
+   table.parent.clear();
+   table.child.clear();
+   table.values.clear();
+   
+   // the connections of segment i are childBegin[i] to childBegin[i+1]-1
+   std::vector< int > childBegin( nSegments + 1 );
+   
+   for( unsigned i=0; i<nSegments; i++ ){
+      
+      Segment* segment = const_cast< Segment* >( segments[i] );
+      
+      table.hits[i] = segment->getHits();
+      table.layers[i] = segment->getLayer();
+      childBegin[i] = table.parent.size();
+      
+      std::list< Segment* > children = segment->getChildren();
+      
+      for( std::list< Segment* >::iterator itChild = children.begin(); itChild != children.end(); ++itChild ){
+         
+         std::vector< std::pair< const Segment* , int > >::const_iterator itIndex =
+         std::lower_bound( segmentIndex.begin(), segmentIndex.end(), std::make_pair( (const Segment*) *itChild , INT_MIN ) );
+         
+         table.parent.push_back( i );
+         table.child.push_back( itIndex->second );
+         
+         // The value a criterion cuts on is the single entry of its map of values. It has to lie inside of the
+         // loosest cut offs, which the connection passed, otherwise the criterion is evaluated in every round.
+         for( unsigned k=0; k<nCriteria; k++ ){
+            
+            _crit2LooseVec[k]->areCompatible( segment , *itChild );
+            std::map< std::string , float > values = _crit2LooseVec[k]->getMapOfValues();
+            
+            float value = std::numeric_limits<float>::quiet_NaN();
+            if( values.size() == 1 ){
+               
+               float saved = values.begin()->second;
+               if( saved >= _crit2LooseMin[k] && saved <= _crit2LooseMax[k] ) value = saved;
+               
+            }
+            
+            table.values.push_back( value );
+            
+         }
+         
+      }
+      
+   }
+   
+   childBegin[nSegments] = table.parent.size();
+   
+   // the connections to the parents, in the order of the parents of each segment
+   table.parentBegin.resize( nSegments + 1 );
+   table.parentConnections.clear();
+   
+   for( unsigned i=0; i<nSegments; i++ ){
+      
+      Segment* segment = const_cast< Segment* >( segments[i] );
+      
+      table.parentBegin[i] = table.parentConnections.size();
+      
+      std::list< Segment* > parents = segment->getParents();
+      
+      for( std::list< Segment* >::iterator itParent = parents.begin(); itParent != parents.end(); ++itParent ){
+         
+         int p = std::lower_bound( segmentIndex.begin(), segmentIndex.end(), std::make_pair( (const Segment*) *itParent , INT_MIN ) )->second;
+         
+         for( int c = childBegin[p]; c < childBegin[p+1]; c++ ){
+            
+            if( table.child[c] == int(i) ){
+               
+               table.parentConnections.push_back( c );
+               break;
+               
+            }
+            
+         }
+         
+      }
+      
+   }
+   
+   table.parentBegin[nSegments] = table.parentConnections.size();
+   
+}
+
+
+void DDCellsAutomatonMV::filterConnections( const ConnectionTable& table, unsigned round, Automaton& automaton ){
+   
+   const unsigned nSegments = table.hits.size();
+   const unsigned nConnections = table.parent.size();
+   const unsigned nCriteria = _crit2LooseVec.size();
+   
+   std::vector< float > min( nCriteria );
+   std::vector< float > max( nCriteria );
+   for( unsigned k=0; k<nCriteria; k++ ) getCutOffs( _crit2LooseNames[k], round, min[k], max[k] );
+   
+   // new segments, the automaton takes ownership of them
+   std::vector< Segment* > segments( nSegments );
+   
+   for( unsigned i=0; i<nSegments; i++ ){
+      
+      segments[i] = new Segment( table.hits[i] );
+      segments[i]->setLayer( table.layers[i] );
+      automaton.addSegment( segments[i] );
+      
+   }
+   
+   // keep the connections passing the cut offs of this round, in the order of the table
+   std::vector< char > accepted( nConnections, 0 );
+   
+   for( unsigned c=0; c<nConnections; c++ ){
+      
+      Segment* parent = segments[ table.parent[c] ];
+      Segment* child = segments[ table.child[c] ];
+      
+      bool compatible = true;
+      
+      for( unsigned k=0; k<nCriteria && compatible; k++ ){
+         
+         const float value = table.values[ c * nCriteria + k ];
+         
+         if( std::isnan( value ) ) compatible = _crit2Vec[k]->areCompatible( parent , child );
+         else compatible = value >= min[k] && value <= max[k];
+         
+      }
+      
+      if( compatible ){
+         
+         parent->addChild( child );
+         accepted[c] = 1;
+         
+      }
+      
+   }
+   
+   for( unsigned i=0; i<nSegments; i++ ){
+      
+      for( int j = table.parentBegin[i]; j < table.parentBegin[i+1]; j++ ){
+         
+         const int c = table.parentConnections[j];
+         if( accepted[c] ) segments[i]->addParent( segments[ table.parent[c] ] );
+         
+      }
+      
+   }
+   
+}
+
+
 void DDCellsAutomatonMV::finaliseTrack( TrackImpl* trackImpl ){
       
 
@@ -1396,7 +1914,7 @@ void DDCellsAutomatonMV::finaliseTrack( TrackImpl* trackImpl ){
 }
 
 
-double DDCellsAutomatonMV::Dist( EVENT::TrackerHit *toHit, EVENT::TrackerHit *fromHit ) {
+double DDCellsAutomatonMV::Dist( EVENT::TrackerHit *toHit, EVENT::TrackerHit *fromHit ) const {
 
   const double *posOuter = fromHit->getPosition();
   const double *posInner = toHit->getPosition();
@@ -1410,51 +1928,15 @@ double DDCellsAutomatonMV::Dist( EVENT::TrackerHit *toHit, EVENT::TrackerHit *fr
 }
 
 
-bool DDCellsAutomatonMV::thetaAgreementImproved( EVENT::TrackerHit *toHit, EVENT::TrackerHit *fromHit, int layer ) {
+bool DDCellsAutomatonMV::thetaAgreementImproved( double theta_inn, double theta_out, int layer ) const {
 
   // Improved error estimation of polar angle theta, taking into account the uncertainty of the radius as well...
   // also the single point resolution is not hard-coded any more
 
   bool agreement = false ;
 
-  //double resolution = 0.004 ; // just temporarily here
-  double MPS_factor = 0.0 ;  // just for test, and only for vertical muons of 4GeV
-
-  double  pos_outer[3];
-  double  pos_inner[3];
-
-  pos_outer[0] = fromHit->getPosition()[0];
-  pos_outer[1] = fromHit->getPosition()[1];
-  pos_outer[2] = fromHit->getPosition()[2];
-  double radout = sqrt(pos_outer[0]*pos_outer[0]+pos_outer[1]*pos_outer[1]);
-  //  double theta_out = (180.0 * atan(radout/pos_outer[2])) / M_PI ;
-  //BEFORE BAD RANGE - at 90deg possible flip of sign -- fixed track ineff, still bad track
-  double theta_out = atan2(radout,pos_outer[2]);
-  theta_out = 2*M_PI-theta_out;
-  //theta_out = theta_out % (2*M_PI);
-  //theta_out = fmod(theta_out,2*M_PI);
-  while(theta_out>=2*M_PI){
-    theta_out = theta_out - 2*M_PI; 
-  }
-  theta_out = theta_out*180./M_PI;
-
-  pos_inner[0] = toHit->getPosition()[0];
-  pos_inner[1] = toHit->getPosition()[1];
-  pos_inner[2] = toHit->getPosition()[2];
-  double radinn = sqrt(pos_inner[0]*pos_inner[0]+pos_inner[1]*pos_inner[1]);
-  //double theta_inn = (180.0 *atan(radinn/pos_inner[2])) / M_PI;
-  //BEFORE BAD RANGE - at 90deg possible flip of sign -- fixed track ineff, still bad track
-  double theta_inn = atan2(radinn,pos_inner[2]);
-  theta_inn = 2*M_PI-theta_inn;
-  while(theta_inn>=2*M_PI){
-    theta_inn = theta_inn - 2*M_PI; 
-  }
-  theta_inn = theta_inn*180./M_PI;
-
   double  diff_theta = fabs ( theta_out - theta_inn ) ;
 
-  streamlog_out(DEBUG4) << "Theta of outer hit " << theta_out << " Theta of inner hit " << theta_inn << " Theta diff between the adjacent hits " << diff_theta << " maximum value " << _hitPairThDiff << std::endl ;
-
   /*  
   int celId_inner = toHit->getCellID0() ;
   UTIL::BitField64 encoder( lcio::ILDCellID0::encoder_string ) ; 
@@ -155,6 +155,16 @@ ExtrToTracker::ExtrToTracker() : Processor("ExtrToTracker") {
                              _performFinalRefit,
                              bool(false));  
 
+  registerProcessorParameter( "TimeStages",
+                             "Measure the time spent in the main processing stages and print a summary per run in end()",
+                             _timeStages,
+                             bool(false));
+  
+  registerProcessorParameter( "StageTimingCSVFile",
+                             "If set together with TimeStages, write the stage times and counters of every event to this CSV file",
+                             _stageTimingCSVFile,
+                             std::string(""));
+
 }
 
 
@@ -203,6 +213,13 @@ void ExtrToTracker::init() {
 
   //_maxChi2PerHit = 100;
   _maxChi2PerHit = _Max_Chi2_Incr;
+
+  _timers.init( name(), _timeStages, _stageTimingCSVFile );
+  _stageFillHitMaps = _timers.addStage( "FillHitMaps" );
+  _stageExtrapolation = _timers.addStage( "Extrapolation" );
+  _stageNotUsedHits = _timers.addStage( "NotUsedHits" );
+  _countInputTracks = _timers.addCounter( "InputTracks" );
+  _countOutputTracks = _timers.addCounter( "OutputTracks" );
     
 }
 
@@ -225,6 +242,8 @@ void ExtrToTracker::processEvent( LCEvent * evt ) {
   
 
 
+  _timers.startEvent( evt->getRunNumber(), evt->getEventNumber() );
+
   // get input collection and relations 
   LCCollection* input_track_col = this->GetCollection( evt, _input_track_col_name ) ;
 
@@ -234,8 +253,10 @@ void ExtrToTracker::processEvent( LCEvent * evt ) {
 
     ////////////////////////
 
+    StageTimers::Scope timeFillHitMaps( _timers, _stageFillHitMaps );
     fillVecSubdet(evt);
     fillMapElHits(_vecDigiHitsCol, _vecMapsElHits);
+    timeFillHitMaps.stop();
 
     ////////////////////////
 
@@ -251,6 +272,8 @@ void ExtrToTracker::processEvent( LCEvent * evt ) {
     
     int nTracks = input_track_col->getNumberOfElements()  ;
 
+    _timers.count( _countInputTracks, nTracks );
+
     streamlog_out(DEBUG4) << " ######### NO OF TRACKS $$$$$$$$$$ " << nTracks << std::endl;
 
     LCCollectionVec* inputTrackVec = new LCCollectionVec( LCIO::TRACK )  ; 
@@ -267,6 +290,8 @@ void ExtrToTracker::processEvent( LCEvent * evt ) {
     //std::sort( inputTrackVec->begin() , inputTrackVec->end() ,  InversePtSort()  ) ;
 
 
+    StageTimers::Scope timeExtrapolation( _timers, _stageExtrapolation );
+
     // loop over the input tracks and refit using KalTest    
     for(int i=0; i< nTracks ; ++i) {
 
@@ -650,6 +675,9 @@ void ExtrToTracker::processEvent( LCEvent * evt ) {
       delete marlin_trk;
       
     }    // for loop to the tracks 
+
+    timeExtrapolation.stop();
+    _timers.count( _countOutputTracks, trackVec->getNumberOfElements() );
     
     //-------------------------------------------------------------------------------------------------------		
    
@@ -665,6 +693,8 @@ void ExtrToTracker::processEvent( LCEvent * evt ) {
     // Save not used hits in a collection for possible further use //
     /////////////////////////////////////////////////////////////////
 
+    StageTimers::Scope timeNotUsedHits( _timers, _stageNotUsedHits );
+
     LCCollectionVec* notUsedHitsVec = new LCCollectionVec( LCIO::TRACKERHITPLANE );    
     CellIDEncoder<TrackerHitPlaneImpl> cellid_encoder( lcio::ILDCellID0::encoder_string, notUsedHitsVec ) ;  //do not change it, code will not work with a different encoder
     notUsedHitsVec->setSubset(true);
@@ -680,6 +710,8 @@ void ExtrToTracker::processEvent( LCEvent * evt ) {
     }//end loops on vector of maps - one for each subdetector
                         
     evt->addCollection( notUsedHitsVec , _output_not_used_col_name ) ;
+
+    timeNotUsedHits.stop();
     
     //delete notUsedHitsVec;
 
@@ -687,6 +719,8 @@ void ExtrToTracker::processEvent( LCEvent * evt ) {
 
   }// track collection no empty  
   
+  _timers.endEvent();
+
   ++_n_evt ;
   
   //cout << " event " << _n_evt << std::endl ;
@@ -709,6 +743,8 @@ void ExtrToTracker::end(){
 		       << " processed " << _n_evt << " events in " << _n_run << " runs "
 		       << std::endl ;
 
+  _timers.printSummary();
+
   streamlog_out(DEBUG4) << " SIT hits considered for track-hit association " << TotalSITHits << " how many of them were matched and fitted successfully ? " << SITHitsFitted << " for how many the fit failed ? " << SITHitsNonFitted << std::endl ;
 
 
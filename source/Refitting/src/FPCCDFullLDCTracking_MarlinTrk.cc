@@ -18,6 +18,7 @@
 #include <map>
 #include <marlin/Global.h>
 #include "ClusterShapes.h"
+#include "HelixDistanceBatch.h"
 
 #include <gear/GEAR.h>
 #include <gear/GearParameters.h>
@@ -4011,6 +4012,37 @@ void FPCCDFullLDCTracking_MarlinTrk::CleanUpExtrapolations() {
 }
 
 
+namespace {
+  
+  /** hit and track within the distance cut, ordered like a loop over the hits and then over the tracks */
+  struct HitTrackCandidate {
+    int iHit;
+    int iTrk;
+    float distance;
+    bool operator<( const HitTrackCandidate& other ) const {
+      return iHit < other.iHit || ( iHit == other.iHit && iTrk < other.iTrk );
+    }
+  };
+  
+  /** positions of the hits as contiguous float arrays for HelixDistanceBatch */
+  void fillHitPositions( const TrackerHitExtendedVec& hitVec, std::vector<float>& x, std::vector<float>& y, std::vector<float>& z, std::vector<int>& idx ) {
+    int nHits = int(hitVec.size());
+    x.resize(nHits);
+    y.resize(nHits);
+    z.resize(nHits);
+    idx.resize(nHits);
+    for (int iH=0;iH<nHits;++iH) {
+      const double* pos = hitVec[iH]->getTrackerHit()->getPosition();
+      x[iH] = float(pos[0]);
+      y[iH] = float(pos[1]);
+      z[iH] = float(pos[2]);
+      idx[iH] = iH;
+    }
+  }
+  
+}
+
+
 void FPCCDFullLDCTracking_MarlinTrk::AssignOuterHitsToTracks(TrackerHitExtendedVec hitVec, float dcut, int refit) {
 
   streamlog_out(DEBUG3) << "FPCCDFullLDCTracking_MarlinTrk::AssignOuterHitsToTracks dcut = " << dcut << std::endl;
@@ -4030,56 +4062,69 @@ void FPCCDFullLDCTracking_MarlinTrk::AssignOuterHitsToTracks(TrackerHitExtendedV
   flagHit.clear();
   pairs.clear();
   
-  // loop over all hits under consideration ...
-  for (int iH=0;iH<nHits;++iH) {
-
-    float pos[3];
+  // hit positions as contiguous arrays, so that each helix is compared to all hits in one batch
+  std::vector<float> hitX, hitY, hitZ;
+  std::vector<int> hitsSameHalf;
+  fillHitPositions(hitVec, hitX, hitY, hitZ, hitsSameHalf);
+  
+  std::vector<HitTrackCandidate> candidates;
+  std::vector<int> closeHits;
+  std::vector<float> closeDistances;
+  HelixDistanceBatch distanceBatch;
+  
+  // loop over all tracks ...
+  for (int iT=0;iT<nTrk;++iT) {
     
-    TrackerHitExtended * trkHitExt = hitVec[iH];
-    TrackerHit * hit = trkHitExt->getTrackerHit();
+    TrackExtended * trkExt = _trkImplVec[iT];
+    
+    // use the previously created trackextrapolations for the
+    HelixClass * helix = _trackExtrapolatedHelix[trkExt];
     
-    for (int ip=0;ip<3;++ip) {
-      pos[ip] = float(hit->getPosition()[ip]);
+    // skip if the extrapolations failed
+    if (helix==0) {
+      streamlog_out(DEBUG3) << "helix extrapolation failed for trkExt" << std::endl;
+      continue;
     }
-            
-    // loop over all tracks in same z-half ...
-    for (int iT=0;iT<nTrk;++iT) {
-      
-      TrackExtended * trkExt = _trkImplVec[iT];
-      float tanLambda = trkExt->getTanLambda();           
-      float product = pos[2]*tanLambda;
-      // check that the hit and track are in the same z-half, which won't work for the rare cases of something going backwards ...
-      
-      if (product>0) {
-      
-        // use the previously created trackextrapolations for the
-        HelixClass * helix = _trackExtrapolatedHelix[trkExt];
-        
-        // skip if the extrapolations failed
-        if (helix==0) {
-          streamlog_out(DEBUG3) << "helix extrapolation failed for trkExt" << std::endl;
-          continue;
-        }
-        
-        float distance = helix->getDistanceToPoint(pos,dcut);
-        
-        streamlog_out(DEBUG1) << "for helix extrapolation " << helix << " distance = " << distance << std::endl;
-        
-        // check the distance is less than the steerable cut ...
-        if (distance<dcut) {
-
-          streamlog_out(DEBUG3) << "for helix extrapolation " << helix << " distance = " << distance << std::endl;
-          
-          // ... if so create the association and flag the hit and track
-          TrackHitPair * trkHitPair =
-          new TrackHitPair(trkExt,trkHitExt,distance);
-          pairs.push_back(trkHitPair);
-          flagTrack[trkExt] = true;
-          flagHit[trkHitExt] = true;
-
-        }
-      }
+    
+    // ... and all hits in the same z-half, which won't work for the rare cases of something going backwards ...
+    float tanLambda = trkExt->getTanLambda();
+    hitsSameHalf.clear();
+    for (int iH=0;iH<nHits;++iH) {
+      if (hitZ[iH]*tanLambda>0) hitsSameHalf.push_back(iH);
+    }
+    
+    // check the distance is less than the steerable cut ...
+    closeHits.clear();
+    closeDistances.clear();
+    distanceBatch.select(*helix, hitX, hitY, hitZ, hitsSameHalf, dcut, closeHits, closeDistances);
+    
+    for (unsigned k=0;k<closeHits.size();++k) {
+      HitTrackCandidate candidate;
+      candidate.iHit = closeHits[k];
+      candidate.iTrk = iT;
+      candidate.distance = closeDistances[k];
+      candidates.push_back(candidate);
     }
+    
+  }
+  
+  // keep the order of creation of the pairs as for a loop over the hits and then over the tracks
+  std::sort(candidates.begin(), candidates.end());
+  
+  for (unsigned iC=0;iC<candidates.size();++iC) {
+    
+    TrackExtended * trkExt = _trkImplVec[candidates[iC].iTrk];
+    TrackerHitExtended * trkHitExt = hitVec[candidates[iC].iHit];
+    
+    streamlog_out(DEBUG3) << "for helix extrapolation " << _trackExtrapolatedHelix[trkExt] << " distance = " << candidates[iC].distance << std::endl;
+    
+    // ... if so create the association and flag the hit and track
+    TrackHitPair * trkHitPair =
+    new TrackHitPair(trkExt,trkHitExt,candidates[iC].distance);
+    pairs.push_back(trkHitPair);
+    flagTrack[trkExt] = true;
+    flagHit[trkHitExt] = true;
+    
   }
   
   int nPairs = int(pairs.size());
@@ -4451,6 +4496,15 @@ void FPCCDFullLDCTracking_MarlinTrk::AssignTPCHitsToTracks(TrackerHitExtendedVec
     HitSign[iH]=std::signbit(temppos[2]);
   }    
   
+  // hit positions as contiguous arrays, so that each helix is compared to the hits in one batch
+  std::vector<float> hitX, hitY, hitZ;
+  std::vector<int> consideredHits;
+  fillHitPositions(hitVec, hitX, hitY, hitZ, consideredHits);
+  
+  std::vector<int> closeHits;
+  std::vector<float> closeDistances;
+  HelixDistanceBatch distanceBatch;
+  
   streamlog_out(DEBUG3) << "AssignTPCHitsToTracks: Starting loop " << nTrk << " tracks   and  " << nHits << " hits" << std::endl;
   
   for (int iT=0;iT<nTrk;++iT) { // loop over all tracks
@@ -4473,6 +4527,8 @@ void FPCCDFullLDCTracking_MarlinTrk::AssignTPCHitsToTracks(TrackerHitExtendedVec
       helix.Initialize_Canonical(phi0,d0,z0,omega,tanLambda,_bField);
       float OnePFivehalfPeriodZ = 1.5*fabs(acos(-1.)*tanLambda/omega);
       
+      consideredHits.clear();
+      
       for (int iH=0;iH<nHits;++iH) { // loop over leftover TPC hits
         
         //check if the hit and the track or on the same side
@@ -4485,14 +4541,19 @@ void FPCCDFullLDCTracking_MarlinTrk::AssignTPCHitsToTracks(TrackerHitExtendedVec
         consider = consider || (DeltaEnd <= OnePFivehalfPeriodZ);
         consider = consider || ( (HitPositions[iH][2]>=startPointZ) && (HitPositions[iH][2]<=endPointZ) );
         
-        if(consider){
-          float distance = helix.getDistanceToPoint(HitPositions[iH], minDistances[iH]);
-          if (distance < minDistances[iH]) {
-            minDistances[iH] = distance;
-            tracksToAttach[iH] = foundTrack;
-          }
-        }
+        if(consider) consideredHits.push_back(iH);
+        
       } // loop over leftover TPC hits
+      
+      // each hit appears once per helix, so the current closest distance of each hit is the cut
+      closeHits.clear();
+      closeDistances.clear();
+      distanceBatch.select(helix, hitX, hitY, hitZ, consideredHits, minDistances, closeHits, closeDistances);
+      
+      for (unsigned k=0;k<closeHits.size();++k) {
+        minDistances[closeHits[k]] = closeDistances[k];
+        tracksToAttach[closeHits[k]] = foundTrack;
+      }
     } //groups in tracks
   } // loop over all tracks
   
@@ -4587,49 +4648,68 @@ void FPCCDFullLDCTracking_MarlinTrk::AssignSiHitsToTracks(TrackerHitExtendedVec
   flagHit.clear();
   pairs.clear();
   
-  for (int iH=0;iH<nHits;++iH) {
+  // hit positions as contiguous arrays, so that each helix is compared to all hits in one batch
+  std::vector<float> hitX, hitY, hitZ;
+  std::vector<int> hitsSameHalf;
+  fillHitPositions(hitVec, hitX, hitY, hitZ, hitsSameHalf);
+  
+  std::vector<HitTrackCandidate> candidates;
+  std::vector<int> closeHits;
+  std::vector<float> closeDistances;
+  HelixDistanceBatch distanceBatch;
+  
+  for (int iT=0;iT<nTrk;++iT) {
     
-    float pos[3];
-    TrackerHitExtended * trkHitExt = hitVec[iH];
-    TrackerHit * hit = trkHitExt->getTrackerHit();
+    TrackExtended * trkExt = _allNonCombinedTPCTracks[iT];
+    
+    float d0 = trkExt->getD0();
+    float z0 = trkExt->getZ0();
+    float phi0 = trkExt->getPhi();
+    float omega = trkExt->getOmega();
+    float tanLambda = trkExt->getTanLambda();
     
-    for (int ip=0;ip<3;++ip) {
-      pos[ip] = float(hit->getPosition()[ip]);
+    // only hits in the same z-half as the track
+    hitsSameHalf.clear();
+    for (int iH=0;iH<nHits;++iH) {
+      if (hitZ[iH]*tanLambda>0) hitsSameHalf.push_back(iH);
     }
     
-    for (int iT=0;iT<nTrk;++iT) {
-      
-      TrackExtended * trkExt = _allNonCombinedTPCTracks[iT];
-      
-      float tanLambda = trkExt->getTanLambda();       
-      float product = pos[2]*tanLambda;
-      
-      streamlog_out(DEBUG0) << "AssignSiHitsToTracks : product =  " << product << " z hit = " << pos[2] <<  std::endl;
-      
-      
-      if (product>0) {
-        
-        float d0 = trkExt->getD0();
-        float z0 = trkExt->getZ0();
-        float phi0 = trkExt->getPhi();
-        float omega = trkExt->getOmega();
-        tanLambda = trkExt->getTanLambda();
-        
-        HelixClass helix;
-        helix.Initialize_Canonical(phi0,d0,z0,omega,tanLambda,_bField);
-        float distance = helix.getDistanceToPoint(pos,dcut);
-        
-        streamlog_out(DEBUG0) << "AssignSiHitsToTracks : distance =  " << distance << " cut = " << dcut << std::endl;
-        
-        if (distance<dcut) {
-          TrackHitPair * trkHitPair = 
-          new TrackHitPair(trkExt,trkHitExt,distance);
-          pairs.push_back(trkHitPair);
-          flagTrack[trkExt] = true;
-          flagHit[trkHitExt] = true;
-        }
-      }
+    if (hitsSameHalf.empty()) continue;
+    
+    // the helix is created once per track instead of once per hit and track
+    HelixClass helix;
+    helix.Initialize_Canonical(phi0,d0,z0,omega,tanLambda,_bField);
+    
+    closeHits.clear();
+    closeDistances.clear();
+    distanceBatch.select(helix, hitX, hitY, hitZ, hitsSameHalf, dcut, closeHits, closeDistances);
+    
+    for (unsigned k=0;k<closeHits.size();++k) {
+      HitTrackCandidate candidate;
+      candidate.iHit = closeHits[k];
+      candidate.iTrk = iT;
+      candidate.distance = closeDistances[k];
+      candidates.push_back(candidate);
     }
+    
+  }
+  
+  // keep the order of creation of the pairs as for a loop over the hits and then over the tracks
+  std::sort(candidates.begin(), candidates.end());
+  
+  for (unsigned iC=0;iC<candidates.size();++iC) {
+    
+    TrackExtended * trkExt = _allNonCombinedTPCTracks[candidates[iC].iTrk];
+    TrackerHitExtended * trkHitExt = hitVec[candidates[iC].iHit];
+    
+    streamlog_out(DEBUG0) << "AssignSiHitsToTracks : distance =  " << candidates[iC].distance << " cut = " << dcut << std::endl;
+    
+    TrackHitPair * trkHitPair = 
+    new TrackHitPair(trkExt,trkHitExt,candidates[iC].distance);
+    pairs.push_back(trkHitPair);
+    flagTrack[trkExt] = true;
+    flagHit[trkHitExt] = true;
+    
   }
   
   int nPairs = int(pairs.size());
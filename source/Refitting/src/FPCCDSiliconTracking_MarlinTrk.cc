@@ -11,6 +11,7 @@
 #include <IMPL/LCCollectionVec.h>
 #include <IMPL/LCRelationImpl.h>
 #include <IMPL/LCFlagImpl.h>
+#include <IMPL/TrackStateImpl.h>
 
 #include <iostream>
 #include <iomanip>
@@ -21,6 +22,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <climits>
+#include <memory>
 
 #include <marlin/Global.h>
 #include <marlin/Exceptions.h>
@@ -269,6 +271,11 @@ FPCCDSiliconTracking_MarlinTrk::FPCCDSiliconTracking_MarlinTrk() : Processor("FP
       _chi2FitCut_kalman,
       float(120.0));
 
+  registerProcessorParameter("IncrementalKalFit",
+      "Extend the fit of a growing track in BuildTrack_KalFit with addAndFit instead of refitting all its hits for every new hit. Ignored with SmoothOn, as the kept fit would already be smoothed. Not validated against the full refit yet",
+      _incrementalKalFit,
+      bool(false));
+
   registerProcessorParameter("AngleCutForMerging",
       "Angle Cut For Merging",
       _angleCutForMerging,
@@ -582,6 +589,11 @@ void FPCCDSiliconTracking_MarlinTrk::init() {
   _trksystem->setOption( IMarlinTrkSystem::CFG::useSmoothing,  _SmoothOn) ;
   _trksystem->init() ;  
 
+  if( _incrementalKalFit && _SmoothOn ){
+    streamlog_out(WARNING) << "FPCCDSiliconTracking_MarlinTrk : IncrementalKalFit is ignored with SmoothOn, the growing tracks are refitted with all their hits" << std::endl;
+    _incrementalKalFit = false;
+  }
+
 
   this->setupGearGeom(Global::GEAR);
 
@@ -605,6 +617,7 @@ void FPCCDSiliconTracking_MarlinTrk::init() {
 
   InitVXDGeometry();
   if(_useSIT == 1) InitSITGeometry();
+  InitIntersectionRadii();
 
   _output_track_col_quality = 0;
 
@@ -1092,6 +1105,8 @@ int FPCCDSiliconTracking_MarlinTrk::InitialiseVTX(LCEvent * evt) {
   _nTotalSITHits = 0;
   _sectors.clear();
   _sectors.resize(_nLayers*_nDivisionsInPhi*_nDivisionsInTheta);
+  _sectorClusterShapes.clear();
+  _sectorClusterShapes.resize(_sectors.size());
 
 
   // Reading out VTX Hits Collection
@@ -1168,6 +1183,7 @@ int FPCCDSiliconTracking_MarlinTrk::InitialiseVTX(LCEvent * evt) {
       int iTheta = int ((cosTheta + double(1.0))/_dTheta);
       int iCode = layer + _nLayers*iPhi + _nLayers*_nDivisionsInPhi*iTheta;      
       _sectors[iCode].push_back( hitExt );
+      _sectorClusterShapes[iCode].push_back( _useClusterRejection ? MakeClusterShape( hit ) : ClusterShape() );
 
       streamlog_out( DEBUG1 ) << " VXD Hit " <<  hit->id() << " added : @ " << pos[0] << " " << pos[1] << " " << pos[2] << " drphi " << hitExt->getResolutionRPhi() << " dz " << hitExt->getResolutionZ() << "  iPhi = " << iPhi <<  " iTheta "  << iTheta << " iCode = " << iCode << "  layer = " << layer << std::endl;  
 
@@ -1314,6 +1330,7 @@ int FPCCDSiliconTracking_MarlinTrk::InitialiseVTX(LCEvent * evt) {
         int iTheta = int ((cosTheta + double(1.0))/_dTheta);
         int iCode = layer + _nLayers*iPhi + _nLayers*_nDivisionsInPhi*iTheta;      
         _sectors[iCode].push_back( hitExt );
+        _sectorClusterShapes[iCode].push_back( ClusterShape() );
 
         streamlog_out( DEBUG1 ) << " SIT Hit " <<  trkhit->id() << " added : @ " << pos[0] << " " << pos[1] << " " << pos[2] << " drphi " << hitExt->getResolutionRPhi() << " dz " << hitExt->getResolutionZ() << "  iPhi = " << iPhi <<  " iTheta "  << iTheta << " iCode = " << iCode << "  layer = " << layer << std::endl;  
 
@@ -1755,7 +1772,8 @@ int FPCCDSiliconTracking_MarlinTrk::BuildTrack_KalFit(TrackerHitExtended * outer
     TrackExtended * trackAR) {
 
   
-
+  // fit of the hits of trackAR, extended by one filter step for every further hit
+  std::unique_ptr<MarlinTrk::IMarlinTrack> keptFit;
 
   int nMisAssign = 0;
   for (int layer = innerLayer-1; layer>=0; layer--) { // loop over remaining layers
@@ -1776,6 +1794,11 @@ int FPCCDSiliconTracking_MarlinTrk::BuildTrack_KalFit(TrackerHitExtended * outer
     float distMin = 1.0e+20;
     TrackerHitExtended * assignedhit = NULL;
 
+    // the innermost hit only changes when a hit is assigned, its cluster is compared to whole sectors at once
+    TrackerHit* curInMostHit = trackAR->getTrackerHitExtendedVec().back()->getTrackerHit();
+    ClusterShape curInMostCluster;
+    if(_useClusterRejection == true) curInMostCluster = MakeClusterShape(curInMostHit);
+
     if(Boundaries[2] < 0) Boundaries[2] = 0;
     if(Boundaries[3] >= _nDivisionsInTheta) Boundaries[3] = _nDivisionsInTheta - 1;
 
@@ -1788,23 +1811,29 @@ int FPCCDSiliconTracking_MarlinTrk::BuildTrack_KalFit(TrackerHitExtended * outer
         int iCode = layer + _nLayers*iPhiInner +  _nLayers*_nDivisionsInPhi*itInner;
         TrackerHitExtendedVec& hitVecInner = _sectors[iCode];
         int nHitsInner = int(hitVecInner.size());
+        if(_useClusterRejection == true && nHitsInner > 0){
+          _clusterCompatible.resize(nHitsInner);
+          CheckClusterCompatibility(curInMostCluster, &_sectorClusterShapes[iCode][0], nHitsInner, &_clusterCompatible[0]);
+        }
         for (int iInner=0;iInner<nHitsInner;iInner++) { 
           TrackerHitExtended * currentHit = hitVecInner[iInner];
           double pos[3]; double distance[3];
           for (int i=0; i<3; ++i) { pos[i] = double(currentHit->getTrackerHit()->getPosition()[i]); }
 
-          int tiltStatus = 0;
-          double dot = 0;
+          bool goodCluster = true;
 
-          if(_useClusterRejection == true){
-            TrackerHit* curInMostHit = trackAR->getTrackerHitExtendedVec().back()->getTrackerHit();
-            tiltStatus = CheckTiltOf2Clusters(curInMostHit, currentHit->getTrackerHit(), 1);
+          if(_useClusterRejection == true && _clusterCompatible[iInner] >= 0){
+            goodCluster = _clusterCompatible[iInner] == 1;
+          }
+          else if(_useClusterRejection == true){
+            int tiltStatus = CheckTiltOf2Clusters(curInMostHit, currentHit->getTrackerHit(), 1);
             //In BuildTrack, in this case the first and second arguments are 
             //always VXD, so needless to check which it is VXD or SIT hit.
-            dot = DotOf2Clusters(curInMostHit,currentHit->getTrackerHit());
+            double dot = DotOf2Clusters(curInMostHit,currentHit->getTrackerHit());
+            bool goodDot = (dot > _minDotOf2Clusters) ? true : false ;
+            goodCluster = tiltStatus >= 0 && goodDot == true;
           }
-          bool goodDot = (dot > _minDotOf2Clusters) ? true : false ;
-          if( _useClusterRejection == false || (tiltStatus >= 0 && goodDot == true) ){
+          if( goodCluster == true ){
             double time = helix.getDistanceToPoint(pos,distance);    
             if (time < 1.0e+10) {
               if (distance[2] < distMin) { // distance[2] = sqrt( d0*d0 + z0*z0 ) 
@@ -1828,16 +1857,26 @@ int FPCCDSiliconTracking_MarlinTrk::BuildTrack_KalFit(TrackerHitExtended * outer
       float Chi2;
       TrackerHitExtendedVec& hvec = trackAR->getTrackerHitExtendedVec();
       bool validCombination = 0;
+      bool assignedHitIsOutlier = false;
 
-      TrackerHitVec trkHits;
-      trkHits.reserve(hvec.size() + 1);
-      trkHits.push_back( assignedhit->getTrackerHit() );
-      for(int ij = int(hvec.size()) - 1 ; ij >= 0 ; ij--){
-        trkHits.push_back(hvec[ij]->getTrackerHit());
-      }
       TrackerHitVec hits_in_fit;
       TrackerHitVec outliers;
-      int error_KalFit = KalFit(ndf,Chi2,trkHits,hits_in_fit,outliers,par,epar,helix);
+      int error_KalFit = 0;
+
+      if(keptFit.get() != 0){
+        error_KalFit = KalFitAddHit(keptFit.get(),assignedhit->getTrackerHit(),ndf,Chi2,outliers,par,epar,helix);
+      }
+      else{
+        TrackerHitVec trkHits;
+        trkHits.reserve(hvec.size() + 1);
+        trkHits.push_back( assignedhit->getTrackerHit() );
+        for(int ij = int(hvec.size()) - 1 ; ij >= 0 ; ij--){
+          trkHits.push_back(hvec[ij]->getTrackerHit());
+        }
+        MarlinTrk::IMarlinTrack* fit = 0;
+        error_KalFit = KalFit(ndf,Chi2,trkHits,hits_in_fit,outliers,par,epar,helix, _incrementalKalFit ? &fit : 0);
+        keptFit.reset(fit);
+      }
 
       if(error_KalFit != 0){
         validCombination = 0;
@@ -1863,6 +1902,7 @@ int FPCCDSiliconTracking_MarlinTrk::BuildTrack_KalFit(TrackerHitExtended * outer
           TrackerHitVec::iterator iter = std::find(outliers.begin(),outliers.end(),assignedhit->getTrackerHit());
           if(iter != outliers.end()){
             outliers.erase(iter); 
+            assignedHitIsOutlier = true;
             validCombination = 0;
             nMisAssign -= 1;//Unless this is here, nMisAssign will be double-counted. 
           }
@@ -1870,7 +1910,11 @@ int FPCCDSiliconTracking_MarlinTrk::BuildTrack_KalFit(TrackerHitExtended * outer
       }
 
 
-      if ( validCombination == 0 ) nMisAssign++; 
+      if ( validCombination == 0 ){
+        nMisAssign++; 
+        // the kept fit must not contain a hit which is not on the track
+        if( !assignedHitIsOutlier ) keptFit.reset();
+      }
       else{
         // assign hit to track and track to hit, update the track parameters
         trackAR->addTrackerHitExtended(assignedhit);
@@ -1944,35 +1988,64 @@ int FPCCDSiliconTracking_MarlinTrk::getIntersectionEasy(HelixClass_double& helix
 
 
 
+void FPCCDSiliconTracking_MarlinTrk::InitIntersectionRadii(){
+
+  // getIntersectionEasyTest is used for the VXD and SIT layers up to 8
+  _intersectionRmean.assign(9, 0.0);
+
+  for(int layer = 0; layer < int(_intersectionRmean.size()); layer++){
+    long double Rmean = 0.0;
+    if(layer >= int(_nLayersVTX)){
+      if(layer - 6 < 0 || layer - 5 >= int(_sit.geodata.size())) continue;
+      Rmean = (_sit.geodata[layer - 6].rmin + _sit.geodata[layer - 5].rmin)/2.0;
+    }
+    else{
+      if(layer >= int(_vxd.geodata.size())) continue;
+      long double hlwidth = _vxd.geodata[layer].sximax;
+      long double Rmin = _vxd.geodata[layer].rmes;
+      long double Rmax = sqrt(Rmin*Rmin + hlwidth*hlwidth);
+      Rmean = (Rmin + Rmax)/2.0;
+    }
+    _intersectionRmean[layer] = Rmean;
+  }
+
+}
+
+
 int FPCCDSiliconTracking_MarlinTrk::getIntersectionEasyTest(HelixClass_double& helix, TrackerHit* basis, int layer, std::vector<double> &isec){
 
+  long double phiX = atan2(basis->getPosition()[1],basis->getPosition()[0]);if(phiX < 0) phiX += 2.0*M_PI;
+  long double curZ = basis->getPosition()[2];
+
+  double point[3];
+  int error = getIntersectionEasyTest(helix.getPhi0(), helix.getD0(), helix.getZ0(), helix.getOmega(), helix.getTanLambda(), phiX, curZ, layer, point);
+
+  if(error != -3) isec.assign(point, point + 3);
+
+  return error;
+
+}
+
+
+int FPCCDSiliconTracking_MarlinTrk::getIntersectionEasyTest(double phi0In, double d0In, double z0In, double omegaIn, double tanLIn, long double phiX, long double curZ, int layer, double* isec){
+
   if(layer > 8){
     std::cout << "getIntersectionEasyTest uses only VXD or SIT layer. Check source code." << std::endl;
     exit(1);
   }
-  long double d0 = helix.getD0();
-  long double z0 = helix.getZ0();
-  long double phi0 = helix.getPhi0();
-  long double tanL = helix.getTanLambda();
-  long double omega = helix.getOmega();
+  long double d0 = d0In;
+  long double z0 = z0In;
+  long double phi0 = phi0In;
+  long double tanL = tanLIn;
+  long double omega = omegaIn;
 
   if(std::isnormal(d0) == false || std::isnormal(z0) == false || std::isnormal(omega) == false || std::isnormal(phi0) == false || std::isnormal(tanL) == false){
     return -3;
   }
 
-  isec.clear();
-  isec.resize(3);
+  isec[0] = isec[1] = isec[2] = 0.0;
 
-  long double Rmean;
-  if(layer >= int(_nLayersVTX)){
-    Rmean = (_sit.geodata[layer - 6].rmin + _sit.geodata[layer - 5].rmin)/2.0;
-  }
-  else{
-    long double hlwidth = _vxd.geodata[layer].sximax;
-    long double Rmin = _vxd.geodata[layer].rmes;
-    long double Rmax = sqrt(Rmin*Rmin + hlwidth*hlwidth);
-    Rmean = (Rmin + Rmax)/2.0;
-  }
+  long double Rmean = _intersectionRmean[layer];
 
   long double A = 1.0 - 0.5*(Rmean*Rmean - d0*d0)/(1./omega/omega - d0/omega);
   if(_mydebugIntersection){
@@ -1985,14 +2058,13 @@ int FPCCDSiliconTracking_MarlinTrk::getIntersectionEasyTest(HelixClass_double& h
   long double phi1 = phi0 - acos(A);
   long double phi2 = phi0 + acos(A);
 
-  long double* point = new long double[6];
+  long double point[6];
   point[0] = -d0*sin(phi0) + 1.0/omega*(sin(phi0) - sin(phi1));
   point[1] =  d0*cos(phi0) - 1.0/omega*(cos(phi0) - cos(phi1));
   point[2] =  z0 + 1.0/omega*(phi0 - phi1)*tanL;
   point[3] = -d0*sin(phi0) + 1.0/omega*(sin(phi0) - sin(phi2));
   point[4] =  d0*cos(phi0) - 1.0/omega*(cos(phi0) - cos(phi2));
   point[5] =  z0 + 1.0/omega*(phi0 - phi2)*tanL;
-  long double phiX = atan2(basis->getPosition()[1],basis->getPosition()[0]);if(phiX < 0) phiX += 2.0*M_PI;
   long double p1 = atan2(point[1],point[0]);if(p1 < 0) p1 += 2.0*M_PI;
   long double p2 = atan2(point[4],point[3]);if(p2 < 0) p2 += 2.0*M_PI;
   long double diff1 = std::abs(p1 - phiX);if(diff1 > M_PI) diff1 = 2.0*M_PI - diff1;
@@ -2000,7 +2072,6 @@ int FPCCDSiliconTracking_MarlinTrk::getIntersectionEasyTest(HelixClass_double& h
   isec[0] = (diff1 < diff2) ? point[0] : point[3];
   isec[1] = (diff1 < diff2) ? point[1] : point[4];
   long double tmpZ = (diff1 < diff2) ? point[2] : point[5];
-  long double curZ = basis->getPosition()[2];
   long double dist = curZ - tmpZ; 
   long double distOne = std::abs(1.0/omega*tanL*2.0*M_PI);
   long double nCircle = dist/distOne;
@@ -2032,8 +2103,6 @@ int FPCCDSiliconTracking_MarlinTrk::getIntersectionEasyTest(HelixClass_double& h
   std::cout << "  isec [2] : " << isec[2] << std::endl;
 #endif
 
-  delete[] point;
-
   return 0;
 
 }
@@ -3926,9 +3995,12 @@ void FPCCDSiliconTracking_MarlinTrk::InitSITGeometry(){
 
 
 
-int FPCCDSiliconTracking_MarlinTrk::KalFit(int& ndf, float& Chi2, TrackerHitVec trkHits,TrackerHitVec& Hits_in_fit, TrackerHitVec& Outliers, float* par , float* epar, HelixClass_double& helix){
+int FPCCDSiliconTracking_MarlinTrk::KalFit(int& ndf, float& Chi2, TrackerHitVec& trkHits,TrackerHitVec& Hits_in_fit, TrackerHitVec& Outliers, float* par , float* epar, HelixClass_double& helix,
+                                           MarlinTrk::IMarlinTrack** keepFit){
 
-  TrackImpl* Track = new TrackImpl;
+  // the LCIO track is only used to read the result of the fit
+  TrackImpl lcioTrack;
+  TrackImpl* Track = &lcioTrack;
   EVENT::FloatVec covMatrix;
   covMatrix.resize(15);
   covMatrix[0]  = ( _initialTrackError_d0    ); //sigma_d0^2
@@ -3943,7 +4015,6 @@ int FPCCDSiliconTracking_MarlinTrk::KalFit(int& ndf, float& Chi2, TrackerHitVec
   error = MarlinTrk::createFinalisedLCIOTrack(marlinTrk, trkHits, Track, fit_backwards, covMatrix, _bField, _maxChi2PerHit2nd); 
   if(error != 0){
     if(_mydebugKalFit) std::cout << "KalFit error code : " << error << std::endl;
-    delete Track;
     delete marlinTrk;
     return error;
     /* For Reference,
@@ -3960,7 +4031,6 @@ int FPCCDSiliconTracking_MarlinTrk::KalFit(int& ndf, float& Chi2, TrackerHitVec
   ndf = Track->getNdf();
   if(std::isnormal(ndf) == false || ndf <= 0){
     if(_mydebugKalFit)std::cout << "ERROR = 8!! ndf is " << ndf << " at KalFit" << std::endl;
-    delete Track; 
     delete marlinTrk;
     return 8;
   }
@@ -3968,7 +4038,6 @@ int FPCCDSiliconTracking_MarlinTrk::KalFit(int& ndf, float& Chi2, TrackerHitVec
   Chi2 = Track->getChi2();
   if(std::isnormal(Chi2) == false || Chi2 < 0.0 ){
     if(_mydebugKalFit)std::cout << "ERROR = 9!! Chi2 is " << Chi2 << " at KalFit" << std::endl;
-    delete Track; 
     delete marlinTrk;
     return 9;
   }
@@ -3976,7 +4045,6 @@ int FPCCDSiliconTracking_MarlinTrk::KalFit(int& ndf, float& Chi2, TrackerHitVec
   const TrackState* trkStateIP = Track->getTrackState(lcio::TrackState::AtIP);
   if (trkStateIP == 0) {
     if(_mydebugKalFit)std::cout << "ERROR = 2!! trkStateIP is NULL! : KalFit" << std::endl;
-    delete Track;
     delete marlinTrk;
     return 2;
   }
@@ -3991,7 +4059,6 @@ int FPCCDSiliconTracking_MarlinTrk::KalFit(int& ndf, float& Chi2, TrackerHitVec
       std::cout << "ERROR = 10!! Some of track parameters output from Kalman Filter are nan or inf. " << std::endl;
       std::cout << "d0,phi0,omega,z0,tanlambda : " <<par[0]<<" "<<par[1]<<" "<<par[2]<<" "<<par[3]<<" "<<par[4]<<std::endl;
     }
-    delete Track;
     delete marlinTrk;
     return 10;
   }
@@ -4022,14 +4089,74 @@ int FPCCDSiliconTracking_MarlinTrk::KalFit(int& ndf, float& Chi2, TrackerHitVec
   for ( unsigned ihit = 0; ihit < outliers.size(); ++ihit) {Outliers.push_back(outliers[ihit].first); }
 
 
-  delete Track;
-  delete marlinTrk;
+  if(keepFit != 0) *keepFit = marlinTrk;
+  else delete marlinTrk;
 
   return error; //0
 
 }
 
 
+int FPCCDSiliconTracking_MarlinTrk::KalFitAddHit(MarlinTrk::IMarlinTrack* marlinTrk, TrackerHit* hit, int& ndf, float& Chi2, TrackerHitVec& Outliers, float* par , float* epar, HelixClass_double& helix){
+
+  Outliers.clear();
+
+  double chi2inc = 0.;
+  int error = marlinTrk->addAndFit(hit, chi2inc, _maxChi2PerHit2nd);
+  if(error == IMarlinTrack::site_fails_chi2_cut){
+    // as in a full fit, the hit becomes an outlier and the state stays as it was
+    Outliers.push_back(hit);
+  }
+  else if(error != IMarlinTrack::success){
+    if(_mydebugKalFit) std::cout << "KalFitAddHit addAndFit error code : " << error << std::endl;
+    return error;
+  }
+
+  // the quantities read from the LCIO track in KalFit, which are taken at the IP in the same way
+  TrackStateImpl trkStateIP;
+  double chi2 = 0.;
+  int ndfFit = 0;
+  error = marlinTrk->propagate(gear::Vector3D(0.,0.,0.), trkStateIP, chi2, ndfFit);
+  if(error != IMarlinTrack::success){
+    if(_mydebugKalFit) std::cout << "KalFitAddHit propagate error code : " << error << std::endl;
+    return error;
+  }
+
+  ndf = ndfFit;
+  if(ndf <= 0){
+    if(_mydebugKalFit)std::cout << "ERROR = 8!! ndf is " << ndf << " at KalFitAddHit" << std::endl;
+    return 8;
+  }
+
+  Chi2 = chi2;
+  if(std::isnormal(Chi2) == false || Chi2 < 0.0 ){
+    if(_mydebugKalFit)std::cout << "ERROR = 9!! Chi2 is " << Chi2 << " at KalFitAddHit" << std::endl;
+    return 9;
+  }
+
+  par[0] = trkStateIP.getD0();
+  par[1] = trkStateIP.getPhi();
+  par[2] = trkStateIP.getOmega();
+  par[3] = trkStateIP.getZ0();
+  par[4] = trkStateIP.getTanLambda();
+
+  if(std::isnormal(par[0]) == false || std::isnormal(par[1]) == false || std::isnormal(par[2]) == false || std::isnormal(par[3]) == false || std::isnormal(par[4]) == false){
+    if(_mydebugKalFit){
+      std::cout << "ERROR = 10!! Some of track parameters output from Kalman Filter are nan or inf. " << std::endl;
+      std::cout << "d0,phi0,omega,z0,tanlambda : " <<par[0]<<" "<<par[1]<<" "<<par[2]<<" "<<par[3]<<" "<<par[4]<<std::endl;
+    }
+    return 10;
+  }
+
+  const FloatVec& covM = trkStateIP.getCovMatrix();
+  for(int i = 0 ; i < 15; i++) epar[i] = covM[i];
+  helix.Initialize_Canonical(par[1],par[0],par[3],par[2],par[4],_bField);
+
+  return IMarlinTrack::success;
+
+}
+
+
 float FPCCDSiliconTracking_MarlinTrk::DotOf2Clusters(TrackerHit* A, TrackerHit* B){
 
   ClusterStatus ca(A);
@@ -4153,6 +4280,18 @@ int FPCCDSiliconTracking_MarlinTrk::CheckTiltOf2Clusters(TrackerHit* A, TrackerH
   std::cout <<  "tilt : "  << cb.tilt << std::endl;
 #endif      
 
+  ClusterShape sa;
+  sa.xiwidth = ca.xiwidth; sa.zetawidth = ca.zetawidth; sa.nPix = ca.nPix; sa.tilt = ca.tilt;
+  ClusterShape sb;
+  sb.xiwidth = cb.xiwidth; sb.zetawidth = cb.zetawidth; sb.nPix = cb.nPix; sb.tilt = cb.tilt;
+
+  return CheckTiltOf2Clusters(sa, sb);
+
+}
+
+
+int FPCCDSiliconTracking_MarlinTrk::CheckTiltOf2Clusters(const ClusterShape& ca, const ClusterShape& cb){
+
   //tilt check.
   //tilt : 0 --> straight line shape
   //tilt : 1 --> zig-zag line going from left bottom to right top
@@ -4189,6 +4328,62 @@ int FPCCDSiliconTracking_MarlinTrk::CheckTiltOf2Clusters(TrackerHit* A, TrackerH
 }
 
 
+FPCCDSiliconTracking_MarlinTrk::ClusterShape FPCCDSiliconTracking_MarlinTrk::MakeClusterShape(TrackerHit* hit){
+
+  ClusterShape shape;
+  ClusterStatus cs(hit);
+
+  if(cs.layer >= _vxd.geodata.size() || cs.layer >= _pixelSizeVec.size() || int(cs.ladder) >= _vxd.geodata[cs.layer].nladder) return shape;
+
+  shape.valid = true;
+  shape.xiwidth = cs.xiwidth;
+  shape.zetawidth = cs.zetawidth;
+  shape.nPix = cs.nPix;
+  shape.tilt = cs.tilt;
+
+  // the same directions as in DotOf2Clusters
+  double sign = 1;
+  if(cs.tilt>1) sign = -1;
+  TVector3 ldir(_pixelSizeVec[cs.layer]*(cs.xiwidth-1),sign*_pixelSizeVec[cs.layer]*(cs.zetawidth-1),_pixelheight);
+  TVector3 revldir(-ldir.X(),-ldir.Y(),ldir.Z());
+  TVector3 gdir = LocalToGlobal(ldir,cs.layer,cs.ladder).Unit();
+  TVector3 revgdir = LocalToGlobal(revldir,cs.layer,cs.ladder).Unit();
+
+  shape.dir[0] = gdir.X(); shape.dir[1] = gdir.Y(); shape.dir[2] = gdir.Z();
+  shape.revDir[0] = revgdir.X(); shape.revDir[1] = revgdir.Y(); shape.revDir[2] = revgdir.Z();
+
+  return shape;
+
+}
+
+
+float FPCCDSiliconTracking_MarlinTrk::DotOf2Clusters(const ClusterShape& a, const ClusterShape& b){
+
+  const double dotRev = a.revDir[0]*b.dir[0] + a.revDir[1]*b.dir[1] + a.revDir[2]*b.dir[2];
+  const double dotFwd = a.dir[0]*b.dir[0] + a.dir[1]*b.dir[1] + a.dir[2]*b.dir[2];
+  float dot1 = ( dotRev > dotFwd ) ? dotRev : dotFwd;
+
+  return dot1;
+
+}
+
+
+void FPCCDSiliconTracking_MarlinTrk::CheckClusterCompatibility(const ClusterShape& a, const ClusterShape* b, int n, signed char* compatible){
+
+  if(a.valid == false){
+    for(int i = 0; i < n; i++) compatible[i] = -1;
+    return;
+  }
+
+  for(int i = 0; i < n; i++){
+    if(b[i].valid == false){ compatible[i] = -1; continue; }
+    const double dot = DotOf2Clusters(a, b[i]);
+    compatible[i] = ( CheckTiltOf2Clusters(a, b[i]) >= 0 && dot > _minDotOf2Clusters ) ? 1 : 0;
+  }
+
+}
+
+
 IntVec FPCCDSiliconTracking_MarlinTrk::getNHitsInSubDet(SimTrackerHitVec simvec){
   IntVec ivec(3);
   for(int i = 0; i < int(simvec.size()); i++){
@@ -4322,21 +4517,27 @@ int FPCCDSiliconTracking_MarlinTrk::getPhiThetaRegion(TrackExtended* trackAR, in
   }
 
 
-  DoubleVec phiSectsTest(5);
-  DoubleVec thetaSectsTest(3);
+  double phiSectsTest[5];
+  double thetaSectsTest[3];
 
+  // The intersections are computed directly from the parameters of the helix variants, with the radius
+  // of the layer taken from the table filled in init. The nominal helix is shared by both loops.
+  long double phiX = atan2(currentInnermostHit->getPosition()[1],currentInnermostHit->getPosition()[0]);if(phiX < 0) phiX += 2.0*M_PI;
+  long double curZ = currentInnermostHit->getPosition()[2];
+  double iSecNominal[3];
 
   for(int i = 0; i < 5; i++){
-    std::vector<double> iSec; HelixClass_double tmpHelix;
+    double iSec[3] = {0.0, 0.0, 0.0};
     if(i == 1 && (d0error < 0) ){ phiSectsTest[1] = phiSectsTest[0]; phiSectsTest[2] = phiSectsTest[0]; i=2; continue; }
     if(i >= 3 && (omegaerror < 0)){ phiSectsTest[3] = phiSectsTest[0]; phiSectsTest[4] = phiSectsTest[0];break; }
 
-    if(i == 0) tmpHelix.Initialize_Canonical(phi0, d0, z0, omega, tanL, _bField);
-    else if(i == 1) tmpHelix.Initialize_Canonical(phi0, d0 + d0error*_nSigmaBuild_phi, z0, omega, tanL, _bField);
-    else if(i == 2) tmpHelix.Initialize_Canonical(phi0, d0 - d0error*_nSigmaBuild_phi, z0, omega, tanL, _bField);
-    else if(i == 3) tmpHelix.Initialize_Canonical(phi0, d0, z0, omega + omegaerror*_nSigmaBuild_phi, tanL, _bField);
-    else if(i == 4) tmpHelix.Initialize_Canonical(phi0, d0, z0, omega - omegaerror*_nSigmaBuild_phi, tanL, _bField);
-    int error = getIntersectionEasyTest(tmpHelix, currentInnermostHit, layer, iSec);
+    int error = 0;
+    if(i == 0) error = getIntersectionEasyTest(phi0, d0, z0, omega, tanL, phiX, curZ, layer, iSec);
+    else if(i == 1) error = getIntersectionEasyTest(phi0, d0 + d0error*_nSigmaBuild_phi, z0, omega, tanL, phiX, curZ, layer, iSec);
+    else if(i == 2) error = getIntersectionEasyTest(phi0, d0 - d0error*_nSigmaBuild_phi, z0, omega, tanL, phiX, curZ, layer, iSec);
+    else if(i == 3) error = getIntersectionEasyTest(phi0, d0, z0, omega + omegaerror*_nSigmaBuild_phi, tanL, phiX, curZ, layer, iSec);
+    else if(i == 4) error = getIntersectionEasyTest(phi0, d0, z0, omega - omegaerror*_nSigmaBuild_phi, tanL, phiX, curZ, layer, iSec);
+    if(i == 0) std::copy(iSec, iSec + 3, iSecNominal);
 
     if(error == -1){ 
       //std::cout << "getIntersectionEasyTest for phi-sector couldn't find intersection. loop : " << i << std::endl; 
@@ -4362,13 +4563,13 @@ int FPCCDSiliconTracking_MarlinTrk::getPhiThetaRegion(TrackExtended* trackAR, in
 
 
   for(int i = 0; i < 3; i++){
-    std::vector<double> iSec; HelixClass_double tmpHelix;
+    double iSec[3] = {0.0, 0.0, 0.0};
     if(i == 1 && (z0error < 0) ){ thetaSectsTest[1] = thetaSectsTest[0]; thetaSectsTest[2] = thetaSectsTest[0]; break; }
-    if(i == 0) tmpHelix.Initialize_Canonical(phi0, d0, z0, omega, tanL, _bField);
-    else if(i == 1){ tmpHelix.Initialize_Canonical(phi0, d0, z0 + z0error*_nSigmaBuild_theta, omega, tanL, _bField); }
-    else if(i == 2){ tmpHelix.Initialize_Canonical(phi0, d0, z0 - z0error*_nSigmaBuild_theta, omega, tanL, _bField); }
+    int error = 0;
+    if(i == 0) std::copy(iSecNominal, iSecNominal + 3, iSec);
+    else if(i == 1){ error = getIntersectionEasyTest(phi0, d0, z0 + z0error*_nSigmaBuild_theta, omega, tanL, phiX, curZ, layer, iSec); }
+    else if(i == 2){ error = getIntersectionEasyTest(phi0, d0, z0 - z0error*_nSigmaBuild_theta, omega, tanL, phiX, curZ, layer, iSec); }
 
-    int error = getIntersectionEasyTest(tmpHelix, currentInnermostHit, layer, iSec);
     if(error == -1){
       //std::cout << "getIntersectionEasyTest for phi-theta couldn't find intersection. loop : " << i << std::endl; 
       return int(trackAR->getTrackerHitExtendedVec().size()); 
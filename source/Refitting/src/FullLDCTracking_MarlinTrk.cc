@@ -13,11 +13,14 @@
 #include <iostream>
 #include <algorithm>
 #include <memory>
+#include <sstream>
 
 #include <math.h>
 #include <map>
 #include <marlin/Global.h>
 #include "ClusterShapes.h"
+#include "HitGridXY.h"
+#include "HelixDistanceBatch.h"
 
 #include <gear/GEAR.h>
 #include <gear/GearParameters.h>
@@ -459,6 +462,16 @@ FullLDCTracking_MarlinTrk::FullLDCTracking_MarlinTrk() : Processor("FullLDCTrack
                              _maxChi2PerHit,
                              double(1.e2));
   
+  registerProcessorParameter( "NumberOfThreads",
+                             "Number of threads converting the input hit and track collections, 1 converts them in the calling thread and 0 uses all hardware threads",
+                             _nThreads,
+                             int(1));
+  
+  registerProcessorParameter( "IncrementalSiHitAddition",
+                             "Add leftover silicon hits to the kept fit of a track with addAndFit instead of refitting all its hits for every hit. Ignored with SmoothOn, as the kept fit would already be smoothed. Not validated against the full refit yet",
+                             _incrementalSiHitAddition,
+                             bool(false));
+  
 
   registerProcessorParameter( "MinChi2ProbForSiliconTracks",
                              "Minimum Chi-squared P value allowed for Silicon Tracks.",
@@ -492,6 +505,15 @@ FullLDCTracking_MarlinTrk::FullLDCTracking_MarlinTrk() : Processor("FullLDCTrack
 			      _trkSystemName,
 			      std::string("KalTest") );
 
+  registerProcessorParameter( "TimeStages",
+                             "Measure the time spent in the main processing stages and print a summary per run in end()",
+                             _timeStages,
+                             bool(false));
+  
+  registerProcessorParameter( "StageTimingCSVFile",
+                             "If set together with TimeStages, write the stage times and counters of every event to this CSV file",
+                             _stageTimingCSVFile,
+                             std::string(""));
 
 
 #ifdef MARLINTRK_DIAGNOSTICS_ON
@@ -530,6 +552,11 @@ void FullLDCTracking_MarlinTrk::init() {
   _trksystem->setOption( IMarlinTrkSystem::CFG::useSmoothing,  _SmoothOn) ;
   _trksystem->init() ;  
   
+  if( _incrementalSiHitAddition && _SmoothOn ){
+    streamlog_out(WARNING) << "FullLDCTracking_MarlinTrk : IncrementalSiHitAddition is ignored with SmoothOn, the tracks are refitted with all their hits for every silicon hit" << std::endl;
+    _incrementalSiHitAddition = false;
+  }
+  
 #ifdef MARLINTRK_DIAGNOSTICS_ON
   
   void * dcv = _trksystem->getDiagnositicsPointer();
@@ -540,6 +567,23 @@ void FullLDCTracking_MarlinTrk::init() {
   
   this->setupGearGeom(Global::GEAR);
   
+  _taskPool.init( _nThreads );
+  
+  _timers.init( name(), _timeStages, _stageTimingCSVFile );
+  _stagePrepareVectors = _timers.addStage( "PrepareVectors" );
+  _stageMergeTPCandSiTracks = _timers.addStage( "MergeTPCandSiTracks" );
+  _stageMergeTPCandSiTracksII = _timers.addStage( "MergeTPCandSiTracksII" );
+  _stageSorting = _timers.addStage( "Sorting" );
+  _stageSelectCombinedTracks = _timers.addStage( "SelectCombinedTracks" );
+  _stageAddNotCombinedTracks = _timers.addStage( "AddNotCombinedTracks" );
+  _stageAddNotAssignedHits = _timers.addStage( "AddNotAssignedHits" );
+  _stageAssignOuterHitsToTracks = _timers.addStage( "AssignOuterHitsToTracks" );
+  _stageAssignSiHitsToTracks = _timers.addStage( "AssignSiHitsToTracks" );
+  _stageAssignTPCHitsToTracks = _timers.addStage( "AssignTPCHitsToTracks" );
+  _stageAddTrackColToEvt = _timers.addStage( "AddTrackColToEvt" );
+  _countCombinedTrackCandidates = _timers.addCounter( "CombinedTrackCandidates" );
+  _countOutputTracks = _timers.addCounter( "OutputTracks" );
+  
 }
 
 void FullLDCTracking_MarlinTrk::processRunHeader( LCRunHeader* run) { 
@@ -562,38 +606,59 @@ void FullLDCTracking_MarlinTrk::processEvent( LCEvent * evt ) {
   streamlog_out(DEBUG5) << std::endl;
   
   
+  _timers.startEvent( evt->getRunNumber(), evt->getEventNumber() );
+  
+  StageTimers::Scope timePrepareVectors( _timers, _stagePrepareVectors );
   prepareVectors( evt );
+  timePrepareVectors.stop();
   streamlog_out(DEBUG5) << "************************************PrepareVectors done..." << std::endl;
 
   streamlog_out(DEBUG5) << "************************************Merge TPC/Si ..." << std::endl;
 
+  StageTimers::Scope timeMergeTPCandSiTracks( _timers, _stageMergeTPCandSiTracks );
   MergeTPCandSiTracks();
+  timeMergeTPCandSiTracks.stop();
   streamlog_out(DEBUG5) << "************************************Merging done ..." << std::endl;
 
+  StageTimers::Scope timeMergeTPCandSiTracksII( _timers, _stageMergeTPCandSiTracksII );
   MergeTPCandSiTracksII();
+  timeMergeTPCandSiTracksII.stop();
   streamlog_out(DEBUG5) << "************************************Merging II done ..." << std::endl;
 
+  _timers.count( _countCombinedTrackCandidates, _allCombinedTracks.size() );
+  
+  StageTimers::Scope timeSorting( _timers, _stageSorting );
   Sorting(_allCombinedTracks);
+  timeSorting.stop();
   streamlog_out(DEBUG5) << "************************************Sorting by Chi2/NDF done ..." << std::endl;
 
   streamlog_out(DEBUG5) << "************************************Selection of all 2 track combininations ..." << std::endl;
+  StageTimers::Scope timeSelectCombinedTracks( _timers, _stageSelectCombinedTracks );
   SelectCombinedTracks();
+  timeSelectCombinedTracks.stop();
   streamlog_out(DEBUG5) << "************************************Selection of all 2 track combininations done ..." << std::endl;
 
   streamlog_out(DEBUG5) << "************************************Trying non combined tracks ..." << std::endl;
+  StageTimers::Scope timeAddNotCombinedTracks( _timers, _stageAddNotCombinedTracks );
   AddNotCombinedTracks( );
+  timeAddNotCombinedTracks.stop();
   streamlog_out(DEBUG5) << "************************************Non combined tracks added ..." << std::endl;
   //CheckTracks( );
 
   streamlog_out(DEBUG5) << "************************************Add Non assigned hits ..." << std::endl;
+  StageTimers::Scope timeAddNotAssignedHits( _timers, _stageAddNotAssignedHits );
   AddNotAssignedHits();
+  timeAddNotAssignedHits.stop();
   streamlog_out(DEBUG5) << "************************************Non assigned hits added ..." << std::endl;
 
+  StageTimers::Scope timeAddTrackColToEvt( _timers, _stageAddTrackColToEvt );
   AddTrackColToEvt(evt,_trkImplVec,
                    _LDCTrackCollection);
+  timeAddTrackColToEvt.stop();
   streamlog_out(DEBUG5) << "Collections added to event ..." << std::endl;
   CleanUp();
   streamlog_out(DEBUG5) << "Cleanup is done." << std::endl;
+  _timers.endEvent();
   _nEvt++;
   //  getchar();
   streamlog_out(DEBUG5) << std::endl;
@@ -942,12 +1007,42 @@ void FullLDCTracking_MarlinTrk::AddTrackColToEvt(LCEvent * evt, TrackExtendedVec
   << " Pz = " << pzTot << std::endl;
   streamlog_out(DEBUG5) << std::endl;
   
+  _timers.count( _countOutputTracks, nTotTracks );
+  
   evt->addCollection(colTRK,TrkColName.c_str());
   
   
 }
 
 
+namespace {
+  
+  /** block of elements of one input collection converted by one task of prepareVectors */
+  struct ConversionTask {
+    int iCol;
+    int begin;
+    int end;
+    int errorElement;   // first element which could not be converted, -1 if none
+    std::string error;
+  };
+  
+  // number of hits and tracks converted by one task
+  const int hitsPerConversionTask = 1024;
+  const int tracksPerConversionTask = 16;
+  
+  void addConversionTasks( int iCol, int nelem, int perTask, std::vector<ConversionTask>& tasks ) {
+    for (int begin=0; begin<nelem; begin+=perTask) {
+      ConversionTask task;
+      task.iCol = iCol;
+      task.begin = begin;
+      task.end = std::min( nelem, begin+perTask );
+      task.errorElement = -1;
+      tasks.push_back( task );
+    }
+  }
+  
+}
+
 void FullLDCTracking_MarlinTrk::prepareVectors(LCEvent * event ) {
   
   
@@ -970,486 +1065,193 @@ void FullLDCTracking_MarlinTrk::prepareVectors(LCEvent * event ) {
   
   std::map <TrackerHit*,TrackerHitExtended*> mapTrackerHits;
   
-  // Reading TPC hits
-  try {
-    
-    LCCollection * col = event->getCollection(_TPCTrackerHitCollection.c_str());
-    
-    int nelem = col->getNumberOfElements();
-    
-    streamlog_out(DEBUG5) << "Number of TPC hits = " << nelem << std::endl;
-    
-    for (int ielem=0;ielem<nelem;++ielem) {
-      
-      TrackerHit * hit = dynamic_cast<TrackerHit*>(col->getElementAt(ielem));
-      TrackerHitExtended * hitExt = new TrackerHitExtended(hit);
-      
-      // Covariance Matrix in LCIO is defined in XYZ convert to R-Phi-Z
-      // For no error in r
-      
-      double tpcRPhiRes = sqrt(hit->getCovMatrix()[0] + hit->getCovMatrix()[2]);
-      double tpcZRes = sqrt(hit->getCovMatrix()[5]);
-      
-      hitExt->setResolutionRPhi(float(tpcRPhiRes));
-      hitExt->setResolutionZ(float(tpcZRes));
-      
-      // type and det are no longer used, set to INT_MAX to try and catch any missuse
-      hitExt->setType(int(INT_MAX));
-      hitExt->setDet(int(INT_MAX));
-      _allTPCHits.push_back( hitExt );
-      mapTrackerHits[hit] = hitExt;
-
-      double pos[3];
-      
-      for (int i=0; i<3; ++i) {
-        pos[i] = hit->getPosition()[i];
-      }
-      
-      unsigned int layer = static_cast<unsigned int>(getLayerID(hit));
-      
-      streamlog_out( DEBUG1 ) << " TPC Hit added : @ " << pos[0] << " " << pos[1] << " " << pos[2]  << " drphi " << tpcRPhiRes << " dz " << tpcZRes << "  layer = " << layer << std::endl;
-    
-    }
-  }
-  catch( DataNotAvailableException &e ) {
-    streamlog_out(DEBUG4) << _TPCTrackerHitCollection.c_str() << " collection is unavailable" << std::endl;
-  };
+  // The hits of all collections are converted concurrently by the task pool, in blocks of elements
+  // written to the positions of the hits in per collection vectors. Afterwards the vectors are
+  // concatenated, and the debug output and fatal errors reported, in the order the collections
+  // were read in before.
   
+  enum { iTPCHits, iFTDPixelHits, iFTDSpacePoints, iSITHits, iSETHits, iVTXHits, nHitCollections };
   
-  // Reading in FTD Pixel Hits Collection
-  //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
-  try {
+  const std::string hitColNames[nHitCollections] = { _TPCTrackerHitCollection, _FTDPixelHitCollection, _FTDSpacePointCollection,
+                                                     _SITTrackerHitCollection, _SETTrackerHitCollection, _VTXTrackerHitCollection };
+  const char* hitColLabels[nHitCollections] = { "TPC", "FTD Pixel", "FTD SpacePoints", "SIT", "SET", "VXD" };
+  
+  LCCollection * hitCols[nHitCollections];
+  std::vector<TrackerHitExtended*> hitExts[nHitCollections];
+  std::vector<int> hitLayers[nHitCollections];
+  std::vector<ConversionTask> hitTasks;
+  
+  for (int iCol=0; iCol<nHitCollections; ++iCol) {
     
-    LCCollection * hitCollection = event->getCollection(_FTDPixelHitCollection.c_str());
+    hitCols[iCol] = 0;
     
-    int nelem = hitCollection->getNumberOfElements();
+    try {
+      hitCols[iCol] = event->getCollection(hitColNames[iCol].c_str());
+    }
+    catch( DataNotAvailableException &e ) {
+      continue;
+    }
     
-    streamlog_out(DEBUG5) << "Number of FTD Pixel hits = " << nelem << std::endl;
+    const int nelem = hitCols[iCol]->getNumberOfElements();
+    hitExts[iCol].assign( nelem, 0 );
+    hitLayers[iCol].assign( nelem, 0 );
+    addConversionTasks( iCol, nelem, hitsPerConversionTask, hitTasks );
     
-    for (int ielem=0; ielem<nelem; ++ielem) {
-      TrackerHitPlane * hit = dynamic_cast<TrackerHitPlane*>(hitCollection->getElementAt(ielem));
-      
-      TrackerHitExtended * hitExt = new TrackerHitExtended( hit );
-      
-      double point_res_rphi = sqrt( hit->getdU()*hit->getdU() + hit->getdV()*hit->getdV() );
-      hitExt->setResolutionRPhi( point_res_rphi );
-      
-      // SJA:FIXME why is this needed? 
-      hitExt->setResolutionZ(0.1);
-      
-      // type and det are no longer used, set to INT_MAX to try and catch any missuse
-      hitExt->setType(int(INT_MAX));            
-      hitExt->setDet(int(INT_MAX));
-      
-      _allFTDHits.push_back( hitExt );
-      mapTrackerHits[hit] = hitExt;
-      
-      // get the layer number
-      unsigned int layer = static_cast<unsigned int>(getLayerID(hit));
-      unsigned int petalIndex = static_cast<unsigned int>(getModuleID(hit));
-      
-      if ( _petalBasedFTDWithOverlaps == true ) {
-        
-        // as we are dealing with staggered petals we will use 2*nlayers in each directions +/- z
-        // the layers will follow the even odd numbering of the petals 
-        if ( petalIndex % 2 == 0 ) {
-          layer = 2*layer;
-        }
-        else {
-          layer = 2*layer + 1;
-        }
-        
-      }
-      
-      if (layer >= _nLayersFTD) {
-        streamlog_out(ERROR) << "FullLDCTracking_MarlinTrk => fatal error in FTD : layer is outside allowed range : " << layer << " number of layers = " << _nLayersFTD <<  std::endl;
-        exit(1);
-      }
-      
-      double pos[3];
-      
-      for (int i=0; i<3; ++i) {
-        pos[i] = hit->getPosition()[i];
-      }      
-      
-      streamlog_out( DEBUG1 ) << " FTD Pixel Hit added : @ " << pos[0] << " " << pos[1] << " " << pos[2]  << " drphi " << hitExt->getResolutionRPhi() << " dz " << hitExt->getResolutionZ() << "  layer = " << layer << std::endl;
-      
-    }
-  }
-  catch(DataNotAvailableException &e ) {
-    streamlog_out(DEBUG4) << _FTDPixelHitCollection.c_str() << " collection is unavailable" << std::endl;
   }
   
-  // Reading in FTD SpacePoint Collection
-  //^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
-  try {
-    
-    LCCollection * hitCollection = event->getCollection(_FTDSpacePointCollection.c_str());
+  _taskPool.run( hitTasks.size(), [&]( int iTask ) {
     
-    int nelem = hitCollection->getNumberOfElements();
+    ConversionTask& task = hitTasks[iTask];
     
-    streamlog_out(DEBUG5) << "Number of FTD SpacePoints hits = " << nelem << std::endl;
+    // the shared _encoder can not be used concurrently
+    UTIL::BitField64 encoder( lcio::ILDCellID0::encoder_string );
     
-    for (int ielem=0; ielem<nelem; ++ielem) {
-      
-      TrackerHit * hit = dynamic_cast<TrackerHit*>(hitCollection->getElementAt(ielem));
-      
-      TrackerHitExtended * hitExt = new TrackerHitExtended( hit );
-      
-      // SJA:FIXME: fudge for now by a factor of two and ignore covariance
-      double point_res_rphi = 2 * sqrt( hit->getCovMatrix()[0] + hit->getCovMatrix()[2] );
-      
-      hitExt->setResolutionRPhi( point_res_rphi );
+    for (int ielem=task.begin; ielem<task.end; ++ielem) {
       
-      // SJA:FIXME why is this needed? 
-      hitExt->setResolutionZ(0.1);
+      LCObject * obj = hitCols[task.iCol]->getElementAt(ielem);
+      int& layer = hitLayers[task.iCol][ielem];
+      TrackerHitExtended * hitExt = 0;
       
-      // type is now only used in one place where it is set to 0 to reject hits from a fit, set to INT_MAX to try and catch any missuse
-      hitExt->setType(int(INT_MAX));
-      // det is no longer used set to INT_MAX to try and catch any missuse
-      hitExt->setDet(int(INT_MAX));
-      
-      _allFTDHits.push_back( hitExt );
-      mapTrackerHits[hit] = hitExt;
-      
-      
-      // get the layer number
-      unsigned int layer = static_cast<unsigned int>(getLayerID(hit));
-      unsigned int petalIndex = static_cast<unsigned int>(getModuleID(hit));
-      
-      if ( _petalBasedFTDWithOverlaps == true ) {
-        
-        // as we are dealing with staggered petals we will use 2*nlayers in each directions +/- z
-        // the layers will follow the even odd numbering of the petals 
-        if ( petalIndex % 2 == 0 ) {
-          layer = 2*layer;
-        }
-        else {
-          layer = 2*layer + 1;
-        }
-        
+      switch (task.iCol) {
+        case iTPCHits:        hitExt = ConvertTPCHit(dynamic_cast<TrackerHit*>(obj), encoder, layer); break;
+        case iFTDPixelHits:   hitExt = ConvertFTDHit(dynamic_cast<TrackerHit*>(obj), true, encoder, layer, task.error); break;
+        case iFTDSpacePoints: hitExt = ConvertFTDHit(dynamic_cast<TrackerHit*>(obj), false, encoder, layer, task.error); break;
+        case iSITHits:        hitExt = ConvertSiHit(dynamic_cast<TrackerHit*>(obj), "SIT", _nLayersSIT, encoder, layer, task.error); break;
+        case iSETHits:        hitExt = ConvertSiHit(dynamic_cast<TrackerHit*>(obj), "SET", _nLayersSET, encoder, layer, task.error); break;
+        case iVTXHits:        hitExt = ConvertVTXHit(dynamic_cast<TrackerHitPlane*>(obj), encoder, layer); break;
       }
       
-      if (layer >= _nLayersFTD) {
-        streamlog_out(ERROR) << "FullLDCTracking_MarlinTrk => fatal error in FTD : layer is outside allowed range : " << layer << " number of layers = " << _nLayersFTD <<  std::endl;
-        exit(1);
+      if (hitExt == 0) {
+        task.errorElement = ielem;
+        return;
       }
       
-      double pos[3];
-      
-      for (int i=0; i<3; ++i) {
-        pos[i] = hit->getPosition()[i];
-      }      
-      
-      streamlog_out( DEBUG1 ) << " FTD SpacePoint Hit added : @ " << pos[0] << " " << pos[1] << " " << pos[2]  << " drphi " << hitExt->getResolutionRPhi() << " dz " << hitExt->getResolutionZ() << "  layer = " << layer << std::endl;
-      
+      hitExts[task.iCol][ielem] = hitExt;
       
     }
-  }
-  catch(DataNotAvailableException &e ) {
-    streamlog_out(DEBUG4) << _FTDSpacePointCollection.c_str() << " collection is unavailable" << std::endl;
-  }
-  
-  
+    
+  });
   
+  unsigned iTask = 0;
   
-  try {
+  for (int iCol=0; iCol<nHitCollections; ++iCol) {
     
-    LCCollection *hitCollection = event->getCollection(_SITTrackerHitCollection.c_str());
+    if (hitCols[iCol] == 0) {
+      streamlog_out(DEBUG4) << hitColNames[iCol] << " collection is unavailable" << std::endl;
+      continue;
+    }
     
-    int nelem = hitCollection->getNumberOfElements();
+    const int nelem = hitExts[iCol].size();
     
-    streamlog_out(DEBUG5) << "Number of SIT hits = " << nelem << std::endl;
+    streamlog_out(DEBUG5) << "Number of " << hitColLabels[iCol] << " hits = " << nelem << std::endl;
     
-    TrackerHit*          trkhit   = 0;
-    TrackerHitPlane*     trkhit_P = 0;
-    TrackerHitZCylinder* trkhit_C = 0;
+    TrackerHitExtendedVec * allHits = 0;
     
-    double drphi(NAN);
-    double dz(NAN);
+    switch (iCol) {
+      case iTPCHits:        allHits = &_allTPCHits; break;
+      case iFTDPixelHits:   allHits = &_allFTDHits; break;
+      case iFTDSpacePoints: allHits = &_allFTDHits; break;
+      case iSITHits:        allHits = &_allSITHits; break;
+      case iSETHits:        allHits = &_allSETHits; break;
+      case iVTXHits:        allHits = &_allVTXHits; break;
+    }
     
-    for (int ielem=0; ielem<nelem; ++ielem) {
-      
-      // hit could be of the following type
-      // 1) TrackerHit, either ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT or just standard TrackerHit
-      // 2) TrackerHitPlane, either 1D or 2D
-      // 3) TrackerHitZCylinder, if coming from a simple cylinder design as in the LOI
-      
-      // Establish which of these it is in the following order of likelyhood
-      //    i)   ILDTrkHitTypeBit::ONE_DIMENSIONAL (TrackerHitPlane) Should Never Happen: SpacePoints Must be Used Instead
-      //    ii)  ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT (TrackerHit)
-      //    iii) TrackerHitPlane (Two dimentional)
-      //    iv)  TrackerHitZCylinder 
-      //    v)   Must be standard TrackerHit
-      
-      trkhit = dynamic_cast<TrackerHit*>(hitCollection->getElementAt(ielem));
+    for (; iTask<hitTasks.size() && hitTasks[iTask].iCol==iCol; ++iTask) {
       
-      int layer = getLayerID(trkhit);
+      const ConversionTask& task = hitTasks[iTask];
       
-      if (layer < 0 || (unsigned)layer >= _nLayersSIT) {
-        streamlog_out(ERROR) << "FullLDCTracking_MarlinTrk => fatal error in SIT : layer is outside allowed range : " << layer << std::endl;
-        exit(1);
-      }
-      
-      // first check that we have not been given 1D hits by mistake, as they won't work here
-      if ( BitSet32( trkhit->getType() )[ UTIL::ILDTrkHitTypeBit::ONE_DIMENSIONAL ] ) {
-        
-        streamlog_out(ERROR) << "FullLDCTracking_MarlinTrk: SIT Hit cannot be of type UTIL::ILDTrkHitTypeBit::ONE_DIMENSIONAL COMPOSITE SPACEPOINTS must be use instead. \n\n  exit(1) called from file " << __FILE__ << " and line " << __LINE__ << std::endl;
-        exit(1);
-        
-      } 
-      // most likely case: COMPOSITE_SPACEPOINT hits formed from stereo strip hits
-      else if ( BitSet32( trkhit->getType() )[ UTIL::ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT ] ) {
-        
-        // SJA:FIXME: fudge for now by a factor of two and ignore covariance
-        drphi =  2 * sqrt(trkhit->getCovMatrix()[0] + trkhit->getCovMatrix()[2]);         
-        dz    =      sqrt(trkhit->getCovMatrix()[5]);         
-        
-      } 
-      // or a PIXEL based SIT, using 2D TrackerHitPlane like the VXD above
-      else if ( ( trkhit_P = dynamic_cast<TrackerHitPlane*>( hitCollection->getElementAt( ielem ) ) ) )  {
-        
-        // first we need to check if the measurement vectors are aligned with the global coordinates 
-        gear::Vector3D U(1.0,trkhit_P->getU()[1],trkhit_P->getU()[0],gear::Vector3D::spherical);
-        gear::Vector3D V(1.0,trkhit_P->getV()[1],trkhit_P->getV()[0],gear::Vector3D::spherical);
-        gear::Vector3D Z(0.0,0.0,1.0);
-        
-        const float eps = 1.0e-07;
-        // V must be the global z axis 
-        if( fabs(1.0 - V.dot(Z)) > eps ) {
-          streamlog_out(ERROR) << "FullLDCTracking_MarlinTrk: PIXEL SIT Hit measurment vectors V is not equal to the global Z axis. \n\n  exit(1) called from file " << __FILE__ << " and line " << __LINE__ << std::endl;
-          exit(1);
-        }
+      for (int ielem=task.begin; ielem<task.end; ++ielem) {
         
-        // U must be normal to the global z axis
-        if( fabs(U.dot(Z)) > eps ) {
-          streamlog_out(ERROR) << "FullLDCTracking_MarlinTrk: PIXEL SIT Hit measurment vectors U is not in the global X-Y plane. \n\n exit(1) called from file " << __FILE__ << " and line " << __LINE__ << std::endl;
+        if (ielem == task.errorElement) {
+          streamlog_out(ERROR) << task.error << std::endl;
           exit(1);
         }
         
-        drphi = trkhit_P->getdU();
-        dz    = trkhit_P->getdV();                                                 
+        TrackerHitExtended * hitExt = hitExts[iCol][ielem];
+        TrackerHit * hit = hitExt->getTrackerHit();
         
-      } 
-      // or a simple cylindrical design, as used in the LOI      
-      else if ( ( trkhit_C = dynamic_cast<TrackerHitZCylinder*>( hitCollection->getElementAt( ielem ) ) ) ) {
+        allHits->push_back( hitExt );
+        mapTrackerHits[hit] = hitExt;
         
-        drphi = trkhit_C->getdRPhi();
-        dz    = trkhit_C->getdZ();
+        streamlog_out( DEBUG1 ) << " " << hitColLabels[iCol] << " Hit " << hit->id() << " added : @ " << hit->getPosition()[0] << " " << hit->getPosition()[1] << " " << hit->getPosition()[2]
+        << " drphi " << hitExt->getResolutionRPhi() << " dz " << hitExt->getResolutionZ() << "  layer = " << hitLayers[iCol][ielem] << std::endl;
         
-      } 
-      // this would be very unlikely, but who knows ... just an ordinary TrackerHit, which is not a COMPOSITE_SPACEPOINT
-      else {
-        
-        // SJA:FIXME: fudge for now by a factor of two and ignore covariance
-        drphi =  2 * sqrt(trkhit->getCovMatrix()[0] + trkhit->getCovMatrix()[2]);         
-        dz =     sqrt(trkhit->getCovMatrix()[5]);             
-        
-      }
-      
-      // now that the hit type has been established carry on and create a 
-      
-      TrackerHitExtended * hitExt = new TrackerHitExtended( trkhit );
-      
-      // SJA:FIXME: just use planar res for now
-      hitExt->setResolutionRPhi(drphi);
-      hitExt->setResolutionZ(dz);
-      
-      // set type is now only used in one place where it is set to 0 to reject hits from a fit, set to INT_MAX to try and catch any missuse
-      hitExt->setType(int(INT_MAX));
-      // det is no longer used set to INT_MAX to try and catch any missuse
-      hitExt->setDet(int(INT_MAX));
-      
-      _allSITHits.push_back( hitExt );
-      mapTrackerHits[trkhit] = hitExt;
-      
-      
-      double pos[3];
-      
-      for (int i=0; i<3; ++i) {
-        pos[i] = trkhit->getPosition()[i];
       }
       
-      streamlog_out( DEBUG1 ) << " SIT Hit " <<  trkhit->id() << " added : @ " << pos[0] << " " << pos[1] << " " << pos[2] << " drphi " << hitExt->getResolutionRPhi() << " dz " << hitExt->getResolutionZ() << "  layer = " << layer << std::endl;
-      
     }
     
-  } catch(DataNotAvailableException &e) {
-    streamlog_out( DEBUG4 ) << " collection not found : " << _SITTrackerHitCollection.c_str() << std::endl ;
   }
   
+  // The input tracks are converted concurrently in the same way, the tasks only read the map of the
+  // hits. The hits are pointed to their tracks afterwards in the order of the tracks, so that a hit
+  // used by more than one track keeps pointing to the last one as before.
   
-  try {
+  enum { iTPCTracks, iSiTracks, nTrackCollections };
+  
+  const std::string trackColNames[nTrackCollections] = { _TPCTrackCollection, _SiTrackCollection };
+  
+  LCCollection * trackCols[nTrackCollections];
+  std::vector<TrackExtended*> trackExts[nTrackCollections];
+  std::vector<double> trackProbs[nTrackCollections];
+  std::vector<ConversionTask> trackTasks;
+  
+  for (int iCol=0; iCol<nTrackCollections; ++iCol) {
     
-    LCCollection *hitCollection = event->getCollection(_SETTrackerHitCollection.c_str());
+    trackCols[iCol] = 0;
     
-    int nelem = hitCollection->getNumberOfElements();
+    try {
+      trackCols[iCol] = event->getCollection(trackColNames[iCol].c_str());
+    }
+    catch( DataNotAvailableException &e ) {
+      continue;
+    }
     
-    streamlog_out(DEBUG5) << "Number of SET hits = " << nelem << std::endl;
+    const int nelem = trackCols[iCol]->getNumberOfElements();
+    trackExts[iCol].assign( nelem, 0 );
+    trackProbs[iCol].assign( nelem, 0. );
+    addConversionTasks( iCol, nelem, tracksPerConversionTask, trackTasks );
     
-    TrackerHit*          trkhit   = 0;
-    TrackerHitPlane*     trkhit_P = 0;
-    TrackerHitZCylinder* trkhit_C = 0;
+  }
+  
+  _taskPool.run( trackTasks.size(), [&]( int iTask ) {
     
-    double drphi(NAN);
-    double dz(NAN);
+    ConversionTask& task = trackTasks[iTask];
     
-    for (int ielem=0; ielem<nelem; ++ielem) {
-      
-      // hit could be of the following type
-      // 1) TrackerHit, either ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT or just standard TrackerHit
-      // 2) TrackerHitPlane, either 1D or 2D
-      // 3) TrackerHitZCylinder, if coming from a simple cylinder design as in the LOI
-      
-      // Establish which of these it is in the following order of likelyhood
-      //    i)   ILDTrkHitTypeBit::ONE_DIMENSIONAL (TrackerHitPlane) Should Never Happen: SpacePoints Must be Used Instead
-      //    ii)  ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT (TrackerHit)
-      //    iii) TrackerHitPlane (Two dimentional)
-      //    iv)  TrackerHitZCylinder
-      //    v)   Must be standard TrackerHit
+    for (int iTrk=task.begin; iTrk<task.end; ++iTrk) {
       
-      trkhit = dynamic_cast<TrackerHit*>(hitCollection->getElementAt(ielem));
+      Track * track = dynamic_cast<Track*>(trackCols[task.iCol]->getElementAt(iTrk));
       
-      int layer = getLayerID(trkhit);
-      
-      if (layer < 0 || (unsigned)layer >= _nLayersSET) {
-        streamlog_out(ERROR) << "FullLDCTracking_MarlinTrk => fatal error in SET : layer is outside allowed range : " << layer << std::endl;
-        exit(1);
-      }
-      
-      // first check that we have not been given 1D hits by mistake, as they won't work here
-      if ( BitSet32( trkhit->getType() )[ UTIL::ILDTrkHitTypeBit::ONE_DIMENSIONAL ] ) {
-        
-        streamlog_out(ERROR) << "FullLDCTracking_MarlinTrk: SET Hit cannot be of type UTIL::ILDTrkHitTypeBit::ONE_DIMENSIONAL COMPOSITE SPACEPOINTS must be use instead. \n\n  exit(1) called from file " << __FILE__ << " and line " << __LINE__ << std::endl;
-        exit(1);
+      if (task.iCol == iSiTracks) {
         
-      }
-      // most likely case: COMPOSITE_SPACEPOINT hits formed from stereo strip hits
-      else if ( BitSet32( trkhit->getType() )[ UTIL::ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT ] ) {
+        const double prob = ( track->getNdf() > 0 ? gsl_cdf_chisq_Q(  track->getChi2() ,  (double) track->getNdf() )  : 0. ) ;
+        trackProbs[task.iCol][iTrk] = prob;
         
-        // SJA:FIXME: fudge for now by a factor of two and ignore covariance
-        drphi =  2 * sqrt(trkhit->getCovMatrix()[0] + trkhit->getCovMatrix()[2]);
-        dz    =      sqrt(trkhit->getCovMatrix()[5]);
+        if( prob < _minChi2ProbForSiliconTracks ) continue;
         
       }
-      // or a PIXEL based SET, using 2D TrackerHitPlane like the VXD above
-      else if ( ( trkhit_P = dynamic_cast<TrackerHitPlane*>( hitCollection->getElementAt( ielem ) ) ) )  {
-        
-        // first we need to check if the measurement vectors are aligned with the global coordinates
-        gear::Vector3D U(1.0,trkhit_P->getU()[1],trkhit_P->getU()[0],gear::Vector3D::spherical);
-        gear::Vector3D V(1.0,trkhit_P->getV()[1],trkhit_P->getV()[0],gear::Vector3D::spherical);
-        gear::Vector3D Z(0.0,0.0,1.0);
-        
-        const float eps = 1.0e-07;
-        // V must be the global z axis
-        if( fabs(1.0 - V.dot(Z)) > eps ) {
-          streamlog_out(ERROR) << "FullLDCTracking_MarlinTrk: PIXEL SET Hit measurment vectors V is not equal to the global Z axis. \n\n  exit(1) called from file " << __FILE__ << " and line " << __LINE__ << std::endl;
-          exit(1);
-        }
-        
-        // U must be normal to the global z axis
-        if( fabs(U.dot(Z)) > eps ) {
-          streamlog_out(ERROR) << "FullLDCTracking_MarlinTrk: PIXEL SET Hit measurment vectors U is not in the global X-Y plane. \n\n exit(1) called from file " << __FILE__ << " and line " << __LINE__ << std::endl;
-          exit(1);
-        }
-        
-        drphi = trkhit_P->getdU();
-        dz    = trkhit_P->getdV();
-        
-      }
-      // or a simple cylindrical design, as used in the LOI
-      else if ( ( trkhit_C = dynamic_cast<TrackerHitZCylinder*>( hitCollection->getElementAt( ielem ) ) ) ) {
-        
-        drphi = trkhit_C->getdRPhi();
-        dz    = trkhit_C->getdZ();
-        
-      }
-      // this would be very unlikely, but who knows ... just an ordinary TrackerHit, which is not a COMPOSITE_SPACEPOINT
-      else {
-        
-        // SJA:FIXME: fudge for now by a factor of two and ignore covariance
-        drphi =  2 * sqrt(trkhit->getCovMatrix()[0] + trkhit->getCovMatrix()[2]);
-        dz =     sqrt(trkhit->getCovMatrix()[5]);
-        
-      }
-      
-      // now that the hit type has been established carry on and create a
-      
-      TrackerHitExtended * hitExt = new TrackerHitExtended( trkhit );
       
-      // SJA:FIXME: just use planar res for now
-      hitExt->setResolutionRPhi(drphi);
-      hitExt->setResolutionZ(dz);
+      trackExts[task.iCol][iTrk] = ConvertTrack(track, mapTrackerHits, task.error);
       
-      // set type is now only used in one place where it is set to 0 to reject hits from a fit, set to INT_MAX to try and catch any missuse
-      hitExt->setType(int(INT_MAX));
-      // det is no longer used set to INT_MAX to try and catch any missuse
-      hitExt->setDet(int(INT_MAX));
-      
-      _allSETHits.push_back( hitExt );
-      mapTrackerHits[trkhit] = hitExt;
-      
-      
-      double pos[3];
-      
-      for (int i=0; i<3; ++i) {
-        pos[i] = trkhit->getPosition()[i];
+      if (trackExts[task.iCol][iTrk] == 0) {
+        task.errorElement = iTrk;
+        return;
       }
       
-      streamlog_out( DEBUG1 ) << " SET Hit " <<  trkhit->id() << " added : @ " << pos[0] << " " << pos[1] << " " << pos[2] << " drphi " << hitExt->getResolutionRPhi() << " dz " << hitExt->getResolutionZ() << "  layer = " << layer << std::endl;
-      
     }
     
-  } catch(DataNotAvailableException &e) {
-    streamlog_out( DEBUG4 ) << " collection not found : " << _SETTrackerHitCollection.c_str() << std::endl ;
-  }
-
-    
-  // Reading VTX Hits
-  try {
-    LCCollection * col = event->getCollection(_VTXTrackerHitCollection.c_str());
-    
-    int nelem = col->getNumberOfElements();
-    
-    streamlog_out(DEBUG5) << "Number of VXD hits = " << nelem << std::endl;
-    
-    for (int ielem=0;ielem<nelem;++ielem) {
-      TrackerHitPlane * trkhit = dynamic_cast<TrackerHitPlane*>(col->getElementAt(ielem));
-      TrackerHitExtended * hitExt = new TrackerHitExtended(trkhit);
-      
-      // SJA:FIXME: just use planar res for now
-      hitExt->setResolutionRPhi(trkhit->getdU());
-      hitExt->setResolutionZ(trkhit->getdV());
-      
-      // type and det are no longer used, set to INT_MAX to try and catch any missuse
-      hitExt->setType(int(INT_MAX));      
-      hitExt->setDet(int(INT_MAX));
-      _allVTXHits.push_back( hitExt );
-      mapTrackerHits[trkhit] = hitExt;
-      
-      double pos[3];
-      
-      for (int i=0; i<3; ++i) {
-        pos[i] = trkhit->getPosition()[i];
-      }
-      
-      int layer = getLayerID(trkhit);
-      
-      streamlog_out( DEBUG1 ) << " VXD Hit " <<  trkhit->id() << " added : @ " << pos[0] << " " << pos[1] << " " << pos[2] << " drphi " << hitExt->getResolutionRPhi() << " dz " << hitExt->getResolutionZ() << "  layer = " << layer << std::endl;
-      
-      
+  });
+  
+  // a track with a hit missing from the hit collections is fatal, as for the hits in the order of the collections
+  for (unsigned iTask=0; iTask<trackTasks.size(); ++iTask) {
+    if (trackTasks[iTask].errorElement >= 0) {
+      streamlog_out(ERROR) << trackColNames[trackTasks[iTask].iCol] << ": " << trackTasks[iTask].error << std::endl;
+      exit(1);
     }
-    
-    
-  }
-  catch( DataNotAvailableException &e ) {
-    streamlog_out(DEBUG4) << _VTXTrackerHitCollection.c_str() << " collection is unavailable" << std::endl;
   }
   
-  
   // Reading TPC Tracks
-  try {
-    LCCollection * col = event->getCollection(_TPCTrackCollection.c_str());
+  if (trackCols[iTPCTracks]) {
+    LCCollection * col = trackCols[iTPCTracks];
     int nelem = col->getNumberOfElements();
     streamlog_out(DEBUG5) << std::endl;
     streamlog_out(DEBUG5) << "Number of TPC Tracks = " << nelem << " in " << _TPCTrackCollection.c_str() << std::endl;
@@ -1460,60 +1262,25 @@ void FullLDCTracking_MarlinTrk::prepareVectors(LCEvent * event ) {
       
       Track * tpcTrack = dynamic_cast<Track*>(col->getElementAt(iTrk) );
       
-      TrackerHitVec hitVec = tpcTrack->getTrackerHits();
-      int nHits = int(hitVec.size());
-      
       streamlog_out(DEBUG5) << toString( iTrk, tpcTrack ,  _bField ) << std::endl;
       
-      TrackExtended * trackExt = new TrackExtended( tpcTrack );
-      
-      trackExt->setOmega(tpcTrack->getOmega());
-      trackExt->setTanLambda(tpcTrack->getTanLambda());
-      trackExt->setPhi(tpcTrack->getPhi());
-      trackExt->setD0(tpcTrack->getD0());
-      trackExt->setZ0(tpcTrack->getZ0());
-      float cov[15];
-      float param[5];
-      //      float reso[4];
-      param[0] = tpcTrack->getOmega();
-      param[1] = tpcTrack->getTanLambda();
-      param[2] = tpcTrack->getPhi();
-      param[3] = tpcTrack->getD0();
-      param[4] = tpcTrack->getZ0();
-      
-      
-      const FloatVec Cov = tpcTrack->getCovMatrix();
-      int NC = int(Cov.size());
-      for (int ic=0;ic<NC;ic++) {
-        cov[ic] =  Cov[ic];
-      }
-      
-      
-      trackExt->setCovMatrix(cov);
-      trackExt->setNDF(tpcTrack->getNdf());
-      trackExt->setChi2(tpcTrack->getChi2());            
-      
-      
-      
-      for (int iHit=0;iHit<nHits;++iHit) {
-        TrackerHit * hit = hitVec[iHit];
-        TrackerHitExtended * hitExt = mapTrackerHits[hit];
-        hitExt->setTrackExtended( trackExt );
-        trackExt->addTrackerHitExtended( hitExt );      
-      }      
-      
+      TrackExtended * trackExt = trackExts[iTPCTracks][iTrk];
       
+      TrackerHitExtendedVec& hitVec = trackExt->getTrackerHitExtendedVec();
+      for (unsigned iHit=0;iHit<hitVec.size();++iHit) {
+        hitVec[iHit]->setTrackExtended( trackExt );
+      }
       
       _allTPCTracks.push_back( trackExt );                
     }      
   }
-  catch ( DataNotAvailableException &e) {
+  else {
     streamlog_out(DEBUG5) << _TPCTrackCollection.c_str() << " collection is unavailable" << std::endl;
   }
   
   // Reading Si Tracks
-  try {
-    LCCollection * col = event->getCollection(_SiTrackCollection.c_str());
+  if (trackCols[iSiTracks]) {
+    LCCollection * col = trackCols[iSiTracks];
     int nelem = col->getNumberOfElements();
     streamlog_out(DEBUG5) << std::endl;
     streamlog_out(DEBUG5) << "Number of Si Tracks = " << nelem << std::endl;
@@ -1522,52 +1289,21 @@ void FullLDCTracking_MarlinTrk::prepareVectors(LCEvent * event ) {
     for (int iTrk=0; iTrk<nelem; ++iTrk) {
       Track * siTrack = dynamic_cast<Track*>(col->getElementAt(iTrk));
       
-      double prob = ( siTrack->getNdf() > 0 ? gsl_cdf_chisq_Q(  siTrack->getChi2() ,  (double) siTrack->getNdf() )  : 0. ) ;
+      TrackExtended * trackExt = trackExts[iSiTracks][iTrk];
       
-      if( prob < _minChi2ProbForSiliconTracks ) {
-        streamlog_out(DEBUG5) << "Si Tracks " << siTrack << " id : " << siTrack->id() << " rejected with prob " << prob << " < " << _minChi2ProbForSiliconTracks << std::endl;
+      if( trackExt == 0 ) {
+        streamlog_out(DEBUG5) << "Si Tracks " << siTrack << " id : " << siTrack->id() << " rejected with prob " << trackProbs[iSiTracks][iTrk] << " < " << _minChi2ProbForSiliconTracks << std::endl;
         continue;
       }
       
-      TrackExtended * trackExt = new TrackExtended( siTrack );
-      TrackerHitVec hitVec = siTrack->getTrackerHits();
+      TrackerHitExtendedVec& hitVec = trackExt->getTrackerHitExtendedVec();
       int nHits = int(hitVec.size());
-      trackExt->setOmega(siTrack->getOmega());
-      trackExt->setTanLambda(siTrack->getTanLambda());
-      trackExt->setPhi(siTrack->getPhi());
-      trackExt->setD0(siTrack->getD0());
-      trackExt->setZ0(siTrack->getZ0());
-      float cov[15];
-      float param[5];
-      
-      param[0] = siTrack->getOmega();
-      param[1] = siTrack->getTanLambda();
-      param[2] = siTrack->getPhi();
-      param[3] = siTrack->getD0();
-      param[4] = siTrack->getZ0();      
-      
-      
-      
-      const FloatVec Cov = siTrack->getCovMatrix();
-      int NC = int(Cov.size());
-      for (int ic=0;ic<NC;ic++) {
-        cov[ic] =  Cov[ic];
-      } 
-      //      }
-      trackExt->setCovMatrix(cov);
-      trackExt->setNDF(siTrack->getNdf());
-      trackExt->setChi2(siTrack->getChi2());      
-      char strg[200];
-      HelixClass helixSi;
       for (int iHit=0;iHit<nHits;++iHit) {
-        TrackerHit * hit = hitVec[iHit];
-        TrackerHitExtended * hitExt = mapTrackerHits[hit];
-        hitExt->setTrackExtended( trackExt );
-        
-        trackExt->addTrackerHitExtended( hitExt );      
+        hitVec[iHit]->setTrackExtended( trackExt );
       }
       
-      
+      char strg[200];
+      HelixClass helixSi;
       float d0Si = trackExt->getD0();
       float z0Si = trackExt->getZ0();
       float omegaSi = trackExt->getOmega();
@@ -1593,16 +1329,268 @@ void FullLDCTracking_MarlinTrk::prepareVectors(LCEvent * event ) {
     
     streamlog_out(DEBUG5) << std::endl;
   }
-  catch ( DataNotAvailableException &e) {
+  else {
     streamlog_out(DEBUG5) << _SiTrackCollection.c_str() << " collection is unavailable" << std::endl;
   }
   
+  // the summaries of the input tracks are added in this order, which GetTPCTrackSummary and GetSiTrackSummary rely on
+  for (unsigned iTrk=0;iTrk<_allTPCTracks.size();++iTrk) AddTrackSummary(_allTPCTracks[iTrk]);
+  for (unsigned iTrk=0;iTrk<_allSiTracks.size();++iTrk) AddTrackSummary(_allSiTracks[iTrk]);
+  
+}
+
+TrackerHitExtended * FullLDCTracking_MarlinTrk::ConvertTPCHit(TrackerHit * hit, UTIL::BitField64& encoder, int& layer) {
+  
+  TrackerHitExtended * hitExt = new TrackerHitExtended(hit);
+  
+  // Covariance Matrix in LCIO is defined in XYZ convert to R-Phi-Z
+  // For no error in r
+  
+  double tpcRPhiRes = sqrt(hit->getCovMatrix()[0] + hit->getCovMatrix()[2]);
+  double tpcZRes = sqrt(hit->getCovMatrix()[5]);
+  
+  hitExt->setResolutionRPhi(float(tpcRPhiRes));
+  hitExt->setResolutionZ(float(tpcZRes));
+  
+  // type and det are no longer used, set to INT_MAX to try and catch any missuse
+  hitExt->setType(int(INT_MAX));
+  hitExt->setDet(int(INT_MAX));
+  
+  encoder.setValue(hit->getCellID0());
+  layer = encoder[lcio::ILDCellID0::layer];
+  
+  return hitExt;
+  
+}
+
+TrackerHitExtended * FullLDCTracking_MarlinTrk::ConvertFTDHit(TrackerHit * hit, bool pixel, UTIL::BitField64& encoder, int& layer, std::string& error) {
+  
+  double point_res_rphi(NAN);
+  
+  if (pixel) {
+    TrackerHitPlane * hitPlane = dynamic_cast<TrackerHitPlane*>(hit);
+    point_res_rphi = sqrt( hitPlane->getdU()*hitPlane->getdU() + hitPlane->getdV()*hitPlane->getdV() );
+  }
+  else {
+    // SJA:FIXME: fudge for now by a factor of two and ignore covariance
+    point_res_rphi = 2 * sqrt( hit->getCovMatrix()[0] + hit->getCovMatrix()[2] );
+  }
+  
+  // get the layer number
+  encoder.setValue(hit->getCellID0());
+  unsigned int ftdLayer = static_cast<unsigned int>(encoder[lcio::ILDCellID0::layer]);
+  unsigned int petalIndex = static_cast<unsigned int>(encoder[lcio::ILDCellID0::module]);
+  
+  if ( _petalBasedFTDWithOverlaps == true ) {
+    
+    // as we are dealing with staggered petals we will use 2*nlayers in each directions +/- z
+    // the layers will follow the even odd numbering of the petals 
+    if ( petalIndex % 2 == 0 ) {
+      ftdLayer = 2*ftdLayer;
+    }
+    else {
+      ftdLayer = 2*ftdLayer + 1;
+    }
+    
+  }
+  
+  layer = ftdLayer;
+  
+  if (ftdLayer >= _nLayersFTD) {
+    std::stringstream msg;
+    msg << "FullLDCTracking_MarlinTrk => fatal error in FTD : layer is outside allowed range : " << ftdLayer << " number of layers = " << _nLayersFTD;
+    error = msg.str();
+    return 0;
+  }
+  
+  TrackerHitExtended * hitExt = new TrackerHitExtended( hit );
+  
+  hitExt->setResolutionRPhi( point_res_rphi );
+  
+  // SJA:FIXME why is this needed? 
+  hitExt->setResolutionZ(0.1);
+  
+  // type is now only used in one place where it is set to 0 to reject hits from a fit, set to INT_MAX to try and catch any missuse
+  hitExt->setType(int(INT_MAX));
+  // det is no longer used set to INT_MAX to try and catch any missuse
+  hitExt->setDet(int(INT_MAX));
+  
+  return hitExt;
+  
+}
+
+TrackerHitExtended * FullLDCTracking_MarlinTrk::ConvertSiHit(TrackerHit * trkhit, const char * det, unsigned nLayers, UTIL::BitField64& encoder, int& layer, std::string& error) {
+  
+  // hit could be of the following type
+  // 1) TrackerHit, either ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT or just standard TrackerHit
+  // 2) TrackerHitPlane, either 1D or 2D
+  // 3) TrackerHitZCylinder, if coming from a simple cylinder design as in the LOI
+  
+  // Establish which of these it is in the following order of likelyhood
+  //    i)   ILDTrkHitTypeBit::ONE_DIMENSIONAL (TrackerHitPlane) Should Never Happen: SpacePoints Must be Used Instead
+  //    ii)  ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT (TrackerHit)
+  //    iii) TrackerHitPlane (Two dimentional)
+  //    iv)  TrackerHitZCylinder 
+  //    v)   Must be standard TrackerHit
+  
+  TrackerHitPlane*     trkhit_P = 0;
+  TrackerHitZCylinder* trkhit_C = 0;
+  
+  double drphi(NAN);
+  double dz(NAN);
+  
+  std::stringstream msg;
+  
+  encoder.setValue(trkhit->getCellID0());
+  layer = encoder[lcio::ILDCellID0::layer];
+  
+  if (layer < 0 || (unsigned)layer >= nLayers) {
+    msg << "FullLDCTracking_MarlinTrk => fatal error in " << det << " : layer is outside allowed range : " << layer;
+    error = msg.str();
+    return 0;
+  }
+  
+  // first check that we have not been given 1D hits by mistake, as they won't work here
+  if ( BitSet32( trkhit->getType() )[ UTIL::ILDTrkHitTypeBit::ONE_DIMENSIONAL ] ) {
+    
+    msg << "FullLDCTracking_MarlinTrk: " << det << " Hit cannot be of type UTIL::ILDTrkHitTypeBit::ONE_DIMENSIONAL COMPOSITE SPACEPOINTS must be use instead. \n\n  exit(1) called from file " << __FILE__ << " and line " << __LINE__;
+    error = msg.str();
+    return 0;
+    
+  } 
+  // most likely case: COMPOSITE_SPACEPOINT hits formed from stereo strip hits
+  else if ( BitSet32( trkhit->getType() )[ UTIL::ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT ] ) {
+    
+    // SJA:FIXME: fudge for now by a factor of two and ignore covariance
+    drphi =  2 * sqrt(trkhit->getCovMatrix()[0] + trkhit->getCovMatrix()[2]);         
+    dz    =      sqrt(trkhit->getCovMatrix()[5]);         
+    
+  } 
+  // or a PIXEL based SIT or SET, using 2D TrackerHitPlane like the VXD
+  else if ( ( trkhit_P = dynamic_cast<TrackerHitPlane*>( trkhit ) ) )  {
+    
+    // first we need to check if the measurement vectors are aligned with the global coordinates 
+    gear::Vector3D U(1.0,trkhit_P->getU()[1],trkhit_P->getU()[0],gear::Vector3D::spherical);
+    gear::Vector3D V(1.0,trkhit_P->getV()[1],trkhit_P->getV()[0],gear::Vector3D::spherical);
+    gear::Vector3D Z(0.0,0.0,1.0);
+    
+    const float eps = 1.0e-07;
+    // V must be the global z axis 
+    if( fabs(1.0 - V.dot(Z)) > eps ) {
+      msg << "FullLDCTracking_MarlinTrk: PIXEL " << det << " Hit measurment vectors V is not equal to the global Z axis. \n\n  exit(1) called from file " << __FILE__ << " and line " << __LINE__;
+      error = msg.str();
+      return 0;
+    }
+    
+    // U must be normal to the global z axis
+    if( fabs(U.dot(Z)) > eps ) {
+      msg << "FullLDCTracking_MarlinTrk: PIXEL " << det << " Hit measurment vectors U is not in the global X-Y plane. \n\n exit(1) called from file " << __FILE__ << " and line " << __LINE__;
+      error = msg.str();
+      return 0;
+    }
+    
+    drphi = trkhit_P->getdU();
+    dz    = trkhit_P->getdV();                                                 
+    
+  } 
+  // or a simple cylindrical design, as used in the LOI      
+  else if ( ( trkhit_C = dynamic_cast<TrackerHitZCylinder*>( trkhit ) ) ) {
+    
+    drphi = trkhit_C->getdRPhi();
+    dz    = trkhit_C->getdZ();
+    
+  } 
+  // this would be very unlikely, but who knows ... just an ordinary TrackerHit, which is not a COMPOSITE_SPACEPOINT
+  else {
+    
+    // SJA:FIXME: fudge for now by a factor of two and ignore covariance
+    drphi =  2 * sqrt(trkhit->getCovMatrix()[0] + trkhit->getCovMatrix()[2]);         
+    dz =     sqrt(trkhit->getCovMatrix()[5]);             
+    
+  }
+  
+  // now that the hit type has been established carry on and create a 
+  
+  TrackerHitExtended * hitExt = new TrackerHitExtended( trkhit );
+  
+  // SJA:FIXME: just use planar res for now
+  hitExt->setResolutionRPhi(drphi);
+  hitExt->setResolutionZ(dz);
+  
+  // set type is now only used in one place where it is set to 0 to reject hits from a fit, set to INT_MAX to try and catch any missuse
+  hitExt->setType(int(INT_MAX));
+  // det is no longer used set to INT_MAX to try and catch any missuse
+  hitExt->setDet(int(INT_MAX));
+  
+  return hitExt;
+  
+}
+
+TrackerHitExtended * FullLDCTracking_MarlinTrk::ConvertVTXHit(TrackerHitPlane * trkhit, UTIL::BitField64& encoder, int& layer) {
+  
+  TrackerHitExtended * hitExt = new TrackerHitExtended(trkhit);
+  
+  // SJA:FIXME: just use planar res for now
+  hitExt->setResolutionRPhi(trkhit->getdU());
+  hitExt->setResolutionZ(trkhit->getdV());
+  
+  // type and det are no longer used, set to INT_MAX to try and catch any missuse
+  hitExt->setType(int(INT_MAX));      
+  hitExt->setDet(int(INT_MAX));
+  
+  encoder.setValue(trkhit->getCellID0());
+  layer = encoder[lcio::ILDCellID0::layer];
+  
+  return hitExt;
+  
+}
+
+TrackExtended * FullLDCTracking_MarlinTrk::ConvertTrack(Track * track, const std::map<TrackerHit*,TrackerHitExtended*>& mapTrackerHits, std::string& error) {
+  
+  TrackExtended * trackExt = new TrackExtended( track );
+  
+  trackExt->setOmega(track->getOmega());
+  trackExt->setTanLambda(track->getTanLambda());
+  trackExt->setPhi(track->getPhi());
+  trackExt->setD0(track->getD0());
+  trackExt->setZ0(track->getZ0());
+  
+  float cov[15];
+  const FloatVec& Cov = track->getCovMatrix();
+  int NC = int(Cov.size());
+  for (int ic=0;ic<NC;ic++) {
+    cov[ic] =  Cov[ic];
+  }
+  
+  trackExt->setCovMatrix(cov);
+  trackExt->setNDF(track->getNdf());
+  trackExt->setChi2(track->getChi2());
+  
+  // the back-reference from the hits to the track is set by the caller
+  const TrackerHitVec& hitVec = track->getTrackerHits();
+  for (unsigned iHit=0;iHit<hitVec.size();++iHit) {
+    std::map<TrackerHit*,TrackerHitExtended*>::const_iterator it = mapTrackerHits.find(hitVec[iHit]);
+    if (it == mapTrackerHits.end()) {
+      std::stringstream msg;
+      msg << "FullLDCTracking_MarlinTrk => fatal error : hit " << hitVec[iHit]->id() << " of track " << track->id() << " is not in the input hit collections";
+      error = msg.str();
+      delete trackExt;
+      return 0;
+    }
+    trackExt->addTrackerHitExtended( it->second );
+  }
   
+  return trackExt;
   
 }
 
 void FullLDCTracking_MarlinTrk::CleanUp(){
   
+  CleanUpIncrementalFits();
+  
+  _trackSummaries.clear();
+  _trackSummaryIndex.clear();
+  
   int nNonCombTpc = int(_allNonCombinedTPCTracks.size());  
   for (int i=0;i<nNonCombTpc;++i) {
     TrackExtended * trkExt = _allNonCombinedTPCTracks[i];
@@ -1719,6 +1707,7 @@ void FullLDCTracking_MarlinTrk::MergeTPCandSiTracks() {
   
   for (int iTPC=0;iTPC<nTPCTracks;++iTPC) {
     TrackExtended * tpcTrackExt = _allTPCTracks[iTPC];
+    const TrackSummary& tpcSummary = GetTPCTrackSummary(iTPC);
     for (int iSi=0;iSi<nSiTracks;++iSi) {
       TrackExtended * siTrackExt = _allSiTracks[iSi];
       int iComp = 0;
@@ -1727,7 +1716,7 @@ void FullLDCTracking_MarlinTrk::MergeTPCandSiTracks() {
       streamlog_out(DEBUG2) << " compare tpc trk " << toString( iTPC,  tpcTrackExt->getTrack(), _bField  ) << std::endl ;
       streamlog_out(DEBUG2) << "    to si trk    " << toString( iSi,   siTrackExt->getTrack(),  _bField  ) << std::endl ;
       
-      float dOmega = CompareTrkII(siTrackExt,tpcTrackExt,_d0CutForMerging,_z0CutForMerging,iComp,angle);
+      float dOmega = CompareTrkII(siTrackExt,tpcTrackExt,GetSiTrackSummary(iSi),tpcSummary,_d0CutForMerging,_z0CutForMerging,iComp,angle);
       
       if ( (dOmega<_dOmegaForMerging) && (angle<_angleForMerging) && !VetoMerge(tpcTrackExt,siTrackExt)) {
 	
@@ -1811,6 +1800,7 @@ void FullLDCTracking_MarlinTrk::MergeTPCandSiTracksII() {
     // check if the tpc track has already been merged with CompareTrkII
     TrackExtended * tpcTrackExt = _allTPCTracks[iTPC];
     if(_candidateCombinedTracks.find(tpcTrackExt) != _candidateCombinedTracks.end() )continue;
+    const TrackSummary& tpcSummary = GetTPCTrackSummary(iTPC);
     
     for (int iSi=0;iSi<nSiTracks;++iSi) {
       
@@ -1821,7 +1811,7 @@ void FullLDCTracking_MarlinTrk::MergeTPCandSiTracksII() {
       int iComp = 0;
       float angleSignificance = 0;
 
-      float significance = CompareTrkIII(siTrackExt,tpcTrackExt,_d0CutForMerging,_z0CutForMerging,iComp,angleSignificance);
+      float significance = CompareTrkIII(siTrackExt,tpcTrackExt,GetSiTrackSummary(iSi),tpcSummary,_d0CutForMerging,_z0CutForMerging,iComp,angleSignificance);
 
       streamlog_out( DEBUG2 ) << " MergeTPCandSiTracksII - tpctrk " << iTPC << " - " << iSi <<  " - significance " << significance
 			      << " angleSignificance " << angleSignificance << std::endl ;
@@ -2154,6 +2144,8 @@ TrackExtended * FullLDCTracking_MarlinTrk::CombineTracks(TrackExtended * tpcTrac
       OutputTrack->addTrackerHitExtended(hitExt);
       hitExt->setUsedInFit(false);
     }
+    
+    AddTrackSummary(OutputTrack);
             
   }
   
@@ -2166,27 +2158,6 @@ TrackExtended * FullLDCTracking_MarlinTrk::CombineTracks(TrackExtended * tpcTrac
 
 
 
-void FullLDCTracking_MarlinTrk::SortingTrackHitPairs(TrackHitPairVec & trackHitPairVec) {
-  
-  int sizeOfVector = int(trackHitPairVec.size());
-  TrackHitPair *one,*two,*Temp;
-  
-  for (int i = 0 ; i < sizeOfVector-1; i++)
-    for (int j = 0; j < sizeOfVector-i-1; j++) {
-      one = trackHitPairVec[j];
-      two = trackHitPairVec[j+1];
-      float oneQ = one->getDistance();
-      float twoQ = two->getDistance();
-      if( oneQ > twoQ ) {
-        Temp = trackHitPairVec[j];
-        trackHitPairVec[j] = trackHitPairVec[j+1];
-        trackHitPairVec[j+1] = Temp;
-      }
-    }  
-  
-  
-}
-
 /*
  
  Sorts all tracks in the vector by Chi2/NDF
@@ -2336,6 +2307,8 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
       // if no tracks have been grouped with this TPC track
       if (groupTPC == NULL) {
 
+        const TrackSummary& tpcSummary = GetTPCTrackSummary(i);
+
         float diffMin = 1.0e+20;
 
         TrackExtended * siTrkToAttach = NULL;
@@ -2354,9 +2327,10 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
             float angleSignificance(0.);
             
             // try to merge tracks using looser cuts
-            float dOmega = CompareTrkII(trkExtSi,trkExtTPC,_d0CutForForcedMerging,_z0CutForForcedMerging,iComp,angle);
+            const TrackSummary& siSummary = GetSiTrackSummary(j);
+            float dOmega = CompareTrkII(trkExtSi,trkExtTPC,siSummary,tpcSummary,_d0CutForForcedMerging,_z0CutForForcedMerging,iComp,angle);
 
-            float significance = CompareTrkIII(trkExtSi,trkExtTPC,_d0CutForForcedMerging,_z0CutForForcedMerging,iComp,angleSignificance);
+            float significance = CompareTrkIII(trkExtSi,trkExtTPC,siSummary,tpcSummary,_d0CutForForcedMerging,_z0CutForForcedMerging,iComp,angleSignificance);
 
             //      if (deltaP < _dPCutForForcedMerging) {
 
@@ -2459,6 +2433,7 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
 
           _allCombinedTracks.push_back( OutputTrack );
           allMergedTracks.push_back( OutputTrack );
+          AddTrackSummary( OutputTrack );
 
         }
       }
@@ -2545,6 +2520,7 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
 
       TrackExtended * trkExt = _allTPCTracks[i];
       GroupTracks * group = trkExt->getGroupTracks();
+      const TrackSummary& trkSummary = GetTPCTrackSummary(i);
 
       streamlog_out(DEBUG2) << " *****************  AddNotCombinedTracks: Check track " << trkExt << " id = " << trkExt->getTrack()->id()  << std::endl;
       
@@ -2625,7 +2601,7 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
               int iComp = 1;
               
               // compare the tracks ... 
-              float dPt = CompareTrk(trkExt,trkInGroup,_d0CutToMergeTPC,_z0CutToMergeTPC,iComp);
+              float dPt = CompareTrk(trkExt,trkInGroup,trkSummary,GetTrackSummary(trkInGroup),_d0CutToMergeTPC,_z0CutToMergeTPC,iComp);
 
               // check that this tracks has the lowest delta pt  and vetomerge (i.e. fullfill momentum cut and makes sure a large number of hits have not been lost in the merger)
               if (dPt < dPtMin && !VetoMerge(trkExt,trkInGroup)) {
@@ -2652,7 +2628,7 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
               for (int iTrk=0;iTrk<nTrk;++iTrk) {
                 TrackExtended * trkInGroup = segVec[iTrk];
                 int iComp = 1;
-                float dPt = CompareTrk(trkExt,trkInGroup,_d0CutToMergeTPC,_z0CutToMergeTPC,iComp);              
+                float dPt = CompareTrk(trkExt,trkInGroup,trkSummary,GetTrackSummary(trkInGroup),_d0CutToMergeTPC,_z0CutToMergeTPC,iComp);              
                 if (dPt >= dPtMin) {          
                   PrintOutMerging(trkExt,trkInGroup,iopt);
                 }
@@ -2709,6 +2685,11 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
     int nCombTrk = int(_trkImplVec.size());
     int nSegments = int(TPCSegments.size());
 
+    // indices of the summaries of the combined tracks, looked up once here. Their summaries are refreshed
+    // through the index when TPC segments have been attached
+    std::vector<int> combSummaryIndex(nCombTrk);
+    for (int iCTrk=0;iCTrk<nCombTrk;++iCTrk) combSummaryIndex[iCTrk] = GetTrackSummaryIndex(_trkImplVec[iCTrk]);
+
     //    std::cout << "Combined tracks = " << nCombTrk << std::endl;
     //    std::cout << "nSegments = " << nSegments << std::endl;
 
@@ -2725,6 +2706,9 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
       TrackExtended * CombTrkToAttach = NULL;
       TrackExtended * keyTrack = NULL;
 
+      std::vector<int> segSummaryIndex(nTrk);
+      for (int iTrk=0;iTrk<nTrk;++iTrk) segSummaryIndex[iTrk] = GetTrackSummaryIndex(segVec[iTrk]);
+
       float deltaPtMin = _dPCutToMergeTPC;
 
       // search over the combined (good) tracks
@@ -2732,6 +2716,7 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
 
         TrackExtended * combTrk = _trkImplVec[iCTrk];
         GroupTracks * groupComb = combTrk->getGroupTracks();
+        const TrackSummary& combSummary = GetTrackSummary(combSummaryIndex[iCTrk]);
 
         bool consider = true;
 
@@ -2751,9 +2736,10 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
             int iopt = 0;
 
             // test for compatibility
-            float dPt = CompareTrk(trk,combTrk,_d0CutToMergeTPC,_z0CutToMergeTPC,iopt);
+            const TrackSummary& trkSummary = GetTrackSummary(segSummaryIndex[iTrk]);
+            float dPt = CompareTrk(trk,combTrk,trkSummary,combSummary,_d0CutToMergeTPC,_z0CutToMergeTPC,iopt);
             float angleSignificance(0.);
-            float significance = CompareTrkIII(trk,combTrk,_d0CutToMergeTPC,_z0CutToMergeTPC,iopt,angleSignificance);
+            float significance = CompareTrkIII(trk,combTrk,trkSummary,combSummary,_d0CutToMergeTPC,_z0CutToMergeTPC,iopt,angleSignificance);
  
             // check if this is a better match than any before
             if ( (dPt<deltaPtMin || significance <5 ) ) {
@@ -2780,7 +2766,7 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
             for (int iTrk=0;iTrk<nTrk;++iTrk) {
               TrackExtended * trk = segVec[iTrk];
               int iopt = 0;
-              float dPt = CompareTrk(trk,combTrk,_d0CutToMergeTPC,_z0CutToMergeTPC,iopt);
+              float dPt = CompareTrk(trk,combTrk,GetTrackSummary(segSummaryIndex[iTrk]),combSummary,_d0CutToMergeTPC,_z0CutToMergeTPC,iopt);
               if (dPt>deltaPtMin) {
                 GroupTracks * groupCur = combTrk->getGroupTracks();
                 TrackExtended * dummySi = groupCur->getTrackExtendedVec()[0];
@@ -2824,6 +2810,7 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
 
           }
         }
+        InvalidateTrackSummary( CombTrkToAttach );
       }
       else {
         if (nTrk==1) { // create a new group 
@@ -2907,6 +2894,7 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
                 }
               }
             }
+            InvalidateTrackSummary( chosenTrack );
             _allNonCombinedTPCTracks.push_back(chosenTrack);
             _trkImplVec.push_back(chosenTrack);
           }
@@ -2974,50 +2962,146 @@ void FullLDCTracking_MarlinTrk::AddNotCombinedTracks() {
   
 }
 
+namespace {
+  
+  /** momentum direction and hit count of a track, computed once per track in CheckTracks */
+  struct TrackDirection {
+    float mom[3];
+    float p;
+    unsigned nHits;
+    double theta;
+    double phi;
+    int iTheta;
+    int iPhi;
+    bool valid;
+  };
+  
+}
+
 void FullLDCTracking_MarlinTrk::CheckTracks() {  
   
-  for(unsigned int i = 0; i< _trkImplVec.size();i++){
+  // only pairs with an opening angle below acos(pdotCut) are tested with a trial fit. The tracks are
+  // bucketed on a (theta,phi) grid with cells at least as large as this angle, so that for every track
+  // only the cells which can contain such a partner need to be searched.
+  const double pdotCut = 0.999;
+  const double maxAngle = 1.01*acos(pdotCut); // margin for the float arithmetic of the pdot cut
+  const int nThetaCells = std::max( 1, int( M_PI/maxAngle ) );
+  const int nPhiCells = std::max( 1, int( 2.0*M_PI/maxAngle ) );
+  const double dThetaCell = M_PI/nThetaCells;
+  const double dPhiCell = 2.0*M_PI/nPhiCells;
+  
+  const unsigned nTrk = _trkImplVec.size();
+  
+  std::vector<TrackDirection> directions(nTrk);
+  std::vector<unsigned> cellStart(nThetaCells*nPhiCells+1, 0);
+  
+  for(unsigned int i = 0; i<nTrk; i++){
+    
+    TrackDirection& dir = directions[i];
+    dir.valid = false;
+    
+    TrackExtended* trk = _trkImplVec[i];
+    if(trk==NULL)continue;
+    
+    HelixClass helix;
+    helix.Initialize_Canonical(trk->getPhi(),trk->getD0(),trk->getZ0(),trk->getOmega(),trk->getTanLambda(),_bField);
+    dir.mom[0] = helix.getMomentum()[0];
+    dir.mom[1] = helix.getMomentum()[1];
+    dir.mom[2] = helix.getMomentum()[2];
+    dir.p = sqrt(dir.mom[0]*dir.mom[0]+dir.mom[1]*dir.mom[1]+dir.mom[2]*dir.mom[2]);
+    if(std::isnan(dir.p))continue;
+    
+    dir.nHits = trk->getTrackerHitExtendedVec().size();
+    if(dir.nHits<1)continue;
+    
+    double cosTheta = dir.p > 0 ? dir.mom[2]/dir.p : 1.0;
+    cosTheta = std::max( -1.0, std::min( 1.0, cosTheta ) );
+    dir.theta = acos(cosTheta);
+    dir.phi = atan2(dir.mom[1],dir.mom[0]);
+    dir.iTheta = std::min( nThetaCells-1, int( dir.theta/dThetaCell ) );
+    dir.iPhi = std::min( nPhiCells-1, std::max( 0, int( (dir.phi+M_PI)/dPhiCell ) ) );
+    dir.valid = true;
+    
+    ++cellStart[ dir.iTheta*nPhiCells + dir.iPhi + 1 ];
+    
+  }
+  
+  // counting sort of the track indices by cell, the tracks of cell c are cellTracks[ cellStart[c] ... cellStart[c+1] )
+  for(unsigned int c = 1; c<cellStart.size(); c++) cellStart[c] += cellStart[c-1];
+  
+  std::vector<unsigned> cellTracks(cellStart.back());
+  std::vector<unsigned> cellFill(cellStart.begin(), cellStart.end()-1);
+  
+  for(unsigned int i = 0; i<nTrk; i++){
+    if(directions[i].valid) cellTracks[ cellFill[ directions[i].iTheta*nPhiCells + directions[i].iPhi ]++ ] = i;
+  }
+  
+  std::vector<unsigned> partners;
+  
+  for(unsigned int i = 0; i<nTrk; i++){
+    
+    const TrackDirection& dirFirst = directions[i];
+    if(!dirFirst.valid)continue;
+    
     TrackExtended *first = _trkImplVec[i];
-    if(first==NULL)continue;
-    float d0First = first->getD0();
-    float z0First = first->getZ0();
-    float omegaFirst = first->getOmega();
-    float tanLFirst = first->getTanLambda();
-    float phiFirst = first->getPhi();
-    HelixClass helixFirst;
-    helixFirst.Initialize_Canonical(phiFirst,d0First,z0First,omegaFirst,tanLFirst,_bField);
-    float momFirst[3];
-    momFirst[0]= helixFirst.getMomentum()[0];
-    momFirst[1]= helixFirst.getMomentum()[1];
-    momFirst[2]= helixFirst.getMomentum()[2];
-    float pFirst    = sqrt(momFirst[0]*momFirst[0]+momFirst[1]*momFirst[1]+momFirst[2]*momFirst[2]);
-    if(std::isnan(pFirst))continue;
-    TrackerHitExtendedVec firstHitVec  = first->getTrackerHitExtendedVec();
-    if(firstHitVec.size()<1)continue;
-    
-    for(unsigned int j = i+1; j<_trkImplVec.size();j++){
-      TrackExtended *second = _trkImplVec[j];
-      if(second==NULL)continue;
-      float d0Second = second->getD0();
-      float z0Second = second->getZ0();
-      float omegaSecond = second->getOmega();
-      float tanLSecond = second->getTanLambda();
-      float phiSecond = second->getPhi();
-      HelixClass helixSecond;
-      helixSecond.Initialize_Canonical(phiSecond,d0Second,z0Second,omegaSecond,tanLSecond,_bField);
-      float momSecond[3];
-      momSecond[0] = helixSecond.getMomentum()[0];
-      momSecond[1] = helixSecond.getMomentum()[1];
-      momSecond[2] = helixSecond.getMomentum()[2];
-      float pSecond    = sqrt(momSecond[0]*momSecond[0]+momSecond[1]*momSecond[1]+momSecond[2]*momSecond[2]);
-      if(std::isnan(pSecond))continue;
-      TrackerHitExtendedVec secondHitVec  = second->getTrackerHitExtendedVec();
-      if(secondHitVec.size()<1)continue;
-      if(firstHitVec.size()+secondHitVec.size()<10)continue;
+    const float* momFirst = dirFirst.mom;
+    float pFirst = dirFirst.p;
+    TrackerHitExtendedVec& firstHitVec  = first->getTrackerHitExtendedVec();
+    
+    // phi window which can contain a partner: sin^2(angle/2) >= sin(theta1)*sin(theta2)*sin^2(dphi/2),
+    // where sin(theta2) is bounded from below by its minimum within maxAngle of theta1
+    const double sinMin = std::min( sin( std::max( 0.0, dirFirst.theta-maxAngle ) ), sin( std::min( M_PI, dirFirst.theta+maxAngle ) ) );
+    const double sinProduct = sin(dirFirst.theta)*sinMin;
+    
+    int iPhiLow = 0;
+    int iPhiHigh = nPhiCells-1;
+    
+    if( sinProduct > 0 ){
+      const double ratio = sin(0.5*maxAngle)/sqrt(sinProduct);
+      if( ratio < 1.0 ){
+        const double halfWidth = 2.0*asin(ratio);
+        const int low  = int( floor( (dirFirst.phi+M_PI-halfWidth)/dPhiCell ) );
+        const int high = int( floor( (dirFirst.phi+M_PI+halfWidth)/dPhiCell ) );
+        if( high-low+1 < nPhiCells ){
+          iPhiLow = low;
+          iPhiHigh = high;
+        }
+      }
+    }
+    
+    partners.clear();
+    
+    for(int iTheta = std::max(0,dirFirst.iTheta-1); iTheta <= std::min(nThetaCells-1,dirFirst.iTheta+1); ++iTheta){
+      for(int iPhi = iPhiLow; iPhi <= iPhiHigh; ++iPhi){
+        
+        const int iPhiWrapped = ( iPhi%nPhiCells + nPhiCells )%nPhiCells;
+        const unsigned cell = iTheta*nPhiCells + iPhiWrapped;
+        
+        for(unsigned k = cellStart[cell]; k<cellStart[cell+1]; ++k){
+          if(cellTracks[k] > i) partners.push_back(cellTracks[k]);
+        }
+        
+      }
+    }
+    
+    // keep the pair order of a plain loop over j > i
+    std::sort(partners.begin(), partners.end());
+    
+    for(unsigned int ip = 0; ip<partners.size(); ip++){
       
+      const unsigned j = partners[ip];
+      const TrackDirection& dirSecond = directions[j];
+      
+      TrackExtended *second = _trkImplVec[j];
+      const float* momSecond = dirSecond.mom;
+      float pSecond = dirSecond.p;
+      if(dirFirst.nHits+dirSecond.nHits<10)continue;
       
       float pdot = (momFirst[0]*momSecond[0]+momFirst[1]*momSecond[1]+momFirst[2]*momSecond[2])/pFirst/pSecond;
-      if(pdot<0.999)continue;
+      if(pdot<pdotCut)continue;
+      
+      TrackerHitExtendedVec& secondHitVec  = second->getTrackerHitExtendedVec();
+      
       // const float sigmaPOverPFirst  = sqrt(first->getCovMatrix()[5])/fabs(omegaFirst);
       // const float sigmaPOverPSecond = sqrt(second->getCovMatrix()[5])/fabs(omegaSecond);
       // const float deltaP = fabs(pFirst-pSecond);
@@ -3097,6 +3181,7 @@ void FullLDCTracking_MarlinTrk::CheckTracks() {
 
 
 float FullLDCTracking_MarlinTrk::CompareTrkII(TrackExtended * first, TrackExtended * second, 
+                                              const TrackSummary& sFirst, const TrackSummary& sSecond,
                                               float d0Cut, float z0Cut,int iopt,float & Angle) {
   
   
@@ -3107,27 +3192,14 @@ float FullLDCTracking_MarlinTrk::CompareTrkII(TrackExtended * first, TrackExtend
   float deltaOmega = fabs((omegaFirst-omegaSecond)/omegaSecond);
   if(deltaOmega> 2*_dOmegaForMerging)return result;
   
-  
-  float d0First = first->getD0();
-  float z0First = first->getZ0();
-  float d0Second = second->getD0();
-  float z0Second = second->getZ0();
-  
-  bool isCloseInIP = (fabs(d0First-d0Second)<d0Cut);
-  isCloseInIP = isCloseInIP && (fabs(z0Second-z0First)<z0Cut);
+  bool isCloseInIP = (fabs(sFirst.d0-sSecond.d0)<d0Cut);
+  isCloseInIP = isCloseInIP && (fabs(sSecond.z0-sFirst.z0)<z0Cut);
   
   
   if(!isCloseInIP)return result;
   
-  float tanLFirst = first->getTanLambda();
-  float phiFirst = first->getPhi();
-  float tanLSecond = second->getTanLambda();
-  float phiSecond = second->getPhi();
-  float qFirst = PIOVER2 - atan(tanLFirst);
-  float qSecond = PIOVER2 - atan(tanLSecond);
-  
-  Angle = (cos(phiFirst)*cos(phiSecond)+sin(phiFirst)*sin(phiSecond))*
-  sin(qFirst)*sin(qSecond)+cos(qFirst)*cos(qSecond);
+  Angle = (sFirst.cosPhi*sSecond.cosPhi+sFirst.sinPhi*sSecond.sinPhi)*
+  sFirst.sinQ*sSecond.sinQ+sFirst.cosQ*sSecond.cosQ;
   Angle = acos(Angle);
   
   result = deltaOmega;
@@ -3154,96 +3226,63 @@ float FullLDCTracking_MarlinTrk::CompareTrkII(TrackExtended * first, TrackExtend
  */
 
 float FullLDCTracking_MarlinTrk::CompareTrkIII(TrackExtended * first, TrackExtended * second, 
+                                               const TrackSummary& sFirst, const TrackSummary& sSecond,
                                                float d0Cut, float z0Cut,int iopt, float & AngleSignificance) {
   
   
   float result = 1.0e+20;
   
-  float d0First = first->getD0();
-  float z0First = first->getZ0();
-  float omegaFirst = first->getOmega();
-  float tanLFirst = first->getTanLambda();
-  float phiFirst = first->getPhi();
-  float qFirst = PIOVER2 - atan(tanLFirst);
-  
-  
-  float d0Second = second->getD0();
-  float z0Second = second->getZ0();
-  float omegaSecond = second->getOmega();
-  float tanLSecond = second->getTanLambda();
-  float phiSecond = second->getPhi();
-  float qSecond = PIOVER2 - atan(tanLSecond);
-  
-  
-  //MB 2010 03
-  float d0ErrFirst = sqrt(first->getCovMatrix()[0]);
-  float z0ErrFirst = sqrt(first->getCovMatrix()[9]);
-  //  float omegaErrFirst = sqrt(first->getCovMatrix()[5]);
-  float phiErrFirst = sqrt(first->getCovMatrix()[2]);
-  float qErrFirst = sqrt(cos(qFirst)*cos(qFirst)*first->getCovMatrix()[14]);
-  //MB END
-  //MB 2010 03
-  float d0ErrSecond = sqrt(second->getCovMatrix()[0]);
-  float z0ErrSecond = sqrt(second->getCovMatrix()[9]);
-  //  float omegaErrSecond = sqrt(second->getCovMatrix()[5]);
-  float phiErrSecond = sqrt(second->getCovMatrix()[2]);
-  float qErrSecond = sqrt(cos(qSecond)*cos(qSecond)*second->getCovMatrix()[14]);
-  //MB END
-  
-  
   //  bool isCloseInIP = (fabs(d0First-d0Second)<d0Cut);
   //isCloseInIP = isCloseInIP && (fabs(z0Second-z0First)<z0Cut);
   
   //MB 2010 03
-  bool isCloseInIP = (fabs(d0First-d0Second)/sqrt(d0ErrFirst*d0ErrFirst+d0ErrSecond*d0ErrSecond)<d0Cut);
-  isCloseInIP = isCloseInIP && (fabs(z0Second-z0First)/sqrt(z0ErrFirst*z0ErrFirst+z0ErrSecond*z0ErrSecond)<z0Cut);
+  bool isCloseInIP = (fabs(sFirst.d0-sSecond.d0)/sqrt(sFirst.d0Err*sFirst.d0Err+sSecond.d0Err*sSecond.d0Err)<d0Cut);
+  isCloseInIP = isCloseInIP && (fabs(sSecond.z0-sFirst.z0)/sqrt(sFirst.z0Err*sFirst.z0Err+sSecond.z0Err*sSecond.z0Err)<z0Cut);
   
   if (!isCloseInIP)return result;
   
-  float Angle = (cos(phiFirst)*cos(phiSecond)+sin(phiFirst)*sin(phiSecond))*
-  sin(qFirst)*sin(qSecond)+cos(qFirst)*cos(qSecond);
-  
-  
-  HelixClass helixFirst;
-  helixFirst.Initialize_Canonical(phiFirst,d0First,z0First,omegaFirst,tanLFirst,_bField);
-  HelixClass helixSecond;
-  helixSecond.Initialize_Canonical(phiSecond,d0Second,z0Second,omegaSecond,tanLSecond,_bField);
-  
-  float pFirst[3];
-  float pSecond[3];
-  float momFirst = 0;
-  float momSecond = 0;
-  
-  for (int iC=0;iC<3;++iC) {
-    pFirst[iC] = helixFirst.getMomentum()[iC];
-    pSecond[iC] = helixSecond.getMomentum()[iC];
-    momFirst += pFirst[iC]* pFirst[iC];
-    momSecond += pSecond[iC]*pSecond[iC];
-  }
-  momFirst = sqrt(momFirst);
-  momSecond = sqrt(momSecond);
+  float Angle = (sFirst.cosPhi*sSecond.cosPhi+sFirst.sinPhi*sSecond.sinPhi)*
+  sFirst.sinQ*sSecond.sinQ+sFirst.cosQ*sSecond.cosQ;
   
+  const float* pFirst = sFirst.mom;
+  const float* pSecond = sSecond.mom;
+  const float momFirst = sFirst.p;
+  const float momSecond = sSecond.p;
   
   float pdot = (pFirst[0]*pSecond[0]+pFirst[1]*pSecond[1]+pFirst[2]*pSecond[2])/momFirst/momSecond;
   if(pdot<0.999)return result;
   
-  const float sigmaPOverPFirst  = sqrt(first->getCovMatrix()[5])/fabs(omegaFirst);
-  const float sigmaPOverPSecond = sqrt(second->getCovMatrix()[5])/fabs(omegaSecond);
+  const float sigmaPOverPFirst  = sFirst.sigmaPOverP;
+  const float sigmaPOverPSecond = sSecond.sigmaPOverP;
   const float deltaP = fabs(momFirst-momSecond);
   const float sigmaPFirst = momFirst*sigmaPOverPFirst;
   const float sigmaPSecond = momSecond*sigmaPOverPSecond;
   const float sigmaDeltaP = sqrt(sigmaPFirst*sigmaPFirst+sigmaPSecond*sigmaPSecond);
   const float significance = deltaP/sigmaDeltaP;
   
+  const double sinPhiFirst = sFirst.sinPhi;
+  const double cosPhiFirst = sFirst.cosPhi;
+  const double sinQFirst = sFirst.sinQ;
+  const double cosQFirst = sFirst.cosQ;
+  const float phiErrFirst = sFirst.phiErr;
+  const float qErrFirst = sFirst.qErr;
+  
+  const double sinPhiSecond = sSecond.sinPhi;
+  const double cosPhiSecond = sSecond.cosPhi;
+  const double sinQSecond = sSecond.sinQ;
+  const double cosQSecond = sSecond.cosQ;
+  const float phiErrSecond = sSecond.phiErr;
+  const float qErrSecond = sSecond.qErr;
+  
   //MB 2010 03
-  float errorAngle =sin(phiFirst)*sin(phiFirst)*phiErrFirst*phiErrFirst*cos(phiSecond)*cos(phiSecond)+
-  sin(phiSecond)*sin(phiSecond)*phiErrSecond*phiErrSecond*cos(phiFirst)*cos(phiFirst)+
-  sin(qFirst)*sin(qFirst)*qErrFirst*qErrFirst*cos(qSecond)*cos(qSecond)+
-  sin(qSecond)*sin(qSecond)*qErrSecond*qErrSecond*cos(qFirst)*cos(qFirst)+
-  cos(phiFirst)*cos(phiFirst)*phiErrFirst*phiErrFirst*(sin(phiSecond)*sin(qFirst)*sin(qSecond))*(sin(phiSecond)*sin(qFirst)*sin(qSecond))+
-  cos(phiSecond)*cos(phiSecond)*phiErrSecond*phiErrSecond*(sin(phiFirst)*sin(qFirst)*sin(qSecond))*(sin(phiFirst)*sin(qFirst)*sin(qSecond))+
-  cos(qFirst)*cos(qFirst)*qErrFirst*qErrFirst*(sin(phiFirst)*sin(phiSecond)*sin(qSecond))*(sin(phiFirst)*sin(phiSecond)*sin(qSecond))+
-  cos(qSecond)*cos(qSecond)*qErrSecond*qErrSecond*(sin(phiFirst)*sin(phiSecond)*sin(qFirst))*(sin(phiFirst)*sin(phiSecond)*sin(qFirst));
+  float errorAngle =sinPhiFirst*sinPhiFirst*phiErrFirst*phiErrFirst*cosPhiSecond*cosPhiSecond+
+  sinPhiSecond*sinPhiSecond*phiErrSecond*phiErrSecond*cosPhiFirst*cosPhiFirst+
+  sinQFirst*sinQFirst*qErrFirst*qErrFirst*cosQSecond*cosQSecond+
+  sinQSecond*sinQSecond*qErrSecond*qErrSecond*cosQFirst*cosQFirst+
+  cosPhiFirst*cosPhiFirst*phiErrFirst*phiErrFirst*(sinPhiSecond*sinQFirst*sinQSecond)*(sinPhiSecond*sinQFirst*sinQSecond)+
+  cosPhiSecond*cosPhiSecond*phiErrSecond*phiErrSecond*(sinPhiFirst*sinQFirst*sinQSecond)*(sinPhiFirst*sinQFirst*sinQSecond)+
+  cosQFirst*cosQFirst*qErrFirst*qErrFirst*(sinPhiFirst*sinPhiSecond*sinQSecond)*(sinPhiFirst*sinPhiSecond*sinQSecond)+
+  cosQSecond*cosQSecond*qErrSecond*qErrSecond*(sinPhiFirst*sinPhiSecond*sinQFirst)*(sinPhiFirst*sinPhiSecond*sinQFirst);
   
   if(Angle<1.){
     errorAngle = sqrt(1./(1.-Angle*Angle)*errorAngle);
@@ -3292,21 +3331,16 @@ float FullLDCTracking_MarlinTrk::CompareTrkIII(TrackExtended * first, TrackExten
 
 
 float FullLDCTracking_MarlinTrk::CompareTrk(TrackExtended * first, TrackExtended * second,
+                                            const TrackSummary& sFirst, const TrackSummary& sSecond,
                                             float d0Cut, float z0Cut,int iopt) {
   
   float result = 1.0e+20;
   
   float d0First = first->getD0();
   float z0First = first->getZ0();
-  float omegaFirst = first->getOmega();
-  float tanLFirst = first->getTanLambda();
-  float phiFirst = first->getPhi();
   
   float d0Second = second->getD0();
   float z0Second = second->getZ0();
-  float omegaSecond = second->getOmega();
-  float tanLSecond = second->getTanLambda();
-  float phiSecond = second->getPhi();
   
   bool isCloseInIP = (fabs(d0First-d0Second)<d0Cut);
   
@@ -3314,42 +3348,29 @@ float FullLDCTracking_MarlinTrk::CompareTrk(TrackExtended * first, TrackExtended
   
   isCloseInIP = isCloseInIP && (fabs(z0Second-z0First)<z0Cut);
   
-  
-  HelixClass helixFirst;
-  helixFirst.Initialize_Canonical(phiFirst,d0First,z0First,omegaFirst,tanLFirst,_bField);
-  HelixClass helixSecond;
-  helixSecond.Initialize_Canonical(phiSecond,d0Second,z0Second,omegaSecond,tanLSecond,_bField);
-  
-  float pFirst[3];
-  float pSecond[3];
   float dPminus[3];
   float dPplus[3];
-  float momFirst = 0;
-  float momSecond = 0;
   float momMinus = 0;
   float momPlus = 0;
   
   if ( isCloseInIP ) {
     
+    const float* pFirst = sFirst.mom;
+    const float* pSecond = sSecond.mom;
+    
     for (int iC=0;iC<3;++iC) {
 
-      pFirst[iC] = helixFirst.getMomentum()[iC];
-      pSecond[iC] = helixSecond.getMomentum()[iC];
-
-      momFirst += pFirst[iC]* pFirst[iC];
-      momSecond += pSecond[iC]*pSecond[iC];
-
       dPminus[iC] = pFirst[iC] - pSecond[iC];
       dPplus[iC] = pFirst[iC] + pSecond[iC];
 
       momMinus += dPminus[iC]*dPminus[iC];
       momPlus += dPplus[iC]*dPplus[iC];
     }
-    momFirst = sqrt(momFirst);
-    momSecond = sqrt(momSecond);
+    const float momFirst = sFirst.p;
+    const float momSecond = sSecond.p;
     
-    float ptFirst = sqrt(pFirst[0]*pFirst[0]+pFirst[1]*pFirst[1]);
-    float ptSecond = sqrt(pSecond[0]*pSecond[0]+pSecond[1]*pSecond[1]);
+    float ptFirst = sFirst.pt;
+    float ptSecond = sSecond.pt;
     
     // if both track's pt are lower than _PtCutToMergeTPC
     if ( (ptFirst<_PtCutToMergeTPC) && (ptSecond<_PtCutToMergeTPC) ) {
@@ -3383,8 +3404,8 @@ float FullLDCTracking_MarlinTrk::CompareTrk(TrackExtended * first, TrackExtended
       
       float dpOverP = 2.0*fabs(momFirst-momSecond)/(momFirst+momSecond);
       const float pdot = (pFirst[0]*pSecond[0]+pFirst[1]*pSecond[1]+pFirst[2]*pSecond[2])/momFirst/momSecond;
-      const float sigmaPOverPFirst  = sqrt(first->getCovMatrix()[5])/fabs(omegaFirst);
-      const float sigmaPOverPSecond = sqrt(second->getCovMatrix()[5])/fabs(omegaSecond);
+      const float sigmaPOverPFirst  = sFirst.sigmaPOverP;
+      const float sigmaPOverPSecond = sSecond.sigmaPOverP;
       const float deltaP = fabs(momFirst-momSecond);
       const float sigmaPFirst = momFirst*sigmaPOverPFirst;
       const float sigmaPSecond = momSecond*sigmaPOverPSecond;
@@ -3401,6 +3422,12 @@ float FullLDCTracking_MarlinTrk::CompareTrk(TrackExtended * first, TrackExtended
          ){
         
         
+        // the helices are only needed for the distances of the hits
+        HelixClass helixFirst;
+        helixFirst.Initialize_Canonical(sFirst.phi,sFirst.d0,sFirst.z0,sFirst.omega,sFirst.tanL,_bField);
+        HelixClass helixSecond;
+        helixSecond.Initialize_Canonical(sSecond.phi,sSecond.d0,sSecond.z0,sSecond.omega,sSecond.tanL,_bField);
+        
         int nTrkGrpFirst = 0;
         int nTrkGrpSecond = 0;
         TrackerHitVec hitvecFirst;
@@ -3811,6 +3838,9 @@ void FullLDCTracking_MarlinTrk::AddNotAssignedHits() {
     }
   }
   
+  // the fits kept for the silicon hit assignment are not needed anymore, the tracks are refitted in AddTrackColToEvt
+  CleanUpIncrementalFits();
+  
   streamlog_out(DEBUG4) << "Assign TPC hits *********************************" << std::endl;
   
   if (_assignTPCHits) {// Treatment of left-over TPC hits
@@ -3857,8 +3887,59 @@ void FullLDCTracking_MarlinTrk::CleanUpExtrapolations() {
   
 }
 
+void FullLDCTracking_MarlinTrk::CleanUpIncrementalFits() {
+  
+  for (std::map<TrackExtended*,IncrementalFit>::iterator it=_incrementalFits.begin(); it!=_incrementalFits.end(); ++it) {
+    delete it->second.marlinTrk;
+  }
+  _incrementalFits.clear();
+  
+}
+
+void FullLDCTracking_MarlinTrk::DeleteIncrementalFit(TrackExtended * trkExt, MarlinTrk::IMarlinTrack* marlinTrk) {
+  
+  std::map<TrackExtended*,IncrementalFit>::iterator it = _incrementalFits.find(trkExt);
+  if (it != _incrementalFits.end() && it->second.marlinTrk == marlinTrk) {
+    _incrementalFits.erase(it);
+  }
+  delete marlinTrk;
+  
+}
+
+
+namespace {
+  
+  /** track-hit pair together with the positions of the track and the hit in the input vectors,
+   *  so that the assignment flags can be kept in plain vectors
+   */
+  struct IndexedTrackHitPair {
+    TrackHitPair * pair;
+    int iTrk;
+    int iHit;
+  };
+  
+  /** orders the pairs on distance, with stable_sort equal distances keep the order of creation */
+  struct IndexedTrackHitPairLess {
+    bool operator()( const IndexedTrackHitPair& a, const IndexedTrackHitPair& b ) const {
+      return a.pair->getDistance() < b.pair->getDistance();
+    }
+  };
+  
+  /** hit and track within the distance cut, ordered like a loop over the hits and then over the tracks */
+  struct HitTrackCandidate {
+    int iHit;
+    int iTrk;
+    float distance;
+    bool operator<( const HitTrackCandidate& other ) const {
+      return iHit < other.iHit || ( iHit == other.iHit && iTrk < other.iTrk );
+    }
+  };
+  
+}
+
+void FullLDCTracking_MarlinTrk::AssignOuterHitsToTracks(const TrackerHitExtendedVec& hitVec, float dcut, int refit) {
 
-void FullLDCTracking_MarlinTrk::AssignOuterHitsToTracks(TrackerHitExtendedVec hitVec, float dcut, int refit) {
+  StageTimers::Scope timeAssign( _timers, _stageAssignOuterHitsToTracks );
 
   streamlog_out(DEBUG3) << "FullLDCTracking_MarlinTrk::AssignOuterHitsToTracks dcut = " << dcut << std::endl;
   
@@ -3866,67 +3947,94 @@ void FullLDCTracking_MarlinTrk::AssignOuterHitsToTracks(TrackerHitExtendedVec hi
   int nHits = int(hitVec.size());
   int nTrk = int(_trkImplVec.size());
   
-  // create maps to record which tracks and tracker hits are flagged for assignment
-  std::map <TrackExtended*,bool> flagTrack;
-  std::map <TrackerHitExtended*,bool> flagHit;
+  // record which tracks and tracker hits are flagged for assignment
+  std::vector<char> flagTrack(nTrk, false);
+  std::vector<char> flagHit(nHits, false);
 
   // vector to hold the matchups and the distance of closest approach.
-  TrackHitPairVec pairs;
+  std::vector<IndexedTrackHitPair> pairs;
 
-  flagTrack.clear();
-  flagHit.clear();
-  pairs.clear();
+  // index the hits in x-y, so that each helix is only compared to the hits close to its circle
+  std::vector<float> hitX(nHits), hitY(nHits), hitZ(nHits);
   
-  // loop over all hits under consideration ...
   for (int iH=0;iH<nHits;++iH) {
-
-    float pos[3];
+    const double* pos = hitVec[iH]->getTrackerHit()->getPosition();
+    hitX[iH] = float(pos[0]);
+    hitY[iH] = float(pos[1]);
+    hitZ[iH] = float(pos[2]);
+  }
+  
+  HitGridXY hitGrid;
+  hitGrid.build(hitX, hitY, dcut);
+  
+  // the hit track combinations within the distance cut
+  std::vector<HitTrackCandidate> candidates;
+  std::vector<int> nearHits;
+  std::vector<int> closeHits;
+  std::vector<float> closeDistances;
+  HelixDistanceBatch distanceBatch;
+  
+  for (int iT=0;iT<nTrk;++iT) {
     
-    TrackerHitExtended * trkHitExt = hitVec[iH];
-    TrackerHit * hit = trkHitExt->getTrackerHit();
+    TrackExtended * trkExt = _trkImplVec[iT];
     
-    for (int ip=0;ip<3;++ip) {
-      pos[ip] = float(hit->getPosition()[ip]);
+    // use the previously created trackextrapolations for the
+    HelixClass * helix = _trackExtrapolatedHelix[trkExt];
+    
+    // skip if the extrapolations failed
+    if (helix==0) {
+      streamlog_out(DEBUG3) << "helix extrapolation failed for trkExt" << std::endl;
+      continue;
     }
-            
-    // loop over all tracks in same z-half ...
-    for (int iT=0;iT<nTrk;++iT) {
-      
-      TrackExtended * trkExt = _trkImplVec[iT];
-      float tanLambda = trkExt->getTanLambda();           
-      float product = pos[2]*tanLambda;
-      // check that the hit and track are in the same z-half, which won't work for the rare cases of something going backwards ...
-      
-      if (product>0) {
-      
-        // use the previously created trackextrapolations for the
-        HelixClass * helix = _trackExtrapolatedHelix[trkExt];
-        
-        // skip if the extrapolations failed
-        if (helix==0) {
-          streamlog_out(DEBUG3) << "helix extrapolation failed for trkExt" << std::endl;
-          continue;
-        }
-        
-        float distance = helix->getDistanceToPoint(pos,dcut);
-        
-        streamlog_out(DEBUG1) << "for helix extrapolation " << helix << " distance = " << distance << std::endl;
-        
-        // check the distance is less than the steerable cut ...
-        if (distance<dcut) {
-
-          streamlog_out(DEBUG3) << "for helix extrapolation " << helix << " distance = " << distance << std::endl;
-          
-          // ... if so create the association and flag the hit and track
-          TrackHitPair * trkHitPair =
-          new TrackHitPair(trkExt,trkHitExt,distance);
-          pairs.push_back(trkHitPair);
-          flagTrack[trkExt] = true;
-          flagHit[trkHitExt] = true;
-
-        }
-      }
+    
+    nearHits.clear();
+    hitGrid.findNearCircle(helix->getXC(), helix->getYC(), helix->getRadius(), dcut, nearHits);
+    
+    // check that the hit and track are in the same z-half, which won't work for the rare cases of something going backwards ...
+    float tanLambda = trkExt->getTanLambda();
+    unsigned nSameHalf = 0;
+    for (unsigned k=0;k<nearHits.size();++k) {
+      if (hitZ[nearHits[k]]*tanLambda>0) nearHits[nSameHalf++] = nearHits[k];
     }
+    nearHits.resize(nSameHalf);
+    
+    // check the distance is less than the steerable cut ...
+    closeHits.clear();
+    closeDistances.clear();
+    distanceBatch.select(*helix, hitX, hitY, hitZ, nearHits, dcut, closeHits, closeDistances);
+    
+    for (unsigned k=0;k<closeHits.size();++k) {
+      HitTrackCandidate candidate;
+      candidate.iHit = closeHits[k];
+      candidate.iTrk = iT;
+      candidate.distance = closeDistances[k];
+      candidates.push_back(candidate);
+    }
+    
+  }
+  
+  // keep the order of creation of the pairs as for a loop over the hits and then over the tracks
+  std::sort(candidates.begin(), candidates.end());
+  
+  for (unsigned iC=0;iC<candidates.size();++iC) {
+    
+    const int iH = candidates[iC].iHit;
+    const int iT = candidates[iC].iTrk;
+    const float distance = candidates[iC].distance;
+    
+    TrackExtended * trkExt = _trkImplVec[iT];
+    
+    streamlog_out(DEBUG3) << "for helix extrapolation " << _trackExtrapolatedHelix[trkExt] << " distance = " << distance << std::endl;
+    
+    // ... if so create the association and flag the hit and track
+    IndexedTrackHitPair trkHitPair;
+    trkHitPair.pair = new TrackHitPair(trkExt,hitVec[iH],distance);
+    trkHitPair.iTrk = iT;
+    trkHitPair.iHit = iH;
+    pairs.push_back(trkHitPair);
+    flagTrack[iT] = true;
+    flagHit[iH] = true;
+    
   }
   
   int nPairs = int(pairs.size());
@@ -3936,23 +4044,24 @@ void FullLDCTracking_MarlinTrk::AssignOuterHitsToTracks(TrackerHitExtendedVec hi
   if (nPairs>0) {
 
     // sort the pairs on distance 
-    SortingTrackHitPairs(pairs);
+    std::stable_sort(pairs.begin(), pairs.end(), IndexedTrackHitPairLess());
 
     for (int iP=0;iP<nPairs;++iP) {
 
-      TrackHitPair * trkHitPair = pairs[iP];
+      TrackHitPair * trkHitPair = pairs[iP].pair;
       TrackExtended * trkExt = trkHitPair->getTrackExtended();
       TrackerHitExtended * trkHitExt = 
 
       trkHitPair->getTrackerHitExtended();
 
       // check if the track or hit is still free to be combined
-      if (flagTrack[trkExt] && flagHit[trkHitExt]) {
+      if (flagTrack[pairs[iP].iTrk] && flagHit[pairs[iP].iHit]) {
 
         if (refit==0) { // just set the association
           trkExt->addTrackerHitExtended( trkHitExt );
           trkHitExt->setUsedInFit( false );
           trkHitExt->setTrackExtended( trkExt );
+          InvalidateTrackSummary( trkExt );
         }
 
         else {
@@ -4146,8 +4255,9 @@ void FullLDCTracking_MarlinTrk::AssignOuterHitsToTracks(TrackerHitExtendedVec hi
           trkExt->addTrackerHitExtended( trkHitExt );
           trkHitExt->setTrackExtended( trkExt );
           trkHitExt->setUsedInFit( true );
-          flagTrack[trkExt] = false;
-          flagHit[trkHitExt] = false;
+          InvalidateTrackSummary( trkExt );
+          flagTrack[pairs[iP].iTrk] = false;
+          flagHit[pairs[iP].iHit] = false;
           
           
           streamlog_out(DEBUG2) << "AssignOuterHitsToTracks: Hit " << trkHitExt << " successfully assigned to track " << trkExt << std::endl;
@@ -4159,7 +4269,7 @@ void FullLDCTracking_MarlinTrk::AssignOuterHitsToTracks(TrackerHitExtendedVec hi
     }
     
     for (int iP=0;iP<nPairs;++iP) {
-      TrackHitPair * trkHitPair = pairs[iP];
+      TrackHitPair * trkHitPair = pairs[iP].pair;
       delete trkHitPair;
     }
     
@@ -4240,9 +4350,11 @@ HelixClass * FullLDCTracking_MarlinTrk::GetExtrapolationHelix( TrackExtended * t
 }
 
 
-void FullLDCTracking_MarlinTrk::AssignTPCHitsToTracks(TrackerHitExtendedVec hitVec,
+void FullLDCTracking_MarlinTrk::AssignTPCHitsToTracks(const TrackerHitExtendedVec& hitVec,
                                                       float dcut) {
   
+  StageTimers::Scope timeAssign( _timers, _stageAssignTPCHitsToTracks );
+  
   int nHits = int(hitVec.size());
   int nTrk = int(_trkImplVec.size());
   
@@ -4253,7 +4365,7 @@ void FullLDCTracking_MarlinTrk::AssignTPCHitsToTracks(TrackerHitExtendedVec hitV
     int nTrkGrp = int(tracksInGroup.size());
     for (int iTrkGrp=0;iTrkGrp<nTrkGrp;++iTrkGrp) {
       TrackExtended * trkGrp = tracksInGroup[iTrkGrp];
-      TrackerHitExtendedVec hitVecGrp = trkGrp->getTrackerHitExtendedVec();
+      TrackerHitExtendedVec& hitVecGrp = trkGrp->getTrackerHitExtendedVec();
       int nHits_Grp = int(hitVecGrp.size());
       float zMin = 1.0e+20;
       float zMax = -1.0e+20;
@@ -4298,6 +4410,22 @@ void FullLDCTracking_MarlinTrk::AssignTPCHitsToTracks(TrackerHitExtendedVec hitV
     HitSign[iH]=std::signbit(temppos[2]);
   }    
   
+  // index the hits in x-y, so that each helix is only compared to the hits close to its circle
+  std::vector<float> hitX(nHits), hitY(nHits), hitZ(nHits);
+  for (int iH=0;iH<nHits;++iH) {
+    hitX[iH] = HitPositions[iH][0];
+    hitY[iH] = HitPositions[iH][1];
+    hitZ[iH] = HitPositions[iH][2];
+  }
+  
+  HitGridXY hitGrid;
+  hitGrid.build(hitX, hitY, dcut);
+  
+  std::vector<int> nearHits;
+  std::vector<int> closeHits;
+  std::vector<float> closeDistances;
+  HelixDistanceBatch distanceBatch;
+  
   streamlog_out(DEBUG3) << "AssignTPCHitsToTracks: Starting loop " << nTrk << " tracks   and  " << nHits << " hits" << std::endl;
   
   for (int iT=0;iT<nTrk;++iT) { // loop over all tracks
@@ -4320,7 +4448,15 @@ void FullLDCTracking_MarlinTrk::AssignTPCHitsToTracks(TrackerHitExtendedVec hitV
       helix.Initialize_Canonical(phi0,d0,z0,omega,tanLambda,_bField);
       float OnePFivehalfPeriodZ = 1.5*fabs(acos(-1.)*tanLambda/omega);
       
-      for (int iH=0;iH<nHits;++iH) { // loop over leftover TPC hits
+      // only the hits within dcut of the helix in x-y can pass the distance cut
+      nearHits.clear();
+      hitGrid.findNearCircle(helix.getXC(), helix.getYC(), helix.getRadius(), dcut, nearHits);
+      
+      unsigned nConsidered = 0;
+      
+      for (unsigned iN=0;iN<nearHits.size();++iN) { // loop over leftover TPC hits close to the helix
+        
+        const int iH = nearHits[iN];
         
         //check if the hit and the track or on the same side
         //xor return 1, if hits are different
@@ -4332,14 +4468,21 @@ void FullLDCTracking_MarlinTrk::AssignTPCHitsToTracks(TrackerHitExtendedVec hitV
         consider = consider || (DeltaEnd <= OnePFivehalfPeriodZ);
         consider = consider || ( (HitPositions[iH][2]>=startPointZ) && (HitPositions[iH][2]<=endPointZ) );
         
-        if(consider){
-          float distance = helix.getDistanceToPoint(HitPositions[iH], minDistances[iH]);
-          if (distance < minDistances[iH]) {
-            minDistances[iH] = distance;
-            tracksToAttach[iH] = foundTrack;
-          }
-        }
+        if(consider) nearHits[nConsidered++] = iH;
+        
       } // loop over leftover TPC hits
+      
+      nearHits.resize(nConsidered);
+      
+      // each hit appears once per helix, so the current closest distance of each hit is the cut
+      closeHits.clear();
+      closeDistances.clear();
+      distanceBatch.select(helix, hitX, hitY, hitZ, nearHits, minDistances, closeHits, closeDistances);
+      
+      for (unsigned k=0;k<closeHits.size();++k) {
+        minDistances[closeHits[k]] = closeDistances[k];
+        tracksToAttach[closeHits[k]] = foundTrack;
+      }
     } //groups in tracks
   } // loop over all tracks
   
@@ -4349,6 +4492,7 @@ void FullLDCTracking_MarlinTrk::AssignTPCHitsToTracks(TrackerHitExtendedVec hitV
       tracksToAttach[iH]->addTrackerHitExtended(trkHitExt);
       trkHitExt->setTrackExtended( tracksToAttach[iH] );
       trkHitExt->setUsedInFit( false );
+      InvalidateTrackSummary( tracksToAttach[iH] );
     }
   }
   
@@ -4419,64 +4563,96 @@ void FullLDCTracking_MarlinTrk::AssignTPCHitsToTracks(TrackerHitExtendedVec hitV
   
 }
 
-void FullLDCTracking_MarlinTrk::AssignSiHitsToTracks(TrackerHitExtendedVec hitVec,
+void FullLDCTracking_MarlinTrk::AssignSiHitsToTracks(const TrackerHitExtendedVec& hitVec,
                                                      float dcut) {
   
+  StageTimers::Scope timeAssign( _timers, _stageAssignSiHitsToTracks );
+  
   int nHits = int(hitVec.size());
   int nTrk = int(_allNonCombinedTPCTracks.size());
   
   streamlog_out(DEBUG3) << "AssignSiHitsToTracks : Number of hits to assign " <<  hitVec.size() << " : Number of available tracks = " << nTrk << std::endl;
   
-  std::map <TrackExtended*,bool> flagTrack;
-  std::map <TrackerHitExtended*,bool> flagHit;
-  TrackHitPairVec pairs;
-  flagTrack.clear();
-  flagHit.clear();
-  pairs.clear();
+  std::vector<char> flagTrack(nTrk, false);
+  std::vector<char> flagHit(nHits, false);
+  std::vector<IndexedTrackHitPair> pairs;
+  
+  // index the hits in x-y, so that each helix is only compared to the hits close to its circle
+  std::vector<float> hitX(nHits), hitY(nHits), hitZ(nHits);
   
   for (int iH=0;iH<nHits;++iH) {
+    const double* pos = hitVec[iH]->getTrackerHit()->getPosition();
+    hitX[iH] = float(pos[0]);
+    hitY[iH] = float(pos[1]);
+    hitZ[iH] = float(pos[2]);
+  }
+  
+  HitGridXY hitGrid;
+  hitGrid.build(hitX, hitY, dcut);
+  
+  // the hit track combinations within the distance cut
+  std::vector<HitTrackCandidate> candidates;
+  std::vector<int> nearHits;
+  std::vector<int> closeHits;
+  std::vector<float> closeDistances;
+  HelixDistanceBatch distanceBatch;
+  
+  for (int iT=0;iT<nTrk;++iT) {
     
-    float pos[3];
-    TrackerHitExtended * trkHitExt = hitVec[iH];
-    TrackerHit * hit = trkHitExt->getTrackerHit();
+    TrackExtended * trkExt = _allNonCombinedTPCTracks[iT];
     
-    for (int ip=0;ip<3;++ip) {
-      pos[ip] = float(hit->getPosition()[ip]);
-    }
+    float d0 = trkExt->getD0();
+    float z0 = trkExt->getZ0();
+    float phi0 = trkExt->getPhi();
+    float omega = trkExt->getOmega();
+    float tanLambda = trkExt->getTanLambda();
     
-    for (int iT=0;iT<nTrk;++iT) {
-      
-      TrackExtended * trkExt = _allNonCombinedTPCTracks[iT];
-      
-      float tanLambda = trkExt->getTanLambda();       
-      float product = pos[2]*tanLambda;
-      
-      streamlog_out(DEBUG0) << "AssignSiHitsToTracks : product =  " << product << " z hit = " << pos[2] <<  std::endl;
-      
-      
-      if (product>0) {
-        
-        float d0 = trkExt->getD0();
-        float z0 = trkExt->getZ0();
-        float phi0 = trkExt->getPhi();
-        float omega = trkExt->getOmega();
-        tanLambda = trkExt->getTanLambda();
-        
-        HelixClass helix;
-        helix.Initialize_Canonical(phi0,d0,z0,omega,tanLambda,_bField);
-        float distance = helix.getDistanceToPoint(pos,dcut);
-        
-        streamlog_out(DEBUG0) << "AssignSiHitsToTracks : distance =  " << distance << " cut = " << dcut << std::endl;
-        
-        if (distance<dcut) {
-          TrackHitPair * trkHitPair = 
-          new TrackHitPair(trkExt,trkHitExt,distance);
-          pairs.push_back(trkHitPair);
-          flagTrack[trkExt] = true;
-          flagHit[trkHitExt] = true;
-        }
-      }
+    // the helix is created once per track instead of once per hit and track
+    HelixClass helix;
+    helix.Initialize_Canonical(phi0,d0,z0,omega,tanLambda,_bField);
+    
+    nearHits.clear();
+    hitGrid.findNearCircle(helix.getXC(), helix.getYC(), helix.getRadius(), dcut, nearHits);
+    
+    // only hits in the same z-half as the track
+    unsigned nSameHalf = 0;
+    for (unsigned k=0;k<nearHits.size();++k) {
+      if (hitZ[nearHits[k]]*tanLambda>0) nearHits[nSameHalf++] = nearHits[k];
     }
+    nearHits.resize(nSameHalf);
+    
+    closeHits.clear();
+    closeDistances.clear();
+    distanceBatch.select(helix, hitX, hitY, hitZ, nearHits, dcut, closeHits, closeDistances);
+    
+    for (unsigned k=0;k<closeHits.size();++k) {
+      HitTrackCandidate candidate;
+      candidate.iHit = closeHits[k];
+      candidate.iTrk = iT;
+      candidate.distance = closeDistances[k];
+      candidates.push_back(candidate);
+    }
+    
+  }
+  
+  // keep the order of creation of the pairs as for a loop over the hits and then over the tracks
+  std::sort(candidates.begin(), candidates.end());
+  
+  for (unsigned iC=0;iC<candidates.size();++iC) {
+    
+    const int iH = candidates[iC].iHit;
+    const int iT = candidates[iC].iTrk;
+    
+    streamlog_out(DEBUG0) << "AssignSiHitsToTracks : distance =  " << candidates[iC].distance << " cut = " << dcut << std::endl;
+    
+    IndexedTrackHitPair trkHitPair;
+    trkHitPair.pair = new TrackHitPair(_allNonCombinedTPCTracks[iT],hitVec[iH],candidates[iC].distance);
+    trkHitPair.iTrk = iT;
+    trkHitPair.iHit = iH;
+    pairs.push_back(trkHitPair);
+    flagTrack[iT] = true;
+    flagHit[iH] = true;
+    
   }
   
   int nPairs = int(pairs.size());
@@ -4485,17 +4661,17 @@ void FullLDCTracking_MarlinTrk::AssignSiHitsToTracks(TrackerHitExtendedVec hitVe
   
   if (nPairs>0) {
     
-    SortingTrackHitPairs(pairs);
+    std::stable_sort(pairs.begin(), pairs.end(), IndexedTrackHitPairLess());
     
     for (int iP=0;iP<nPairs;++iP) {
       
-      TrackHitPair * trkHitPair = pairs[iP];
+      TrackHitPair * trkHitPair = pairs[iP].pair;
       TrackExtended * trkExt = trkHitPair->getTrackExtended();
       TrackerHitExtended * trkHitExt = 
       
       trkHitPair->getTrackerHitExtended();
       
-      if (flagTrack[trkExt] && flagHit[trkHitExt]) {              
+      if (flagTrack[pairs[iP].iTrk] && flagHit[pairs[iP].iHit]) {              
         
         // get the hits already assigned to the track
         TrackerHitExtendedVec hitsInTrack = trkExt->getTrackerHitExtendedVec();
@@ -4545,85 +4721,133 @@ void FullLDCTracking_MarlinTrk::AssignSiHitsToTracks(TrackerHitExtendedVec hitVe
         
         if( trkHits.size() < 3 ) return ;
         
-        // sort the hits in R
-        std::vector< std::pair<float, EVENT::TrackerHit*> > r2_values;
-        r2_values.reserve(trkHits.size());
+        const double* remainPos = remainHit->getPosition();
+        float remainR2 = remainPos[0]*remainPos[0]+remainPos[1]*remainPos[1];
         
-        for (TrackerHitVec::iterator it=trkHits.begin(); it!=trkHits.end(); ++it) {
-          EVENT::TrackerHit* h = *it;
-          float r2 = h->getPosition()[0]*h->getPosition()[0]+h->getPosition()[1]*h->getPosition()[1];
-          r2_values.push_back(std::make_pair(r2, *it));
-        }
+        MarlinTrk::IMarlinTrack* marlin_trk = 0;
+        int nOutliers = 0;
+        float r2Min = remainR2;
         
-        sort(r2_values.begin(),r2_values.end());
+        // set if the kept fit rejected the hit, its state is then unchanged and stays usable
+        bool hitRejected = false;
         
-        trkHits.clear();
-        trkHits.reserve(r2_values.size());
+        // the backward fit kept from the last hit assigned to this track ends at its innermost hit,
+        // a hit further inside only needs one more filter step instead of a refit of all hits
+        std::map<TrackExtended*,IncrementalFit>::iterator fitIt = _incrementalFits.find(trkExt);
         
-        for (std::vector< std::pair<float, EVENT::TrackerHit*> >::iterator it=r2_values.begin(); it!=r2_values.end(); ++it) {
-          trkHits.push_back(it->second);
+        if (fitIt != _incrementalFits.end()) {
+          
+          IncrementalFit& incFit = fitIt->second;
+          
+          if (incFit.nHitsInFit == nHitsInFit && remainR2 < incFit.r2Min) {
+            
+            double chi2inc = 0.;
+            int error = incFit.marlinTrk->addAndFit(remainHit, chi2inc, _maxChi2PerHit);
+            
+            streamlog_out(DEBUG2) << "AssignSiHitsToTracks: addAndFit to the kept fit returns " << error << " chi2 increment = " << chi2inc << std::endl;
+            
+            if (error == IMarlinTrack::success || error == IMarlinTrack::site_fails_chi2_cut) {
+              marlin_trk = incFit.marlinTrk;
+              nOutliers = incFit.nOutliers;
+              hitRejected = ( error == IMarlinTrack::site_fails_chi2_cut );
+              if (hitRejected) ++nOutliers;
+            }
+            
+          }
+          
+          if (marlin_trk == 0) {
+            delete incFit.marlinTrk;
+            _incrementalFits.erase(fitIt);
+          }
+          
         }
         
+        if (marlin_trk == 0) {
+          
+          // sort the hits in R
+          std::vector< std::pair<float, EVENT::TrackerHit*> > r2_values;
+          r2_values.reserve(trkHits.size());
+        
+          for (TrackerHitVec::iterator it=trkHits.begin(); it!=trkHits.end(); ++it) {
+            EVENT::TrackerHit* h = *it;
+            float r2 = h->getPosition()[0]*h->getPosition()[0]+h->getPosition()[1]*h->getPosition()[1];
+            r2_values.push_back(std::make_pair(r2, *it));
+          }
+        
+          sort(r2_values.begin(),r2_values.end());
+        
+          trkHits.clear();
+          trkHits.reserve(r2_values.size());
+        
+          for (std::vector< std::pair<float, EVENT::TrackerHit*> >::iterator it=r2_values.begin(); it!=r2_values.end(); ++it) {
+            trkHits.push_back(it->second);
+          }
+        
         
-        streamlog_out(DEBUG2) << "AssignSiHitsToTracks: Start Fitting: AddHits: number of hits to fit " << trkHits.size() << std::endl;
+          streamlog_out(DEBUG2) << "AssignSiHitsToTracks: Start Fitting: AddHits: number of hits to fit " << trkHits.size() << std::endl;
                 
         
-        MarlinTrk::IMarlinTrack* marlin_trk = _trksystem->createTrack();
+          marlin_trk = _trksystem->createTrack();
         
-        IMPL::TrackStateImpl pre_fit ;
+          IMPL::TrackStateImpl pre_fit ;
         
         
-        pre_fit.setD0(trkExt->getD0());
-        pre_fit.setPhi(trkExt->getPhi());
-        pre_fit.setZ0(trkExt->getZ0());
-        pre_fit.setOmega(trkExt->getOmega());
-        pre_fit.setTanLambda(trkExt->getTanLambda());
+          pre_fit.setD0(trkExt->getD0());
+          pre_fit.setPhi(trkExt->getPhi());
+          pre_fit.setZ0(trkExt->getZ0());
+          pre_fit.setOmega(trkExt->getOmega());
+          pre_fit.setTanLambda(trkExt->getTanLambda());
         
-        float ref[3];
-        ref[0]=ref[1]=ref[2]=0.0;
+          float ref[3];
+          ref[0]=ref[1]=ref[2]=0.0;
         
-        pre_fit.setReferencePoint(ref);
+          pre_fit.setReferencePoint(ref);
         
-        pre_fit.setLocation(lcio::TrackStateImpl::AtIP);
+          pre_fit.setLocation(lcio::TrackStateImpl::AtIP);
         
-        // setup initial dummy covariance matrix
-        EVENT::FloatVec covMatrix;
-        covMatrix.resize(15);
+          // setup initial dummy covariance matrix
+          EVENT::FloatVec covMatrix;
+          covMatrix.resize(15);
         
-        for (unsigned icov = 0; icov<covMatrix.size(); ++icov) {
-          covMatrix[icov] = 0;
-        }
+          for (unsigned icov = 0; icov<covMatrix.size(); ++icov) {
+            covMatrix[icov] = 0;
+          }
         
-        covMatrix[0]  = ( _initialTrackError_d0    ); //sigma_d0^2
-        covMatrix[2]  = ( _initialTrackError_phi0  ); //sigma_phi0^2
-        covMatrix[5]  = ( _initialTrackError_omega ); //sigma_omega^2
-        covMatrix[9]  = ( _initialTrackError_z0    ); //sigma_z0^2
-        covMatrix[14] = ( _initialTrackError_tanL  ); //sigma_tanl^2
+          covMatrix[0]  = ( _initialTrackError_d0    ); //sigma_d0^2
+          covMatrix[2]  = ( _initialTrackError_phi0  ); //sigma_phi0^2
+          covMatrix[5]  = ( _initialTrackError_omega ); //sigma_omega^2
+          covMatrix[9]  = ( _initialTrackError_z0    ); //sigma_z0^2
+          covMatrix[14] = ( _initialTrackError_tanL  ); //sigma_tanl^2
         
-        pre_fit.setCovMatrix(covMatrix);
+          pre_fit.setCovMatrix(covMatrix);
         
-        int error = MarlinTrk::createFit( trkHits, marlin_trk, &pre_fit, _bField, IMarlinTrack::backward , _maxChi2PerHit );
+          int error = MarlinTrk::createFit( trkHits, marlin_trk, &pre_fit, _bField, IMarlinTrack::backward , _maxChi2PerHit );
         
-        if ( error != IMarlinTrack::success ) {
+          if ( error != IMarlinTrack::success ) {
           
-          streamlog_out(DEBUG3) << "FullLDCTracking_MarlinTrk::AssignSiHitsToTracks: creation of fit fails with error " << error << std::endl;
+            streamlog_out(DEBUG3) << "FullLDCTracking_MarlinTrk::AssignSiHitsToTracks: creation of fit fails with error " << error << std::endl;
           
-          delete marlin_trk ;
-          continue ;
+            delete marlin_trk ;
+            continue ;
           
-        }
+          }
+        
+          std::vector<std::pair<EVENT::TrackerHit* , double> > outliers ;
+          marlin_trk->getOutliers(outliers);
         
-        std::vector<std::pair<EVENT::TrackerHit* , double> > outliers ;
-        marlin_trk->getOutliers(outliers);
+          nOutliers = outliers.size();
+          r2Min = r2_values.front().first;
+          
+        }
         
-        float outlier_pct = outliers.size()/float(trkHits.size());
+        float outlier_pct = nOutliers/float(trkHits.size());
         
         streamlog_out(DEBUG1) << "FullLDCTracking_MarlinTrk::AssignSiHitsToTracks: percentage of outliers " << outlier_pct << std::endl;
         
         if ( outlier_pct > _maxAllowedPercentageOfOutliersForTrackCombination) {
           
           streamlog_out(DEBUG2) << "FullLDCTracking_MarlinTrk::AssignSiHitsToTracks: percentage of outliers " << outlier_pct << " is greater than cut maximum: " << _maxAllowedPercentageOfOutliersForTrackCombination << std::endl;
-          delete marlin_trk ;
+          if (!hitRejected) DeleteIncrementalFit(trkExt, marlin_trk);
           continue ;
           
         }
@@ -4634,12 +4858,11 @@ void FullLDCTracking_MarlinTrk::AssignSiHitsToTracks(TrackerHitExtendedVec hitVe
         TrackStateImpl trkState ;
         return_code = marlin_trk->propagate(point, trkState, chi2_D, ndf ) ;
         
-        delete marlin_trk ;
-        
-        if ( error != IMarlinTrack::success ) {
+        if ( return_code != IMarlinTrack::success ) {
           
-          streamlog_out(DEBUG3) << "FullLDCTracking_MarlinTrk::AssignSiHitsToTracks: propagate to IP fails with error " << error << std::endl;
+          streamlog_out(DEBUG3) << "FullLDCTracking_MarlinTrk::AssignSiHitsToTracks: propagate to IP fails with error " << return_code << std::endl;
           
+          if (!hitRejected) DeleteIncrementalFit(trkExt, marlin_trk);
           continue ;
           
         }
@@ -4648,6 +4871,7 @@ void FullLDCTracking_MarlinTrk::AssignSiHitsToTracks(TrackerHitExtendedVec hitVe
           
           streamlog_out(DEBUG2) << "FullLDCTracking_MarlinTrk::AssignSiHitsToTracks: Fit failed : NDF is less that zero  " << ndf << std::endl;
           
+          if (!hitRejected) DeleteIncrementalFit(trkExt, marlin_trk);
           continue ;
           
         }
@@ -4659,6 +4883,7 @@ void FullLDCTracking_MarlinTrk::AssignSiHitsToTracks(TrackerHitExtendedVec hitVe
           
           streamlog_out(DEBUG2) << "FullLDCTracking_MarlinTrk::AssignSiHitsToTracks: track fail Chi2 cut of " << _chi2FitCut << " chi2 of track = " <<  chi2Fit << std::endl;
           
+          if (!hitRejected) DeleteIncrementalFit(trkExt, marlin_trk);
           continue ;
           
         }
@@ -4686,8 +4911,21 @@ void FullLDCTracking_MarlinTrk::AssignSiHitsToTracks(TrackerHitExtendedVec hitVe
         trkExt->addTrackerHitExtended( trkHitExt );
         trkHitExt->setTrackExtended( trkExt );
         trkHitExt->setUsedInFit( true );
-        flagTrack[trkExt] = false;
-        flagHit[trkHitExt] = false;
+        InvalidateTrackSummary( trkExt );
+        
+        if (_incrementalSiHitAddition) {
+          IncrementalFit& incFit = _incrementalFits[trkExt];
+          incFit.marlinTrk = marlin_trk;
+          incFit.nHitsInFit = nHitsInFit + 1;
+          incFit.nOutliers = nOutliers;
+          incFit.r2Min = r2Min;
+        }
+        else {
+          delete marlin_trk;
+        }
+        
+        flagTrack[pairs[iP].iTrk] = false;
+        flagHit[pairs[iP].iHit] = false;
         
         
         streamlog_out(DEBUG2) << "AssignSiHitsToTracks: Hit " << trkHitExt << " successfully assigned to track " << trkExt << std::endl;
@@ -4696,7 +4934,7 @@ void FullLDCTracking_MarlinTrk::AssignSiHitsToTracks(TrackerHitExtendedVec hitVe
     }
     
     for (int iP=0;iP<nPairs;++iP) {
-      TrackHitPair * trkHitPair = pairs[iP];
+      TrackHitPair * trkHitPair = pairs[iP].pair;
       delete trkHitPair;
     }
     
@@ -5122,61 +5360,77 @@ void FullLDCTracking_MarlinTrk::GeneralSorting(int * index, float * val, int dir
 
 int FullLDCTracking_MarlinTrk::SegmentRadialOverlap(TrackExtended* first, TrackExtended* second){
   
+  // count the pairs of hits of the two groups with a difference in r of less than half a pad height,
+  // for the hits of the first group in the radial window below. The r extents in the track summaries
+  // allow to skip the tracks without hits which can contribute.
+  const double rLow = _tpc_inner_r;
+  const double rHigh = _tpc_pad_height;
+  const double halfPadHeight = _tpc_pad_height/2.0;
   
-  int nTrkGrpFirst = 0;
-  int nTrkGrpSecond = 0;
-  TrackerHitVec hitvecFirst;
-  TrackerHitVec hitvecSecond;
+  std::vector<float> radiiFirst;
+  std::vector<float> radiiSecond;
   GroupTracks * groupFirst = first->getGroupTracks();
   GroupTracks * groupSecond = second->getGroupTracks();
   
-  if(groupFirst!=NULL){
+  if(groupFirst==NULL || groupSecond==NULL) return 0;
+  
+  TrackExtendedVec tracksInGroupFirst = groupFirst->getTrackExtendedVec();
+  int nTrkGrpFirst = int(tracksInGroupFirst.size());
+  
+  for (int iTrkGrp=0;iTrkGrp<nTrkGrpFirst;++iTrkGrp) {
     
-    TrackExtendedVec tracksInGroupFirst = groupFirst->getTrackExtendedVec();
-    nTrkGrpFirst = int(tracksInGroupFirst.size());
+    TrackExtended * trkGrp = tracksInGroupFirst[iTrkGrp];
+    const TrackSummary& summary = GetTrackSummary(trkGrp);
+    if(summary.nHits==0 || summary.rMax < rLow || summary.rMin > rHigh) continue;
     
-    for (int iTrkGrp=0;iTrkGrp<nTrkGrpFirst;++iTrkGrp) {
-      
-      TrackExtended * trkGrp = tracksInGroupFirst[iTrkGrp];
-      TrackerHitExtendedVec hitVec = trkGrp->getTrackerHitExtendedVec();
-      
-      for(unsigned int i =0; i<hitVec.size(); ++i){
-        hitvecFirst.push_back(hitVec[i]->getTrackerHit());        
-      }
+    TrackerHitExtendedVec& hitVec = trkGrp->getTrackerHitExtendedVec();
+    
+    for(unsigned int i =0; i<hitVec.size(); ++i){
+      float xi = (float)hitVec[i]->getTrackerHit()->getPosition()[0];
+      float yi = (float)hitVec[i]->getTrackerHit()->getPosition()[1];
+      float ri = sqrt(xi*xi+yi*yi);
+      if(ri < rLow || ri > rHigh)continue;
+      radiiFirst.push_back(ri);
     }
   }
-  if(groupSecond!=NULL){
+  
+  if(radiiFirst.empty()) return 0;
+  
+  const float rFirstMin = *std::min_element(radiiFirst.begin(), radiiFirst.end());
+  const float rFirstMax = *std::max_element(radiiFirst.begin(), radiiFirst.end());
+  
+  // margin for the rounding of the difference in r
+  const double margin = 1.0e-3 + 1.0e-5*rFirstMax;
+  
+  TrackExtendedVec tracksInGroupSecond = groupSecond->getTrackExtendedVec();
+  int nTrkGrpSecond = int(tracksInGroupSecond.size());
+  
+  for (int iTrkGrp=0;iTrkGrp<nTrkGrpSecond;++iTrkGrp) {
     
-    TrackExtendedVec tracksInGroupSecond = groupSecond->getTrackExtendedVec();
-    nTrkGrpSecond = int(tracksInGroupSecond.size());
+    TrackExtended * trkGrp = tracksInGroupSecond[iTrkGrp];
+    const TrackSummary& summary = GetTrackSummary(trkGrp);
+    if(summary.nHits==0 || summary.rMax < rFirstMin-halfPadHeight-margin || summary.rMin > rFirstMax+halfPadHeight+margin) continue;
     
-    for (int iTrkGrp=0;iTrkGrp<nTrkGrpSecond;++iTrkGrp) {
-      TrackExtended * trkGrp = tracksInGroupSecond[iTrkGrp];
-      TrackerHitExtendedVec hitVec = 
-      trkGrp->getTrackerHitExtendedVec();
-      
-      for(unsigned int i=0;i<hitVec.size();++i){
-        hitvecSecond.push_back(hitVec[i]->getTrackerHit());
-      }
+    TrackerHitExtendedVec& hitVec = trkGrp->getTrackerHitExtendedVec();
+    
+    for(unsigned int i=0;i<hitVec.size();++i){
+      float xj = (float)hitVec[i]->getTrackerHit()->getPosition()[0];
+      float yj = (float)hitVec[i]->getTrackerHit()->getPosition()[1];
+      radiiSecond.push_back(sqrt(xj*xj+yj*yj));
     }
   }
   
+  std::sort(radiiSecond.begin(), radiiSecond.end());
   
-  int nhitsFirst = (int)hitvecFirst.size();
-  int nhitsSecond = (int)hitvecSecond.size();
   int count = 0;
-  for(int i =0;i<nhitsFirst;++i){
-    float xi = (float)hitvecFirst[i]->getPosition()[0];
-    float yi = (float)hitvecFirst[i]->getPosition()[1];
-    float ri = sqrt(xi*xi+yi*yi);
-    if(ri < _tpc_inner_r || ri > _tpc_pad_height)continue;
-    for(int j =0;j<nhitsSecond;++j){
-      float xj = (float)hitvecSecond[j]->getPosition()[0];
-      float yj = (float)hitvecSecond[j]->getPosition()[1];
-      float rj = sqrt(xj*xj+yj*yj);
-      if(fabs(ri-rj)<_tpc_pad_height/2.0)count++;
+  for(unsigned i=0;i<radiiFirst.size();++i){
+    float ri = radiiFirst[i];
+    std::vector<float>::const_iterator it = std::lower_bound(radiiSecond.begin(), radiiSecond.end(), float(ri-halfPadHeight-margin));
+    for(;it!=radiiSecond.end() && *it<=ri+halfPadHeight+margin;++it){
+      float rj = *it;
+      if(fabs(ri-rj)<halfPadHeight)count++;
     }
-  }  
+  }
   return count;
 }
 
@@ -5194,31 +5448,8 @@ bool FullLDCTracking_MarlinTrk::VetoMerge(TrackExtended* firstTrackExt, TrackExt
   
   streamlog_out(DEBUG1) << "FullLDCTracking_MarlinTrk::VetoMerge called for " << firstTrackExt << " and " << secondTrackExt << std::endl;
   
-  const float d0First = firstTrackExt->getD0();
-  const float z0First = firstTrackExt->getZ0();
-  const float omegaFirst = firstTrackExt->getOmega();
-  const float tanLFirst = firstTrackExt->getTanLambda();
-  const float phi0First = firstTrackExt->getPhi();
-  
-  const float d0Second = secondTrackExt->getD0();
-  const float z0Second = secondTrackExt->getZ0();
-  const float omegaSecond = secondTrackExt->getOmega();
-  const float tanLSecond = secondTrackExt->getTanLambda();
-  const float phi0Second = secondTrackExt->getPhi();        
-  
-  HelixClass firstHelix;
-  firstHelix.Initialize_Canonical(phi0First,d0First,z0First,omegaFirst,tanLFirst,_bField);
-  const float pxFirst = firstHelix.getMomentum()[0];
-  const float pyFirst = firstHelix.getMomentum()[1];
-  const float pzFirst = firstHelix.getMomentum()[2];        
-  
-  HelixClass secondHelix;
-  secondHelix.Initialize_Canonical(phi0Second,d0Second,z0Second,omegaSecond,tanLSecond,_bField);
-  const float pxSecond = secondHelix.getMomentum()[0];
-  const float pySecond = secondHelix.getMomentum()[1];
-  const float pzSecond = secondHelix.getMomentum()[2];      
-  const float pFirst = sqrt(pxFirst*pxFirst+pyFirst*pyFirst+pzFirst*pzFirst);
-  const float pSecond = sqrt(pxSecond*pxSecond+pySecond*pySecond+pzSecond*pzSecond);
+  const float pFirst = GetTrackSummary(firstTrackExt).p;
+  const float pSecond = GetTrackSummary(secondTrackExt).p;
   
   if(pFirst<_vetoMergeMomentumCut || pSecond<_vetoMergeMomentumCut) {
     streamlog_out(DEBUG1) << "FullLDCTracking_MarlinTrk::VetoMerge do not veto as below momentum cut of 2.5 : pFirst = " << pFirst << " pSecond = " << pSecond << std::endl;
@@ -5259,10 +5490,132 @@ bool FullLDCTracking_MarlinTrk::VetoMerge(TrackExtended* firstTrackExt, TrackExt
 }
 
 
+/*
+ 
+ add the summary of a newly created track to _trackSummaries and return its index
+ 
+ */
+
+int FullLDCTracking_MarlinTrk::AddTrackSummary(TrackExtended * trk) {
+  
+  _trackSummaries.push_back(TrackSummary());
+  const int index = int(_trackSummaries.size())-1;
+  _trackSummaryIndex[trk] = index;
+  
+  TrackSummary& summary = _trackSummaries.back();
+  summary.track = trk;
+  FillTrackSummary(summary);
+  
+  return index;
+  
+}
+
+/*
+ 
+ return the summary with the given index, recomputed first if its track changed since it was filled
+ 
+ */
+
+const FullLDCTracking_MarlinTrk::TrackSummary& FullLDCTracking_MarlinTrk::GetTrackSummary(int index) {
+  
+  TrackSummary& summary = _trackSummaries[index];
+  if (!summary.valid) FillTrackSummary(summary);
+  return summary;
+  
+}
+
+/*
+ 
+ return the index of the summary of trk. All tracks which take part in the comparisons get their summary
+ when they are created, a track without one is only expected for the debug output and gets it here
+ 
+ */
+
+int FullLDCTracking_MarlinTrk::GetTrackSummaryIndex(TrackExtended * trk) {
+  
+  std::map<TrackExtended*,int>::const_iterator it = _trackSummaryIndex.find(trk);
+  
+  if (it == _trackSummaryIndex.end()) {
+    streamlog_out(DEBUG2) << "FullLDCTracking_MarlinTrk::GetTrackSummaryIndex: no summary for track " << trk << ", adding it" << std::endl;
+    return AddTrackSummary(trk);
+  }
+  
+  return it->second;
+  
+}
+
+/*
+ 
+ mark the summary of trk as invalid, to be called wherever the hits or the parameters of a track change
+ 
+ */
+
+void FullLDCTracking_MarlinTrk::InvalidateTrackSummary(TrackExtended * trk) {
+  
+  std::map<TrackExtended*,int>::const_iterator it = _trackSummaryIndex.find(trk);
+  if (it != _trackSummaryIndex.end()) _trackSummaries[it->second].valid = false;
+  
+}
+
+void FullLDCTracking_MarlinTrk::FillTrackSummary(TrackSummary& summary) {
+  
+  TrackExtended * trk = summary.track;
+  const float* cov = trk->getCovMatrix();
+  
+  summary.d0 = trk->getD0();
+  summary.z0 = trk->getZ0();
+  summary.omega = trk->getOmega();
+  summary.tanL = trk->getTanLambda();
+  summary.phi = trk->getPhi();
+  
+  HelixClass helix;
+  helix.Initialize_Canonical(summary.phi,summary.d0,summary.z0,summary.omega,summary.tanL,_bField);
+  
+  float mom2 = 0;
+  for (int iC=0;iC<3;++iC) {
+    summary.mom[iC] = helix.getMomentum()[iC];
+    mom2 += summary.mom[iC]*summary.mom[iC];
+  }
+  summary.p = sqrt(mom2);
+  summary.pt = sqrt(summary.mom[0]*summary.mom[0]+summary.mom[1]*summary.mom[1]);
+  
+  summary.q = PIOVER2 - atan(summary.tanL);
+  summary.sinPhi = sin(summary.phi);
+  summary.cosPhi = cos(summary.phi);
+  summary.sinQ = sin(summary.q);
+  summary.cosQ = cos(summary.q);
+  
+  summary.d0Err = sqrt(cov[0]);
+  summary.z0Err = sqrt(cov[9]);
+  summary.phiErr = sqrt(cov[2]);
+  summary.qErr = sqrt(cos(summary.q)*cos(summary.q)*cov[14]);
+  summary.sigmaPOverP = sqrt(cov[5])/fabs(summary.omega);
+  
+  TrackerHitExtendedVec& hitVec = trk->getTrackerHitExtendedVec();
+  
+  summary.nHits = int(hitVec.size());
+  summary.rMin = 1.0e+20;
+  summary.rMax = -1.0e+20;
+  
+  for (unsigned int i=0;i<hitVec.size();++i) {
+    float x = (float)hitVec[i]->getTrackerHit()->getPosition()[0];
+    float y = (float)hitVec[i]->getTrackerHit()->getPosition()[1];
+    float r = sqrt(x*x+y*y);
+    if (r<summary.rMin) summary.rMin = r;
+    if (r>summary.rMax) summary.rMax = r;
+  }
+  
+  summary.valid = true;
+  
+}
+
+
 void FullLDCTracking_MarlinTrk::check(LCEvent * evt) { }
 
 void FullLDCTracking_MarlinTrk::end() { 
   
+  _timers.printSummary();
+  
   delete _encoder ;
   
 }
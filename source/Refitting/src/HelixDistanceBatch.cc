@@ -0,0 +1,83 @@
+
+#include "HelixDistanceBatch.h"
+
+#include <cmath>
+
+#include "HelixClass.h"
+
+
+void HelixDistanceBatch::bandExcess( float xc, float yc, float radius, const float* x, const float* y, const float* cut, int n, float* excess ){
+
+  // the band is compared in r^2 and the two sides are combined with a max, so that the loop has
+  // neither branches nor a sqrt. The margin covers a different rounding of the distance inside HelixClass.
+  for( int i=0; i<n; ++i ){
+    const float dx = x[i] - xc ;
+    const float dy = y[i] - yc ;
+    const float r2 = dx*dx + dy*dy ;
+    const float width = cut[i] + 1.0e-5f*( radius + cut[i] ) + 1.0e-5f ;
+    const float rOut = radius + width ;
+    const float rIn  = radius - width ;
+    const float outside = r2 - rOut*rOut ;
+    const float inside  = rIn*std::fabs( rIn ) - r2 ; // never > 0 if there is no inner edge
+    excess[i] = outside > inside ? outside : inside ;
+  }
+
+}
+
+
+void HelixDistanceBatch::select( HelixClass& helix, const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& z,
+                                 const std::vector<int>& idx, float cut, std::vector<int>& selected, std::vector<float>& distances ){
+
+  select( helix, x, y, z, idx, &cut, false, selected, distances ) ;
+
+}
+
+void HelixDistanceBatch::select( HelixClass& helix, const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& z,
+                                 const std::vector<int>& idx, const std::vector<float>& cuts, std::vector<int>& selected, std::vector<float>& distances ){
+
+  if( cuts.empty() ) return ;
+
+  select( helix, x, y, z, idx, &cuts[0], true, selected, distances ) ;
+
+}
+
+
+void HelixDistanceBatch::select( HelixClass& helix, const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& z,
+                                 const std::vector<int>& idx, const float* cuts, bool cutPerPoint, std::vector<int>& selected, std::vector<float>& distances ){
+
+  const int n = idx.size() ;
+
+  if( n == 0 ) return ;
+
+  _x.resize( n ) ;
+  _y.resize( n ) ;
+  _cut.resize( n ) ;
+  _excess.resize( n ) ;
+
+  for( int k=0; k<n; ++k ){
+    _x[k] = x[ idx[k] ] ;
+    _y[k] = y[ idx[k] ] ;
+    _cut[k] = cutPerPoint ? cuts[ idx[k] ] : cuts[0] ;
+  }
+
+  bandExcess( helix.getXC(), helix.getYC(), std::fabs( helix.getRadius() ), &_x[0], &_y[0], &_cut[0], n, &_excess[0] ) ;
+
+  for( int k=0; k<n; ++k ){
+
+    if( _excess[k] > 0.f ) continue ;
+
+    const int i = idx[k] ;
+    const float cut = _cut[k] ;
+
+    float pos[3] = { x[i], y[i], z[i] } ;
+
+    const float distance = helix.getDistanceToPoint( pos, cut ) ;
+
+    if( distance < cut ){
+      selected.push_back( i ) ;
+      distances.push_back( distance ) ;
+    }
+
+  }
+
+}
@@ -0,0 +1,143 @@
+
+#include "HitGridXY.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+namespace {
+
+  // upper limit on the number of cells along each axis
+  const int maxCellsPerAxis = 512 ;
+
+}
+
+
+void HitGridXY::build( const std::vector<float>& x, const std::vector<float>& y, float minCellSize ){
+
+  const int n = x.size() ;
+
+  _cellStart.clear() ;
+  _cellPoints.clear() ;
+  _nx = _ny = 0 ;
+
+  if( n == 0 ) return ;
+
+  double xMax = x[0] ;
+  double yMax = y[0] ;
+  _xMin = x[0] ;
+  _yMin = y[0] ;
+
+  for( int i=1; i<n; ++i ){
+    _xMin = std::min( _xMin, double(x[i]) ) ;
+    _yMin = std::min( _yMin, double(y[i]) ) ;
+    xMax = std::max( xMax, double(x[i]) ) ;
+    yMax = std::max( yMax, double(y[i]) ) ;
+  }
+
+  const double width  = xMax - _xMin ;
+  const double height = yMax - _yMin ;
+
+  // aim for about one point per cell
+  _cellSize = std::max( double(minCellSize), std::sqrt( width*height/n ) ) ;
+  _cellSize = std::max( _cellSize, std::max( width, height )/maxCellsPerAxis ) ;
+  if( !( _cellSize > 0. ) ) _cellSize = 1. ;
+
+  _nx = std::min( maxCellsPerAxis, int( width/_cellSize ) + 1 ) ;
+  _ny = std::min( maxCellsPerAxis, int( height/_cellSize ) + 1 ) ;
+
+  // counting sort of the points by cell
+  std::vector<int> cellOfPoint( n ) ;
+  _cellStart.assign( _nx*_ny + 1, 0 ) ;
+
+  for( int i=0; i<n; ++i ){
+    const int ix = std::min( _nx-1, int( ( x[i] - _xMin )/_cellSize ) ) ;
+    const int iy = std::min( _ny-1, int( ( y[i] - _yMin )/_cellSize ) ) ;
+    cellOfPoint[i] = iy*_nx + ix ;
+    ++_cellStart[ cellOfPoint[i] + 1 ] ;
+  }
+
+  for( unsigned c=1; c<_cellStart.size(); ++c ) _cellStart[c] += _cellStart[c-1] ;
+
+  std::vector<int> fill( _cellStart.begin(), _cellStart.end()-1 ) ;
+  _cellPoints.resize( n ) ;
+
+  for( int i=0; i<n; ++i ) _cellPoints[ fill[ cellOfPoint[i] ]++ ] = i ;
+
+}
+
+
+int HitGridXY::column( double x ) const {
+
+  const double ix = std::floor( ( x - _xMin )/_cellSize ) ;
+
+  if( ix < 0 ) return -1 ;
+  if( ix >= _nx ) return _nx ;
+
+  return int( ix ) ;
+
+}
+
+
+void HitGridXY::findNearCircle( double xc, double yc, double radius, double dist, std::vector<int>& result ) const {
+
+  const unsigned nBefore = result.size() ;
+
+  if( _cellPoints.empty() ) return ;
+
+  // helices without a usable circle, e.g. with omega = 0, are compared to all points
+  if( !std::isfinite( xc ) || !std::isfinite( yc ) || !std::isfinite( radius ) || !std::isfinite( dist ) ){
+    result.insert( result.end(), _cellPoints.begin(), _cellPoints.end() ) ;
+    std::sort( result.begin() + nBefore, result.end() ) ;
+    return ;
+  }
+
+  // margin for the float arithmetic of the distance calculation
+  dist += 1.0e-4*( std::fabs( radius ) + dist ) + 1.0e-3 ;
+
+  const double rOut = std::fabs( radius ) + dist ;
+  const double rIn  = std::fabs( radius ) - dist ;
+
+  for( int iy=0; iy<_ny; ++iy ){
+
+    const double y0 = _yMin + iy*_cellSize ;
+    const double y1 = y0 + _cellSize ;
+
+    const double dyMin = ( yc >= y0 && yc <= y1 ) ? 0. : std::min( std::fabs( y0 - yc ), std::fabs( y1 - yc ) ) ;
+    const double dyMax = std::max( std::fabs( y0 - yc ), std::fabs( y1 - yc ) ) ;
+
+    if( dyMin > rOut ) continue ;
+
+    // within this row the band around the circle is contained in xIn <= |x - xc| <= xOut
+    const double xOut = std::sqrt( rOut*rOut - dyMin*dyMin ) ;
+    const double xIn  = ( rIn > 0. && rIn > dyMax ) ? std::sqrt( rIn*rIn - dyMax*dyMax ) : 0. ;
+
+    int lowA  = column( xc - xOut ) ;
+    int highA = column( xc - xIn ) ;
+    int lowB  = column( xc + xIn ) ;
+    int highB = column( xc + xOut ) ;
+
+    if( lowB <= highA ){ // the two ranges overlap
+      highA = highB ;
+      lowB = _nx ;
+    }
+
+    const int ranges[2][2] = { { lowA, highA }, { lowB, highB } } ;
+
+    for( int r=0; r<2; ++r ){
+
+      const int low  = std::max( 0, ranges[r][0] ) ;
+      const int high = std::min( _nx-1, ranges[r][1] ) ;
+
+      for( int ix=low; ix<=high; ++ix ){
+        const int cell = iy*_nx + ix ;
+        for( int k=_cellStart[cell]; k<_cellStart[cell+1]; ++k ) result.push_back( _cellPoints[k] ) ;
+      }
+
+    }
+
+  }
+
+  std::sort( result.begin() + nBefore, result.end() ) ;
+
+}
@@ -136,6 +136,16 @@ RefitProcessor::RefitProcessor() : Processor("RefitProcessor") {
 			      _mass ,
 			      double(0.13957018) ) ;
 
+  registerProcessorParameter( "TimeStages",
+                             "Measure the time spent in the main processing stages and print a summary per run in end()",
+                             _timeStages,
+                             bool(false));
+  
+  registerProcessorParameter( "StageTimingCSVFile",
+                             "If set together with TimeStages, write the stage times and counters of every event to this CSV file",
+                             _stageTimingCSVFile,
+                             std::string(""));
+
 }
 
 
@@ -170,6 +180,11 @@ void RefitProcessor::init() {
   _n_run = 0 ;
   _n_evt = 0 ;
   
+  _timers.init( name(), _timeStages, _stageTimingCSVFile );
+  _stageRefit = _timers.addStage( "Refit" );
+  _countInputTracks = _timers.addCounter( "InputTracks" );
+  _countOutputTracks = _timers.addCounter( "OutputTracks" );
+  
 }
 
 void RefitProcessor::processRunHeader( LCRunHeader* run) { 
@@ -185,6 +200,8 @@ void RefitProcessor::processEvent( LCEvent * evt ) {
   streamlog_out(DEBUG4) << "   processing event: " << _n_evt 
   << std::endl ;
   
+  _timers.startEvent( evt->getRunNumber(), evt->getEventNumber() );
+  
   // get input collection and relations 
   LCCollection* input_track_col = this->GetCollection( evt, _input_track_col_name ) ;
   
@@ -208,6 +225,10 @@ void RefitProcessor::processEvent( LCEvent * evt ) {
     
     streamlog_out(DEBUG4) << "Processing input collection " << _input_track_col_name << " with " << nTracks << " tracks\n";
     
+    _timers.count( _countInputTracks, nTracks );
+    
+    StageTimers::Scope timeRefit( _timers, _stageRefit );
+    
     // loop over the input tacks and refit using KalTest    
     for(int i=0; i< nTracks ; ++i){
       
@@ -411,11 +432,15 @@ void RefitProcessor::processEvent( LCEvent * evt ) {
       
     } 
     
+    timeRefit.stop();
+    _timers.count( _countOutputTracks, trackVec->getNumberOfElements() );
+    
     evt->addCollection( trackVec , _output_track_col_name) ;
     evt->addCollection( trackRelVec , _output_track_rel_name) ;
     delete input_track_rels; input_track_rels = 0;
 
   }
+  _timers.endEvent();
   ++_n_evt ;
 }
 
@@ -428,6 +453,8 @@ void RefitProcessor::check( LCEvent * evt ) {
 
 void RefitProcessor::end(){ 
   
+  _timers.printSummary();
+  
   streamlog_out(DEBUG) << "RefitProcessor::end()  " << name() 
   << " processed " << _n_evt << " events in " << _n_run << " runs "
   << std::endl ;
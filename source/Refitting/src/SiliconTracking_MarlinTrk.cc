@@ -42,6 +42,7 @@
 #include "MarlinTrk/MarlinTrkDiagnostics.h"
 #ifdef MARLINTRK_DIAGNOSTICS_ON
 #include "MarlinTrk/DiagnosticsController.h"
+#include "SetTrackerHitExtensions.h"
 #endif
 
 #include "MarlinCED.h"
@@ -552,6 +553,15 @@ SiliconTracking_MarlinTrk::SiliconTracking_MarlinTrk() : Processor("SiliconTrack
 			      _trkSystemName,
 			      std::string("KalTest") );
 
+  registerProcessorParameter( "TimeStages",
+                             "Measure the time spent in the main processing stages and print a summary per run in end()",
+                             _timeStages,
+                             bool(false));
+  
+  registerProcessorParameter( "StageTimingCSVFile",
+                             "If set together with TimeStages, write the stage times and counters of every event to this CSV file",
+                             _stageTimingCSVFile,
+                             std::string(""));
   
 #ifdef MARLINTRK_DIAGNOSTICS_ON
   
@@ -677,6 +687,18 @@ void SiliconTracking_MarlinTrk::init() {
   
   _output_track_col_quality = 0;
   
+  _timers.init( name(), _timeStages, _stageTimingCSVFile );
+  _stageInitialiseVTX = _timers.addStage( "InitialiseVTX" );
+  _stageInitialiseFTD = _timers.addStage( "InitialiseFTD" );
+  _stageProcessOneSector = _timers.addStage( "ProcessOneSector" );
+  _stageTrackingInFTD = _timers.addStage( "TrackingInFTD" );
+  _stageSorting = _timers.addStage( "Sorting" );
+  _stageCreateTrack = _timers.addStage( "CreateTrack" );
+  _stageAttachRemainingHits = _timers.addStage( "AttachRemainingHits" );
+  _stageFinalRefit = _timers.addStage( "FinalRefit" );
+  _countTrackCandidates = _timers.addCounter( "TrackCandidates" );
+  _countOutputTracks = _timers.addCounter( "OutputTracks" );
+  
 }
 
 
@@ -709,8 +731,15 @@ void SiliconTracking_MarlinTrk::processEvent( LCEvent * evt ) {
   streamlog_out(DEBUG4) << "SiliconTracking_MarlinTrk -> run = " << _nRun 
   << "  event = " << _nEvt << std::endl;
   
+  _timers.startEvent( evt->getRunNumber(), evt->getEventNumber() );
+  
+  StageTimers::Scope timeInitialiseVTX( _timers, _stageInitialiseVTX );
   int successVTX = InitialiseVTX( evt );
+  timeInitialiseVTX.stop();
+  
+  StageTimers::Scope timeInitialiseFTD( _timers, _stageInitialiseFTD );
   int successFTD = InitialiseFTD( evt );
+  timeInitialiseFTD.stop();
   
   if (_UseEventDisplay) {
     
@@ -726,11 +755,13 @@ void SiliconTracking_MarlinTrk::processEvent( LCEvent * evt ) {
     
     streamlog_out(DEBUG1) << "      phi          theta        layer      nh o :   m :   i  :: o*m*i " << std::endl; 
     
+    StageTimers::Scope timeProcessOneSector( _timers, _stageProcessOneSector );
     for (int iPhi=0; iPhi<_nDivisionsInPhi; ++iPhi) { 
       for (int iTheta=0; iTheta<_nDivisionsInTheta;++iTheta) {
         ProcessOneSector(iPhi,iTheta); // Process one VXD sector     
       }
     }
+    timeProcessOneSector.stop();
     
     streamlog_out(DEBUG4) << "End of Processing VXD and SIT sectors" << std::endl;
     
@@ -738,7 +769,9 @@ void SiliconTracking_MarlinTrk::processEvent( LCEvent * evt ) {
   
   if (successFTD == 1) {
     streamlog_out(DEBUG1) << "      phi          side        layer      nh o :   m :   i  :: o*m*i " << std::endl;
+    StageTimers::Scope timeTrackingInFTD( _timers, _stageTrackingInFTD );
     TrackingInFTD(); // Perform tracking in the FTD
+    timeTrackingInFTD.stop();
     streamlog_out(DEBUG4) << "End of Processing FTD sectors" << std::endl;
   }
   
@@ -747,17 +780,20 @@ void SiliconTracking_MarlinTrk::processEvent( LCEvent * evt ) {
   if (successVTX == 1 || successFTD == 1) {
     //if (successVTX == 1 ) {
     
+    StageTimers::Scope timeSorting( _timers, _stageSorting );
     for (int nHits = _nHitsChi2; nHits >= 3 ;// the three is hard coded, sorry.
          // It's the minimal number to form a track
          nHits--) {
       Sorting( _tracksWithNHitsContainer.getTracksWithNHitsVec( nHits ) );
       
     }
+    timeSorting.stop();
     
     
     streamlog_out(DEBUG4) <<  "End of Sorting " << std::endl;
     
     
+    StageTimers::Scope timeCreateTrack( _timers, _stageCreateTrack );
     for (int nHits = _nHitsChi2; nHits >= 3 ;// the three is hard coded, sorry.
          // It's the minimal number to form a track
          nHits--) {
@@ -770,7 +806,11 @@ void SiliconTracking_MarlinTrk::processEvent( LCEvent * evt ) {
       }
       streamlog_out(DEBUG4) <<  "End of creating "<< nHits << " hits tracks " << std::endl;
     }
+    timeCreateTrack.stop();
+    
+    _timers.count( _countTrackCandidates, _trackImplVec.size() );
     
+    StageTimers::Scope timeAttachRemainingHits( _timers, _stageAttachRemainingHits );
     if (_attachFast == 0) {
       AttachRemainingVTXHitsSlow();
       AttachRemainingFTDHitsSlow();
@@ -779,6 +819,7 @@ void SiliconTracking_MarlinTrk::processEvent( LCEvent * evt ) {
       AttachRemainingVTXHitsFast();
       AttachRemainingFTDHitsFast();
     }
+    timeAttachRemainingHits.stop();
     
     streamlog_out(DEBUG4) <<  "End of picking up remaining hits " << std::endl;
     
@@ -791,7 +832,11 @@ void SiliconTracking_MarlinTrk::processEvent( LCEvent * evt ) {
     LCCollectionVec * relCol = NULL;
     
     
+    StageTimers::Scope timeFinalRefit( _timers, _stageFinalRefit );
     FinalRefit(trkCol, relCol);
+    timeFinalRefit.stop();
+    
+    _timers.count( _countOutputTracks, trkCol->getNumberOfElements() );
     
     // set the quality of the output collection
     switch (_output_track_col_quality) {
@@ -834,6 +879,7 @@ void SiliconTracking_MarlinTrk::processEvent( LCEvent * evt ) {
   
   CleanUp();
   streamlog_out(DEBUG4) << "Event is done " << std::endl;
+  _timers.endEvent();
   _nEvt++;
   
 }
@@ -1365,6 +1411,8 @@ void SiliconTracking_MarlinTrk::check(LCEvent * evt) {
 
 void SiliconTracking_MarlinTrk::end() {
   
+  _timers.printSummary();
+  
   delete _fastfitter ; _fastfitter = 0;
   delete _encoder ; _encoder = 0;
   //  delete _trksystem ; _trksystem = 0;
@@ -1707,6 +1755,8 @@ TrackExtended * SiliconTracking_MarlinTrk::TestTriplet(TrackerHitExtended * oute
     EVENT::TrackerHit* trkhit = hit_list[ihit];
     std::vector<MCParticle*> mcps;
 
+    // create the truth extensions if SetTrackerHitExtensions attaches them lazily
+    SetTrackerHitExtensions::resolveMCTruth4HitExts(trkhit);
     MarlinTrk::getMCParticlesForTrackerHit(trkhit, mcps);
     
     if (mcps.size() == 1) {
@@ -0,0 +1,172 @@
+#include "SplitSectorConnector.h"
+
+#include <cstdlib>
+#include <algorithm>
+
+
+namespace {
+
+  // distance of two phi indices on the ring of n sectors
+  int phiDistance( int iPhi1, int iPhi2, int n ){
+    int d = ( ( iPhi1 - iPhi2 ) % n + n ) % n ;
+    return std::min( d, n - d ) ;
+  }
+
+}
+
+
+SplitSectorConnector::SplitSectorConnector( KiTrack::ISectorConnector* connector, int nLayers, int nDivisionsInPhi, int nDivisionsInTheta ) :
+  _connector( connector ),
+  _nLayers( nLayers ),
+  _nDivisionsInPhi( nDivisionsInPhi ),
+  _nDivisionsInTheta( nDivisionsInTheta ),
+  _split( 0 ) {
+}
+
+
+void SplitSectorConnector::setSplit( int split ){
+
+  _split = split ;
+  _splitSectors.clear() ;
+
+}
+
+
+int SplitSectorConnector::getSplitSector( int layer, int iPhi, int iTheta ) const {
+
+  return firstSplitSector() + layer + _nLayers*iPhi + _nLayers*( _nDivisionsInPhi << _split )*iTheta ;
+
+}
+
+
+int SplitSectorConnector::getCoarseSector( int sector ) const {
+
+  if( sector < firstSplitSector() ) return sector ;
+
+  int layer, iPhi, iTheta ;
+  decode( sector, layer, iPhi, iTheta ) ;
+
+  return layer + _nLayers*( iPhi >> _split ) + _nLayers*_nDivisionsInPhi*( iTheta >> _split ) ;
+
+}
+
+
+void SplitSectorConnector::addSplitSector( int splitSector ){
+
+  _splitSectors[ getCoarseSector( splitSector ) ].insert( splitSector ) ;
+
+}
+
+
+void SplitSectorConnector::decode( int sector, int& layer, int& iPhi, int& iTheta ) const {
+
+  int nPhi = _nDivisionsInPhi ;
+
+  if( sector >= firstSplitSector() ){
+    sector -= firstSplitSector() ;
+    nPhi <<= _split ;
+  }
+
+  layer = sector % _nLayers ;
+  iPhi = ( sector / _nLayers ) % nPhi ;
+  iTheta = sector / ( _nLayers*nPhi ) ;
+
+}
+
+
+std::set< int > SplitSectorConnector::getTargetSectors( int sector ){
+
+  const int coarseSector = getCoarseSector( sector ) ;
+
+  std::set< int > coarseTargets = _connector->getTargetSectors( coarseSector ) ;
+
+  if( _splitSectors.empty() ) return coarseTargets ;
+
+  std::set< int > targets ;
+
+  // A configured sector connects to all sub-sectors of its split targets
+  if( sector == coarseSector ){
+
+    for( std::set< int >::const_iterator it = coarseTargets.begin() ; it != coarseTargets.end() ; ++it ){
+
+      std::map< int , std::set< int > >::const_iterator split = _splitSectors.find( *it ) ;
+
+      if( split == _splitSectors.end() ) targets.insert( *it ) ;
+      else targets.insert( split->second.begin(), split->second.end() ) ;
+
+    }
+
+    return targets ;
+
+  }
+
+  // A sub-sector connects to the sectors inside the window of its configured sector, counted in the sub-sectors
+  // around it. The window is read off the targets of the configured sector, the targets on the IP layer are kept.
+  int layer, iPhi, iTheta ;
+  decode( coarseSector, layer, iPhi, iTheta ) ;
+
+  int windowPhi = 0 ;
+  int windowTheta = 0 ;
+
+  for( std::set< int >::const_iterator it = coarseTargets.begin() ; it != coarseTargets.end() ; ++it ){
+
+    int targetLayer, targetPhi, targetTheta ;
+    decode( *it, targetLayer, targetPhi, targetTheta ) ;
+    if( targetLayer == 0 ) continue ;
+
+    windowPhi = std::max( windowPhi, phiDistance( targetPhi, iPhi, _nDivisionsInPhi ) ) ;
+    windowTheta = std::max( windowTheta, std::abs( targetTheta - iTheta ) ) ;
+
+  }
+
+  const int nPhiSplit = _nDivisionsInPhi << _split ;
+  const int nSplit = 1 << _split ;
+
+  int splitLayer, splitPhi, splitTheta ;
+  decode( sector, splitLayer, splitPhi, splitTheta ) ;
+
+  for( std::set< int >::const_iterator it = coarseTargets.begin() ; it != coarseTargets.end() ; ++it ){
+
+    int targetLayer, targetPhi, targetTheta ;
+    decode( *it, targetLayer, targetPhi, targetTheta ) ;
+
+    if( targetLayer == 0 ){
+      targets.insert( *it ) ;
+      continue ;
+    }
+
+    std::map< int , std::set< int > >::const_iterator split = _splitSectors.find( *it ) ;
+
+    if( split != _splitSectors.end() ){
+
+      for( std::set< int >::const_iterator itSplit = split->second.begin() ; itSplit != split->second.end() ; ++itSplit ){
+
+        decode( *itSplit, targetLayer, targetPhi, targetTheta ) ;
+
+        if( phiDistance( targetPhi, splitPhi, nPhiSplit ) <= windowPhi && std::abs( targetTheta - splitTheta ) <= windowTheta ) targets.insert( *itSplit ) ;
+
+      }
+
+    }
+    else{
+
+      // the distance to the closest sub-sector the unsplit target would have
+      const int firstPhi = targetPhi*nSplit ;
+      const int lastPhi = firstPhi + nSplit - 1 ;
+
+      int distPhi = 0 ;
+      if( ( ( splitPhi - firstPhi ) % nPhiSplit + nPhiSplit ) % nPhiSplit >= nSplit ){
+        distPhi = std::min( phiDistance( splitPhi, firstPhi, nPhiSplit ), phiDistance( splitPhi, lastPhi, nPhiSplit ) ) ;
+      }
+
+      const int closestTheta = std::min( std::max( splitTheta, targetTheta*nSplit ), targetTheta*nSplit + nSplit - 1 ) ;
+
+      if( distPhi <= windowPhi && std::abs( closestTheta - splitTheta ) <= windowTheta ) targets.insert( *it ) ;
+
+    }
+
+  }
+
+  return targets ;
+
+}
@@ -29,7 +29,6 @@
 #include <UTIL/CellIDEncoder.h>
 #include <UTIL/ILDConf.h>
 #include <UTIL/BitSet32.h>
-#include <UTIL/LCRelationNavigator.h>
 
 #include "DD4hep/LCDD.h"
 #include "DD4hep/DD4hepUnits.h"
@@ -46,11 +45,19 @@
 #include <AIDA/IAnalysisFactory.h>
 #include <AIDA/IHistogramFactory.h>
 
+#include "RVersion.h"
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+#include "TROOT.h"
+#else
+#include "TThread.h"
+#endif
+
 #include <cmath>
 #include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <climits>
+#include <atomic>
 #include <cfloat>
 
 //CxxUtils/
@@ -130,6 +137,11 @@ TruthTrackFinder::TruthTrackFinder() : Processor("TruthTrackFinder") {
                               m_fitForward,
                               bool(false));
   
+  registerProcessorParameter( "NumberOfThreads",
+                              "Number of threads fitting the particles, each with its own track fit factory. 1 fits them in the calling thread and 0 uses all hardware threads. More than 1 is not validated yet, compare with a serial run (also under ThreadSanitizer) before using it",
+                              m_nThreads,
+                              int(1));
+  
 	
 }
 
@@ -157,13 +169,29 @@ void TruthTrackFinder::init() {
 	m_eventNumber = 0 ;
 	m_fitFails = 0;
   
-  // Set up the track fit factory
+  // Set up the track fit factories, one per thread as a factory must not be used by two fits at the same time
+  m_taskPool.init(m_nThreads);
+  
+  // The KalTest fits create ROOT objects, ROOT has to protect its global state before the factories are created
+  if(m_taskPool.nThreads() > 1){
+    streamlog_out(WARNING) << "TruthTrackFinder: fitting with " << m_taskPool.nThreads() << " threads is not validated yet, compare the tracks with a run with NumberOfThreads = 1" << std::endl;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+    ROOT::EnableThreadSafety();
+#else
+    TThread::Initialize();
+#endif
+  }
+  
   const gear::GearMgr* fakeGear = 0;
-  trackFactory =  MarlinTrk::Factory::createMarlinTrkSystem( "DDKalTest" , fakeGear , "" ) ;
-  trackFactory->setOption( MarlinTrk::IMarlinTrkSystem::CFG::useQMS,        true) ;
-  trackFactory->setOption( MarlinTrk::IMarlinTrkSystem::CFG::usedEdx,       true) ;
-  trackFactory->setOption( MarlinTrk::IMarlinTrkSystem::CFG::useSmoothing,  false) ;
-  trackFactory->init() ;
+  for(int iThread=0;iThread<m_taskPool.nThreads();iThread++){
+    MarlinTrk::IMarlinTrkSystem* factory =  MarlinTrk::Factory::createMarlinTrkSystem( "DDKalTest" , fakeGear , "" ) ;
+    factory->setOption( MarlinTrk::IMarlinTrkSystem::CFG::useQMS,        true) ;
+    factory->setOption( MarlinTrk::IMarlinTrkSystem::CFG::usedEdx,       true) ;
+    factory->setOption( MarlinTrk::IMarlinTrkSystem::CFG::useSmoothing,  false) ;
+    factory->init() ;
+    m_trackFactories.push_back(factory);
+  }
+  trackFactory = m_trackFactories[0];
 
   // Put default values for track fitting
   m_initialTrackError_d0 = 1.e6;
@@ -196,10 +224,13 @@ void TruthTrackFinder::processEvent( LCEvent* evt ) {
   LCCollection* particleCollection = 0 ;
   getCollection(particleCollection, m_inputParticleCollection, evt); if(particleCollection == 0) return;
 
-	// Make objects to hold all of the tracker hit, simulated hit and relation collections
+	// Make objects to hold all of the tracker hit collections and their truth relations
 	std::vector<LCCollection*> trackerHitCollections;
-	std::vector<LCCollection*> trackerHitRelationCollections;
-	std::vector<LCRelationNavigator*> relations;
+	std::vector<const TruthRelationIndex::EntryVec*> relations;
+	
+	// Use the truth index shared by BuildTruthRelationIndex if it ran for this event, otherwise fill our own
+	const TruthRelationIndex* sharedIndex = TruthRelationIndex::get(evt);
+	m_truthIndex.clear();
 	
 	// Loop over each input collection and get the data
 	for(unsigned int collection=0; collection<m_inputTrackerHitCollections.size();collection++){
@@ -207,15 +238,16 @@ void TruthTrackFinder::processEvent( LCEvent* evt ) {
 		// Get the collection of tracker hits
 		LCCollection* trackerHitCollection = 0 ;
 		getCollection(trackerHitCollection, m_inputTrackerHitCollections[collection], evt); if(trackerHitCollection == 0) continue;
-		trackerHitCollections.push_back(trackerHitCollection);
 
-	  // Get the collection of tracker hit relations
-	  LCCollection* trackerHitRelationCollection = 0 ;
-	  getCollection(trackerHitRelationCollection, m_inputTrackerHitRelationCollections[collection], evt);
-		trackerHitRelationCollections.push_back(trackerHitRelationCollection);
-  
-	  // Create the relations navigator
-	  LCRelationNavigator* relation = new LCRelationNavigator( trackerHitRelationCollection );
+	  // Get the hit to simulated hit relations for this collection
+	  const TruthRelationIndex::EntryVec* relation = sharedIndex ? sharedIndex->getCollection(m_inputTrackerHitCollections[collection], m_inputTrackerHitRelationCollections[collection]) : 0;
+	  if(relation == 0){
+	    LCCollection* trackerHitRelationCollection = 0 ;
+	    getCollection(trackerHitRelationCollection, m_inputTrackerHitRelationCollections[collection], evt); if(trackerHitRelationCollection == 0) continue;
+	    relation = &m_truthIndex.addCollection(m_inputTrackerHitCollections[collection], m_inputTrackerHitRelationCollections[collection], trackerHitCollection, trackerHitRelationCollection);
+	  }
+
+		trackerHitCollections.push_back(trackerHitCollection);
 		relations.push_back(relation);
   
 	}
@@ -234,12 +266,22 @@ void TruthTrackFinder::processEvent( LCEvent* evt ) {
  	/* 
    Now for each MC particle we want the list of hits belonging to it. The most 
    efficient way is to loop over all hits once, and store the pointers in a 
-   map, with the key a pointer to the MC particle. We can then loop over each
-   MC particle at the end and get all of the hits, before making a track.
+   vector per particle, at the index of the particle in its collection. We can
+   then fit the particles and add the tracks in the order of the collection.
   */
   
-  // Make the container
-  std::map<MCParticle*, std::vector<TrackerHit*> > particleHits;
+  // Make the container, the particles are looked up by pointer in a sorted table of their indices
+  int nParticles = particleCollection->getNumberOfElements();
+  
+  m_particleIndex.resize(nParticles);
+  for(int itP=0;itP<nParticles;itP++){
+    m_particleIndex[itP] = std::make_pair( dynamic_cast<MCParticle*>( particleCollection->getElementAt(itP) ), itP ) ;
+  }
+  std::sort(m_particleIndex.begin(),m_particleIndex.end());
+  
+  // Keep the vectors of earlier events to reuse their memory
+  if(int(m_particleHits.size()) < nParticles) m_particleHits.resize(nParticles);
+  for(int itP=0;itP<nParticles;itP++) m_particleHits[itP].clear();
 
 	// Loop over all input collections
 	for(unsigned int collection=0; collection<trackerHitCollections.size();collection++){
@@ -251,33 +293,83 @@ void TruthTrackFinder::processEvent( LCEvent* evt ) {
 	    TrackerHitPlane* hit = dynamic_cast<TrackerHitPlane*>( trackerHitCollections[collection]->getElementAt(itHit) ) ;
     
 	    // Get the related simulated hit(s)
-	    const LCObjectVec& simHitVector = relations[collection]->getRelatedToObjects( hit );
+	    const TruthRelationIndex::Entry& truth = (*relations[collection])[itHit];
+	    if(truth.nSimHits == 0) continue;
 
 	    // Take the first hit only (this should be changed? Yes - loop over all related simHits and add an entry for each mcparticle so that this hit is in each fit)
-	    SimTrackerHit* simHit = dynamic_cast<SimTrackerHit*>(simHitVector.at(0));
-
 	    // Get the particle belonging to that hit
-	    MCParticle* particle = simHit->getMCParticle();
+	    MCParticle* particle = truth.mcp;
 
-	    // Push back the element into the container
-	    particleHits[particle].push_back(hit);
+	    // Push back the element into the container, hits of particles which are not in the collection are never fitted
+	    std::vector<std::pair<MCParticle*, int> >::const_iterator itIndex = std::lower_bound(m_particleIndex.begin(), m_particleIndex.end(), std::make_pair(particle, 0));
+	    if(itIndex == m_particleIndex.end() || itIndex->first != particle) continue;
+	    m_particleHits[itIndex->second].push_back(hit);
 
 	  }
 	}
 	
-  // Now loop over all particles and get the list of hits
-  int nParticles = particleCollection->getNumberOfElements();
+  // Fit the particles concurrently, task i fits the next particle not taken yet with the i-th track system until
+  // none is left. The results are stored at the index of the particle and added to the output afterwards in its order.
+  m_particleTracks.assign(nParticles, 0);
+  m_particleFitFailed.assign(nParticles, 0);
+  
+  // The log stream is global and not thread safe. If debug messages are written, which the fits of the
+  // track systems also do, the particles are fitted in the calling thread.
+  const int nTasks = streamlog_level(DEBUG9) ? 1 : m_trackFactories.size();
+  
+  std::atomic<int> nextParticle(0);
+  
+  m_taskPool.run( nTasks, [&]( int iTask ){
+    
+    for(int itP=nextParticle++;itP<nParticles;itP=nextParticle++){
+      
+      // Only make tracks with 3 or more hits
+      if(m_particleHits[itP].size() < 3) continue;
+      
+      MCParticle* mcParticle = dynamic_cast<MCParticle*>( particleCollection->getElementAt(itP) ) ;
+      
+      m_particleTracks[itP] = fitParticle( m_trackFactories[iTask], mcParticle, m_particleHits[itP] );
+      if(m_particleTracks[itP] == 0) m_particleFitFailed[itP] = 1;
+      
+    }
+    
+  });
+  
+  // Now loop over all particles and collect the tracks
   for(int itP=0;itP<nParticles;itP++){
-		
+    
+    m_fitFails += m_particleFitFailed[itP];
+    
+    TrackImpl* track = m_particleTracks[itP];
+    if(track == 0) continue;
+    
     // Get the particle
     MCParticle* mcParticle = dynamic_cast<MCParticle*>( particleCollection->getElementAt(itP) ) ;
     
-    // Get the vector of hits from the container
-    if(particleHits.count(mcParticle) == 0) continue;
-    std::vector<TrackerHit*> trackHits = particleHits[mcParticle];
+    // Push back to the output container
+    trackCollection->addElement(track);
+		
+    // Make the particle to track link
+    LCRelationImpl* relationTrack = new LCRelationImpl;
+    relationTrack->setFrom(track);
+    relationTrack->setTo(mcParticle);
+    relationTrack->setWeight(1.0);
+    trackRelationCollection->addElement(relationTrack);
+    
+  }
+  
+  // Save the output track collection
+  evt->addCollection( trackCollection , m_outputTrackCollection ) ;
+  // Save the output particle to track relation collection
+  evt->addCollection( trackRelationCollection , m_outputTrackRelationCollection ) ;
 
-    // Only make tracks with 3 or more hits
-    if(trackHits.size() < 3) continue;
+	// Increment the event number
+	m_eventNumber++ ;
+	
+}
+
+
+TrackImpl* TruthTrackFinder::fitParticle( MarlinTrk::IMarlinTrkSystem* factory, MCParticle* mcParticle, std::vector<TrackerHit*>& trackHits ){
 		
 		// Sort the hits from smaller to larger radius
 		std::sort(trackHits.begin(),trackHits.end(),sort_by_radius);
@@ -289,13 +381,12 @@ void TruthTrackFinder::processEvent( LCEvent* evt ) {
      covariance matrix etc. Set these up, then call the fit.
     */
 		
-		// Make the track object and relations object
-		LCRelationImpl* relationTrack = new LCRelationImpl;
+		// Make the track object
 		TrackImpl* track = new TrackImpl ;
 
     // IMarlinTrk used to fit track - IMarlinTrk interface to separete pattern recogition from fit implementation
-    MarlinTrk::IMarlinTrack* marlinTrack = trackFactory->createTrack();
-    MarlinTrk::IMarlinTrack* marlinTrackZSort = trackFactory->createTrack();
+    MarlinTrk::IMarlinTrack* marlinTrack = factory->createTrack();
+    MarlinTrk::IMarlinTrack* marlinTrackZSort = factory->createTrack();
 
     // Save a vector of the hits to be used (why is this not attached to the track directly?? MarlinTrkUtils to be updated?)
     EVENT::TrackerHitVec trackfitHits;
@@ -396,9 +487,9 @@ void TruthTrackFinder::processEvent( LCEvent* evt ) {
     streamlog_out( DEBUG2 )<<"TruthTrackFinder: fitError "<< fitError << std::endl;
 
 		// Check track quality - if fit fails chi2 will be 0
-		if(fitError!=0){ delete track; delete relationTrack; delete marlinTrack; delete marlinTrackZSort; m_fitFails++;  continue;}
-		if(track->getChi2() <= 0.){ delete track; delete relationTrack; delete marlinTrack; delete marlinTrackZSort; m_fitFails++;  continue;}
-		if(track->getNdf() <= 0.){ delete track; delete relationTrack; delete marlinTrack; delete marlinTrackZSort; m_fitFails++;  continue;}
+		if(fitError!=0){ delete track; delete marlinTrack; delete marlinTrackZSort; return 0;}
+		if(track->getChi2() <= 0.){ delete track; delete marlinTrack; delete marlinTrackZSort; return 0;}
+		if(track->getNdf() <= 0.){ delete track; delete marlinTrack; delete marlinTrackZSort; return 0;}
 
 
     std::vector<std::pair<EVENT::TrackerHit*, double> > hits_in_fit;
@@ -414,31 +505,10 @@ void TruthTrackFinder::processEvent( LCEvent* evt ) {
 
     streamlog_out( DEBUG5 )<<"TruthTrackFinder: trackHits.size(): "<<trackHits.size()<<" trackfitHits.size(): "<<trackfitHits.size()<<" hits_in_fit.size(): "<<hits_in_fit.size()   << std::endl;
 
-    
-    
-    
-    // Push back to the output container
-    trackCollection->addElement(track);
-		
-    // Make the particle to track link
-    relationTrack->setFrom(track);
-    relationTrack->setTo(mcParticle);
-    relationTrack->setWeight(1.0);
-    trackRelationCollection->addElement(relationTrack);
-
 		delete marlinTrack;
 		delete marlinTrackZSort;
-  }
-  
-  // Save the output track collection
-  evt->addCollection( trackCollection , m_outputTrackCollection ) ;
-  // Save the output particle to track relation collection
-  evt->addCollection( trackRelationCollection , m_outputTrackRelationCollection ) ;
-
-	// Increment the event number
-	m_eventNumber++ ;
-	for(unsigned int collection=0; collection<trackerHitCollections.size();collection++) delete relations[collection];
-	
+    
+    return track;
 }
 
 void TruthTrackFinder::check( LCEvent * evt ) {
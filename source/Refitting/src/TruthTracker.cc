@@ -17,7 +17,6 @@
 
 
 #include <IMPL/LCRelationImpl.h>
-#include <UTIL/LCRelationNavigator.h>
 
 // ----- include for verbosity dependend logging ---------
 #include "marlin/VerbosityLevels.h"
@@ -324,7 +323,7 @@ void TruthTracker::processEvent( LCEvent * evt ) {
   _nMCP = 0 ;
   
   _colTrackerHits.clear();
-  _navTrackerHitRel.clear();
+  _truthTrackerHitRel.clear();
   _nCreatedTracks = 0;
   
   /**********************************************************************************************/
@@ -376,7 +375,7 @@ void TruthTracker::processEvent( LCEvent * evt ) {
     LCCollection* trackerHitCol = _colTrackerHits[iCol];
     int nHits = trackerHitCol->getNumberOfElements();
     
-    LCRelationNavigator* nav = _navTrackerHitRel[iCol];
+    const TruthRelationIndex::EntryVec& truthRows = *_truthTrackerHitRel[iCol];
     
     for( int j=0; j<nHits; j++ ){
       
@@ -395,14 +394,14 @@ void TruthTracker::processEvent( LCEvent * evt ) {
         
       }
       
-      const LCObjectVec& to = nav->getRelatedToObjects( trkhit );
+      const TruthRelationIndex::Entry& truth = truthRows[j];
       
       if( BitSet32( trkhit->getType() )[ UTIL::ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT ]   ){ //it is a composite spacepoint
         
-        if( to.size() == 2 ){
+        if( truth.nSimHits == 2 ){
           
-          SimTrackerHit* simhitA = dynamic_cast<SimTrackerHit*>(to.at(0));
-          SimTrackerHit* simhitB = dynamic_cast<SimTrackerHit*>(to.at(1));
+          SimTrackerHit* simhitA = truth.simhits[0];
+          SimTrackerHit* simhitB = truth.simhits[1];
           
           MCParticle* mcpA = simhitA->getMCParticle();
           MCParticle* mcpB = simhitB->getMCParticle();
@@ -447,14 +446,14 @@ void TruthTracker::processEvent( LCEvent * evt ) {
           
           
         }        
-        else{ streamlog_out( DEBUG0 ) << "spacepoint discarded, because it is related to " << to.size() << "SimTrackerHits. It should be 2!\n"; } 
+        else{ streamlog_out( DEBUG0 ) << "spacepoint discarded, because it is related to " << truth.nSimHits << "SimTrackerHits. It should be 2!\n"; } 
         
       }
       else{  // no composite spacepoint
         
-        if( to.size() == 1){ // only take trackerHits, that have only one related SimHit
+        if( truth.nSimHits == 1){ // only take trackerHits, that have only one related SimHit
           
-          SimTrackerHit* simhit = dynamic_cast<SimTrackerHit*>(to.at(0));
+          SimTrackerHit* simhit = truth.simhits[0];
           simHitTrkHit.push_back(std::make_pair(simhit, trkhit));
           
 //#ifdef MARLINTRK_DIAGNOSTICS_ON
@@ -462,7 +461,7 @@ void TruthTracker::processEvent( LCEvent * evt ) {
 //          trkhit->ext<MarlinTrk::MCTruth4HitExt>()->simhit = simhit;  
 //#endif       
         }
-        else{ streamlog_out( DEBUG0 ) << "TrackerHit discarded, because it is related to " << to.size() << "SimTrackerHits. It should be 1!\n"; }
+        else{ streamlog_out( DEBUG0 ) << "TrackerHit discarded, because it is related to " << truth.nSimHits << "SimTrackerHits. It should be 1!\n"; }
         
       }
       
@@ -588,11 +587,6 @@ void TruthTracker::processEvent( LCEvent * evt ) {
   
   streamlog_out( DEBUG4 ) << "Created " << _nCreatedTracks << " truth tracks\n";
   
-  // clear the navigator relations
-  for (unsigned i = 0 ; i < _navTrackerHitRel.size(); ++i) {
-    delete _navTrackerHitRel[i];
-  }
-  
   ++_n_evt ;
   
 }
@@ -633,6 +627,10 @@ void TruthTracker::SetupInputCollections( LCEvent * evt ) {
     exit(1);
   }
   
+  const TruthRelationIndex* index = TruthRelationIndex::get( evt );
+  
+  _truthIndex.clear();
+  
   for( unsigned i=0; i< _colNamesTrackerHits.size(); i++ ){
     
     
@@ -640,13 +638,23 @@ void TruthTracker::SetupInputCollections( LCEvent * evt ) {
     LCCollection* colTrkHits = GetCollection( evt, _colNamesTrackerHits[i] );
     if( colTrkHits == NULL ) continue;
     
-    // the relations of them
-    LCRelationNavigator* nav = GetRelations( evt, _colNamesTrackerHitRelations[i] );
-    if( nav == NULL ) continue;
+    // the relations of them, use the shared index if it has been built for this event
+    const TruthRelationIndex::EntryVec* rows = index ? index->getCollection( _colNamesTrackerHits[i], _colNamesTrackerHitRelations[i] ) : NULL;
     
+    if( rows == NULL ) {
+      
+      LCCollection* colRel = GetCollection( evt, _colNamesTrackerHitRelations[i] );
+      if( colRel == NULL ) {
+        streamlog_out( ERROR ) << " --> " << _colNamesTrackerHitRelations[i] << " track relation collection absent" << std::endl;     
+        continue;
+      }
+      
+      rows = &_truthIndex.addCollection( _colNamesTrackerHits[i], _colNamesTrackerHitRelations[i], colTrkHits, colRel );
+      
+    }
     
     _colTrackerHits.push_back( colTrkHits );
-    _navTrackerHitRel.push_back( nav );
+    _truthTrackerHitRel.push_back( rows );
     
     
   }
@@ -2075,24 +2083,6 @@ LCCollection* TruthTracker::GetCollection(  LCEvent * evt, std::string colName )
   
 }
 
-LCRelationNavigator* TruthTracker::GetRelations(LCEvent * evt , std::string RelName ) {
-  
-  LCRelationNavigator* nav = NULL ;
-  LCCollection* col = NULL;
-  
-  try{
-    
-    col = evt->getCollection( RelName.c_str() );
-    nav = new LCRelationNavigator( col );
-    streamlog_out( DEBUG4 ) << " --> " << RelName << " track relation collection found, number of elements = " << col->getNumberOfElements() << std::endl;
-  }
-  catch(DataNotAvailableException &e){
-    streamlog_out( ERROR ) << " --> " << RelName.c_str() << " track relation collection absent" << std::endl;     
-  }
-  
-  return nav;
-  
-}
 
 
 void TruthTracker::drawEvent(){
@@ -0,0 +1,80 @@
+#ifndef BuildTruthRelationIndex_h
+#define BuildTruthRelationIndex_h 1
+
+#include "marlin/Processor.h"
+#include "lcio.h"
+#include <string>
+#include <vector>
+
+using namespace lcio ;
+using namespace marlin ;
+
+
+/** Builds, once per event, the flat TrackerHit -> SimTrackerHit -> MCParticle table (TruthRelationIndex)
+ *  for the given tracker hit collections and publishes it for the processors that follow.
+ *  TruthTracker, TruthTrackFinder, SetTrackerHitExtensions and CalcTrackerHitResiduals use the
+ *  published table instead of creating their own LCRelationNavigators.
+ *
+ *  <h4>Input - Prerequisites</h4>
+ *  Needs collections of LCIO TrackerHits and the LCRelations to their SimTrackerHits.
+ *
+ * @param TrackerHitsInputCollections Name of the tracker hit input collections <br>
+ * (default value: VXDTrackerHits SITTrackerHits FTDPixelTrackerHits FTDSpacePoints TPCTrackerHits SETTrackerHits )
+ *
+ * @param TrackerHitsRelInputCollections Name of the lcrelation collections, that link the TrackerHits to their SimTrackerHits.
+ * Have to be in same order as TrackerHitsInputCollections!!! <br>
+ * (default value: VXDTrackerHitRelations SITTrackerHitRelations FTDPixelTrackerHitRelations FTDSpacePointRelations TPCTrackerHitRelations SETTrackerHitRelations )
+ *
+ */
+class BuildTruthRelationIndex : public Processor {
+  
+public:
+  
+  virtual Processor*  newProcessor() { return new BuildTruthRelationIndex ; }
+  
+  
+  BuildTruthRelationIndex() ;
+  
+  /** Called at the begin of the job before anything is read.
+   * Use to initialize the processor, e.g. book histograms.
+   */
+  virtual void init() ;
+  
+  /** Called for every run.
+   */
+  virtual void processRunHeader( LCRunHeader* run ) ;
+  
+  /** Called for every event - the working horse.
+   */
+  virtual void processEvent( LCEvent * evt ) ; 
+  
+  
+  virtual void check( LCEvent * evt ) ; 
+  
+  
+  /** Called after data processing for clean up.
+   */
+  virtual void end() ;
+  
+protected:
+  
+  /** helper function to get collection using try catch block */
+  LCCollection* GetCollection(  LCEvent * evt, std::string colName ) ;
+  
+  /** input TrackerHit collections
+   */
+  std::vector< std::string > _colNamesTrackerHits;
+ 
+  /** input relation collections 
+   */
+  std::vector< std::string > _colNamesTrackerHitRelations;
+  
+  int _n_run ;
+  int _n_evt ;
+  
+} ;
+
+#endif
+
+
+
@@ -12,6 +12,8 @@
 #include <UTIL/BitField64.h>
 #include <UTIL/ILDConf.h>
 
+#include "TruthRelationIndex.h"
+
 namespace EVENT{
   class MCParticle ;
   class Track ;
@@ -87,11 +89,27 @@ protected:
   
 //  void bookHistograms();
   
+  /// the residuals histogrammed for every input collection
+  enum ResidualType { res_x = 0, res_y, res_z, res_r, res_rphi, res_du, res_dv, res_dw, NRESIDUALTYPES };
+  
+  /** Residuals of one histogram. The first MAXBUFFERSIZE values are kept in a fixed size reservoir 
+   *  and used to choose the histogram range, after that the histogram is filled directly. 
+   */
+  struct HistogramBuffer {
+    std::string name;
+    float values[MAXBUFFERSIZE];
+    unsigned nValues;
+    TH1F* histo;
+  };
+  
+  /** integer handle of the histogram for residual type of steering collection iColName, resolved once in init */
+  int histoHandle(unsigned iColName, ResidualType type) const { return iColName*NRESIDUALTYPES + type; }
+  
   void createHistogramBuffers();
   
-  void fill_histo(const std::string& name, float value);
+  void fill_histo(int handle, float value);
   
-  void write_buffer_to_histo( std::map<std::string, std::list<float>*>::iterator it_buffer );
+  void write_buffer_to_histo( HistogramBuffer& buffer );
   
   const LCObjectVec* getSimHits( TrackerHit* trkhit, const FloatVec* weights = NULL);
   
@@ -108,10 +126,8 @@ protected:
   /** helper function to get collection using try catch block */
   LCCollection* GetCollection(  LCEvent * evt, std::string colName ) ;
   
-  /** helper function to get relations using try catch block */
-  LCRelationNavigator* GetRelations( LCEvent * evt, std::string RelName ) ;
-  
-  /** sets up the different collections */
+  /** sets up the different collections, the truth relations are taken from the
+   *  TruthRelationIndex published by BuildTruthRelationIndex if available */
   void SetupInputCollections( LCEvent * evt ) ;
   
     
@@ -131,15 +147,16 @@ protected:
   
   
   std::vector< LCCollection* > _colTrackerHits;
-  std::vector< LCRelationNavigator* > _navTrackerHitRel;
+  std::vector< unsigned > _colIndexTrackerHits; // position of the collection in _colNamesTrackerHits
+  std::vector< const TruthRelationIndex::EntryVec* > _truthTrackerHitRel;
+  
+  /** private truth index, used if no BuildTruthRelationIndex ran for this event */
+  TruthRelationIndex _truthIndex;
     
   
   TFile* _root_file;
   
-  std::map<std::string, TH1F*> _histo_map;
-  std::map<std::string, TH1F*>::iterator _histo_map_it;
-  
-  std::map<std::string, std::list<float>*> _histo_buffer_map;
+  std::vector<HistogramBuffer> _histo_buffers;
   
   
 } ;
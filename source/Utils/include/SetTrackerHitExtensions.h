@@ -12,6 +12,10 @@
 #include <UTIL/BitField64.h>
 #include <UTIL/ILDConf.h>
 
+#include "MarlinTrk/MarlinTrkDiagnostics.h"
+
+#include "TruthRelationIndex.h"
+
 namespace EVENT{
   class MCParticle ;
   class Track ;
@@ -43,6 +47,11 @@ namespace MarlinTrk{
  * Have to be in same order as TrackerHitsInputCollections!!! <br>
  * (default value: FTDTrackerHitRelations SITTrackerHitRelations TPCTrackerHitRelations VXDTrackerHitRelations )
  * 
+ * @param LazyMCTruth4HitExt Only store a hit -> simhit index per event and create the MCTruth4HitExt of a hit on the first 
+ * call to SetTrackerHitExtensions::getMCTruth4HitExt. Code reading the extension directly, e.g. the MarlinTrk diagnostics, 
+ * needs the default eager mode. <br>
+ * (default value: false )
+ * 
  * 
  * 
  * @author S. J. Aplin, DESY 
@@ -78,8 +87,25 @@ public:
    */
   virtual void end() ;
   
+#ifdef MARLINTRK_DIAGNOSTICS_ON
+  
+  /** Returns the MCTruth4HitExt of the hit. In lazy mode the extension is created on the first call 
+   *  from the hit -> simhit index of the current event. Returns NULL if the hit has no single SimTrackerHit.
+   */
+  static MarlinTrk::MCTruth4HitExtStruct* getMCTruth4HitExt( EVENT::TrackerHit* hit ) ;
+  
+  /** Makes sure the MCTruth4HitExts of the hit, or of its strip hits for composite spacepoints, exist */
+  static void resolveMCTruth4HitExts( EVENT::TrackerHit* hit ) ;
+  
+#endif
+  
 protected:
   
+#ifdef MARLINTRK_DIAGNOSTICS_ON
+  /** attach simhit to hit via MCTruth4HitExt, or only remember the link in lazy mode */
+  void linkSimHit( TrackerHit* hit, SimTrackerHit* simhit ) ;
+#endif
+  
   
   const LCObjectVec* getSimHits( TrackerHit* trkhit, const FloatVec* weights = NULL);
   
@@ -94,10 +120,8 @@ protected:
   /** helper function to get collection using try catch block */
   LCCollection* GetCollection(  LCEvent * evt, std::string colName ) ;
   
-  /** helper function to get relations using try catch block */
-  LCRelationNavigator* GetRelations( LCEvent * evt, std::string RelName ) ;
-  
-  /** sets up the different collections */
+  /** sets up the different collections, the truth relations are taken from the
+   *  TruthRelationIndex published by BuildTruthRelationIndex if available */
   void SetupInputCollections( LCEvent * evt ) ;
   
   
@@ -111,6 +135,8 @@ protected:
   std::vector< std::string > _colNamesTrackerHitRelations;
   
   
+  bool _lazyAttachment ;
+  
 //   int _nEventPrintout ;
   int _n_run ;
   int _n_evt ;
@@ -118,7 +144,10 @@ protected:
   
   
   std::vector< LCCollection* > _colTrackerHits;
-  std::vector< LCRelationNavigator* > _navTrackerHitRel;
+  std::vector< const TruthRelationIndex::EntryVec* > _truthTrackerHitRel;
+  
+  /** private truth index, used if no BuildTruthRelationIndex ran for this event */
+  TruthRelationIndex _truthIndex;
     
   
 } ;
@@ -5,7 +5,9 @@
 #include "marlin/EventModifier.h"
 
 #include "lcio.h"
+#include <IMPL/LCCollectionVec.h>
 #include <string>
+#include <vector>
 
 
 using namespace lcio ;
@@ -33,7 +35,8 @@ protected:
     std::string name ;
     unsigned layer0 ;
     unsigned layer1 ;
-    LCCollection* collection ;
+    LCCollectionVec* collection ;
+    unsigned nHits ;
   };
   
   /// Enum used for hit types
@@ -78,6 +81,16 @@ protected:
 
  protected:
 
+  /** decode the position of the layer field from the encoding string, only called when the encoding changes */
+  void setupLayerField( const std::string& encoderString ) ;
+
+  /** layer number of the cellID, extracted with a shift and mask */
+  int layerFromCellID( long id ) const {
+    long layer = ( id & _layerMask ) >> _layerOffset ;
+    if( _layerSigned && ( layer & ( 1L << ( _layerWidth - 1 ) ) ) ) layer -= ( 1L << _layerWidth ) ;
+    return layer ;
+  }
+
   ////Input collection name.
   std::string _colName ;
 
@@ -86,6 +99,19 @@ protected:
 
   std::vector<OutColInfo> _outCols ;
 
+  /// output collection indices for every layer number, built once in init
+  std::vector< std::vector<unsigned> > _layerToOutCols ;
+
+  /// encoding the layer field below was decoded from
+  std::string _encoderString ;
+  long _layerMask ;
+  unsigned _layerOffset ;
+  unsigned _layerWidth ;
+  bool _layerSigned ;
+
+  /// layer of every hit of the current event, kept to avoid reallocation
+  std::vector<int> _hitLayers ;
+
   HitType _type ;
 
   int _nRun ;
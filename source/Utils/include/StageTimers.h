@@ -0,0 +1,116 @@
+#ifndef StageTimers_h
+#define StageTimers_h 1
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <chrono>
+
+/** Lightweight instrumentation for processors: high resolution wall clock timers and counters
+ *  for named processing stages.
+ *
+ *  Stages and counters are registered once in init() and referred to by the returned integer
+ *  handle afterwards. Per event the times and counts are accumulated into a summary for each run
+ *  which is printed by printSummary() in end(). Optionally one CSV line per event is written.
+ *  When disabled the timers do not read the clock and counting is a single branch.
+ *
+ *  Usage:
+ *  <pre>
+ *    init():          _timers.init( name(), _timeStages, _stageTimingCSVFile ) ;
+ *                     _stageSorting = _timers.addStage( "Sorting" ) ;
+ *    processEvent():  _timers.startEvent( evt->getRunNumber(), evt->getEventNumber() ) ;
+ *                     { StageTimers::Scope t( _timers, _stageSorting ) ; Sorting() ; }
+ *                     _timers.endEvent() ;
+ *    end():           _timers.printSummary() ;
+ *  </pre>
+ */
+class StageTimers {
+
+public:
+
+  typedef std::chrono::steady_clock Clock ;
+
+  StageTimers() ;
+  ~StageTimers() ;
+
+  /** owner is used in the printout, an empty csvFileName disables the per event output */
+  void init( const std::string& owner, bool enabled, const std::string& csvFileName ) ;
+
+  /** register a stage, returns the handle passed to Scope and addTime */
+  int addStage( const std::string& name ) ;
+
+  /** register a counter, returns the handle passed to count */
+  int addCounter( const std::string& name ) ;
+
+  bool enabled() const { return _enabled ; }
+
+  void startEvent( int run, int evt ) ;
+  void endEvent() ;
+
+  void addTime( int stage, double seconds ) { _evtTime[stage] += seconds ; ++_evtCalls[stage] ; }
+
+  void count( int counter, long n = 1 ) { if( _enabled ) _evtCounts[counter] += n ; }
+
+  /** print the summary of every run and of the whole job and close the CSV file */
+  void printSummary() ;
+
+  /** times the enclosing scope, or until stop() is called */
+  class Scope {
+  public:
+    Scope( StageTimers& timers, int stage ) : _timers( timers ), _stage( stage ), _running( timers.enabled() ) {
+      if( _running ) _start = Clock::now() ;
+    }
+    ~Scope() { stop() ; }
+    void stop() {
+      if( _running ) {
+        _timers.addTime( _stage, std::chrono::duration<double>( Clock::now() - _start ).count() ) ;
+        _running = false ;
+      }
+    }
+  private:
+    StageTimers& _timers ;
+    int _stage ;
+    bool _running ;
+    Clock::time_point _start ;
+  };
+
+private:
+
+  struct RunSummary {
+    int run ;
+    long nEvents ;
+    double totalTime ;
+    double maxEventTime ;
+    std::vector<double> time ;
+    std::vector<double> maxTime ;
+    std::vector<long> calls ;
+    std::vector<long> counts ;
+  };
+
+  void printRun( const RunSummary& summary ) const ;
+
+  std::string _owner ;
+  bool _enabled ;
+
+  std::vector<std::string> _stageNames ;
+  std::vector<std::string> _counterNames ;
+
+  // current event
+  int _run ;
+  int _evt ;
+  Clock::time_point _evtStart ;
+  std::vector<double> _evtTime ;
+  std::vector<long> _evtCalls ;
+  std::vector<long> _evtCounts ;
+
+  std::vector<RunSummary> _runs ;
+
+  std::string _csvFileName ;
+  std::ofstream* _csv ;
+
+} ;
+
+#endif
+
+
+
@@ -0,0 +1,72 @@
+#ifndef TaskPool_h
+#define TaskPool_h 1
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+/** Small pool of worker threads for running independent tasks of a processor concurrently.
+ *
+ *  The threads are started once in init() and wait for work between the calls of run(). run()
+ *  calls task(i) for every i in [0,nTasks), distributing the indices dynamically over the workers
+ *  and the calling thread, and returns when all tasks are done. The tasks must only write to
+ *  their own outputs, e.g. the i-th element of a vector sized beforehand, so that the results
+ *  can be combined in a fixed order afterwards. The first exception thrown by a task is rethrown
+ *  by run(). With a single thread the tasks are run in order in the calling thread.
+ *
+ *  Usage:
+ *  <pre>
+ *    init():          _taskPool.init( _nThreads ) ;
+ *    processEvent():  std::vector<Result> results( n ) ;
+ *                     _taskPool.run( n, [&]( int i ){ results[i] = convert( i ) ; } ) ;
+ *  </pre>
+ */
+class TaskPool {
+
+public:
+
+  TaskPool() ;
+  ~TaskPool() ;
+
+  /** use nThreads threads including the calling one, nThreads <= 0 uses all hardware threads */
+  void init( int nThreads ) ;
+
+  int nThreads() const { return _workers.size() + 1 ; }
+
+  /** call task(i) for i = 0 ... nTasks-1 and wait until all calls have returned */
+  void run( int nTasks, const std::function<void(int)>& task ) ;
+
+private:
+
+  TaskPool( const TaskPool& ) ;
+  TaskPool& operator=( const TaskPool& ) ;
+
+  void stop() ;
+  void work( unsigned long batch ) ;
+  void execute() ;
+
+  std::vector<std::thread> _workers ;
+
+  std::mutex _mutex ;
+  std::condition_variable _start ;
+  std::condition_variable _done ;
+
+  // current batch of tasks
+  const std::function<void(int)>* _task ;
+  int _nTasks ;
+  std::atomic<int> _next ;
+  int _nBusy ;
+  unsigned long _batch ;
+  bool _stop ;
+  std::exception_ptr _error ;
+
+} ;
+
+#endif
+
+
+
@@ -0,0 +1,89 @@
+#ifndef TruthRelationIndex_h
+#define TruthRelationIndex_h 1
+
+#include "lcio.h"
+#include <string>
+#include <vector>
+#include <deque>
+
+namespace EVENT{
+  class LCEvent ;
+  class LCCollection ;
+  class TrackerHit ;
+  class SimTrackerHit ;
+  class MCParticle ;
+}
+
+/** Flat TrackerHit -> SimTrackerHit -> MCParticle table for a set of tracker hit collections.
+ *
+ *  For every indexed collection there is one row per TrackerHit, stored at the position of
+ *  the hit in its collection, so the truth information of hit j of a collection is simply
+ *  row j. The rows are filled with a single pass over the LCRelation collection instead of
+ *  one LCRelationNavigator lookup per hit.
+ *
+ *  The index is built once per event by the BuildTruthRelationIndex processor and published
+ *  via TruthRelationIndex::get( evt ). Processors that need the truth relations should use the
+ *  published index if it has their hit collection indexed with the same relation collection, and
+ *  otherwise fill a private TruthRelationIndex themselves.
+ */
+class TruthRelationIndex {
+
+public:
+
+  /// one row per TrackerHit
+  struct Entry{
+    EVENT::TrackerHit* trkhit ;
+    EVENT::SimTrackerHit* simhits[2] ;  ///< the first two related SimTrackerHits in relation order
+    int nSimHits ;                      ///< total number of related SimTrackerHits
+    EVENT::MCParticle* mcp ;            ///< MCParticle of simhits[0], NULL if there is none
+  };
+
+  typedef std::vector<Entry> EntryVec ;
+
+  TruthRelationIndex() : _nUsed(0), _evt(0), _runNumber(-1), _evtNumber(-1) {}
+
+  /** Forget all collections and the event, keeps the allocated rows for reuse */
+  void clear() ;
+
+  /** Mark the index as belonging to evt */
+  void setEvent( const EVENT::LCEvent* evt ) ;
+
+  /** True if the index was built for evt */
+  bool isForEvent( const EVENT::LCEvent* evt ) const ;
+
+  /** Index the hits of the collection name, colTrkHits, using the relations of the collection relName,
+   *  colRel, and return the rows. The returned reference stays valid until the next call to clear().
+   */
+  const EntryVec& addCollection( const std::string& name, const std::string& relName, EVENT::LCCollection* colTrkHits, EVENT::LCCollection* colRel ) ;
+
+  /** Rows for the tracker hit collection name indexed with the relation collection relName, NULL if it
+   *  has not been indexed or only with other relations
+   */
+  const EntryVec* getCollection( const std::string& name, const std::string& relName ) const ;
+
+  /** The index published for evt by BuildTruthRelationIndex, NULL if none was built for this event */
+  static const TruthRelationIndex* get( const EVENT::LCEvent* evt ) ;
+
+  /** The process wide index filled by BuildTruthRelationIndex */
+  static TruthRelationIndex& published() ;
+
+private:
+
+  std::vector<std::string> _names ;
+  std::vector<std::string> _relNames ;
+  std::deque<EntryVec> _rows ;  // deque so that references handed out by addCollection stay valid
+  unsigned _nUsed ;
+
+  // scratch space for the hit pointer -> position lookup, kept to avoid reallocation
+  std::vector< std::pair<const void*, int> > _positions ;
+
+  const EVENT::LCEvent* _evt ;
+  int _runNumber ;
+  int _evtNumber ;
+
+} ;
+
+#endif
+
+
+
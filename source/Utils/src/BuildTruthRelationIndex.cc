@@ -0,0 +1,153 @@
+
+#include "BuildTruthRelationIndex.h"
+#include "TruthRelationIndex.h"
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+#include <EVENT/LCCollection.h>
+
+// ----- include for verbosity dependend logging ---------
+#include "marlin/VerbosityLevels.h"
+
+
+using namespace lcio ;
+using namespace marlin ;
+
+
+
+BuildTruthRelationIndex aBuildTruthRelationIndex ;
+
+BuildTruthRelationIndex::BuildTruthRelationIndex() : Processor("BuildTruthRelationIndex") {
+    
+  // modify processor description
+  _description = "Builds once per event a flat TrackerHit -> SimTrackerHit -> MCParticle table that is shared by the truth processors" ;
+  
+  // register steering parameters: name, description, class-variable, default value
+  
+  StringVec trackerHitsRelInputColNamesDefault;
+  trackerHitsRelInputColNamesDefault.push_back( "VXDTrackerHitRelations" );
+  trackerHitsRelInputColNamesDefault.push_back( "SITTrackerHitRelations" );
+  trackerHitsRelInputColNamesDefault.push_back( "FTDPixelTrackerHitRelations" );
+  trackerHitsRelInputColNamesDefault.push_back( "FTDSpacePointRelations" );
+  trackerHitsRelInputColNamesDefault.push_back( "TPCTrackerHitRelations" );
+  trackerHitsRelInputColNamesDefault.push_back( "SETTrackerHitRelations" );
+  
+  
+  registerInputCollections("LCRelation",
+                           "TrackerHitsRelInputCollections",
+                           "Name of the lcrelation collections, that link the TrackerHits to their SimTrackerHits. Have to be in same order as TrackerHitsInputCollections!!!",
+                           _colNamesTrackerHitRelations,
+                           trackerHitsRelInputColNamesDefault );
+  
+  
+  StringVec trackerHitsInputColNamesDefault;
+  
+  trackerHitsInputColNamesDefault.push_back( "VXDTrackerHits" );
+  trackerHitsInputColNamesDefault.push_back( "SITTrackerHits" );
+  trackerHitsInputColNamesDefault.push_back( "FTDPixelTrackerHits" );
+  trackerHitsInputColNamesDefault.push_back( "FTDSpacePoints" );
+  trackerHitsInputColNamesDefault.push_back( "TPCTrackerHits" );
+  trackerHitsInputColNamesDefault.push_back( "SETTrackerHits" );
+  
+  registerInputCollections("TrackerHit",
+                           "TrackerHitsInputCollections", 
+                           "Name of the tracker hit input collections",
+                           _colNamesTrackerHits,
+                           trackerHitsInputColNamesDefault);
+  
+  
+  _n_run = 0 ;
+  _n_evt = 0 ;
+  
+}
+
+
+void BuildTruthRelationIndex::init() { 
+  
+  streamlog_out(DEBUG) << "   init called  " 
+  << std::endl ;
+  
+  // usually a good idea to
+  printParameters() ;
+  
+  // Check if there are as many tracker hit input collections as relation collections
+  if(  _colNamesTrackerHits.size() !=  _colNamesTrackerHitRelations.size() ){
+    
+    streamlog_out( ERROR ) << "There must be as many input collections of tracker Hits as of relations. At the moment, there are "
+    << _colNamesTrackerHits.size() << " tracker hit collections and " << _colNamesTrackerHitRelations.size() << " relation collections passed as steering paremeters!\n";
+    
+    exit(1);
+  }
+  
+}
+
+void BuildTruthRelationIndex::processRunHeader( LCRunHeader* run) { 
+  
+  ++_n_run ;
+} 
+
+void BuildTruthRelationIndex::processEvent( LCEvent * evt ) { 
+  
+  streamlog_out(DEBUG3) << "   processing event: " << _n_evt << std::endl ;
+  
+  TruthRelationIndex& index = TruthRelationIndex::published() ;
+  
+  index.clear() ;
+  index.setEvent( evt ) ;
+  
+  for( unsigned i=0; i< _colNamesTrackerHits.size(); i++ ){
+    
+    // the tracker hits
+    LCCollection* colTrkHits = GetCollection( evt, _colNamesTrackerHits[i] );
+    if( colTrkHits == NULL ) continue;
+    
+    // the relations of them
+    LCCollection* colRel = GetCollection( evt, _colNamesTrackerHitRelations[i] );
+    if( colRel == NULL ) {
+      streamlog_out( ERROR ) << " --> " << _colNamesTrackerHitRelations[i] << " track relation collection absent" << std::endl;     
+      continue;
+    }
+    
+    index.addCollection( _colNamesTrackerHits[i], _colNamesTrackerHitRelations[i], colTrkHits, colRel ) ;
+    
+  }
+  
+  ++_n_evt ;
+  
+}
+
+
+
+void BuildTruthRelationIndex::check( LCEvent * evt ) { 
+  // nothing to check here - could be used to fill checkplots in reconstruction processor
+}
+
+
+void BuildTruthRelationIndex::end() { 
+  
+  streamlog_out(DEBUG4) << "BuildTruthRelationIndex::end()  " << name() 
+  << " processed " << _n_evt << " events in " << _n_run << " runs "
+  << std::endl ;
+  
+  TruthRelationIndex::published().clear() ;
+  
+}
+
+
+LCCollection* BuildTruthRelationIndex::GetCollection(  LCEvent * evt, std::string colName ){
+  
+  LCCollection* col = NULL;
+  
+  try {
+    col = evt->getCollection( colName.c_str() ) ;
+    streamlog_out( DEBUG4 ) << " --> " << colName.c_str() << " collection found, number of elements = " << col->getNumberOfElements() << std::endl;
+  }
+  catch(DataNotAvailableException &e) {
+    streamlog_out( DEBUG4 ) << " --> " << colName.c_str() <<  " collection absent" << std::endl;     
+  }
+  
+  return col; 
+  
+}
@@ -3,6 +3,8 @@
 
 #include <vector>
 #include <cstdlib>
+#include <algorithm>
+#include <cmath>
 
 #include <EVENT/LCCollection.h>
 #include <IMPL/LCCollectionVec.h>
@@ -12,7 +14,6 @@
 #include <EVENT/SimTrackerHit.h>
 
 #include <IMPL/LCRelationImpl.h>
-#include <UTIL/LCRelationNavigator.h>
 
 // ----- include for verbosity dependend logging ---------
 #include "marlin/VerbosityLevels.h"
@@ -91,9 +92,6 @@ CalcTrackerHitResiduals::CalcTrackerHitResiduals() : Processor("CalcTrackerHitRe
   
   _root_file = 0;
   
-  _histo_map.clear();
-  _histo_map_it = _histo_map.begin();
-  
 }
 
 
@@ -143,7 +141,8 @@ void CalcTrackerHitResiduals::processEvent( LCEvent * evt ) {
   
   
   _colTrackerHits.clear();
-  _navTrackerHitRel.clear();
+  _colIndexTrackerHits.clear();
+  _truthTrackerHitRel.clear();
   
   /**********************************************************************************************/
   /*                Prepare the collections                                                     */
@@ -168,14 +167,16 @@ void CalcTrackerHitResiduals::processEvent( LCEvent * evt ) {
     
     LCCollection* trackerHitCol = _colTrackerHits[iCol];
     int nHits = trackerHitCol->getNumberOfElements();
+    
+    const unsigned iColName = _colIndexTrackerHits[iCol];
 
-    streamlog_out( DEBUG1 ) << "Process " << _colNamesTrackerHits[iCol] << " collection with " << nHits << " hits \n";
+    streamlog_out( DEBUG1 ) << "Process " << _colNamesTrackerHits[iColName] << " collection with " << nHits << " hits \n";
     
     
     double rec_pos[3];
     double sim_pos[3];
     
-    LCRelationNavigator* nav = _navTrackerHitRel[iCol];
+    const TruthRelationIndex::EntryVec& truthRows = *_truthTrackerHitRel[iCol];
 
     
     /**********************************************************************************************/
@@ -199,7 +200,7 @@ void CalcTrackerHitResiduals::processEvent( LCEvent * evt ) {
         
       }
       
-      const LCObjectVec& to = nav->getRelatedToObjects( trkhit );
+      const TruthRelationIndex::Entry& truth = truthRows[j];
 
       
       const int celId = trkhit->getCellID0() ;
@@ -234,10 +235,10 @@ void CalcTrackerHitResiduals::processEvent( LCEvent * evt ) {
         /**********************************************************************************************/
         
         // Check that the space point is only created from 2 strip hits
-        if( to.size() == 2 ){
+        if( truth.nSimHits == 2 ){
           
-          SimTrackerHit* simhitA = dynamic_cast<SimTrackerHit*>(to.at(0));
-          SimTrackerHit* simhitB = dynamic_cast<SimTrackerHit*>(to.at(1));
+          SimTrackerHit* simhitA = truth.simhits[0];
+          SimTrackerHit* simhitB = truth.simhits[1];
           
           // Check if the simHits are from the same particle in order to avoid problems
           if( simhitA->getMCParticle() == simhitB->getMCParticle() ) { 
@@ -268,12 +269,12 @@ void CalcTrackerHitResiduals::processEvent( LCEvent * evt ) {
             << " dz " << dz 
             << "\n";
 
-            fill_histo(_colNamesTrackerHits[iCol] + "_res_x", dx);
-            fill_histo(_colNamesTrackerHits[iCol] + "_res_y", dy);
-            fill_histo(_colNamesTrackerHits[iCol] + "_res_z", dz);
+            fill_histo(histoHandle(iColName, res_x), dx);
+            fill_histo(histoHandle(iColName, res_y), dy);
+            fill_histo(histoHandle(iColName, res_z), dz);
             
-            fill_histo(_colNamesTrackerHits[iCol] + "_res_r", dr);
-            fill_histo(_colNamesTrackerHits[iCol] + "_res_rphi", drphi);
+            fill_histo(histoHandle(iColName, res_r), dr);
+            fill_histo(histoHandle(iColName, res_rphi), drphi);
                                     
             
           } else { streamlog_out( DEBUG1 ) << "spacepoint discarded, because simHits are not equal " << simhitA->getMCParticle() << " != " 
@@ -281,7 +282,7 @@ void CalcTrackerHitResiduals::processEvent( LCEvent * evt ) {
           }
           
         }        
-        else { streamlog_out( DEBUG1 ) << "spacepoint discarded, because it is related to " << to.size() << "SimTrackerHits. It should be 2!\n"; } 
+        else { streamlog_out( DEBUG1 ) << "spacepoint discarded, because it is related to " << truth.nSimHits << "SimTrackerHits. It should be 2!\n"; } 
         
       } else {  
         
@@ -289,9 +290,9 @@ void CalcTrackerHitResiduals::processEvent( LCEvent * evt ) {
         /*                Treat Normal Hits                                                           */
         /**********************************************************************************************/
         
-        if( to.size() == 1 ){ // only take trackerHits, that have only one related SimHit
+        if( truth.nSimHits == 1 ){ // only take trackerHits, that have only one related SimHit
 
-          SimTrackerHit* simhit = dynamic_cast<SimTrackerHit*>(to.at(0));
+          SimTrackerHit* simhit = truth.simhits[0];
           
           sim_pos[0] = simhit->getPosition()[0];
           sim_pos[1] = simhit->getPosition()[1];
@@ -317,16 +318,16 @@ void CalcTrackerHitResiduals::processEvent( LCEvent * evt ) {
           << "\n";
          
                     
-          fill_histo(_colNamesTrackerHits[iCol] + "_res_x", dx);
-          fill_histo(_colNamesTrackerHits[iCol] + "_res_y", dy);
-          fill_histo(_colNamesTrackerHits[iCol] + "_res_z", dz);
-          fill_histo(_colNamesTrackerHits[iCol] + "_res_du", du);
-          fill_histo(_colNamesTrackerHits[iCol] + "_res_dv", dv);
-          fill_histo(_colNamesTrackerHits[iCol] + "_res_dw", dw);
+          fill_histo(histoHandle(iColName, res_x), dx);
+          fill_histo(histoHandle(iColName, res_y), dy);
+          fill_histo(histoHandle(iColName, res_z), dz);
+          fill_histo(histoHandle(iColName, res_du), du);
+          fill_histo(histoHandle(iColName, res_dv), dv);
+          fill_histo(histoHandle(iColName, res_dw), dw);
           
         }
 
-        else{ streamlog_out( DEBUG1 ) << "TrackerHit discarded, because it is related to " << to.size() << "SimTrackerHits. It should be 1!\n"; }
+        else{ streamlog_out( DEBUG1 ) << "TrackerHit discarded, because it is related to " << truth.nSimHits << "SimTrackerHits. It should be 1!\n"; }
         
       }
       
@@ -380,18 +381,18 @@ void CalcTrackerHitResiduals::end() {
   
   // convert any remaining buffers to histograms
   
-  std::map<std::string, std::list<float>*>::iterator it = _histo_buffer_map.begin();
-  
-  streamlog_out(DEBUG4) << "Number of remaining buffers = " << _histo_buffer_map.size() << std::endl ;
-  
-  for (it = _histo_buffer_map.begin(); it != _histo_buffer_map.end(); ++it) {
+  for (unsigned i = 0; i < _histo_buffers.size(); ++i) {
+    
+    HistogramBuffer& buffer = _histo_buffers[i];
+    
+    if (buffer.histo != 0) continue;
 
-    streamlog_out(DEBUG4) << "Write remaining buffer " << it->first 
+    streamlog_out(DEBUG4) << "Write remaining buffer " << buffer.name 
     << std::endl ;
     
-    this->write_buffer_to_histo(it);
+    this->write_buffer_to_histo(buffer);
 
-    streamlog_out(DEBUG4) << "Write remaining buffer: done " << it->first 
+    streamlog_out(DEBUG4) << "Write remaining buffer: done " << buffer.name 
     << std::endl ;
     
   }
@@ -420,6 +421,10 @@ void CalcTrackerHitResiduals::SetupInputCollections( LCEvent * evt ) {
     exit(1);
   }
   
+  const TruthRelationIndex* index = TruthRelationIndex::get( evt );
+  
+  _truthIndex.clear();
+  
   for( unsigned i=0; i< _colNamesTrackerHits.size(); i++ ){
     
     
@@ -427,13 +432,24 @@ void CalcTrackerHitResiduals::SetupInputCollections( LCEvent * evt ) {
     LCCollection* colTrkHits = GetCollection( evt, _colNamesTrackerHits[i] );
     if( colTrkHits == NULL ) continue;
     
-    // the relations of them
-    LCRelationNavigator* nav = GetRelations( evt, _colNamesTrackerHitRelations[i] );
-    if( nav == NULL ) continue;
+    // the relations of them, use the shared index if it has been built for this event
+    const TruthRelationIndex::EntryVec* rows = index ? index->getCollection( _colNamesTrackerHits[i], _colNamesTrackerHitRelations[i] ) : NULL;
     
+    if( rows == NULL ) {
+      
+      LCCollection* colRel = GetCollection( evt, _colNamesTrackerHitRelations[i] );
+      if( colRel == NULL ) {
+        streamlog_out( ERROR ) << " --> " << _colNamesTrackerHitRelations[i] << " track relation collection absent" << std::endl;     
+        continue;
+      }
+      
+      rows = &_truthIndex.addCollection( _colNamesTrackerHits[i], _colNamesTrackerHitRelations[i], colTrkHits, colRel );
+      
+    }
     
     _colTrackerHits.push_back( colTrkHits );
-    _navTrackerHitRel.push_back( nav );
+    _colIndexTrackerHits.push_back( i );
+    _truthTrackerHitRel.push_back( rows );
     
     
   }
@@ -461,24 +477,6 @@ LCCollection* CalcTrackerHitResiduals::GetCollection(  LCEvent * evt, std::strin
   
 }
 
-LCRelationNavigator* CalcTrackerHitResiduals::GetRelations(LCEvent * evt , std::string RelName ) {
-  
-  LCRelationNavigator* nav = NULL ;
-  LCCollection* col = NULL;
-  
-  try{
-    
-    col = evt->getCollection( RelName.c_str() );
-    nav = new LCRelationNavigator( col );
-    streamlog_out( DEBUG4 ) << " --> " << RelName << " track relation collection found, number of elements = " << col->getNumberOfElements() << std::endl;
-  }
-  catch(DataNotAvailableException &e){
-    streamlog_out( ERROR ) << " --> " << RelName.c_str() << " track relation collection absent" << std::endl;     
-  }
-  
-  return nav;
-  
-}
 
 
 //void CalcTrackerHitResiduals::bookHistograms(){
@@ -516,94 +514,58 @@ LCRelationNavigator* CalcTrackerHitResiduals::GetRelations(LCEvent * evt , std::
 
 void CalcTrackerHitResiduals::createHistogramBuffers(){
 
-    for( unsigned iCol=0; iCol<_colNamesTrackerHits.size(); iCol++){
-
-      std::list<float>* buffer = 0;
-      
-      std::string name;
-
-      name = _colNamesTrackerHits[iCol] + "_res_x";
-      buffer = new std::list<float>;      
-      _histo_buffer_map[name] = buffer;
-
-      name = _colNamesTrackerHits[iCol] + "_res_y";
-      buffer = new std::list<float>;      
-      _histo_buffer_map[name] = buffer;
-
-      name = _colNamesTrackerHits[iCol] + "_res_z";
-      buffer = new std::list<float>;      
-      _histo_buffer_map[name] = buffer;
-      
-      name = _colNamesTrackerHits[iCol] + "_res_r";
-      buffer = new std::list<float>;      
-      _histo_buffer_map[name] = buffer;
-      
-      name = _colNamesTrackerHits[iCol] + "_res_rphi";
-      buffer = new std::list<float>;      
-      _histo_buffer_map[name] = buffer;
+  static const char* suffix[NRESIDUALTYPES] = { "_res_x", "_res_y", "_res_z", "_res_r", "_res_rphi", "_res_du", "_res_dv", "_res_dw" };
+  
+  _histo_buffers.resize( _colNamesTrackerHits.size() * NRESIDUALTYPES );
+  
+  for( unsigned iCol=0; iCol<_colNamesTrackerHits.size(); iCol++){
+    
+    for( int type=0; type<NRESIDUALTYPES; type++){
       
-      name = _colNamesTrackerHits[iCol] + "_res_du";
-      buffer = new std::list<float>;      
-      _histo_buffer_map[name] = buffer;
+      HistogramBuffer& buffer = _histo_buffers[ histoHandle(iCol, ResidualType(type)) ];
       
-      name = _colNamesTrackerHits[iCol] + "_res_dv";
-      buffer = new std::list<float>;      
-      _histo_buffer_map[name] = buffer;
-      
-      name = _colNamesTrackerHits[iCol] + "_res_dw";
-      buffer = new std::list<float>;      
-      _histo_buffer_map[name] = buffer;
-
+      buffer.name    = _colNamesTrackerHits[iCol] + suffix[type];
+      buffer.nValues = 0;
+      buffer.histo   = 0;
       
     }
+    
+  }
 
 }
 
-void CalcTrackerHitResiduals::write_buffer_to_histo(std::map<std::string, std::list<float>*>::iterator it_buffer){
+void CalcTrackerHitResiduals::write_buffer_to_histo(HistogramBuffer& buffer){
   
   
   // to avoid outliers we will discard the top and bottom 10 percent of values and calculate the rms from that
-    
-  std::string name = it_buffer->first;
-  std::list<float>* buffer = it_buffer->second;
   
-  if (buffer->empty()) {
+  if (buffer.nValues == 0) {
     return;
   }
   
-  buffer->sort();
+  // sort a copy, the reservoir is filled into the histogram in the order the values came in
+  float sorted[MAXBUFFERSIZE];
+  std::copy(buffer.values, buffer.values + buffer.nValues, sorted);
+  std::sort(sorted, sorted + buffer.nValues);
   
-  std::list<float>::iterator it;
-  std::list<float>::iterator it_first_10pc = buffer->begin();
-  std::list<float>::iterator it_last_10pc = buffer->end();
-
-  
-  int ten_percent = buffer->size() * 0.1;
-  
-  for (int i = 0 ; i<ten_percent; ++i) {
-    it_first_10pc++;
-    it_last_10pc--;    
-  }
-
+  int ten_percent = buffer.nValues * 0.1;
  
   float sum2 = 0;
   float sum = 0;
-  int i = 0;
   
-  for(it=it_first_10pc; it != it_last_10pc; ++it) {
+  for(unsigned i = ten_percent; i < buffer.nValues - ten_percent; ++i) {
     
-    sum  += (*it);
-    sum2 += (*it) * (*it);
-    streamlog_out(MESSAGE) << "i = " << i << " value " << *it << " sum = " << sum << " sum2 = " << sum2 << std::endl;
-    i++;
+    sum  += sorted[i];
+    sum2 += sorted[i] * sorted[i];
+    streamlog_out(DEBUG0) << "i = " << i << " value " << sorted[i] << " sum = " << sum << " sum2 = " << sum2 << std::endl;
     
   }
   
-  unsigned N = buffer->size() - 2*ten_percent;
+  unsigned N = buffer.nValues - 2*ten_percent;
   float mean = sum / N ;
   float rms = sqrt( sum2/N - mean*mean ); 
   
-  streamlog_out(MESSAGE) << "write_buffer_to_histo: Histo Name = " << name 
+  streamlog_out(MESSAGE) << "write_buffer_to_histo: Histo Name = " << buffer.name 
   << " sum2 = " << sum2
   << " sum = " << sum
   << " rms = " << rms
@@ -618,77 +580,40 @@ void CalcTrackerHitResiduals::write_buffer_to_histo(std::map<std::string, std::l
     
   _root_file->cd();
   
-  TH1F* histo = new TH1F(name.c_str(), name.c_str(), nbinsx, xlow, xup);
-  _histo_map[name] = histo;
+  buffer.histo = new TH1F(buffer.name.c_str(), buffer.name.c_str(), nbinsx, xlow, xup);
     
-  for(it=buffer->begin(); it != buffer->end(); ++it) {
-    histo->Fill(*it);
+  for(unsigned i = 0; i < buffer.nValues; ++i) {
+    buffer.histo->Fill(buffer.values[i]);
   }
   
+  buffer.nValues = 0;
    
 }
 
-void CalcTrackerHitResiduals::fill_histo(const std::string& name, float value){
-
+void CalcTrackerHitResiduals::fill_histo(int handle, float value){
 
-  streamlog_out(DEBUG1) << "fill_histo: Histo Name = " << name << std::endl;
-  
-  // first check if the buffer is still being used
-  
-  std::map<std::string, std::list<float>*>::iterator it = _histo_buffer_map.begin();
+  HistogramBuffer& buffer = _histo_buffers[handle];
   
-  it = _histo_buffer_map.find(name);
+  // as long as the range is not known the value goes into the reservoir
   
-  if (it != _histo_buffer_map.end()) {
-
-    streamlog_out(DEBUG1) << "fill_histo: Use buffer" << std::endl;
-    
-    std::list<float>* buffer = it->second;
+  if (buffer.histo == 0) {
     
-    buffer->push_back(value);
+    buffer.values[buffer.nValues++] = value;
 
     // now check if the buffer is full
     
-    if (buffer->size() == MAXBUFFERSIZE) {
+    if (buffer.nValues == MAXBUFFERSIZE) {
 
-      write_buffer_to_histo(it);
-      
-      delete buffer;
-      _histo_buffer_map.erase(it);
+      write_buffer_to_histo(buffer);
       
     }
     
-    
   // else just fill the historgram directly 
     
   } else {
-
-    streamlog_out(DEBUG1) << "fill_histo: Use Histo" << std::endl;
-    
-    _histo_map_it = _histo_map.find(name);
-    
-    if (_histo_map_it == _histo_map.end()) {
-      
-      for (_histo_map_it = _histo_map.begin(); _histo_map_it!=_histo_map.end(); ++_histo_map_it ) {
-        streamlog_out(ERROR) << " Histo Name = " << _histo_map_it->first << " Pointer = " << _histo_map_it->second << std::endl;
-      }
-      
-      throw EVENT::Exception( std::string(" Histogram ") + name + std::string(" does not exist in the _histo_map")) ;    
-      
-    } 
-    
-        
-    TH1F* histo = _histo_map_it->second;
-
     
-    histo->Fill(value);
+    buffer.histo->Fill(value);
     
   }
-
-  
-  
   
 }
-
-
-
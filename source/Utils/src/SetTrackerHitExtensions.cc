@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <cstdlib>
+#include <algorithm>
 
 #include <EVENT/LCCollection.h>
 #include <IMPL/LCCollectionVec.h>
@@ -12,7 +13,6 @@
 #include <EVENT/SimTrackerHit.h>
 
 #include <IMPL/LCRelationImpl.h>
-#include <UTIL/LCRelationNavigator.h>
 
 // ----- include for verbosity dependend logging ---------
 #include "marlin/VerbosityLevels.h"
@@ -34,6 +34,24 @@ using namespace marlin ;
 using namespace MarlinTrk ;
 
 
+#ifdef MARLINTRK_DIAGNOSTICS_ON
+
+namespace {
+  
+  typedef std::vector< std::pair<const TrackerHit*, SimTrackerHit*> > HitSimHitIndex ;
+  
+  /// hit -> simhit links of the event being processed, sorted by hit, used in lazy mode
+  HitSimHitIndex lazySimHitIndex ;
+  
+  struct HitSimHitLess{
+    bool operator()( const std::pair<const TrackerHit*, SimTrackerHit*>& a, const std::pair<const TrackerHit*, SimTrackerHit*>& b ) const { return a.first < b.first ; }
+  };
+  
+}
+
+#endif
+
+
 
 SetTrackerHitExtensions aSetTrackerHitExtensions ;
 
@@ -79,6 +97,12 @@ SetTrackerHitExtensions::SetTrackerHitExtensions() : Processor("SetTrackerHitExt
                            trackerHitsInputColNamesDefault);
   
   
+  registerProcessorParameter( "LazyMCTruth4HitExt",
+                             "Only store a hit -> simhit index per event and create the MCTruth4HitExt of a hit on first access through SetTrackerHitExtensions::getMCTruth4HitExt, otherwise attach the extension to every hit",
+                             _lazyAttachment,
+                             bool(false));
+  
+  
   _n_run = 0 ;
   _n_evt = 0 ;
   
@@ -114,7 +138,12 @@ void SetTrackerHitExtensions::processEvent( LCEvent * evt ) {
   
   
   _colTrackerHits.clear();
-  _navTrackerHitRel.clear();
+  _truthTrackerHitRel.clear();
+  
+#ifdef MARLINTRK_DIAGNOSTICS_ON
+  // the hits of the previous event are gone
+  lazySimHitIndex.clear();
+#endif
   
   /**********************************************************************************************/
   /*                Prepare the collections                                                     */
@@ -134,7 +163,7 @@ void SetTrackerHitExtensions::processEvent( LCEvent * evt ) {
     LCCollection* trackerHitCol = _colTrackerHits[iCol];
     int nHits = trackerHitCol->getNumberOfElements();
     
-    LCRelationNavigator* nav = _navTrackerHitRel[iCol];
+    const TruthRelationIndex::EntryVec& truthRows = *_truthTrackerHitRel[iCol];
     
     for( int j=0; j<nHits; j++ ){
       
@@ -153,20 +182,20 @@ void SetTrackerHitExtensions::processEvent( LCEvent * evt ) {
         
       }
       
-      const LCObjectVec& to = nav->getRelatedToObjects( trkhit );
+      const TruthRelationIndex::Entry& truth = truthRows[j];
       
       if( BitSet32( trkhit->getType() )[ UTIL::ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT ]   ){ //it is a composite spacepoint
         
-        if( to.size() == 2 ){
+        if( truth.nSimHits == 2 ){
                                         
 #ifdef MARLINTRK_DIAGNOSTICS_ON
 
-          SimTrackerHit* simhitA = dynamic_cast<SimTrackerHit*>(to.at(0));
-          SimTrackerHit* simhitB = dynamic_cast<SimTrackerHit*>(to.at(1));
+          SimTrackerHit* simhitA = truth.simhits[0];
+          SimTrackerHit* simhitB = truth.simhits[1];
           
           // set the pointer to the simhit via lcio extention MCTruth4HitExt
           
-          const LCObjectVec rawObjects = trkhit->getRawHits();
+          const LCObjectVec& rawObjects = trkhit->getRawHits();
           
           for( unsigned k=0; k< rawObjects.size(); k++ ){
             
@@ -175,13 +204,11 @@ void SetTrackerHitExtensions::processEvent( LCEvent * evt ) {
               
               if( rawHit->getCellID0() == simhitA->getCellID0() ) {
                 streamlog_out( DEBUG4 ) << "link simhit = " << simhitA << " Cell ID = " << simhitA->getCellID0() << " with trkhit = " << rawHit << " Cell ID = " <<  rawHit->getCellID0() << std::endl;     
-                rawHit->ext<MarlinTrk::MCTruth4HitExt>() = new MarlinTrk::MCTruth4HitExtStruct;    
-                rawHit->ext<MarlinTrk::MCTruth4HitExt>()->simhit = simhitA;                 
+                linkSimHit( rawHit, simhitA );
               }
               if( rawHit->getCellID0() == simhitB->getCellID0() ) {
                 streamlog_out( DEBUG4 ) << "link simhit = " << simhitB << " Cell ID = " << simhitB->getCellID0() << " with trkhit = " << rawHit << " Cell ID = " <<  rawHit->getCellID0() << std::endl;     
-                rawHit->ext<MarlinTrk::MCTruth4HitExt>() = new MarlinTrk::MCTruth4HitExtStruct;    
-                rawHit->ext<MarlinTrk::MCTruth4HitExt>()->simhit = simhitB;                 
+                linkSimHit( rawHit, simhitB );
               }
               
             } 
@@ -191,25 +218,24 @@ void SetTrackerHitExtensions::processEvent( LCEvent * evt ) {
           
           
         }        
-        else{ streamlog_out( DEBUG1 ) << "spacepoint discarded, because it is related to " << to.size() << "SimTrackerHits. It should be 2!\n"; } 
+        else{ streamlog_out( DEBUG1 ) << "spacepoint discarded, because it is related to " << truth.nSimHits << "SimTrackerHits. It should be 2!\n"; } 
         
       }
       else{  // no composite spacepoint
         
-        if( to.size() == 1){ // only take trackerHits, that have only one related SimHit          
+        if( truth.nSimHits == 1){ // only take trackerHits, that have only one related SimHit          
           
 #ifdef MARLINTRK_DIAGNOSTICS_ON
 
-          SimTrackerHit* simhit = dynamic_cast<SimTrackerHit*>(to.at(0));
+          SimTrackerHit* simhit = truth.simhits[0];
           
-          trkhit->ext<MarlinTrk::MCTruth4HitExt>() = new MarlinTrk::MCTruth4HitExtStruct;    
-          trkhit->ext<MarlinTrk::MCTruth4HitExt>()->simhit = simhit;  
+          linkSimHit( trkhit, simhit );
           
           streamlog_out( DEBUG4 ) << "link simhit = " << simhit << " Cell ID = " << simhit->getCellID0() << " with trkhit = " << trkhit << " Cell ID = " <<  trkhit->getCellID0() << std::endl; 
 
 #endif       
         }
-        else{ streamlog_out( DEBUG1 ) << "TrackerHit discarded, because it is related to " << to.size() << "SimTrackerHits. It should be 1!\n"; }
+        else{ streamlog_out( DEBUG1 ) << "TrackerHit discarded, because it is related to " << truth.nSimHits << "SimTrackerHits. It should be 1!\n"; }
         
       }
       
@@ -217,6 +243,13 @@ void SetTrackerHitExtensions::processEvent( LCEvent * evt ) {
     }
     
   }
+  
+#ifdef MARLINTRK_DIAGNOSTICS_ON
+  if( _lazyAttachment ) {
+    std::sort( lazySimHitIndex.begin(), lazySimHitIndex.end(), HitSimHitLess() );
+    streamlog_out( DEBUG3 ) << "stored " << lazySimHitIndex.size() << " hit -> simhit links for lazy MCTruth4HitExt attachment" << std::endl;
+  }
+#endif
     
   ++_n_evt ;
   
@@ -224,6 +257,63 @@ void SetTrackerHitExtensions::processEvent( LCEvent * evt ) {
 
 
 
+#ifdef MARLINTRK_DIAGNOSTICS_ON
+
+void SetTrackerHitExtensions::linkSimHit( TrackerHit* hit, SimTrackerHit* simhit ) {
+  
+  if( _lazyAttachment ) {
+    lazySimHitIndex.push_back( std::make_pair( hit, simhit ) );
+    return;
+  }
+  
+  hit->ext<MarlinTrk::MCTruth4HitExt>() = new MarlinTrk::MCTruth4HitExtStruct;    
+  hit->ext<MarlinTrk::MCTruth4HitExt>()->simhit = simhit;  
+  
+}
+
+
+MarlinTrk::MCTruth4HitExtStruct* SetTrackerHitExtensions::getMCTruth4HitExt( EVENT::TrackerHit* hit ) {
+  
+  MarlinTrk::MCTruth4HitExtStruct* ext = hit->ext<MarlinTrk::MCTruth4HitExt>();
+  
+  if( ext != 0 || lazySimHitIndex.empty() ) return ext;
+  
+  HitSimHitIndex::const_iterator it = std::lower_bound( lazySimHitIndex.begin(), lazySimHitIndex.end(), std::make_pair( static_cast<const TrackerHit*>(hit), static_cast<SimTrackerHit*>(0) ), HitSimHitLess() );
+  
+  if( it == lazySimHitIndex.end() || it->first != hit ) return 0;
+  
+  ext = new MarlinTrk::MCTruth4HitExtStruct;
+  ext->simhit = it->second;
+  hit->ext<MarlinTrk::MCTruth4HitExt>() = ext;
+  
+  return ext;
+  
+}
+
+
+void SetTrackerHitExtensions::resolveMCTruth4HitExts( EVENT::TrackerHit* hit ) {
+  
+  if( lazySimHitIndex.empty() ) return;
+  
+  if( BitSet32( hit->getType() )[ UTIL::ILDTrkHitTypeBit::COMPOSITE_SPACEPOINT ] ){
+    
+    const LCObjectVec& rawObjects = hit->getRawHits();
+    
+    for( unsigned k=0; k< rawObjects.size(); k++ ){
+      TrackerHit* rawHit = dynamic_cast< TrackerHit* >( rawObjects[k] );
+      if( rawHit ) getMCTruth4HitExt( rawHit );
+    }
+    
+  }
+  else {
+    getMCTruth4HitExt( hit );
+  }
+  
+}
+
+#endif
+
+
 void SetTrackerHitExtensions::check( LCEvent * evt ) { 
   // nothing to check here - could be used to fill checkplots in reconstruction processor
 }
@@ -254,6 +344,10 @@ void SetTrackerHitExtensions::SetupInputCollections( LCEvent * evt ) {
     exit(1);
   }
   
+  const TruthRelationIndex* index = TruthRelationIndex::get( evt );
+  
+  _truthIndex.clear();
+  
   for( unsigned i=0; i< _colNamesTrackerHits.size(); i++ ){
     
     
@@ -261,13 +355,23 @@ void SetTrackerHitExtensions::SetupInputCollections( LCEvent * evt ) {
     LCCollection* colTrkHits = GetCollection( evt, _colNamesTrackerHits[i] );
     if( colTrkHits == NULL ) continue;
     
-    // the relations of them
-    LCRelationNavigator* nav = GetRelations( evt, _colNamesTrackerHitRelations[i] );
-    if( nav == NULL ) continue;
+    // the relations of them, use the shared index if it has been built for this event
+    const TruthRelationIndex::EntryVec* rows = index ? index->getCollection( _colNamesTrackerHits[i], _colNamesTrackerHitRelations[i] ) : NULL;
     
+    if( rows == NULL ) {
+      
+      LCCollection* colRel = GetCollection( evt, _colNamesTrackerHitRelations[i] );
+      if( colRel == NULL ) {
+        streamlog_out( ERROR ) << " --> " << _colNamesTrackerHitRelations[i] << " track relation collection absent" << std::endl;     
+        continue;
+      }
+      
+      rows = &_truthIndex.addCollection( _colNamesTrackerHits[i], _colNamesTrackerHitRelations[i], colTrkHits, colRel );
+      
+    }
     
     _colTrackerHits.push_back( colTrkHits );
-    _navTrackerHitRel.push_back( nav );
+    _truthTrackerHitRel.push_back( rows );
     
     
   }
@@ -295,24 +399,6 @@ LCCollection* SetTrackerHitExtensions::GetCollection(  LCEvent * evt, std::strin
   
 }
 
-LCRelationNavigator* SetTrackerHitExtensions::GetRelations(LCEvent * evt , std::string RelName ) {
-  
-  LCRelationNavigator* nav = NULL ;
-  LCCollection* col = NULL;
-  
-  try{
-    
-    col = evt->getCollection( RelName.c_str() );
-    nav = new LCRelationNavigator( col );
-    streamlog_out( DEBUG4 ) << " --> " << RelName << " track relation collection found, number of elements = " << col->getNumberOfElements() << std::endl;
-  }
-  catch(DataNotAvailableException &e){
-    streamlog_out( ERROR ) << " --> " << RelName.c_str() << " track relation collection absent" << std::endl;     
-  }
-  
-  return nav;
-  
-}
 
 
 
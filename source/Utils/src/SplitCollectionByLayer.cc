@@ -22,6 +22,7 @@ SplitCollectionByLayer aSplitCollectionByLayer ;
 
 
 SplitCollectionByLayer::SplitCollectionByLayer() : Processor("SplitCollectionByLayer") ,
+			   _layerMask(0), _layerOffset(0), _layerWidth(0), _layerSigned(false),
 			   _nRun(0), _nEvt(0) {
   
   // modify processor description
@@ -53,6 +54,22 @@ SplitCollectionByLayer::SplitCollectionByLayer() : Processor("SplitCollectionByL
 }
 
 
+namespace {
+
+  // upper limit of the layer numbers of the output collections, above any layer field of the encodings in use
+  const long maxLayerNumber = 1023 ;
+
+  // layer number of the steering parameter, -1 if it is not a number in [0,maxLayerNumber]
+  long layerFromParameter( const std::string& value ){
+    char* end = 0 ;
+    long layer = std::strtol( value.c_str(), &end, 10 ) ;
+    if( end == value.c_str() || *end != 0 || layer < 0 || layer > maxLayerNumber ) return -1 ;
+    return layer ;
+  }
+
+}
+
+
 template <class T>
 long cellIDFromHit( const LCObject* o){
   long id = -1 ;
@@ -71,19 +88,51 @@ void SplitCollectionByLayer::init() {
   printParameters() ;
   
   
+  if( _outColAndLayers.size() % 3 != 0 ){
+    throw EVENT::Exception( "SplitCollectionByLayer: OutputCollections must be given as triplets of name, start layer and end layer" ) ;
+  }
+
   _outCols.resize( _outColAndLayers.size() / 3 ) ;
   
   unsigned i=0,index=0 ;
   while( i < _outColAndLayers.size() ){
 
     _outCols[index].name    = _outColAndLayers[ i++ ] ;
-    _outCols[index].layer0  = std::atoi( _outColAndLayers[ i++ ].c_str() ) ;
-    _outCols[index].layer1  = std::atoi( _outColAndLayers[ i++ ].c_str() ) ;
+
+    long layer0 = layerFromParameter( _outColAndLayers[ i++ ] ) ;
+    long layer1 = layerFromParameter( _outColAndLayers[ i++ ] ) ;
+
+    if( layer0 < 0 || layer1 < 0 ){
+      streamlog_out( ERROR ) << " OutputCollections: the layers " << _outColAndLayers[ i-2 ] << " " << _outColAndLayers[ i-1 ] << " of " << _outCols[index].name
+			     << " must be numbers from 0 to " << maxLayerNumber << std::endl ;
+      throw EVENT::Exception( "SplitCollectionByLayer: invalid layer numbers in OutputCollections" ) ;
+    }
+
+    _outCols[index].layer0  = layer0 ;
+    _outCols[index].layer1  = layer1 ;
     _outCols[index].collection = 0 ;
+    _outCols[index].nHits = 0 ;
 
     ++index ;
   }
 
+  // direct lookup of the output collections for every layer, ranges may overlap
+  unsigned maxLayer = 0 ;
+  for(unsigned i=0, N= _outCols.size() ; i<N ; ++i){
+    if( _outCols[i].layer1 > maxLayer ) maxLayer = _outCols[i].layer1 ;
+  }
+
+  _layerToOutCols.clear() ;
+  if( ! _outCols.empty() ) _layerToOutCols.resize( maxLayer + 1 ) ;
+
+  for(unsigned i=0, N= _outCols.size() ; i<N ; ++i){
+    for(unsigned l= _outCols[i].layer0 ; l <= _outCols[i].layer1 ; ++l){
+      _layerToOutCols[l].push_back( i ) ;
+    }
+  }
+
+  _encoderString.clear() ;
+
   _nRun = 0 ;
   _nEvt = 0 ;
   
@@ -126,33 +175,17 @@ void SplitCollectionByLayer::processEvent( LCEvent * evt ) {
   
   std::string encoderString = col->getParameters().getStringVal( "CellIDEncoding" ) ;
 
-  UTIL::BitField64 encoder( encoderString ) ;
-
-  unsigned layerIndex = encoder.index("layer") ;
+  if( encoderString != _encoderString ) setupLayerField( encoderString ) ;
 
 
-  //---- create output collections
-  for(unsigned i=0, N= _outCols.size() ; i<N ; ++i){
-    
-    LCCollectionVec* newCol = new LCCollectionVec(  col->getTypeName() ) ; 
+  //---- decode the layer of every hit and count the hits per output collection
 
-    newCol->setSubset( true ) ;
-
-    newCol->parameters().setValue( "CellIDEncoding", encoderString ) ;
-
-    //    evt->addCollection(  newCol , _outCols[i].name ) ;
-
-    _outCols[i].collection =  newCol ;
-
-    streamlog_out( DEBUG5 ) << " create new output collection " << _outCols[i].name << " of type " <<  col->getTypeName() << std::endl ;
-     streamlog_out( DEBUG5 ) << " create new output collection " << _outCols[i].name << " of type " <<  col->getTypeName() << " to the event  " << std::endl ;
- }
+  int nHit = col->getNumberOfElements()  ;
 
+  _hitLayers.resize( nHit ) ;
 
-  //---- loop over hits
+  for(unsigned i=0, N= _outCols.size() ; i<N ; ++i) _outCols[i].nHits = 0 ;
 
-  int nHit = col->getNumberOfElements()  ;
-  
   for(int i=0; i< nHit ; i++){
       
     lcio::LCObject* h =  col->getElementAt( i ) ;
@@ -174,24 +207,60 @@ void SplitCollectionByLayer::processEvent( LCEvent * evt ) {
       id = cellIDFromHit<CalorimeterHit>( h ) ; 
       break ;
     case UnkownType:
-      continue ;
+      break ;
     }
 
-    encoder.setValue( id ) ;
+    int layerID = ( _type == UnkownType ) ? -1 : layerFromCellID( id ) ;
 
-    int layerID = encoder[ layerIndex ] ;
+    // layers without an output collection are marked with -1
+    if( layerID < 0 || layerID >= int( _layerToOutCols.size() ) ) layerID = -1 ;
 
+    _hitLayers[i] = layerID ;
 
-    // check if we have an output collection for this layer
-    for(unsigned i=0, N= _outCols.size() ; i<N ; ++i){
-      
-      if( ( _outCols[i].layer0 <= layerID )  && ( layerID <= _outCols[i].layer1 ) ){
+    if( layerID < 0 ) continue ;
+
+    const std::vector<unsigned>& outCols = _layerToOutCols[ layerID ] ;
+    for(unsigned k=0, K= outCols.size() ; k<K ; ++k) ++_outCols[ outCols[k] ].nHits ;
+  }
+
+
+  //---- create output collections
+  for(unsigned i=0, N= _outCols.size() ; i<N ; ++i){
+    
+    LCCollectionVec* newCol = new LCCollectionVec(  col->getTypeName() ) ; 
+
+    newCol->setSubset( true ) ;
+
+    newCol->parameters().setValue( "CellIDEncoding", encoderString ) ;
+
+    newCol->reserve( _outCols[i].nHits ) ;
+
+    //    evt->addCollection(  newCol , _outCols[i].name ) ;
+
+    _outCols[i].collection =  newCol ;
+
+    streamlog_out( DEBUG5 ) << " create new output collection " << _outCols[i].name << " of type " <<  col->getTypeName() << std::endl ;
+ }
 
-	_outCols[i].collection->addElement( h ) ;
 
-	streamlog_out( DEBUG0 ) << " adding hit for layer " << layerID << " to collection : " << _outCols[i].name << std::endl ;
+  //---- loop over hits
+
+  for(int i=0; i< nHit ; i++){
+
+    int layerID = _hitLayers[i] ;
+
+    if( layerID < 0 ) continue ;
+
+    lcio::LCObject* h =  col->getElementAt( i ) ;
+
+    const std::vector<unsigned>& outCols = _layerToOutCols[ layerID ] ;
+
+    for(unsigned k=0, K= outCols.size() ; k<K ; ++k){
+
+      _outCols[ outCols[k] ].collection->addElement( h ) ;
+
+      streamlog_out( DEBUG0 ) << " adding hit for layer " << layerID << " to collection : " << _outCols[ outCols[k] ].name << std::endl ;
 
-      }    
     }
   }
 
@@ -222,6 +291,25 @@ void SplitCollectionByLayer::processEvent( LCEvent * evt ) {
 
 
 
+void SplitCollectionByLayer::setupLayerField( const std::string& encoderString ) {
+
+  UTIL::BitField64 encoder( encoderString ) ;
+
+  const UTIL::BitFieldValue& layerField = encoder[ encoder.index("layer") ] ;
+
+  _layerMask   = layerField.mask() ;
+  _layerOffset = layerField.offset() ;
+  _layerWidth  = layerField.width() ;
+  _layerSigned = layerField.isSigned() ;
+
+  _encoderString = encoderString ;
+
+  streamlog_out( DEBUG5 ) << " layer field of encoding " << encoderString << " : offset " << _layerOffset 
+			  << " width " << _layerWidth << " signed " << _layerSigned << std::endl ;
+}
+
+
+
 void SplitCollectionByLayer::check( LCEvent * evt ) { 
   // nothing to check here - could be used to fill checkplots in reconstruction processor
 }
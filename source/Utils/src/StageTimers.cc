@@ -0,0 +1,209 @@
+
+#include "StageTimers.h"
+
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+// ----- include for verbosity dependend logging ---------
+#include "marlin/VerbosityLevels.h"
+
+
+StageTimers::StageTimers() : _enabled(false), _run(-1), _evt(-1), _csv(0) {}
+
+StageTimers::~StageTimers() {
+
+  if( _csv ) {
+    _csv->close() ;
+    delete _csv ;
+  }
+
+}
+
+
+void StageTimers::init( const std::string& owner, bool enabled, const std::string& csvFileName ) {
+
+  _owner = owner ;
+  _enabled = enabled ;
+  _csvFileName = enabled ? csvFileName : std::string("") ;
+
+  _stageNames.clear() ;
+  _counterNames.clear() ;
+  _runs.clear() ;
+
+}
+
+int StageTimers::addStage( const std::string& name ) {
+
+  _stageNames.push_back( name ) ;
+  _evtTime.resize( _stageNames.size(), 0. ) ;
+  _evtCalls.resize( _stageNames.size(), 0 ) ;
+
+  return _stageNames.size() - 1 ;
+
+}
+
+int StageTimers::addCounter( const std::string& name ) {
+
+  _counterNames.push_back( name ) ;
+  _evtCounts.resize( _counterNames.size(), 0 ) ;
+
+  return _counterNames.size() - 1 ;
+
+}
+
+
+void StageTimers::startEvent( int run, int evt ) {
+
+  if( ! _enabled ) return ;
+
+  _run = run ;
+  _evt = evt ;
+
+  std::fill( _evtTime.begin(), _evtTime.end(), 0. ) ;
+  std::fill( _evtCalls.begin(), _evtCalls.end(), 0 ) ;
+  std::fill( _evtCounts.begin(), _evtCounts.end(), 0 ) ;
+
+  _evtStart = Clock::now() ;
+
+}
+
+
+void StageTimers::endEvent() {
+
+  if( ! _enabled ) return ;
+
+  double evtTime = std::chrono::duration<double>( Clock::now() - _evtStart ).count() ;
+
+  if( _runs.empty() || _runs.back().run != _run ) {
+
+    RunSummary summary ;
+    summary.run = _run ;
+    summary.nEvents = 0 ;
+    summary.totalTime = 0. ;
+    summary.maxEventTime = 0. ;
+    summary.time.resize( _stageNames.size(), 0. ) ;
+    summary.maxTime.resize( _stageNames.size(), 0. ) ;
+    summary.calls.resize( _stageNames.size(), 0 ) ;
+    summary.counts.resize( _counterNames.size(), 0 ) ;
+
+    _runs.push_back( summary ) ;
+
+  }
+
+  RunSummary& summary = _runs.back() ;
+
+  ++summary.nEvents ;
+  summary.totalTime += evtTime ;
+  summary.maxEventTime = std::max( summary.maxEventTime, evtTime ) ;
+
+  for( unsigned i=0; i<_stageNames.size(); ++i ) {
+    summary.time[i] += _evtTime[i] ;
+    summary.maxTime[i] = std::max( summary.maxTime[i], _evtTime[i] ) ;
+    summary.calls[i] += _evtCalls[i] ;
+  }
+
+  for( unsigned i=0; i<_counterNames.size(); ++i ) {
+    summary.counts[i] += _evtCounts[i] ;
+  }
+
+  if( ! _csvFileName.empty() ) {
+
+    if( _csv == 0 ) {
+
+      _csv = new std::ofstream( _csvFileName.c_str() ) ;
+
+      *_csv << "run,event,total" ;
+      for( unsigned i=0; i<_stageNames.size(); ++i ) *_csv << "," << _stageNames[i] ;
+      for( unsigned i=0; i<_counterNames.size(); ++i ) *_csv << "," << _counterNames[i] ;
+      *_csv << "\n" ;
+
+    }
+
+    *_csv << _run << "," << _evt << "," << evtTime ;
+    for( unsigned i=0; i<_stageNames.size(); ++i ) *_csv << "," << _evtTime[i] ;
+    for( unsigned i=0; i<_counterNames.size(); ++i ) *_csv << "," << _evtCounts[i] ;
+    *_csv << "\n" ;
+
+  }
+
+}
+
+
+void StageTimers::printSummary() {
+
+  if( _csv ) {
+    _csv->close() ;
+    delete _csv ;
+    _csv = 0 ;
+    _csvFileName.clear() ;
+  }
+
+  if( ! _enabled || _runs.empty() ) return ;
+
+  for( unsigned i=0; i<_runs.size(); ++i ) printRun( _runs[i] ) ;
+
+  if( _runs.size() < 2 ) return ;
+
+  // sum over all runs
+  RunSummary job = _runs[0] ;
+  job.run = -1 ;
+
+  for( unsigned r=1; r<_runs.size(); ++r ) {
+
+    const RunSummary& summary = _runs[r] ;
+
+    job.nEvents += summary.nEvents ;
+    job.totalTime += summary.totalTime ;
+    job.maxEventTime = std::max( job.maxEventTime, summary.maxEventTime ) ;
+
+    for( unsigned i=0; i<job.time.size(); ++i ) {
+      job.time[i] += summary.time[i] ;
+      job.maxTime[i] = std::max( job.maxTime[i], summary.maxTime[i] ) ;
+      job.calls[i] += summary.calls[i] ;
+    }
+
+    for( unsigned i=0; i<job.counts.size(); ++i ) job.counts[i] += summary.counts[i] ;
+
+  }
+
+  printRun( job ) ;
+
+}
+
+
+void StageTimers::printRun( const RunSummary& summary ) const {
+
+  // format into a local stream so that the precision settings do not stick to the log stream
+  std::ostringstream out ;
+
+  out << std::fixed << std::setprecision(3) ;
+
+  out << _owner << " stage timing for " ;
+  if( summary.run < 0 ) out << "all runs" ;
+  else out << "run " << summary.run ;
+  out << " : " << summary.nEvents << " events, "
+      << 1000.*summary.totalTime/summary.nEvents << " ms/event, max " << 1000.*summary.maxEventTime << " ms\n" ;
+
+  for( unsigned i=0; i<_stageNames.size(); ++i ) {
+
+    out << "  " << std::setw(28) << std::left << _stageNames[i] << std::right
+        << std::setw(12) << 1000.*summary.time[i]/summary.nEvents << " ms/event"
+        << std::setw(8) << std::setprecision(1) << ( summary.totalTime > 0. ? 100.*summary.time[i]/summary.totalTime : 0. ) << " %"
+        << std::setprecision(3)
+        << "   max " << std::setw(10) << 1000.*summary.maxTime[i] << " ms"
+        << "   calls " << summary.calls[i] << "\n" ;
+
+  }
+
+  for( unsigned i=0; i<_counterNames.size(); ++i ) {
+
+    out << "  " << std::setw(28) << std::left << _counterNames[i] << std::right
+        << std::setw(12) << double( summary.counts[i] )/summary.nEvents << " /event"
+        << "   total " << summary.counts[i] << "\n" ;
+
+  }
+
+  streamlog_out( MESSAGE ) << out.str() << std::flush ;
+
+}
@@ -0,0 +1,122 @@
+
+#include "TaskPool.h"
+
+
+TaskPool::TaskPool() : _task(0), _nTasks(0), _next(0), _nBusy(0), _batch(0), _stop(false) {}
+
+TaskPool::~TaskPool() {
+
+  stop() ;
+
+}
+
+
+void TaskPool::init( int nThreads ) {
+
+  stop() ;
+
+  if( nThreads <= 0 ) nThreads = std::thread::hardware_concurrency() ;
+
+  _stop = false ;
+
+  for( int i=1; i<nThreads; ++i ) _workers.push_back( std::thread( &TaskPool::work, this, _batch ) ) ;
+
+}
+
+
+void TaskPool::stop() {
+
+  {
+    std::lock_guard<std::mutex> lock( _mutex ) ;
+    _stop = true ;
+  }
+
+  _start.notify_all() ;
+
+  for( unsigned i=0; i<_workers.size(); ++i ) _workers[i].join() ;
+
+  _workers.clear() ;
+
+}
+
+
+void TaskPool::run( int nTasks, const std::function<void(int)>& task ) {
+
+  if( nTasks <= 0 ) return ;
+
+  if( _workers.empty() || nTasks == 1 ) {
+    for( int i=0; i<nTasks; ++i ) task( i ) ;
+    return ;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock( _mutex ) ;
+    _task = &task ;
+    _nTasks = nTasks ;
+    _next = 0 ;
+    _nBusy = _workers.size() ;
+    _error = std::exception_ptr() ;
+    ++_batch ;
+  }
+
+  _start.notify_all() ;
+
+  execute() ;
+
+  std::exception_ptr error ;
+
+  {
+    std::unique_lock<std::mutex> lock( _mutex ) ;
+    _done.wait( lock, [this]{ return _nBusy == 0 ; } ) ;
+    _task = 0 ;
+    error = _error ;
+    _error = std::exception_ptr() ;
+  }
+
+  if( error ) std::rethrow_exception( error ) ;
+
+}
+
+
+void TaskPool::work( unsigned long batch ) {
+
+  for(;;) {
+
+    {
+      std::unique_lock<std::mutex> lock( _mutex ) ;
+      _start.wait( lock, [&]{ return _stop || _batch != batch ; } ) ;
+      if( _stop ) return ;
+      batch = _batch ;
+    }
+
+    execute() ;
+
+    {
+      std::lock_guard<std::mutex> lock( _mutex ) ;
+      if( --_nBusy == 0 ) _done.notify_one() ;
+    }
+
+  }
+
+}
+
+
+void TaskPool::execute() {
+
+  for(;;) {
+
+    const int i = _next++ ;
+
+    if( i >= _nTasks ) return ;
+
+    try {
+      (*_task)( i ) ;
+    }
+    catch(...) {
+      std::lock_guard<std::mutex> lock( _mutex ) ;
+      if( !_error ) _error = std::current_exception() ;
+    }
+
+  }
+
+}
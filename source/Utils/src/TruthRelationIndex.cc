@@ -0,0 +1,144 @@
+
+#include "TruthRelationIndex.h"
+
+#include <algorithm>
+
+#include <EVENT/LCEvent.h>
+#include <EVENT/LCCollection.h>
+#include <EVENT/LCRelation.h>
+#include <EVENT/TrackerHit.h>
+#include <EVENT/SimTrackerHit.h>
+#include <EVENT/MCParticle.h>
+
+// ----- include for verbosity dependend logging ---------
+#include "marlin/VerbosityLevels.h"
+
+using namespace lcio ;
+
+
+namespace {
+
+  struct PositionLess{
+    bool operator()( const std::pair<const void*, int>& a, const std::pair<const void*, int>& b ) const { return a.first < b.first ; }
+  };
+
+}
+
+
+void TruthRelationIndex::clear(){
+
+  _names.clear() ;
+  _relNames.clear() ;
+  _nUsed = 0 ;
+
+  _evt = 0 ;
+  _runNumber = -1 ;
+  _evtNumber = -1 ;
+
+}
+
+void TruthRelationIndex::setEvent( const EVENT::LCEvent* evt ){
+
+  _evt = evt ;
+  _runNumber = evt->getRunNumber() ;
+  _evtNumber = evt->getEventNumber() ;
+
+}
+
+bool TruthRelationIndex::isForEvent( const EVENT::LCEvent* evt ) const {
+
+  // the pointer alone is not enough as the reader may reuse the memory of the previous event
+  return evt != 0 && evt == _evt && evt->getRunNumber() == _runNumber && evt->getEventNumber() == _evtNumber ;
+
+}
+
+
+const TruthRelationIndex::EntryVec& TruthRelationIndex::addCollection( const std::string& name, const std::string& relName, EVENT::LCCollection* colTrkHits, EVENT::LCCollection* colRel ){
+
+  if( _nUsed == _rows.size() ) _rows.push_back( EntryVec() ) ;
+
+  EntryVec& rows = _rows[_nUsed] ;
+  ++_nUsed ;
+  _names.push_back( name ) ;
+  _relNames.push_back( relName ) ;
+
+  int nHits = colTrkHits->getNumberOfElements() ;
+
+  rows.resize( nHits ) ;
+  _positions.resize( nHits ) ;
+
+  for( int j=0; j<nHits; j++ ){
+
+    Entry& e = rows[j] ;
+    e.trkhit      = dynamic_cast<TrackerHit*>( colTrkHits->getElementAt( j ) ) ;
+    e.simhits[0]  = 0 ;
+    e.simhits[1]  = 0 ;
+    e.nSimHits    = 0 ;
+    e.mcp         = 0 ;
+
+    _positions[j] = std::make_pair( static_cast<const void*>( colTrkHits->getElementAt( j ) ), j ) ;
+
+  }
+
+  std::sort( _positions.begin(), _positions.end(), PositionLess() ) ;
+
+  // one pass over the relations, each one is attached to the row of its TrackerHit
+  int nRel = colRel->getNumberOfElements() ;
+
+  for( int i=0; i<nRel; i++ ){
+
+    LCRelation* rel = dynamic_cast<LCRelation*>( colRel->getElementAt( i ) ) ;
+    if( rel == 0 ) continue ;
+
+    std::pair<const void*, int> key( static_cast<const void*>( rel->getFrom() ), 0 ) ;
+
+    std::vector< std::pair<const void*, int> >::const_iterator it = std::lower_bound( _positions.begin(), _positions.end(), key, PositionLess() ) ;
+
+    if( it == _positions.end() || it->first != key.first ) {
+      streamlog_out( DEBUG1 ) << "TruthRelationIndex: relation " << i << " in the relations for " << name << " points to a hit which is not in the collection" << std::endl ;
+      continue ;
+    }
+
+    Entry& e = rows[ it->second ] ;
+
+    if( e.nSimHits < 2 ) e.simhits[ e.nSimHits ] = dynamic_cast<SimTrackerHit*>( rel->getTo() ) ;
+    ++e.nSimHits ;
+
+  }
+
+  for( int j=0; j<nHits; j++ ){
+    if( rows[j].simhits[0] ) rows[j].mcp = rows[j].simhits[0]->getMCParticle() ;
+  }
+
+  streamlog_out( DEBUG2 ) << "TruthRelationIndex: indexed " << nHits << " hits of " << name << " with " << nRel << " relations" << std::endl ;
+
+  return rows ;
+
+}
+
+
+const TruthRelationIndex::EntryVec* TruthRelationIndex::getCollection( const std::string& name, const std::string& relName ) const {
+
+  for( unsigned i=0; i<_nUsed; ++i ){
+    if( _names[i] == name && _relNames[i] == relName ) return &_rows[i] ;
+  }
+
+  return 0 ;
+
+}
+
+
+TruthRelationIndex& TruthRelationIndex::published(){
+
+  static TruthRelationIndex index ;
+  return index ;
+
+}
+
+const TruthRelationIndex* TruthRelationIndex::get( const EVENT::LCEvent* evt ){
+
+  const TruthRelationIndex& index = published() ;
+
+  return index.isForEvent( evt ) ? &index : 0 ;
+
+}
@@ -38,8 +38,8 @@ namespace ftf
 		short        phiIndex ;        // Phi index    
 		short        etaIndex ;        // Eta index      
 		//
-		Hit*         nextVolumeHit ;  // Next volume hit            
-		Hit*         nextRowHit    ;  // Next row hit               
+		unsigned char* used ;          // flag in the HitVolumes arrays, 0 if in no volume
+		int          source ;          // for a copy in a SpeculativeBuild the index of the copied hit in its sources
 		double       r    ;            // radius                     
 		double       phi  ;            // azimuthal angle            
 		double       dphi ;            // Error in phi               
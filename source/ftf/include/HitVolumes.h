@@ -0,0 +1,85 @@
+#ifndef HITVOLUMES_H
+#define HITVOLUMES_H
+//
+// Contiguous layout of the hits in the (row,phi,eta) volumes of the FTF.
+//
+
+#include <vector>
+
+#include "Hit.h"
+#include "TrackFindingParameters.h"
+
+namespace ftf
+{
+	//
+	//    Copy of the fields of the hits read by the hit selection of Track, in the
+	//    precision the selection is run with. xp, yp and wxy are the conformal
+	//    coordinates for primaries, set by setConformal.
+	//
+	template <typename Real>
+	class HotHits
+	{
+	public:
+		void resize ( int n ) {
+			x.resize ( n ) ; y.resize ( n ) ; z.resize ( n ) ;
+			phi.resize ( n ) ; eta.resize ( n ) ; dz.resize ( n ) ; wz.resize ( n ) ;
+			xp.resize ( n ) ; yp.resize ( n ) ; wxy.resize ( n ) ;
+			row.resize ( n ) ;
+		} ;
+		void set ( int slot, const Hit* hit ) {
+			x[slot]   = hit->x ;
+			y[slot]   = hit->y ;
+			z[slot]   = hit->z ;
+			phi[slot] = hit->phi ;
+			eta[slot] = hit->eta ;
+			dz[slot]  = hit->dz ;
+			wz[slot]  = hit->wz ;
+			row[slot] = hit->row ;
+		} ;
+		void setConformal ( int slot, const Hit* hit ) {
+			xp[slot]  = hit->xp ;
+			yp[slot]  = hit->yp ;
+			wxy[slot] = hit->wxy ;
+		} ;
+
+		std::vector<Real>  x, y, z ;
+		std::vector<Real>  phi, eta ;
+		std::vector<Real>  dz, wz ;
+		std::vector<Real>  xp, yp, wxy ;
+		std::vector<short> row ;
+	} ;
+	//
+	//    The hits are sorted once per event by volume with a counting sort. The hits of
+	//    a volume are the range [begin(volume),end(volume)) of the arrays, in the order
+	//    of the input hits, and the used flag and the fields of the hits read by the
+	//    hit selection are kept in separate arrays, so that the search for the next hit
+	//    of a track scans memory linearly. These fields are copied in double or, with
+	//    floatHits, in float precision. The hits themselves keep the errors, charge and
+	//    fit results. The hits of a row are kept the same way in the order of the input hits.
+	//
+	class HitVolumes
+	{
+	public:
+		HitVolumes ( ) : floatHits(0) { } ;
+		void   allocate ( int nVolumes, int nRows ) ;
+		void   fill     ( Hit* hits, int nHits, const std::vector<int>& hitVolume, const std::vector<int>& hitRow,
+			              int floatHits ) ;
+		void   updateConformal ( ) ;
+
+		inline int begin    ( int volume ) const { return volumeStart[volume] ; } ;
+		inline int end      ( int volume ) const { return volumeStart[volume+1] ; } ;
+		inline int rowBegin ( int row )    const { return rowStart[row] ; } ;
+		inline int rowEnd   ( int row )    const { return rowStart[row+1] ; } ;
+
+		std::vector<Hit*>          hit  ;     // hits sorted by volume 
+		std::vector<unsigned char> used ;     // set while the hit belongs to a track
+		HotHits<double>            hotDouble ;
+		HotHits<float>             hotFloat ;
+		int                        floatHits ; // hotFloat is filled instead of hotDouble
+		std::vector<int>           volumeStart ;
+
+		std::vector<Hit*>          rowHit ;   // hits sorted by row
+		std::vector<int>           rowStart ;
+	} ;
+} // end namespace ftf
+#endif
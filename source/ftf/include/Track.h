@@ -8,8 +8,12 @@
 // 380(1996) pp. 582-585.
 //
 
+#include <deque>
+#include <vector>
+
 #include "TrackUtil.h"
 #include "Hit.h"
+#include "HitVolumes.h"
 #include "ThreeDPoint.h"
 #include "TrackFindingParameters.h"
 
@@ -20,6 +24,26 @@ int const GO_UP      = 1 ;
 
 namespace ftf
 {
+	//
+	//    Hits of a track built speculatively by a worker thread of the pipelined finder.
+	//    The track is built on copies of the hits, so that the shared hits are not changed,
+	//    and the free hits which could have changed the result are recorded, so that the
+	//    track can be checked against the hits used in the meantime before it is taken.
+	//
+	class SpeculativeBuild
+	{
+	public:
+		void clear ( ) { hits.clear() ; sources.clear() ; examined.clear() ; } ;
+		int  uses  ( const unsigned char* flag ) {   // hit already in the track
+			for ( unsigned int i = 0 ; i < sources.size() ; i++ ) if ( sources[i]->used == flag ) return 1 ;
+			return 0 ;
+		} ;
+
+		std::deque<Hit>   hits ;      // copies of the hits added to the track
+		std::vector<Hit*> sources ;   // hit copied into hits[i]
+		std::vector<int>  examined ;  // HitVolumes slots of the free hits inside the eta/phi window
+	} ;
+
 	class Track 
 	{ 
 
@@ -55,6 +79,8 @@ namespace ftf
 		double    dz0 ;
 		double    eta ;
 		double    dtanl ;
+		double    covCircle[6] ;  // covariance of the circle centre x, y and radius of the last getErrorsCircleFit,
+		                          // lower triangle (xx, yx, yy, rx, ry, rr)
 
 		TrackFindingParameters*  para  ;    // Parameters pointer
 
@@ -79,8 +105,25 @@ namespace ftf
 		double    ddXy, a1Xy, a2Xy ;    /*fit par in xy */
 		double    ddSz, a1Sz, a2Sz ;    /*fit par in sz */
 
+		double    swCircle   ;     // Weighted sums of the hits for fitCircle,
+		double    sxCircle   ;     // x and y relative to the reference hit
+		double    syCircle   ;
+		double    sxxCircle  ;
+		double    sxyCircle  ;
+		double    syyCircle  ;
+		double    sxrrCircle ;     // x*r**2
+		double    syrrCircle ;     // y*r**2
+		double    srrrrCircle;     // r**4
+
 		Track*    nxatrk  ;
 
+		double    sNextHit ;       // s and conformal coordinates of the hit selected
+		double    xpNextHit ;      // by followHitSelection
+		double    ypNextHit ;
+		double    wxyNextHit ;
+
+		SpeculativeBuild* speculative ; // set while the track is built speculatively
+
 		//methods
 
 		Track ( ) ;
@@ -88,6 +131,8 @@ namespace ftf
 
 		int         fitHelix        (  ) ;
 		int         fitCircle       (  ) ;
+		void        addCircleSums   ( Hit* thisHit ) ;
+		void        resetCircleSums ( ) ;
 		int         fitLine         (  ) ;
 		TrackFindingParameters* getPara()  { return para ; } ;
 		int         getErrorsCircleFit ( double a, double b, double r ) ;
@@ -111,20 +156,31 @@ namespace ftf
 
 		void      add                   ( Hit* thisHit, int way ) ;
 		void      add                   ( Track* thisTrack ) ;
-		int       buildTrack            ( Hit* firstHit, Container* volume ) ;
+		int       buildTrack            ( Hit* firstHit, HitVolumes* volumes ) ;
+		Hit*      useHit                ( Hit* thisHit ) ;
+		int       speculativeHitsFree   ( HitVolumes* volumes ) ;
+		void      takeSpeculativeHits   ( ) ;
 		void      dEdx                  ( ) ;
 		void      deleteCandidate       ( ) ;
 		void      fill                  ( ) ;
 		void      fillPrimary           ( double& xc, double& yc, double& rc,double xPar, double yPar ) ;
 		void      fillSecondary         ( double& xc, double& yc, double xPar, double yPar ) ;
-		int       follow                ( Container* volume, int way, int rowToStop ) ;
-		int       followHitSelection    ( Hit* baseHit, Hit* candidateHit ) ;
+		int       follow                ( HitVolumes* volumes, int way, int rowToStop ) ;
+		template <typename Real>
+		int       followHitSelection    ( Hit* baseHit, const HotHits<Real>& hot, int slot, Hit* candidateHit ) ;
+		template <typename Real>
+		int       followWindow          ( Real basePhi, Real baseEta, Real candidatePhi, Real candidateEta ) ;
 		Track*    getNextTrack          ( )      { return nxatrk ; } ; 
 		int       mergePrimary          ( TrackContainer* trackArea ) ;
 		void      reset                 ( ) ;
-		Hit*      seekNextHit           ( Container* volume, Hit* baseHit, int nradiusSteps, int whichFunction ) ;
-		int       segment               ( Container* volume, int way ) ;
-		int       segmentHitSelection   ( Hit* baseHit, Hit* candidateHit ) ;
+		Hit*      seekNextHit           ( HitVolumes* volumes, Hit* baseHit, int nradiusSteps, int whichFunction ) ;
+		template <typename Real>
+		Hit*      seekNextHit           ( HitVolumes* volumes, const HotHits<Real>& hot, Hit* baseHit, int nradiusSteps, int whichFunction ) ;
+		int       segment               ( HitVolumes* volumes, int way ) ;
+		template <typename Real>
+		int       segmentHitSelection   ( Hit* baseHit, const HotHits<Real>& hot, int slot ) ;
+		template <typename Real>
+		Real      segmentDphi           ( Real basePhi, Real candidatePhi ) ;
 
     //#define TRDEBUG 1
 #ifdef TRDEBUG
@@ -9,14 +9,26 @@
 //
 
 #include <string.h>
+#include <vector>
 
 #include "TrackUtil.h"
 #include "TrackFindingParameters.h"
 #include "Hit.h"
+#include "HitVolumes.h"
 #include "Track.h"
+#include "TaskPool.h"
 
 namespace ftf
 {
+	//
+	//    Steps taken by the finder when an event runs out of its time budget para.maxTime
+	//
+	int const DEGRADE_NONE           = 0 ;
+	int const DEGRADE_MIN_HITS       = 1 ; // minHitsPerTrack raised
+	int const DEGRADE_SEARCH_RANGE   = 2 ; // row search ranges and eta/phi windows narrowed
+	int const DEGRADE_NO_SECONDARIES = 3 ; // secondary passes skipped
+	int const DEGRADE_STOP           = 4 ; // track finding stopped
+
 	class TrackFinder {
 
 	public:
@@ -28,9 +40,13 @@ namespace ftf
 		void    mergePrimaryTracks      ( );
 		double  process                 ( );
 		int     reset                   ( );
+		int     setParameters           ( const TrackFindingParameters& newPara );
+		void    updateParameters        ( );
 		int     setConformalCoordinates ( );
 		int     setPointers             ( );
 		double  CpuTime                 ( );
+		double  WallTime                ( );
+		int     checkTimeBudget         ( );
 
 		int                    nHits;  
 		int                    nHitsOutOfRange;
@@ -40,14 +56,32 @@ namespace ftf
 		Track*                 track;  
 		TrackFindingParameters para;
 		int                    maxTracks;
-		Container*             volumeC;
-		Container*             rowC;
+		HitVolumes             volumes;
 		TrackContainer*        trackC;
 		double                 initialCpuTime;
 		double                 cpuTime;
+		double                 initialWallTime;
+		double                 wallTime;
+		int                    degradationLevel; // step reached in the last event, DEGRADE_NONE if in time
+		TaskPool               taskPool;         // threads of the pipelined track building, para.nThreads
 
 	private: 
+		void       degrade ( int level ) ;
+		void       restoreDegradedParameters ( ) ;
+		void       initTrack  ( Track* thisTrack, int id, Hit* firstHit ) ;
+		void       finishTrack ( Track* thisTrack, int built ) ;
+		int        buildRowPipelined ( int ir ) ;
+
 		Track*     currentTrack;
+		int        savedMinHitsPerTrack ;         // parameters changed by degrade
+		int        savedSegmentRowSearchRange ;
+		int        savedTrackRowSearchRange ;
+		double     savedDeta, savedDphi ;
+		std::vector<int> hitVolume ;   // volume and row of every hit, -1 if outside
+		std::vector<int> hitRow ;
+		std::vector<Track>            speculativeTracks ;  // tracks of the seeds of one row built in parallel
+		std::vector<SpeculativeBuild> speculativeBuilds ;
+		std::vector<int>              speculativeResult ;  // buildTrack result, -1 if the seed was used
 
 	} ;
 } // end namespace ftf
@@ -4,6 +4,7 @@
 #include "marlin/Processor.h"
 #include "lcio.h"
 #include <string>
+#include <vector>
 
 #include <UTIL/LCRelationNavigator.h>
 
@@ -20,6 +21,11 @@ namespace MarlinTrk{
 namespace ftf {
   class TrackFinder ;
   class TrackFindingParameters ;
+  class Track ;
+}
+
+namespace IMPL {
+  class TrackImpl ;
 }
 
 /**  Track Finder using FTF processor for marlin. 
@@ -113,6 +119,10 @@ protected:
   
   void setFTFParameters ( ftf::TrackFindingParameters* para ) ;
   
+  /** track state, chi2 and ndf of an ftf track from its own fit, used if the tracks are not refitted
+   */
+  void setFTFTrackState( ftf::Track& trk, IMPL::TrackImpl* track ) const ;
+  
 
   /** Input tpc tracker hit collection name
    */
@@ -159,7 +169,7 @@ protected:
   
   ftf::TrackFinder* _trackFinder;
 
-  std::map<int, TrackerHit*> hitmap;
+  std::vector<TrackerHit*> hitsById;  // LCIO hit of every ftf hit, indexed by Hit::id
 
   int _nlayers_vxd;
   int _nlayers_sit;
@@ -172,6 +182,7 @@ protected:
   bool _MSOn ;
   bool _ElossOn ;
   bool _SmoothOn ;
+  bool _refitTracks ;
 
   float _initialTrackError_d0;
   float _initialTrackError_phi0;
@@ -181,6 +192,12 @@ protected:
   
   double _maxChi2PerHit;
   
+  bool _floatHitSelection;
+  double _maxTimePerEvent;
+  int _nThreads;
+  std::string _ftfParameterFile;
+  StringVec _ftfParameters;
+  
   bool _runMarlinTrkDiagnostics;
   std::string _MarlinTrkDiagnosticsName;
   
@@ -15,13 +15,33 @@ namespace ftf
 	class TrackFindingParameters 
 	{          
 	public:
+		//
+		//    Entry of the table of the parameters which can be set by name,
+		//    read, write, print and set all go through the table
+		//
+		struct Parameter {
+			const char* name ;
+			const char* alias ;                            // older name accepted by set, or 0
+			int    TrackFindingParameters::* intValue ;    // one of the two is set
+			double TrackFindingParameters::* doubleValue ;
+			double min, max ;                              // allowed range
+			int    volumes ;                               // 1 if the volumes depend on it
+		} ;
+
 		TrackFindingParameters( ) { setDefaults() ; } ;
 		void       setDefaults( ) ;
-		void       read( char* inputFile ) ;
-		void       write( char* outputFile ) ;
+		int        read( const char* inputFile ) ;
+		void       write( const char* outputFile ) ;
 		void       write( FILE* outFile ) ;
 		void       print();
 
+		static const Parameter* find ( const char* name ) ;
+		int        set         ( const char* name, double value ) ;
+		int        get         ( const char* name, double& value ) const ;
+		int        validate    ( ) const ;
+		int        sameVolumes ( const TrackFindingParameters& other ) const ;
+		void       assign      ( const TrackFindingParameters& other ) ;
+
 		int        infoLevel;       // Level of information printed about progress
 		int        segmentRowSearchRange;       // Row search range for segments 
 		int        trackRowSearchRange;         // Row search range for tracks 
@@ -52,6 +72,8 @@ namespace ftf
 		int        rowStart;        // Row where start track search
 		int        rowEnd  ;        // Row where end   track search
 		int        szFitFlag;       // Switch for sz fit 
+		int        floatHitSelection; // Run the hit selection in float instead of double
+		int        nThreads;        // Threads building the tracks of a row together, serial if 1, all if 0
 		double     bField      ;    // Magnetic field  
 		double     hitChi2Cut;      // Maximum hit chi2 
 		double     goodHitChi2;     // Chi2 to stop looking for next hit 
@@ -87,7 +109,7 @@ namespace ftf
 		double     xyWeightVertex;  // Weight vertex in x-y
 		double     phiVertex      ;
 		double     rVertex        ;
-		double     maxTime        ; // maxTime tracker can run
+		double     maxTime        ; // Wall time budget of the tracker per event [s]
 		int        phiClosed ;
 		int        primaries  ;
 		int        nRowsPlusOne, nPhiPlusOne   ; // Number volumes + 1
@@ -30,19 +30,12 @@ void Hit::printLinks ( int point_level )
 		printf ( "%3d %3d %3d  %3d  %6.2f %5.2f  %6.2f %6.2f %6.2f \n", 
 		(int)id, (int)row, (int)phiIndex, (int)etaIndex, 
 		phi*toDeg, eta, x, y, z ) ;
-	int vhit ;
-	if ( nextVolumeHit != 0 ) vhit = (nextVolumeHit)->id ;
-	else vhit = -1 ;
-	int rhit ;
-	if ( nextRowHit != 0 ) rhit = (nextRowHit)->id ;
-	else rhit = -1 ;
 	int thit ;
 	if ( nextTrackHit != 0 ) thit = (nextTrackHit)->id ;
 	else thit = -1 ;
 
 	if ( fmod((double)point_level,10) > 1 ) 
-		printf ( "pointers:vol,row,tr (%4d,%4d,%4d)\n ",
-		vhit, rhit, thit) ; 
+		printf ( "pointers:tr (%4d)\n ", thit) ; 
 	//int tid ;
 	//if ( track != 0 ) tid = track->id ;
 	//else tid = -1 ;
@@ -57,4 +50,5 @@ void Hit::printLinks ( int point_level )
 void Hit::setTrack ( Track* this_track ) 
 {
 	track = this_track ;
+	if ( used != 0 ) *used = ( this_track != 0 ) ;
 }
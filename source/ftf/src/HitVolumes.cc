@@ -0,0 +1,74 @@
+#include "HitVolumes.h"
+using namespace ftf;
+
+//*********************************************************************
+//      Sets the number of volumes and rows
+//*********************************************************************
+void HitVolumes::allocate ( int nVolumes, int nRows ) 
+{
+	volumeStart.assign ( nVolumes + 1, 0 ) ;
+	rowStart.assign ( nRows + 1, 0 ) ;
+}
+//*********************************************************************
+//      Sorts the hits by volume and by row
+//      hitVolume and hitRow are -1 for hits outside the volumes
+//*********************************************************************
+void HitVolumes::fill ( Hit* hits, int nHits, const std::vector<int>& hitVolume, const std::vector<int>& hitRow,
+					   int floatHitsIn ) 
+{
+	int nVolumes = volumeStart.size() - 1 ;
+	int nRows    = rowStart.size() - 1 ;
+	//
+	//     Count the hits per volume and row
+	//
+	volumeStart.assign ( nVolumes + 1, 0 ) ;
+	rowStart.assign ( nRows + 1, 0 ) ;
+	int nUsed = 0 ;
+	for ( int ihit = 0 ; ihit < nHits ; ihit++ ) {
+		if ( hitVolume[ihit] < 0 ) continue ;
+		volumeStart[hitVolume[ihit]+1]++ ;
+		rowStart[hitRow[ihit]+1]++ ;
+		nUsed++ ;
+	}
+	for ( int i = 0 ; i < nVolumes ; i++ ) volumeStart[i+1] += volumeStart[i] ;
+	for ( int i = 0 ; i < nRows    ; i++ ) rowStart[i+1]    += rowStart[i] ;
+	//
+	//     Place the hits, the input order is kept inside a volume and a row
+	//
+	floatHits = floatHitsIn ;
+	hit.resize ( nUsed ) ;
+	used.assign ( nUsed, 0 ) ;
+	if ( floatHits ) hotFloat.resize ( nUsed ) ;
+	else             hotDouble.resize ( nUsed ) ;
+	rowHit.resize ( nUsed ) ;
+
+	std::vector<int> nextVolumeSlot ( volumeStart.begin(), volumeStart.end()-1 ) ;
+	std::vector<int> nextRowSlot ( rowStart.begin(), rowStart.end()-1 ) ;
+
+	for ( int ihit = 0 ; ihit < nHits ; ihit++ ) {
+		Hit* thisHit = &(hits[ihit]) ;
+		if ( hitVolume[ihit] < 0 ) {
+			thisHit->used = 0 ;
+			continue ;
+		}
+		int slot = nextVolumeSlot[hitVolume[ihit]]++ ;
+		hit[slot]  = thisHit ;
+		if ( floatHits ) hotFloat.set ( slot, thisHit ) ;
+		else             hotDouble.set ( slot, thisHit ) ;
+		thisHit->used = &(used[slot]) ;
+
+		rowHit[nextRowSlot[hitRow[ihit]]++] = thisHit ;
+	}
+}
+//*********************************************************************
+//      Copies the conformal coordinates of the hits, after they
+//      are calculated for the primaries
+//*********************************************************************
+void HitVolumes::updateConformal ( ) 
+{
+	int nUsed = hit.size() ;
+	for ( int slot = 0 ; slot < nUsed ; slot++ ) {
+		if ( floatHits ) hotFloat.setConformal ( slot, hit[slot] ) ;
+		else             hotDouble.setConformal ( slot, hit[slot] ) ;
+	}
+}
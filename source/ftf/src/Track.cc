@@ -12,6 +12,7 @@ void ftfMatrixDiagonal ( double *h, double &h11, double &h22, double &h33 ) ;
 Track::Track ( ){
 	firstHit = 0 ;
 	lastHit  = 0 ;
+	speculative = 0 ;
 }
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //       Fit a circle
@@ -42,23 +43,16 @@ int Track::fitHelix (  )
 // 
 //  Written in FORTRAN by Jawluen Tang, Physics department , UT-Austin 
 //  Moved to C by Pablo Yepes
+//
+//  The sums over the hits are updated by add when a hit is included,
+//  the averages and moments of the hits are derived from them, as in
+//  the circle fit of V. Karimaki, so that there is no loop over the hits
 //---------------------------------------------------------------
 int Track::fitCircle (  ) 
 {
-	double wsum  = 0.0 ;
-	double xav   = 0.0 ;
-	double yav   = 0.0 ;
-	//
-	//     Loop over hits calculating average
-	//
-	for ( startLoop() ; done() ; nextHit() ) { 
-
-		Hit* cHit = currentHit ;
-		cHit->wxy = 1.0F/ (double)(cHit->dx*cHit->dx + cHit->dy*cHit->dy) ;
-		wsum      += cHit->wxy ;
-		xav       += cHit->wxy * cHit->x ;
-		yav       += cHit->wxy * cHit->y ;
-	}
+	double wsum  = swCircle ;
+	double xav   = sxCircle + xRefHit * swCircle ;
+	double yav   = syCircle + yRefHit * swCircle ;
   
 	if ( getPara()->vertexConstrainedFit != 0 ) {
 		wsum += getPara()->xyWeightVertex ;
@@ -68,23 +62,22 @@ int Track::fitCircle (  )
   
 	xav = xav / wsum ;
 	yav = yav / wsum ;
+	//
+	//   Average relative to the reference hit
+	//
+	double mx = xav - xRefHit ;
+	double my = yav - yRefHit ;
 
 	//
 	//  CALCULATE <X**2>, <XY>, AND <Y**2> WITH <X> = 0, & <Y> = 0
 	//
-	double xxav  = 0.0 ;
-	double xyav  = 0.0 ; 
-	double yyav  = 0.0 ;
+	double hxx   = sxxCircle - 2.0 * mx * sxCircle + mx * mx * swCircle ;
+	double hxy   = sxyCircle - mx * syCircle - my * sxCircle + mx * my * swCircle ;
+	double hyy   = syyCircle - 2.0 * my * syCircle + my * my * swCircle ;
+	double xxav  = hxx ;
+	double xyav  = hxy ; 
+	double yyav  = hyy ;
 	double xi, yi ;
-
-	for ( startLoop() ; done() ; nextHit() ) { 
-		Hit* cHit = currentHit ;
-		xi        = cHit->x - xav ;
-		yi        = cHit->y - yav ;
-		xxav     += xi * xi * cHit->wxy ;
-		xyav     += xi * yi * cHit->wxy ;
-		yyav     += yi * yi * cHit->wxy ;
-	}
   
 	if ( getPara()->vertexConstrainedFit != 0 ) {
 		xi        = getPara()->xVertex - xav ;
@@ -149,37 +142,36 @@ int Track::fitCircle (  )
 	double rrav   = xxav + yyav ;
 	double rscale = sqrt(rrav) ;
 
-	xxav   = 0.0 ;
-	yyav   = 0.0 ;
-	xyav   = 0.0 ;
-	double xrrav	 = 0.0 ;
-	double yrrav	 = 0.0 ;
-	double rrrrav  = 0.0 ;
-
-	double xixi, yiyi, riri, wiriri, xold, yold ;
-	for ( startLoop() ; done() ; nextHit() ) { 
-		Hit* cHit = currentHit ;
-		xold = cHit->x - xav ;
-		yold = cHit->y - yav ;
-		//
-		//-->  ROTATE SO THAT <XY> = 0 & DIVIDE BY RSCALE SO THAT <R**2> = 1
-		//
-		xi = (  cosrot * xold + sinrot * yold ) / rscale ;
-		yi = ( -sinrot * xold + cosrot * yold ) / rscale ;
-
-		xixi   = xi * xi ;
-		yiyi   = yi * yi ;
-		riri   = xixi + yiyi ;
-		wiriri = cHit->wxy * riri ;
+	//
+	//-->  THIRD AND FOURTH MOMENTS OF THE HITS WITH <X> = 0, & <Y> = 0
+	//
+	double mm    = mx * mx + my * my ;
+	double srr   = sxxCircle + syyCircle ;
+	double sxm   = mx * sxCircle  + my * syCircle ;
+	double sxxm  = mx * sxxCircle + my * sxyCircle ;
+	double syym  = mx * sxyCircle + my * syyCircle ;
+	double smm   = mx * mx * sxxCircle + 2.0 * mx * my * sxyCircle + my * my * syyCircle ;
+	double hxrr  = sxrrCircle - 2.0 * sxxm + mm * sxCircle - mx * srr + 2.0 * mx * sxm - mx * mm * swCircle ;
+	double hyrr  = syrrCircle - 2.0 * syym + mm * syCircle - my * srr + 2.0 * my * sxm - my * mm * swCircle ;
+	double hrrrr = srrrrCircle + 4.0 * smm + mm * mm * swCircle
+		- 4.0 * ( mx * sxrrCircle + my * syrrCircle ) + 2.0 * mm * srr - 4.0 * mm * sxm ;
+	//
+	//-->  ROTATE SO THAT <XY> = 0 & DIVIDE BY RSCALE SO THAT <R**2> = 1
+	//
+	double cc     = cosrot * cosrot ;
+	double ss     = sinrot * sinrot ;
+	double cs     = cosrot * sinrot ;
+	double rscale2 = rscale * rscale ;
+	double rscale3 = rscale2 * rscale ;
 
-		xyav   += cHit->wxy * xi * yi ;
-		xxav   += cHit->wxy * xixi ;
-		yyav   += cHit->wxy * yiyi ;
+	xxav   = (  cc * hxx + 2.0 * cs * hxy + ss * hyy ) / rscale2 ;
+	yyav   = (  ss * hxx - 2.0 * cs * hxy + cc * hyy ) / rscale2 ;
+	xyav   = ( -cs * hxx + ( cc - ss ) * hxy + cs * hyy ) / rscale2 ;
+	double xrrav	 = (  cosrot * hxrr + sinrot * hyrr ) / rscale3 ;
+	double yrrav	 = ( -sinrot * hxrr + cosrot * hyrr ) / rscale3 ;
+	double rrrrav  = hrrrr / ( rscale2 * rscale2 ) ;
 
-		xrrav  += wiriri * xi ;
-		yrrav  += wiriri * yi ;
-		rrrrav += wiriri * riri ;
-	}
+	double xixi, yiyi, riri, wiriri, xold, yold ;
 	//
 	//   Include vertex if required
 	//
@@ -468,34 +460,24 @@ int Track::getErrorsCircleFit ( double a, double b, double r ) {
 		h[j] = 0.;
 	}
 	//
-	//    If circle fit was not used the
-	//    errors in the real space need to
-	//    be calculated
-	//
-	if ( pt < getPara()->ptMinHelixFit ) {
-		for ( startLoop() ; done() ; nextHit() ) { 
-
-			Hit* cHit = currentHit ;
-			cHit->wxy = 1.0F/ (double)(cHit->dx*cHit->dx + cHit->dy*cHit->dy) ;
-		}
-	}
-	//
-	//    Loop over points in fit
+	//    Loop over points in fit, with the
+	//    weights in the real space
 	//
 	for ( startLoop() ; done() ; nextHit() ) {
 		Hit* cHit = currentHit ;
+		double wxy = 1.0F/ (double)(cHit->dx*cHit->dx + cHit->dy*cHit->dy) ;
 		dx = cHit->x - a;
 		dy = cHit->y - b;
 		hyp = (double)sqrt( dx * dx + dy * dy );
 		s1 = dx / hyp;
 		c1 = dy / hyp;
 		ratio = r / hyp;
-		h[0] += cHit->wxy * (ratio * (s1 * s1 - 1) + 1);
-		h[1] += cHit->wxy * ratio * s1 * c1;
-		h[2] += cHit->wxy * s1;
-		h[4] += cHit->wxy * (ratio * (c1 * c1 - 1) + 1);
-		h[5] += cHit->wxy * c1;
-		h[8] += cHit->wxy ;
+		h[0] += wxy * (ratio * (s1 * s1 - 1) + 1);
+		h[1] += wxy * ratio * s1 * c1;
+		h[2] += wxy * s1;
+		h[4] += wxy * (ratio * (c1 * c1 - 1) + 1);
+		h[5] += wxy * c1;
+		h[8] += wxy ;
 	}
 	h[3]  = h[1];
 	h[6]  = h[2];
@@ -503,6 +485,24 @@ int Track::getErrorsCircleFit ( double a, double b, double r ) {
 
 	ftfMatrixDiagonal  ( h, h11, h22, h33 ) ;
 	//
+	//   Full covariance of (a,b,r), the inverse of h by cofactors
+	//
+	double c00 = h[4]*h[8] - h[5]*h[7] ;
+	double c10 = h[5]*h[6] - h[3]*h[8] ;
+	double c20 = h[3]*h[7] - h[4]*h[6] ;
+	double det = h[0]*c00 + h[1]*c10 + h[2]*c20 ;
+	if ( det != 0. ) {
+		covCircle[0] = c00 / det ;
+		covCircle[1] = c10 / det ;
+		covCircle[2] = ( h[0]*h[8] - h[2]*h[6] ) / det ;
+		covCircle[3] = c20 / det ;
+		covCircle[4] = ( h[1]*h[6] - h[0]*h[7] ) / det ;
+		covCircle[5] = ( h[0]*h[4] - h[1]*h[3] ) / det ;
+	}
+	else {
+		for ( int k = 0 ; k < 6 ; k++ ) covCircle[k] = 0. ;
+	}
+	//
 	//   Calculate pt error now
 	//
 	dpt          = (double)(2.9979e-3 * getPara()->bField * h33 );
@@ -1008,6 +1008,7 @@ void Track::add ( Hit* thisHit, int way )
 	//
 	if ( way < 0 || nHits == 1 ) {
 		if ( nHits > 1 ) (lastHit)->nextTrackHit = thisHit ;
+		else firstHit = thisHit ;
 		lastHit = thisHit ;
 		innerMostRow = (lastHit)->row ;
 		xLastHit = (lastHit)->x ;
@@ -1022,6 +1023,7 @@ void Track::add ( Hit* thisHit, int way )
 	//        Declare hit as used and fill chi2
 	//
 	thisHit->setTrack ( this ) ;
+	addCircleSums ( thisHit ) ;
 	//
 	//    Check whether a fit update is needed
 	//
@@ -1161,6 +1163,11 @@ void Track::add ( Track* piece )
 	chi2[0] += piece->chi2[0] ;
 	chi2[1] += piece->chi2[1] ;
 	//
+	//   The sums of the piece are relative to its own reference hit
+	//
+	resetCircleSums ( ) ;
+	for ( startLoop() ; done() ; nextHit() ) addCircleSums ( currentHit ) ;
+	//
 	//   Update track parameters
 	//
 	//
@@ -1177,27 +1184,28 @@ void Track::add ( Track* piece )
 //****************************************************************************
 //   Control how the track gets built
 //****************************************************************************
-int Track::buildTrack ( Hit* frstHit, Container* volume ) {
+int Track::buildTrack ( Hit* frstHit, HitVolumes* volumes ) {
 	//
 	//   Add first hit to track
 	//
-	add ( frstHit, GO_DOWN ) ;
+	add ( useHit ( frstHit ), GO_DOWN ) ;
 	//
 	//    Try to build a segment first
 	//
-	if ( !segment ( volume, GO_DOWN ) ) return 0 ;
+	if ( !segment ( volumes, GO_DOWN ) ) return 0 ;
 	//
 	//    If segment build go for a real track with a fit
 	//
 	int rowToStop = getPara()->rowInnerMost ;
-	if ( !follow ( volume, GO_DOWN, rowToStop ) ) return 0 ;
+	if ( !follow ( volumes, GO_DOWN, rowToStop ) ) return 0 ;
 	//
 	//    Now to extent track the other direction if requested
 	//
-	if ( getPara()->goBackwards != 0 ) follow ( volume, GO_UP, getPara()->rowOuterMost ) ;
+	if ( getPara()->goBackwards != 0 ) follow ( volumes, GO_UP, getPara()->rowOuterMost ) ;
 	//
-	//  Fill tracks
+	//  Fill tracks, a speculative track is filled when it is taken
 	//
+	if ( speculative != 0 ) return 1 ;
 	if ( getPara()->fillTracks != 0 ) fill ( ) ;
 #ifdef TRDEBUG
 	debugFill ( ) ;
@@ -1206,6 +1214,57 @@ int Track::buildTrack ( Hit* frstHit, Container* volume ) {
 	return 1 ;
 }
 //***************************************************************************
+//   Returns the hit to be added to the track, a copy of it if the
+//   track is built speculatively
+//***************************************************************************
+Hit* Track::useHit ( Hit* thisHit ) {
+	if ( speculative == 0 ) return thisHit ;
+
+	speculative->hits.push_back ( *thisHit ) ;
+	speculative->sources.push_back ( thisHit ) ;
+	Hit* copy = &(speculative->hits.back()) ;
+	copy->used         = 0 ;
+	copy->nextTrackHit = 0 ;
+	copy->source       = speculative->sources.size() - 1 ;
+	return copy ;
+}
+//***************************************************************************
+//   Checks whether the speculative build of the track still holds, that is
+//   whether none of the hits it used or looked at was taken by another track
+//***************************************************************************
+int Track::speculativeHitsFree ( HitVolumes* volumes ) {
+	for ( unsigned int i = 0 ; i < speculative->sources.size() ; i++ ) 
+		if ( speculative->sources[i]->track != 0 ) return 0 ;
+	for ( unsigned int i = 0 ; i < speculative->examined.size() ; i++ ) 
+		if ( volumes->used[speculative->examined[i]] ) return 0 ;
+	return 1 ;
+}
+//***************************************************************************
+//   Moves the track from the copies to the hits themselves and assigns
+//   the hits to the track
+//***************************************************************************
+void Track::takeSpeculativeHits ( ) {
+	std::vector<Hit*>& sources = speculative->sources ;
+	speculative = 0 ;
+
+	Hit* previousHit = 0 ;
+	for ( Hit* copy = firstHit ; copy != 0 ; copy = copy->nextTrackHit ) {
+		Hit* thisHit = sources[copy->source] ;
+		thisHit->s      = copy->s ;
+		thisHit->xp     = copy->xp ;
+		thisHit->yp     = copy->yp ;
+		thisHit->wxy    = copy->wxy ;
+		thisHit->xyChi2 = copy->xyChi2 ;
+		thisHit->szChi2 = copy->szChi2 ;
+		thisHit->nextTrackHit = 0 ;
+		thisHit->setTrack ( this ) ;
+		if ( previousHit != 0 ) previousHit->nextTrackHit = thisHit ;
+		else firstHit = thisHit ;
+		previousHit = thisHit ;
+	}
+	lastHit = previousHit ;
+}
+//***************************************************************************
 //   Calculates dEdx
 //***************************************************************************
 void Track::dEdx (  ){
@@ -1452,7 +1511,7 @@ void Track::fillSecondary ( double &xc, double &yc,
 //              way   :       which way to procede in r (negative or positive)
 //              row_to_stop:  row index where to stop
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-int Track::follow ( Container* volume, int way, int ir_stop ) {
+int Track::follow ( HitVolumes* volumes, int way, int ir_stop ) {
 
 	Hit* nextHit ;
 
@@ -1480,7 +1539,7 @@ int Track::follow ( Container* volume, int way, int ir_stop ) {
 		//
 		chi2[0] = getPara()->hitChi2Cut ;
 
-		nextHit = seekNextHit ( volume, nextHit, way*getPara()->trackRowSearchRange, USE_FOLLOW ) ;
+		nextHit = seekNextHit ( volumes, nextHit, way*getPara()->trackRowSearchRange, USE_FOLLOW ) ;
 
 #ifdef TRDEBUG
 		if ( getPara()->trackDebug && getPara()->debugLevel >= 1 ){
@@ -1504,6 +1563,15 @@ int Track::follow ( Container* volume, int way, int ir_stop ) {
 		//    Stop if nothing found
 		//
 		if ( nextHit == 0 ) break ;
+		nextHit = useHit ( nextHit ) ;
+		//
+		//   Conformal coordinates of secondaries relative to the reference hit
+		//
+		if ( getPara()->primaries == 0 ) {
+			nextHit->xp  = xpNextHit ;
+			nextHit->yp  = ypNextHit ;
+			nextHit->wxy = wxyNextHit ;
+		}
 		//
 		//   Keep total chi2
 		//
@@ -1514,6 +1582,7 @@ int Track::follow ( Container* volume, int way, int ir_stop ) {
 		//   if sz fit update track length
 		//
 		if ( getPara()->szFitFlag  ) {
+			nextHit->s = sNextHit ;
 			length = nextHit->s ;
 			szChi2 += chi2[1]  ;
 			nextHit->szChi2 = chi2[1] ;
@@ -1544,48 +1613,51 @@ int Track::follow ( Container* volume, int way, int ir_stop ) {
 /*******************************************************************************
 Reconstructs tracks
 *********************************************************************************/
-int Track::followHitSelection ( Hit* baseHit, Hit* candidateHit ){
-	//
-	double lszChi2 = 0 ;
-	double lchi2 ;
-	double slocal, deta, dphi ;
-	double dx, dy, dxy, dsz, temp ;
+//     The candidate is read from the hot arrays at slot, in the precision Real,
+//     and from candidateHit for its errors. s and the conformal coordinates of
+//     the best candidate are kept in sNextHit, xpNextHit, ... for follow
+/*******************************************************************************/
+template <typename Real>
+int Track::followHitSelection ( Hit* baseHit, const HotHits<Real>& hot, int slot, Hit* candidateHit ){
 	//
-	//           Check delta eta 
-	//
-	//   if ( baseHit->dz < 1000. && candidateHit->dz < 1000 ){
-	deta = fabs((baseHit->eta)-(candidateHit->eta)) ;
-	if ( deta > getPara()->deta ) return 0 ; 
-	//   }
-	//   else deta = 0.F ;
+	Real lszChi2 = 0 ;
+	Real lchi2 ;
+	Real slocal = 0 ;
+	Real dx, dy, dxy, dsz, temp ;
+	Real xp, yp, wxy ;
 	//
-	//           Check delta phi
+	//           Check delta eta and delta phi
 	//
-	dphi = fabs((baseHit->phi)-(candidateHit->phi)) ;
-	if ( dphi > getPara()->dphi && dphi < twoPi-getPara()->dphi ) return 0 ;
+	if ( !followWindow<Real> ( baseHit->phi, baseHit->eta, hot.phi[slot], hot.eta[slot] ) ) return 0 ;
 	//
 	//      If looking for secondaries calculate conformal coordinates
 	//
 	if ( getPara()->primaries == 0 ){
-		double xx = candidateHit->x - xRefHit ;
-		double yy = candidateHit->y - yRefHit ;
-		double rr = xx * xx + yy * yy ;
-		candidateHit->xp =   xx / rr ;
-		candidateHit->yp = - yy / rr ;
-
-		candidateHit->wxy  = rr * rr /
+		Real xx = hot.x[slot] - (Real)xRefHit ;
+		Real yy = hot.y[slot] - (Real)yRefHit ;
+		Real rr = xx * xx + yy * yy ;
+		xp  =   xx / rr ;
+		yp  = - yy / rr ;
+		wxy = rr * rr /
 			( square(getPara()->xyErrorScale)  *
 			( square(candidateHit->dx) + square(candidateHit->dy) ) ) ;
 	}
+	else {
+		xp  = hot.xp[slot] ;
+		yp  = hot.yp[slot] ;
+		wxy = hot.wxy[slot] ;
+	}
 	//
 	//      Calculate distance in x and y
 	//
-	temp = (a2Xy * candidateHit->xp - candidateHit->yp + a1Xy) ;
-	dxy  = temp * temp / ( a2Xy * a2Xy + 1.F ) ;
+	const Real a1 = a1Xy ;
+	const Real a2 = a2Xy ;
+	temp = (a2 * xp - yp + a1) ;
+	dxy  = temp * temp / ( a2 * a2 + 1.F ) ;
 	//
 	//    Calculate chi2
 	//
-	lchi2    = (dxy * candidateHit->wxy) ;
+	lchi2    = (dxy * wxy) ;
 
 	if ( lchi2 > chi2[0] ) return 0 ;
 	//
@@ -1595,16 +1667,18 @@ int Track::followHitSelection ( Hit* baseHit, Hit* candidateHit ){
 		//
 		//        Get "s" and calculate distance hit-line
 		//
-		dx     = baseHit->x - candidateHit->x ;
-		dy     = baseHit->y - candidateHit->y ;
-		slocal = length + sqrt ( dx * dx + dy * dy ) ;
-
-		temp = (a2Sz * slocal - candidateHit->z + a1Sz) ;
-		dsz  = temp * temp / ( a2Sz * a2Sz + 1 ) ;
+		dx     = (Real)baseHit->x - hot.x[slot] ;
+		dy     = (Real)baseHit->y - hot.y[slot] ;
+		slocal = (Real)length + sqrt ( dx * dx + dy * dy ) ;
+
+		const Real a1 = a1Sz ;
+		const Real a2 = a2Sz ;
+		temp = (a2 * slocal - hot.z[slot] + a1) ;
+		dsz  = temp * temp / ( a2 * a2 + 1 ) ;
 		//
 		//              Calculate chi2
 		//
-		lszChi2 = dsz * candidateHit->wz ;
+		lszChi2 = dsz * hot.wz[slot] ;
 		lchi2 += lszChi2 ;
 	} 
 	else {
@@ -1617,7 +1691,10 @@ int Track::followHitSelection ( Hit* baseHit, Hit* candidateHit ){
 		chi2[0]       = (double)lchi2    ;
 		chi2[1]       = (double)lszChi2 ;
 
-		if ( getPara()->szFitFlag != 0 ) candidateHit->s = (double)slocal ;
+		if ( getPara()->szFitFlag != 0 ) sNextHit = (double)slocal ;
+		xpNextHit  = xp ;
+		ypNextHit  = yp ;
+		wxyNextHit = wxy ;
 		//
 		//       if a good chi2 is found let's stop here
 		//
@@ -1631,6 +1708,28 @@ int Track::followHitSelection ( Hit* baseHit, Hit* candidateHit ){
 	return 0 ;
 }
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//    Checks whether a candidate hit is inside the eta and phi range of the
+//    base hit when following a track
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+template <typename Real>
+int Track::followWindow ( Real basePhi, Real baseEta, Real candidatePhi, Real candidateEta ){
+	//
+	//           Check delta eta 
+	//
+	//   if ( baseHit->dz < 1000. && candidateHit->dz < 1000 ){
+	Real deta = fabs(baseEta-candidateEta) ;
+	if ( deta > getPara()->deta ) return 0 ; 
+	//   }
+	//   else deta = 0.F ;
+	//
+	//           Check delta phi
+	//
+	Real dphi = fabs(basePhi-candidatePhi) ;
+	if ( dphi > getPara()->dphi && dphi < twoPi-getPara()->dphi ) return 0 ;
+
+	return 1 ;
+}
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //    Merges tracks
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 int Track::mergePrimary ( TrackContainer* trackArea ){
@@ -1752,6 +1851,42 @@ void Track::reset (void)
 			chi2[1]  = 
 			length         = 0.F ;
 	}
+	resetCircleSums ( ) ;
+}
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//    Includes a hit in the sums of the circle fit
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+void Track::addCircleSums ( Hit* thisHit )
+{
+	double w  = 1.0F/ (double)(thisHit->dx*thisHit->dx + thisHit->dy*thisHit->dy) ;
+	double x  = thisHit->x - xRefHit ;
+	double y  = thisHit->y - yRefHit ;
+	double rr = x * x + y * y ;
+
+	swCircle    += w ;
+	sxCircle    += w * x ;
+	syCircle    += w * y ;
+	sxxCircle   += w * x * x ;
+	sxyCircle   += w * x * y ;
+	syyCircle   += w * y * y ;
+	sxrrCircle  += w * x * rr ;
+	syrrCircle  += w * y * rr ;
+	srrrrCircle += w * rr * rr ;
+}
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//    Sets the sums of the circle fit to zero
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+void Track::resetCircleSums ( )
+{
+	swCircle    =
+		sxCircle    =
+		syCircle    =
+		sxxCircle   =
+		sxyCircle   =
+		syyCircle   =
+		sxrrCircle  =
+		syrrCircle  =
+		srrrrCircle = 0. ;
 }
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //     Function to look for next hit
@@ -1761,7 +1896,21 @@ void Track::reset (void)
 //		    which_function: Function to be used to decide whether the hit is good
 // Returns:	Selected hit
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-Hit* Track::seekNextHit ( Container  *volume, 
+Hit* Track::seekNextHit ( HitVolumes *volumes, 
+						 Hit* baseHit,
+						 int     n_r_steps,
+						 int which_function ) {
+	if ( volumes->floatHits )
+		return seekNextHit<float> ( volumes, volumes->hotFloat, baseHit, n_r_steps, which_function ) ;
+	return seekNextHit<double> ( volumes, volumes->hotDouble, baseHit, n_r_steps, which_function ) ;
+}
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//    Same with the hit selection run in the precision Real, hot are the
+//    arrays of volumes filled in that precision
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+template <typename Real>
+Hit* Track::seekNextHit ( HitVolumes *volumes, 
+						 const HotHits<Real>& hot,
 						 Hit* baseHit,
 						 int     n_r_steps,
 						 int which_function ) {
@@ -1791,6 +1940,8 @@ Hit* Track::seekNextHit ( Container  *volume,
 
 
 							 Hit* selected_hit  = 0 ;
+							 const Real basePhi = baseHit->phi ;
+							 const Real baseEta = baseHit->eta ;
 							 //
 							 //      Loop over modules
 							 //
@@ -1830,24 +1981,34 @@ Hit* Track::seekNextHit ( Container  *volume,
 									 //
 									 //       Now loop over hits in each volume 
 									 //
+									 //       The used flags and the hot arrays of the volume are contiguous,
+									 //       the hit itself is only read by the follow selection of secondaries
+									 //
 									 areaIndex = irp   * getPara()->nPhiEtaPlusOne + ipp * getPara()->nEtaPlusOne + itp ;
-									 for ( Hit* candidateHit = volume[areaIndex].first ; 
-										 candidateHit != 0 ;
-										 candidateHit = candidateHit->nextVolumeHit ){
+									 int volumeEnd = volumes->end(areaIndex) ;
+									 for ( int iHit = volumes->begin(areaIndex) ; iHit < volumeEnd ; iHit++ ){
+											 Hit* candidateHit = volumes->hit[iHit] ;
 #ifdef TRDEBUG
 											 debugInVolume ( baseHit, candidateHit ) ;
 #endif
 											 //----------------------------------------------------------------------------
 											 //         Check whether the hit was used before
 											 //--------------------------------------------------------------------------*/
-											 if ( candidateHit->track != 0 ) continue ;
+											 if ( volumes->used[iHit] ) continue ;
+											 if ( speculative && speculative->uses ( &(volumes->used[iHit]) ) ) continue ;
 											 //--------------------------------------------------------------------------
 											 //         If first points, just choose the closest hit
 											 //-------------------------------------------------------------------------- */
-											 if ( which_function == USE_SEGMENT ) 
-												 result = segmentHitSelection ( baseHit, candidateHit ) ;
-											 else 
-												 result = followHitSelection  ( baseHit, candidateHit ) ;
+											 if ( which_function == USE_SEGMENT ) {
+												 if ( segmentDphi<Real> ( basePhi, hot.phi[iHit] ) < 0 ) continue ;
+												 if ( speculative ) speculative->examined.push_back ( iHit ) ;
+												 result = segmentHitSelection<Real> ( baseHit, hot, iHit ) ;
+											 }
+											 else {
+												 if ( !followWindow<Real> ( basePhi, baseEta, hot.phi[iHit], hot.eta[iHit] ) ) continue ;
+												 if ( speculative ) speculative->examined.push_back ( iHit ) ;
+												 result = followHitSelection<Real>  ( baseHit, hot, iHit, candidateHit ) ;
+											 }
 											 //
 											 //     Check result
 											 //
@@ -1878,7 +2039,7 @@ found: ;
 //             way        :    whether to go to negative or positive ir
 //             row_to_stop:    row index where to stop
 //++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-int Track::segment( Container* volume, int way ){
+int Track::segment( HitVolumes* volumes, int way ){
 	//
 	//   Define some variables
 	//
@@ -1901,7 +2062,7 @@ int Track::segment( Container* volume, int way ){
 	//
 	while ( nextHit != 0 && nHits < getPara()->nHitsForSegment ) {
 		chi2[0] = getPara()->maxDistanceSegment ; ;
-		nextHit = seekNextHit ( volume, nextHit, way*getPara()->segmentRowSearchRange, 
+		nextHit = seekNextHit ( volumes, nextHit, way*getPara()->segmentRowSearchRange, 
 			USE_SEGMENT ) ;
 #ifdef TRDEBUG
 		if ( getPara()->trackDebug && getPara()->debugLevel > 0 ) {
@@ -1919,6 +2080,7 @@ int Track::segment( Container* volume, int way ){
 		//     If sz fit update s
 		//
 		if ( nextHit != 0 ){
+			nextHit = useHit ( nextHit ) ;
 			//
 			//   Calculate track length if sz plane considered
 			//
@@ -1956,42 +2118,57 @@ int Track::segment( Container* volume, int way ){
 		return 0 ;
 }
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//     Difference in phi between the base hit and a candidate hit for segments,
+//     -1 if the candidate is outside the phi range
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+template <typename Real>
+Real Track::segmentDphi ( Real basePhi, Real candidatePhi ){
+
+	Real dphi  = fabs(basePhi - candidatePhi) ; 
+	if ( dphi > pi ) dphi = fabs( twoPi - dphi ) ;
+	if ( dphi > getPara()->dphi && dphi < twoPi -getPara()->dphi ) return -1 ;
+
+	return dphi ;
+}
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 //     Routine to look for segments.
 //	 Arguments:
 //	 baseHit:       Hit from which track is being extrapolated
-//   candidateHit:  Hit being examined as a candidate to which extend track
+//   hot, slot:     Hot arrays and slot of the hit being examined as a candidate
+//                  to which extend track
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-int Track::segmentHitSelection ( Hit* baseHit, Hit* candidateHit ){
+template <typename Real>
+int Track::segmentHitSelection ( Hit* baseHit, const HotHits<Real>& hot, int slot ){
 
-	double dx, dy, dr, d3, dangle ;
-	double dphi, deta ;
-	double   angle ;
+	Real dx, dy, dr, d3 ;
+	double dangle ;
+	Real dphi, deta ;
+	Real   angle ;
 	//
 	//   select hit with the
 	//   the smallest value of d3 (defined below)
 	//
-	dphi  = (double)fabs((baseHit->phi) - (candidateHit->phi)) ; 
-	if ( dphi > pi ) dphi = (double)fabs( twoPi - dphi ) ;
-	if ( dphi > getPara()->dphi && dphi < twoPi -getPara()->dphi ) return 0 ;
+	dphi  = segmentDphi<Real> ( baseHit->phi, hot.phi[slot] ) ;
+	if ( dphi < 0 ) return 0 ;
 	//
 	//    Make sure we want to look at the difference in eta
 	//
-	if ( baseHit->dz < 1000. && candidateHit->dz < 1000. ){
-		deta  = (double)fabs((baseHit->eta) - (candidateHit->eta)) ; 
+	if ( baseHit->dz < 1000. && hot.dz[slot] < 1000. ){
+		deta  = fabs((Real)(baseHit->eta) - (hot.eta[slot])) ; 
 		if ( deta > getPara()->deta ) return 0 ;
 	}
 	else deta = 0.F ;
 
-	dr    = (double)fabs((double)(baseHit->row - candidateHit->row));
-	d3    = (double)(toDeg * dr * ( dphi  + deta ) ) ;
+	dr    = fabs((Real)(baseHit->row - hot.row[slot]));
+	d3    = (Real)(toDeg * dr * ( dphi  + deta ) ) ;
 	//
 	//     If initial segment is longer than 2 store angle info in 
 	//     a1Xy and a1_sz
 	//
 	if ( getPara()->nHitsForSegment > 2 && nHits-1 < getPara()->nHitsForSegment ) {
-		dx = candidateHit->x - baseHit->x ;
-		dy = candidateHit->y - baseHit->y ;
-		angle = (double)atan2 ( dy, dx ) ;
+		dx = hot.x[slot] - (Real)baseHit->x ;
+		dy = hot.y[slot] - (Real)baseHit->y ;
+		angle = atan2 ( dy, dx ) ;
 		if ( angle < 0  ) angle = angle + twoPi ;
 		lastXyAngle = angle ;
 	}
@@ -2015,9 +2192,9 @@ int Track::segmentHitSelection ( Hit* baseHit, Hit* candidateHit ){
 		//   between the last two track segments
 		//
 		if ( nHits > 1 ) {
-			dx     = candidateHit->x - baseHit->x ;
-			dy     = candidateHit->y - baseHit->y ;
-			angle  = (double)atan2 ( dy, dx ) ;
+			dx     = hot.x[slot] - (Real)baseHit->x ;
+			dy     = hot.y[slot] - (Real)baseHit->y ;
+			angle  = atan2 ( dy, dx ) ;
 			if ( angle < 0  ) angle = angle + twoPi ;
 			dangle = (double)fabs ( lastXyAngle - angle );
 			lastXyAngle = angle ;
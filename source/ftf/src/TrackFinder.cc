@@ -1,6 +1,12 @@
 #include "TrackFinder.h"
+#include <chrono>
 using namespace ftf;
 using std::max;
+//
+//    Fractions of para.maxTime after which the finder takes the next degradation step,
+//    the last step stops the track finding when the time budget is used up
+//
+static const double degradationTimeFraction[DEGRADE_STOP] = { 0.5, 0.7, 0.85, 1.0 } ;
 
 //*********************************************************************
 //      Initializes the package
@@ -10,17 +16,14 @@ TrackFinder::TrackFinder ( )
 	hit        = 0 ;  
 	track      = 0 ;
 	trackC     = 0 ;
-	volumeC    = 0 ;
-	rowC       = 0 ;
 	nHitsOutOfRange = 0 ;
+	degradationLevel = DEGRADE_NONE ;
 }
 //*********************************************************************
 //      Initializes the package
 //*********************************************************************
 TrackFinder::~TrackFinder ( ) 
 {
-	if ( volumeC != 0 ) delete[] volumeC  ;
-	if ( rowC  != 0 ) delete[] rowC ;
 	if ( trackC != 0 ) delete[] trackC ;
 }
 //*********************************************************************
@@ -28,6 +31,7 @@ TrackFinder::~TrackFinder ( )
 //*********************************************************************
 double TrackFinder::process (  ) 
 {  
+	degradationLevel = DEGRADE_NONE ;
 	//-----------------------------------------------------------------
 	//        Make sure there is something to work with
 	//------------------------------------------------------------------ 
@@ -38,6 +42,12 @@ double TrackFinder::process (  )
 	}
 	//
 	initialCpuTime  = CpuTime ( );
+	initialWallTime = WallTime ( );
+	savedMinHitsPerTrack       = para.minHitsPerTrack ;
+	savedSegmentRowSearchRange = para.segmentRowSearchRange ;
+	savedTrackRowSearchRange   = para.trackRowSearchRange ;
+	savedDeta                  = para.deta ;
+	savedDphi                  = para.dphi ;
 	//
 	//        General initialization 
 	//
@@ -59,12 +69,16 @@ double TrackFinder::process (  )
 	//      Look for secondaries    
 	//
 	para.primaries = 0 ;
-	for ( i = 0 ; i < para.nSecondaryPasses ; i++ )
+	for ( i = 0 ; i < para.nSecondaryPasses ; i++ ) {
+		if ( degradationLevel >= DEGRADE_NO_SECONDARIES ) break ;
 		if ( getTracks() != 0 ) break ;
+	}
 
 	//   if ( para.dEdx ) dEdx ( ) ;
 
+	restoreDegradedParameters ( ) ;
 	cpuTime  = CpuTime  ( ) - initialCpuTime  ;
+	wallTime = WallTime ( ) - initialWallTime ;
 #ifdef DEBUG
 	if ( para.infoLevel > 0 )
 		fprintf ( stderr, "TrackFinder::process: cpu %7.3f \n", cpuTime ) ;
@@ -106,16 +120,34 @@ int TrackFinder::getTracks ( )
 		//
 		//           Loop over hits in this particular row
 		//
-		if ( rowC[ir].first != 0 &&  ((rowC[ir].first)->row) < para.rowEnd ) break ;
+		if ( volumes.rowBegin(ir) < volumes.rowEnd(ir) && ((volumes.rowHit[volumes.rowBegin(ir)])->row) < para.rowEnd ) break ;
 		//    if ( ((rowC[ir].first)->row) < para.rowEnd ) break ;
-		for ( Hit* firstHit = rowC[ir].first ;
-			firstHit != 0 ;
-			firstHit =(firstHit->nextRowHit) ) {
+		//
+		//           With more than one thread the row is built as a whole
+		//
+		if ( para.nThreads > 1 ) {
+			if ( buildRowPipelined ( ir ) != 0 ) {
+				para.nHitsForSegment = nHitsSegment ;  
+				return 1 ;
+			}
+			continue ;
+		}
+		for ( int iRowHit = volumes.rowBegin(ir) ; iRowHit < volumes.rowEnd(ir) ; iRowHit++ ) {
+				Hit* firstHit = volumes.rowHit[iRowHit] ;
 				//
 				//     Check hit was not used before
 				//
 				if ( firstHit->track != 0  ) continue ;
 				//
+				//     Check time
+				//
+				if ( checkTimeBudget ( ) >= DEGRADE_STOP ) {
+					fprintf ( stderr, "TrackFinder::getTracks: tracker time out after %f\n", 
+						WallTime() - initialWallTime ) ;
+					para.nHitsForSegment = nHitsSegment ;  
+					return 1 ;
+				}
+				//
 				//     One more track 
 				//
 				nTracks++ ;
@@ -130,56 +162,17 @@ int TrackFinder::getTracks ( )
 				//     Initialize variables before going into track hit loop
 				//
 				Track* thisTrack    = &track[nTracks-1];
-				thisTrack->para     = &para ;
-				thisTrack->id       = nTracks ;
-				thisTrack->firstHit = thisTrack->lastHit = firstHit ;
-				thisTrack->innerMostRow = thisTrack->outerMostRow = firstHit->row ;
-				thisTrack->xRefHit  = firstHit->x ;
-				thisTrack->yRefHit  = firstHit->y ;
-				thisTrack->xLastHit = firstHit->x ;
-				thisTrack->yLastHit = firstHit->y ;
-#ifdef TRDEBUG
-				thisTrack->debugNew ( ) ;
-#endif
-				//
-				//              Set fit parameters to zero
-				//
-				thisTrack->reset ( ) ;
+				initTrack ( thisTrack, nTracks, firstHit ) ;
 				//
 				//      Go into hit looking loop
 				//
-				if ( thisTrack->buildTrack ( firstHit, volumeC ) != 0 ) {
-					//
-					//    Merge Tracks if requested
-					//
-					if ( para.primaries &&
-						para.mergePrimaries == 1 &&
-						para.fillTracks &&
-						thisTrack->mergePrimary( trackC )  ) {
-							nTracks-- ;
-							thisTrack->deleteCandidate ( ) ;
-					}
-				}
-				else{
-					//
-					//      If track was not built delete candidate
-					//
-					thisTrack->deleteCandidate ( ) ;
-					nTracks-- ;
-				}
+				finishTrack ( thisTrack, thisTrack->buildTrack ( firstHit, &volumes ) ) ;
 				//    
 				//       End loop over hits inside row               
 				//
 		}
 		//       End loop over rows                           
 		//
-		//    Check time
-		//
-		if ( CpuTime() - initialCpuTime > para.maxTime ) {
-			fprintf ( stderr, "TrackFinder::getTracks: tracker time out after %f\n", 
-				CpuTime() - initialCpuTime ) ;
-			break ;
-		}
 	}
 	//
 	para.nHitsForSegment = nHitsSegment ;  
@@ -187,6 +180,118 @@ int TrackFinder::getTracks ( )
 	return 0 ;
 }
 //********************************************************************
+//     Initializes the variables of a track before the hit looking loop
+//********************************************************************
+void TrackFinder::initTrack ( Track* thisTrack, int id, Hit* firstHit ) 
+{
+	thisTrack->para     = &para ;
+	thisTrack->id       = id ;
+	thisTrack->firstHit = thisTrack->lastHit = firstHit ;
+	thisTrack->innerMostRow = thisTrack->outerMostRow = firstHit->row ;
+	thisTrack->xRefHit  = firstHit->x ;
+	thisTrack->yRefHit  = firstHit->y ;
+	thisTrack->xLastHit = firstHit->x ;
+	thisTrack->yLastHit = firstHit->y ;
+#ifdef TRDEBUG
+	thisTrack->debugNew ( ) ;
+#endif
+	//
+	//              Set fit parameters to zero
+	//
+	thisTrack->reset ( ) ;
+}
+//********************************************************************
+//     Keeps, merges or deletes a track after buildTrack
+//********************************************************************
+void TrackFinder::finishTrack ( Track* thisTrack, int built ) 
+{
+	if ( built != 0 ) {
+		//
+		//    Merge Tracks if requested
+		//
+		if ( para.primaries &&
+			para.mergePrimaries == 1 &&
+			para.fillTracks &&
+			thisTrack->mergePrimary( trackC )  ) {
+				nTracks-- ;
+				thisTrack->deleteCandidate ( ) ;
+		}
+	}
+	else{
+		//
+		//      If track was not built delete candidate
+		//
+		thisTrack->deleteCandidate ( ) ;
+		nTracks-- ;
+	}
+}
+//********************************************************************
+//     Builds the tracks starting in row ir with para.nThreads threads.
+//     First the tracks of all free hits of the row are built in parallel
+//     on copies of the hits, each as if it were the next track of the
+//     serial loop. They are then taken in the order of the serial loop,
+//     a track is rebuilt if a hit it used or looked at was taken by one
+//     of the tracks before it. The tracks are the same as with one thread.
+//     The time budget is checked once per row.
+//********************************************************************
+int TrackFinder::buildRowPipelined ( int ir ) 
+{
+	if ( checkTimeBudget ( ) >= DEGRADE_STOP ) {
+		fprintf ( stderr, "TrackFinder::getTracks: tracker time out after %f\n", 
+			WallTime() - initialWallTime ) ;
+		return 1 ;
+	}
+	int firstSeed = volumes.rowBegin(ir) ;
+	int nSeeds    = volumes.rowEnd(ir) - firstSeed ;
+	if ( nSeeds <= 0 ) return 0 ;
+	if ( (int)speculativeTracks.size() < nSeeds ) {
+		speculativeTracks.resize ( nSeeds ) ;
+		speculativeBuilds.resize ( nSeeds ) ;
+		speculativeResult.resize ( nSeeds ) ;
+	}
+	//
+	//    Build the tracks speculatively, the shared hits are only read
+	//
+	taskPool.run ( nSeeds, [&] ( int i ) {
+		Hit* firstHit = volumes.rowHit[firstSeed+i] ;
+		speculativeResult[i] = -1 ;
+		if ( firstHit->track != 0 ) return ;
+		Track* thisTrack = &(speculativeTracks[i]) ;
+		speculativeBuilds[i].clear ( ) ;
+		initTrack ( thisTrack, 0, firstHit ) ;
+		thisTrack->speculative = &(speculativeBuilds[i]) ;
+		speculativeResult[i] = thisTrack->buildTrack ( firstHit, &volumes ) ;
+	} ) ;
+	//
+	//    Take them in order
+	//
+	for ( int i = 0 ; i < nSeeds ; i++ ) {
+		Hit* firstHit = volumes.rowHit[firstSeed+i] ;
+		if ( firstHit->track != 0  ) continue ;
+		nTracks++ ;
+		if ( nTracks > maxTracks ){
+			fprintf(stderr,"\n TrackFinder::getTracks: Max nr tracks reached !") ;
+			nTracks = maxTracks  ;
+			return 1 ;
+		}
+		Track* thisTrack = &track[nTracks-1];
+		int built ;
+		if ( speculativeResult[i] >= 0 && speculativeTracks[i].speculativeHitsFree ( &volumes ) ) {
+			*thisTrack     = speculativeTracks[i] ;
+			thisTrack->id  = nTracks ;
+			thisTrack->takeSpeculativeHits ( ) ;
+			built = speculativeResult[i] ;
+			if ( built != 0 && para.fillTracks != 0 ) thisTrack->fill ( ) ;
+		}
+		else {
+			initTrack ( thisTrack, nTracks, firstHit ) ;
+			built = thisTrack->buildTrack ( firstHit, &volumes ) ;
+		}
+		finishTrack ( thisTrack, built ) ;
+	}
+	return 0 ;
+}
+//********************************************************************
 //
 void TrackFinder::mergePrimaryTracks ( ) 
 {
@@ -243,25 +348,11 @@ int TrackFinder::reset (void)
 		para.nEtaTrackPlusOne = para.nEtaTrack + 1 ;
 	}
 	//
-	//-->    Allocate volume memory
+	//-->    Allocate volume and row ranges
 	//
-	if (volumeC != NULL) delete[] volumeC; 
 	int nVolumes = para.nRowsPlusOne*para.nPhiPlusOne *
 		para.nEtaPlusOne ;
-	volumeC = new Container[nVolumes];
-	if(volumeC == NULL) {
-		fprintf ( stderr, "Problem with memory allocation... exiting\n" ) ;
-		return 1 ;
-	}
-	// 
-	//      Allocate row memory
-	//
-	if ( rowC != NULL ) delete[] rowC ;
-	rowC = new Container[para.nRowsPlusOne];
-	if ( rowC == NULL) {
-		fprintf ( stderr, "Problem with memory allocation... exiting\n" ) ;
-		exit(0);
-	}
+	volumes.allocate ( nVolumes, para.nRowsPlusOne ) ;
 	//
 	//       Allocate track area memory
 	//
@@ -313,6 +404,41 @@ int TrackFinder::reset (void)
 	-------------------------------------------------------------------------- */
 	para.phiSliceTrack   = (para.phiMaxTrack - para.phiMinTrack)/para.nPhiTrack ;
 	para.etaSliceTrack   = (para.etaMaxTrack - para.etaMinTrack)/para.nEtaTrack ;
+	//
+	//    Set what does not depend on the volumes
+	//
+	updateParameters ( ) ;
+	//
+	//   Set # hits & tracks to zero
+	//
+	// nHits   = 0 ;
+	// nTracks = 0 ;
+	//
+	//    Set initialization flag to true
+	//
+	para.init = 1 ;
+	return 0 ;
+}
+//*********************************************************************
+//      Switches to another set of parameters, e.g. to run several
+//      configurations on the same event. The volumes are only
+//      allocated again if a parameter they depend on changed
+//*********************************************************************
+int TrackFinder::setParameters ( const TrackFindingParameters& newPara )
+{
+	if ( newPara.validate ( ) != 0 ) return 1 ;
+	int sameVolumes = para.init != 0 && para.sameVolumes ( newPara ) ;
+	para.assign ( newPara ) ;
+	if ( sameVolumes ) updateParameters ( ) ;
+	else               para.init = 0 ;
+	return 0 ;
+}
+//*********************************************************************
+//      Sets the quantities derived from the parameters which do not
+//      change the volumes
+//*********************************************************************
+void TrackFinder::updateParameters ( )
+{
 	//
 	//    Set vertex parameters
 	//
@@ -337,15 +463,12 @@ int TrackFinder::reset (void)
 		para.xyWeightVertex = 1.0F ;
 	}
 	//
-	//   Set # hits & tracks to zero
+	//    Start the threads of the pipelined track building, 0 uses all hardware threads
 	//
-	// nHits   = 0 ;
-	// nTracks = 0 ;
-	//
-	//    Set initialization flag to true
-	//
-	para.init = 1 ;
-	return 0 ;
+	if ( para.nThreads != 1 && taskPool.nThreads() != para.nThreads ) {
+		taskPool.init ( para.nThreads ) ;
+		para.nThreads = taskPool.nThreads() ;
+	}
 }
 
 //*********************************************************************
@@ -374,6 +497,7 @@ int TrackFinder::setConformalCoordinates ( )
 		thisHit->yp    =   - y * invR2 ;
 		thisHit->wxy   =   r2 * r2 /  ( square(para.xyErrorScale) * ( square(thisHit->dx) + square(thisHit->dy) ) ) ;
 	} 
+	volumes.updateConformal ( ) ;
 
 	return 0 ;
 } 
@@ -389,11 +513,10 @@ int TrackFinder::setPointers ( )
 	//
 	nHitsOutOfRange = 0 ;
 	//
-	//   Set volumes to zero
+	//   Volume and row of every hit, the hits are sorted into the volumes at the end
 	//
-	memset ( rowC,   0, para.nRowsPlusOne*sizeof(Container) ) ;
-	int n = para.nRowsPlusOne*para.nEtaPlusOne*para.nPhiPlusOne ;
-	memset ( volumeC, 0, n*sizeof(Container) ) ;
+	hitVolume.assign ( nHits, -1 ) ;
+	hitRow.assign ( nHits, -1 ) ;
 	if ( para.mergePrimaries )
 	{ 
 		memset ( trackC, 0, para.nPhiTrackPlusOne*para.nEtaTrackPlusOne*sizeof(Container) ) ;  
@@ -435,11 +558,6 @@ int TrackFinder::setPointers ( )
 		thisHit->phi = phi ;
 		thisHit->eta = eta ;
 		/*-------------------------------------------------------------------------
-		Set pointers
-		-------------------------------------------------------------------------*/
-		thisHit->nextVolumeHit  = 
-			thisHit->nextRowHit     = 0 ;
-		/*-------------------------------------------------------------------------
 		Get phi index for hit
 		-------------------------------------------------------------------------*/
 
@@ -476,31 +594,18 @@ int TrackFinder::setPointers ( )
 		thisHit->nextTrackHit  = 0 ;
 		thisHit->track         = 0 ;
 		/* ------------------------------------------------------------------------- 
-		Increase nr. of hits in small volume  WARNING! C-arrays go from 0
-		Set Id of first hit in this vol. and link to next hit in previous
-		hit in the same volume
+		Volume index  WARNING! C-arrays go from 0
 		-------------------------------------------------------------------------*/
 		volumeIndex = localRow  * para.nPhiEtaPlusOne + 
 			thisHit->phiIndex * para.nEtaPlusOne + thisHit->etaIndex ;
 
-
-		if (volumeC[volumeIndex].first == 0 ) 
-			volumeC[volumeIndex].first = thisHit ;
-		else
-			((volumeC[volumeIndex].last))->nextVolumeHit = thisHit ;
-		volumeC[volumeIndex].last = thisHit ;
-
-		/*-------------------------------------------------------------------------
-		Set row pointers
-		-------------------------------------------------------------------------*/
-
-		if ( rowC[localRow].first == NULL ){
-			rowC [localRow].first = thisHit ;
-		}
-		else
-			((rowC[localRow].last))->nextRowHit = thisHit ;
-		rowC[localRow].last = thisHit ;
+		hitVolume[ihit] = volumeIndex ;
+		hitRow[ihit]    = localRow ;
 	}
+	/*-------------------------------------------------------------------------
+	Sort the hits into the volumes and rows
+	-------------------------------------------------------------------------*/
+	volumes.fill ( hit, nHits, hitVolume, hitRow, para.floatHitSelection ) ;
 	return 0 ;
 } 
 //***********************************************************************
@@ -516,3 +621,55 @@ double TrackFinder::CpuTime( void )
 	return (double)(clock()) / CLOCKS_PER_SEC;
 }
 
+double TrackFinder::WallTime( void )
+{
+	return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count() ;
+}
+//***********************************************************************
+//     Compares the wall time spent in this event with the budget
+//     para.maxTime and takes the degradation steps that are due
+//     Returns the degradation level reached
+//***********************************************************************
+int TrackFinder::checkTimeBudget ( )
+{
+	if ( degradationLevel >= DEGRADE_STOP ) return degradationLevel ;
+
+	double elapsed = WallTime ( ) - initialWallTime ;
+	while ( degradationLevel < DEGRADE_STOP && 
+		elapsed > degradationTimeFraction[degradationLevel] * para.maxTime ) {
+		degrade ( degradationLevel + 1 ) ;
+	}
+	return degradationLevel ;
+}
+//***********************************************************************
+//     Takes one degradation step
+//***********************************************************************
+void TrackFinder::degrade ( int level )
+{
+	degradationLevel = level ;
+	if ( para.infoLevel > 0 )
+		fprintf ( stderr, "TrackFinder::degrade: level %d after %f s\n", 
+			level, WallTime() - initialWallTime ) ;
+
+	if ( level == DEGRADE_MIN_HITS ) {
+		para.minHitsPerTrack += 2 ;
+	}
+	else if ( level == DEGRADE_SEARCH_RANGE ) {
+		para.segmentRowSearchRange = max(1,para.segmentRowSearchRange/2) ;
+		para.trackRowSearchRange   = max(1,para.trackRowSearchRange/2) ;
+		para.deta                  = 0.5 * para.deta ;
+		para.dphi                  = 0.5 * para.dphi ;
+	}
+}
+//***********************************************************************
+//     Restores the parameters changed by degrade for the next event
+//***********************************************************************
+void TrackFinder::restoreDegradedParameters ( )
+{
+	para.minHitsPerTrack       = savedMinHitsPerTrack ;
+	para.segmentRowSearchRange = savedSegmentRowSearchRange ;
+	para.trackRowSearchRange   = savedTrackRowSearchRange ;
+	para.deta                  = savedDeta ;
+	para.dphi                  = savedDphi ;
+}
+
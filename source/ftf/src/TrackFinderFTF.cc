@@ -17,6 +17,7 @@
 #include <UTIL/ILDConf.h>
 
 #include <cmath>
+#include <cstdlib>
 
 // ----- include for verbosity dependend logging ---------
 #include "marlin/VerbosityLevels.h"
@@ -136,6 +137,11 @@ TrackFinderFTF::TrackFinderFTF() : Processor("TrackFinderFTF") {
                            std::string("FTFTracks") ) ;
   
     
+  registerProcessorParameter("RefitTracks",
+                             "Refit the FTF tracks with the Kalman filter. If false the helix of the FTF fit is written as the track state at the parameter point of FTF, with the covariance of d0, phi0 and omega propagated from the circle fit, or the InitialTrackError values as unknown errors where the circle fit gives no valid covariance",
+                             _refitTracks,
+                             bool(true));
+  
   registerProcessorParameter("MultipleScatteringOn",
                              "Use MultipleScattering in Fit",
                              _MSOn,
@@ -182,6 +188,32 @@ TrackFinderFTF::TrackFinderFTF() : Processor("TrackFinderFTF") {
                              _maxChi2PerHit,
                              double(1.e2));
   
+  registerProcessorParameter( "FloatHitSelection",
+                             "Run the selection of the next hit of a track in float instead of double precision",
+                             _floatHitSelection,
+                             bool(false));
+  
+  registerProcessorParameter( "MaxTimePerEvent",
+                             "Wall time budget of the track finding per event in seconds, the finder degrades in steps towards the end of it and stops when it is used up. <= 0 for no budget",
+                             _maxTimePerEvent,
+                             double(0.));
+  
+  registerProcessorParameter( "NumberOfThreads",
+                             "Number of threads building the tracks starting in the same row, the tracks are the same as with 1 thread. 0 uses all hardware threads",
+                             _nThreads,
+                             int(1));
+  
+  registerProcessorParameter( "FTFParameterFile",
+                             "File with pairs of FTF parameter name and value, as written by TrackFindingParameters::write, applied after the parameters above. Empty for none",
+                             _ftfParameterFile,
+                             std::string(""));
+  
+  StringVec ftfParametersExample ;
+  registerProcessorParameter( "FTFParameters",
+                             "Pairs of FTF parameter name and value applied after FTFParameterFile, e.g. deta 0.05 dphi 0.05",
+                             _ftfParameters,
+                             ftfParametersExample );
+  
   
 #ifdef MARLINTRK_DIAGNOSTICS_ON
   
@@ -259,6 +291,47 @@ void TrackFinderFTF::init() {
   
   this->setFTFParameters( &(_trackFinder->para) );
   
+  // the FTF errors are needed for the track states if the tracks are not refitted
+  if( ! _refitTracks ) _trackFinder->para.getErrors = 1 ;
+  
+  int nParameterErrors = 0 ;
+  
+  if( ! _ftfParameterFile.empty() ) nParameterErrors += _trackFinder->para.read( _ftfParameterFile.c_str() ) ;
+  
+  for( unsigned i=0; i+1<_ftfParameters.size(); i+=2 ){
+    
+    char* end = 0 ;
+    double value = strtod( _ftfParameters[i+1].c_str(), &end ) ;
+    
+    if( end == _ftfParameters[i+1].c_str() || *end != 0 ){
+      streamlog_out( ERROR ) << "  FTFParameters: value " << _ftfParameters[i+1] << " of " << _ftfParameters[i] << " is not a number" << std::endl ;
+      ++nParameterErrors ;
+      continue ;
+    }
+    
+    if( _trackFinder->para.set( _ftfParameters[i].c_str(), value ) != 0 ) ++nParameterErrors ;
+    
+  }
+  
+  if( _ftfParameters.size() % 2 != 0 ){
+    streamlog_out( ERROR ) << "  FTFParameters: " << _ftfParameters.back() << " has no value" << std::endl ;
+    ++nParameterErrors ;
+  }
+  
+  // the FTF errors are still needed without RefitTracks if the parameter file or FTFParameters switched them off
+  if( ! _refitTracks && _trackFinder->para.getErrors == 0 ) {
+    streamlog_out( WARNING ) << "  TrackFinderFTF: getErrors is switched on again, as the track states are taken from FTF without RefitTracks" << std::endl ;
+    _trackFinder->para.getErrors = 1 ;
+  }
+  
+  nParameterErrors += _trackFinder->para.validate() ;
+  
+  if( nParameterErrors != 0 ) {
+    
+    throw EVENT::Exception( std::string("  TrackFinderFTF: invalid FTF parameters, see the messages above") ) ;
+    
+  }
+  
   int maxHits        = 30000 ;
 	int maxTracks      =  1000 ;
   
@@ -320,7 +393,7 @@ void TrackFinderFTF::processEvent( LCEvent * evt ) {
 //  _input_set_hits_col = this->GetCollection( evt, _input_set_hits_col_name ) ;
 //  
   _trackFinder->reset ( ) ;
-  hitmap.clear();
+  hitsById.clear();
   
   // establish the track collection that will be created 
   LCCollectionVec* trackVec = new LCCollectionVec( LCIO::TRACK )  ;    
@@ -364,7 +437,7 @@ void TrackFinderFTF::processEvent( LCEvent * evt ) {
     _trackFinder->hit[counter].dy       = 0.01;
     _trackFinder->hit[counter].dz       = 0.01;
     
-    hitmap[ _trackFinder->hit[counter].id ] = trkhit;
+    hitsById.push_back( trkhit );
     
     ++counter;
     
@@ -398,7 +471,7 @@ void TrackFinderFTF::processEvent( LCEvent * evt ) {
     _trackFinder->hit[counter].dy       = trkhit->getCovMatrix()[1];
     _trackFinder->hit[counter].dz       = trkhit->getCovMatrix()[2];
     
-    hitmap[ _trackFinder->hit[counter].id ] = trkhit;
+    hitsById.push_back( trkhit );
     
     ++counter;
     
@@ -433,7 +506,7 @@ void TrackFinderFTF::processEvent( LCEvent * evt ) {
 //    _trackFinder->hit[counter].dy       = trkhit->getCovMatrix()[2] ;
 //    _trackFinder->hit[counter].dz       = trkhit->getCovMatrix()[5] ;
 //    
-//    hitmap[ _trackFinder->hit[counter].id ] = trkhit;
+//    hitsById.push_back( trkhit );
 //    
 //    ++counter;
 //    
@@ -468,7 +541,7 @@ void TrackFinderFTF::processEvent( LCEvent * evt ) {
 //    _trackFinder->hit[counter].dy       = trkhit->getCovMatrix()[2] ;
 //    _trackFinder->hit[counter].dz       = trkhit->getCovMatrix()[5] ;
 //    
-//    hitmap[ _trackFinder->hit[counter].id ] = trkhit;
+//    hitsById.push_back( trkhit );
 //    
 //    ++counter;
 //    
@@ -502,7 +575,7 @@ void TrackFinderFTF::processEvent( LCEvent * evt ) {
 //    _trackFinder->hit[counter].dy       = 0.01 ;
 //    _trackFinder->hit[counter].dz       = 0.01 ;
 //    
-//    hitmap[ _trackFinder->hit[counter].id ] = trkhit;
+//    hitsById.push_back( trkhit );
 //    
 //    ++counter;
 //    
@@ -541,20 +614,39 @@ void TrackFinderFTF::processEvent( LCEvent * evt ) {
   
   std::cout << std::endl;
   
+  std::vector<TrackerHit*> hit_list;
+  
   for ( int i = 0 ; i < _trackFinder->nTracks ; i++ ) {
     printf ( " %d pt %f tanl %f nHits %d \n ", i, 
             _trackFinder->track[i].pt, 
             _trackFinder->track[i].tanl,
             _trackFinder->track[i].nHits );
     
-    ftf::Track trk = _trackFinder->track[i];
+    ftf::Track& trk = _trackFinder->track[i];
     
     IMPL::TrackImpl* Track = new TrackImpl;
 
-    std::vector<TrackerHit*> hit_list;
+    hit_list.clear();
     
     for ( trk.startLoop() ; trk.done() ; trk.nextHit()  ) { 
-      hit_list.push_back(hitmap[(trk.currentHit)->id]);
+      hit_list.push_back(hitsById[(trk.currentHit)->id]);
+    }
+    
+    if( ! _refitTracks ){
+      
+      sort( hit_list.begin(), hit_list.end(), TrackFinderFTF::compare_r() );
+      
+      this->setFTFTrackState( trk, Track ) ;
+      
+      for ( unsigned ihit = 0; ihit < hit_list.size(); ++ihit) Track->addHit( hit_list[ihit] ) ;
+      
+      MarlinTrk::addHitNumbersToTrack(Track, hit_list, true, *_encoder);
+      MarlinTrk::addHitNumbersToTrack(Track, hit_list, false, *_encoder);
+      
+      trackVec->addElement(Track);
+      
+      continue ;
+      
     }
     
     // setup initial dummy covariance matrix
@@ -645,10 +737,14 @@ void TrackFinderFTF::processEvent( LCEvent * evt ) {
   
   streamlog_out(DEBUG4) << " \n **************************************************** " ;
   streamlog_out(DEBUG4) << " \n ** Number of reconstructed tracks: " << _trackFinder->nTracks  ;
+  streamlog_out(DEBUG4) << " \n ** Time budget degradation level: " << _trackFinder->degradationLevel  ;
   streamlog_out(DEBUG4) << " \n **************************************************** "  ;
   streamlog_out(DEBUG4) << " \n "  ;
   
   
+  // let downstream processors tell events cut short by the time budget apart
+  trackVec->parameters().setValue( "FTFDegradationLevel" , _trackFinder->degradationLevel ) ;
+  
   evt->addCollection( trackVec , _output_track_col_name) ;
 
   ++_n_evt ;
@@ -762,6 +858,89 @@ void TrackFinderFTF::setFTFParameters ( ftf::TrackFindingParameters* para ) {
 	para->dphiMerge        = 0.01F  ;
 	para->phiClosed        = 0      ;
   
+	para->floatHitSelection = _floatHitSelection ;
+	if ( _maxTimePerEvent > 0 ) para->maxTime = _maxTimePerEvent ;
+	para->nThreads = _nThreads ;
+  
+}
+
+void TrackFinderFTF::setFTFTrackState( ftf::Track& trk, IMPL::TrackImpl* track ) const {
+  
+  // The parameter point of the FTF fit becomes the reference point, so that d0 and z0 are zero.
+  const double bScale  = bFactor * _trackFinder->para.bField ;
+  const double radius  = trk.pt / bScale ;
+  const double sign    = trk.q < 0 ? -1. : 1. ;
+  
+  // d0, phi0 and omega are propagated linearly from the covariance of the circle centre (xc,yc) and
+  // radius R of the FTF fit. With u the unit vector from the centre to the reference point, which
+  // lies on the circle, d0 = sign(q)*( R - |P-C| ), phi0 is the angle of u rotated by 90 degrees and
+  // omega = q/R, so that the rows of the jacobian in (xc,yc,R) are
+  //   d0:     sign(q) * ( ux, uy, 1 )
+  //   phi0:   ( uy/R, -ux/R, 0 )
+  //   omega:  ( 0, 0, -sign(q)/R^2 )
+  const double ux = -sign * sin( trk.psi ) ;
+  const double uy =  sign * cos( trk.psi ) ;
+  
+  const double jacobian[3][3] = { { sign*ux,   sign*uy,    sign                    },
+                                  { uy/radius, -ux/radius, 0.                      },
+                                  { 0.,        0.,         -sign/(radius*radius)   } } ;
+  
+  const double* c = trk.covCircle ;
+  const double circleCov[3][3] = { { c[0], c[1], c[3] },
+                                   { c[1], c[2], c[4] },
+                                   { c[3], c[4], c[5] } } ;
+  
+  double phi = trk.psi ;
+  if( phi >= M_PI ) phi -= 2.0 * M_PI ;
+  
+  float refPoint[3] ;
+  refPoint[0] = trk.r0 * cos( trk.phi0 ) ;
+  refPoint[1] = trk.r0 * sin( trk.phi0 ) ;
+  refPoint[2] = trk.z0 ;
+  
+  // For short or almost straight tracks the matrix of the circle fit can be close to singular or not
+  // positive definite, then its inverse is no covariance and d0, phi0 and omega are marked as unknown
+  // with the large initial errors of the Kalman fit
+  const double minor2 = c[0]*c[2] - c[1]*c[1] ;
+  const double minor3 = c[0]*( c[2]*c[5] - c[4]*c[4] ) - c[1]*( c[1]*c[5] - c[4]*c[3] ) + c[3]*( c[1]*c[4] - c[2]*c[3] ) ;
+  const bool circleCovValid = c[0] > 0. && minor2 > 0. && minor3 > 0. ;
+  
+  // lower triangle of (d0,phi0,omega) in the first six elements, z0 and tanl are uncorrelated with them
+  EVENT::FloatVec covMatrix( 15, 0. ) ;
+  
+  if( circleCovValid ){
+    
+    for( int i=0; i<3; ++i ){
+      for( int j=0; j<=i; ++j ){
+        double cov = 0. ;
+        for( int k=0; k<3; ++k ){
+          for( int l=0; l<3; ++l ) cov += jacobian[i][k] * circleCov[k][l] * jacobian[j][l] ;
+        }
+        covMatrix[ i*(i+1)/2 + j ] = cov ;
+      }
+    }
+    
+  }
+  else {
+    
+    streamlog_out( DEBUG2 ) << "  FTF track " << trk.id << " with " << trk.nHits << " hits has no valid circle covariance, d0, phi0 and omega get the initial errors" << std::endl ;
+    
+    covMatrix[0]  = _initialTrackError_d0 ;     //sigma_d0^2
+    covMatrix[2]  = _initialTrackError_phi0 ;   //sigma_phi0^2
+    covMatrix[5]  = _initialTrackError_omega ;  //sigma_omega^2
+    
+  }
+  
+  covMatrix[9]  = trk.dz0 ;                                 //sigma_z0^2
+  covMatrix[14] = trk.dtanl ;                               //sigma_tanl^2
+  
+  const int location = _trackFinder->para.parameterLocation ? TrackState::AtFirstHit : TrackState::AtIP ;
+  
+  track->addTrackState( new TrackStateImpl( location, 0., phi, trk.q / radius, 0., trk.tanl, covMatrix, refPoint ) ) ;
+  
+  track->setChi2( trk.chi2[0] + trk.chi2[1] ) ;
+  track->setNdf( 2*trk.nHits - 5 ) ;
+  track->setRadiusOfInnermostHit( trk.r0 ) ;
   
 }
 
@@ -3,265 +3,216 @@
 #include <algorithm>
 #include <iostream>
 #include <cstring>
+#include <cmath>
+#include <string>
 using namespace ftf;
 using std::cout;
 using std::endl;
 
-void TrackFindingParameters::read ( char* inputFile ) 
+//
+//    Parameters which can be set by name, in the order they are written.
+//    The ranges only exclude values the finder cannot work with
+//
+static const double big = 1.e30 ;
+typedef TrackFindingParameters P ;
+static const TrackFindingParameters::Parameter parameterTable[] = {
+	// name                  alias                    int                        double                       min      max     volumes
+	{ "infoLevel",            0,                      &P::infoLevel,             0,                           0,       big,    0 },
+	{ "segmentRowSearch",     "segmentRowSearchRange",&P::segmentRowSearchRange, 0,                           0,       big,    0 },
+	{ "trackRowSearch",       "trackRowSearchRange",  &P::trackRowSearchRange,   0,                           0,       big,    0 },
+	{ "getErrors",            0,                      &P::getErrors,             0,                           0,       1,      0 },
+	{ "fillTracks",           0,                      &P::fillTracks,            0,                           0,       1,      0 },
+	{ "ghostFlag",            0,                      &P::ghostFlag,             0,                           0,       1,      0 },
+	{ "goBackwards",          0,                      &P::goBackwards,           0,                           0,       1,      0 },
+	{ "mergePrimaries",       0,                      &P::mergePrimaries,        0,                           0,       1,      1 },
+	{ "minHitsPerTrack",      0,                      &P::minHitsPerTrack,       0,                           1,       big,    0 },
+	{ "modRow",               0,                      &P::modRow,                0,                           1,       big,    1 },
+	{ "nHitsForSegment",      0,                      &P::nHitsForSegment,       0,                           1,       big,    0 },
+	{ "minHitsForFit",        0,                      &P::minHitsForFit,         0,                           1,       big,    0 },
+	{ "nEta",                 0,                      &P::nEta,                  0,                           1,       big,    1 },
+	{ "nPhi",                 0,                      &P::nPhi,                  0,                           1,       big,    1 },
+	{ "deta",                 0,                      0,                         &P::deta,                    0,       big,    0 },
+	{ "dphi",                 0,                      0,                         &P::dphi,                    0,       big,    0 },
+	{ "etaMin",               0,                      0,                         &P::etaMin,                  -big,    big,    1 },
+	{ "etaMax",               0,                      0,                         &P::etaMax,                  -big,    big,    1 },
+	{ "phiMin",               0,                      0,                         &P::phiMin,                  -twoPi,  twoPi,  1 },
+	{ "phiMax",               0,                      0,                         &P::phiMax,                  -twoPi,  2*twoPi,1 },
+	{ "phiShift",             0,                      0,                         &P::phiShift,                -twoPi,  twoPi,  0 },
+	{ "detaMerge",            0,                      0,                         &P::detaMerge,               0,       big,    0 },
+	{ "dphiMerge",            0,                      0,                         &P::dphiMerge,               0,       big,    0 },
+	{ "distanceMerge",        0,                      0,                         &P::distanceMerge,           0,       big,    0 },
+	{ "nEtaTrack",            0,                      &P::nEtaTrack,             0,                           1,       big,    1 },
+	{ "nPhiTrack",            0,                      &P::nPhiTrack,             0,                           1,       big,    1 },
+	{ "etaMinTrack",          0,                      0,                         &P::etaMinTrack,             -big,    big,    1 },
+	{ "etaMaxTrack",          0,                      0,                         &P::etaMaxTrack,             -big,    big,    1 },
+	{ "phiMinTrack",          0,                      0,                         &P::phiMinTrack,             -twoPi,  twoPi,  1 },
+	{ "phiMaxTrack",          0,                      0,                         &P::phiMaxTrack,             -twoPi,  2*twoPi,1 },
+	{ "nPrimaryPasses",       0,                      &P::nPrimaryPasses,        0,                           0,       big,    0 },
+	{ "nSecondaryPasses",     0,                      &P::nSecondaryPasses,      0,                           0,       big,    0 },
+	{ "vertexConstrainedFit", 0,                      &P::vertexConstrainedFit,  0,                           0,       1,      0 },
+	{ "parameterLocation",    0,                      &P::parameterLocation,     0,                           0,       1,      0 },
+	{ "rowInnerMost",         0,                      &P::rowInnerMost,          0,                           0,       big,    1 },
+	{ "rowOuterMost",         0,                      &P::rowOuterMost,          0,                           0,       big,    1 },
+	{ "rowStart",             0,                      &P::rowStart,              0,                           0,       big,    0 },
+	{ "rowEnd",               0,                      &P::rowEnd,                0,                           0,       big,    0 },
+	{ "szFitFlag",            0,                      &P::szFitFlag,             0,                           0,       1,      0 },
+	{ "floatHitSelection",    0,                      &P::floatHitSelection,     0,                           0,       1,      0 },
+	{ "nThreads",             0,                      &P::nThreads,              0,                           0,       big,    0 },
+	{ "maxChi2Primary",       0,                      0,                         &P::maxChi2Primary,          0,       big,    0 },
+	{ "bField",               0,                      0,                         &P::bField,                  -big,    big,    0 },
+	{ "hitChi2Cut",           0,                      0,                         &P::hitChi2Cut,              0,       big,    0 },
+	{ "goodHitChi2",          0,                      0,                         &P::goodHitChi2,             0,       big,    0 },
+	{ "trackChi2Cut",         0,                      0,                         &P::trackChi2Cut,            0,       big,    0 },
+	{ "goodDistance",         0,                      0,                         &P::goodDistance,            0,       big,    0 },
+	{ "ptMinHelixFit",        0,                      0,                         &P::ptMinHelixFit,           0,       big,    0 },
+	{ "maxDistanceSegment",   0,                      0,                         &P::maxDistanceSegment,      0,       big,    0 },
+	{ "segmentMaxAngle",      0,                      0,                         &P::segmentMaxAngle,         0,       pi,     0 },
+	{ "xyErrorScale",         0,                      0,                         &P::xyErrorScale,            0,       big,    0 },
+	{ "szErrorScale",         0,                      0,                         &P::szErrorScale,            0,       big,    0 },
+	{ "xVertex",              0,                      0,                         &P::xVertex,                 -big,    big,    0 },
+	{ "yVertex",              0,                      0,                         &P::yVertex,                 -big,    big,    0 },
+	{ "dxVertex",             0,                      0,                         &P::dxVertex,                0,       big,    0 },
+	{ "dyVertex",             0,                      0,                         &P::dyVertex,                0,       big,    0 },
+	{ "zVertex",              0,                      0,                         &P::zVertex,                 -big,    big,    0 },
+	{ "xyWeightVertex",       0,                      0,                         &P::xyWeightVertex,          0,       big,    0 },
+	{ "phiVertex",            0,                      0,                         &P::phiVertex,               -twoPi,  twoPi,  0 },
+	{ "rVertex",              0,                      0,                         &P::rVertex,                 0,       big,    0 },
+	{ "maxTime",              0,                      0,                         &P::maxTime,                 0,       big,    0 }
+} ;
+static const int nParameters = sizeof(parameterTable)/sizeof(parameterTable[0]) ;
+
+//
+//    Returns the table entry of a parameter, 0 if there is none
+//
+const TrackFindingParameters::Parameter* TrackFindingParameters::find ( const char* name ) 
+{
+	for ( int i = 0 ; i < nParameters ; i++ ) {
+		const Parameter& p = parameterTable[i] ;
+		if ( !strcmp(name,p.name) || ( p.alias != 0 && !strcmp(name,p.alias) ) ) return &p ;
+	}
+	return 0 ;
+}
+
+//
+//    Sets a parameter by name, returns 0 if it was set, 1 if the name is unknown,
+//    2 if an integer parameter gets a fraction and 3 if the value is out of range
+//
+int TrackFindingParameters::set ( const char* name, double value ) 
+{
+	const Parameter* p = find ( name ) ;
+	if ( p == 0 ) {
+		printf ( "TrackFindingParameters::set: parameter %s not found \n", name ) ;
+		return 1 ;
+	}
+	if ( p->intValue != 0 && value != floor(value) ) {
+		printf ( "TrackFindingParameters::set: parameter %s is an integer, not %g \n", name, value ) ;
+		return 2 ;
+	}
+	if ( !( value >= p->min && value <= p->max ) ) {
+		printf ( "TrackFindingParameters::set: parameter %s = %g outside [%g,%g] \n", name, value, p->min, p->max ) ;
+		return 3 ;
+	}
+	if ( p->intValue != 0 ) this->*(p->intValue) = (int)value ;
+	else                    this->*(p->doubleValue) = value ;
+	return 0 ;
+}
+
+int TrackFindingParameters::get ( const char* name, double& value ) const 
+{
+	const Parameter* p = find ( name ) ;
+	if ( p == 0 ) return 1 ;
+	value = p->intValue != 0 ? this->*(p->intValue) : this->*(p->doubleValue) ;
+	return 0 ;
+}
+
+//
+//    Checks the ranges of the table and the consistency of the limits,
+//    returns the number of problems found
+//
+int TrackFindingParameters::validate ( ) const 
+{
+	int nProblems = 0 ;
+	for ( int i = 0 ; i < nParameters ; i++ ) {
+		const Parameter& p = parameterTable[i] ;
+		double value = p.intValue != 0 ? this->*(p.intValue) : this->*(p.doubleValue) ;
+		if ( !( value >= p.min && value <= p.max ) ) {
+			printf ( "TrackFindingParameters::validate: %s = %g outside [%g,%g] \n", p.name, value, p.min, p.max ) ;
+			nProblems++ ;
+		}
+	}
+	if ( etaMin >= etaMax || etaMinTrack >= etaMaxTrack ) {
+		printf ( "TrackFindingParameters::validate: empty eta range \n" ) ;
+		nProblems++ ;
+	}
+	if ( phiMin >= phiMax || phiMax - phiMin > twoPi + 0.1 ||
+		phiMinTrack >= phiMaxTrack || phiMaxTrack - phiMinTrack > twoPi + 0.1 ) {
+		printf ( "TrackFindingParameters::validate: wrong phi range \n" ) ;
+		nProblems++ ;
+	}
+	if ( rowInnerMost > rowOuterMost ) {
+		printf ( "TrackFindingParameters::validate: rowInnerMost %d above rowOuterMost %d \n", rowInnerMost, rowOuterMost ) ;
+		nProblems++ ;
+	}
+	return nProblems ;
+}
+
+//
+//    Returns 1 if the parameters the volumes depend on are the same in both sets
+//
+int TrackFindingParameters::sameVolumes ( const TrackFindingParameters& other ) const 
+{
+	for ( int i = 0 ; i < nParameters ; i++ ) {
+		const Parameter& p = parameterTable[i] ;
+		if ( !p.volumes ) continue ;
+		if ( p.intValue != 0 && this->*(p.intValue) != other.*(p.intValue) ) return 0 ;
+		if ( p.doubleValue != 0 && this->*(p.doubleValue) != other.*(p.doubleValue) ) return 0 ;
+	}
+	return 1 ;
+}
+
+//
+//    Copies the parameters of the table, the values derived by TrackFinder are kept
+//
+void TrackFindingParameters::assign ( const TrackFindingParameters& other ) 
+{
+	for ( int i = 0 ; i < nParameters ; i++ ) {
+		const Parameter& p = parameterTable[i] ;
+		if ( p.intValue != 0 ) this->*(p.intValue) = other.*(p.intValue) ;
+		else                   this->*(p.doubleValue) = other.*(p.doubleValue) ;
+	}
+}
+
+//
+//    Reads pairs of name and value, returns the number of parameters which
+//    could not be set
+//
+int TrackFindingParameters::read ( const char* inputFile ) 
 {
 
 	FILE* dataFile = fopen( inputFile, "r");
 	if (dataFile == NULL) {
-		printf ( "TrackFindingParameters::write: Error opening input file %s \n", inputFile ) ;
-		return ;
+		printf ( "TrackFindingParameters::read: Error opening input file %s \n", inputFile ) ;
+		return 1 ;
 	}
 
-	char* name = new char[100] ;
-	while ( 1 ) {
-		if ( fscanf ( dataFile, "%s", name ) == EOF ) break ;
-		if ( !strncmp(name,"infoLevel"       ,8) ) { 
-			fscanf ( dataFile, "%d", &infoLevel ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"segmentRowSearch",8) ) {
-			fscanf ( dataFile, "%d", &segmentRowSearchRange ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"trackRowSearch",  8) ) {
-			fscanf ( dataFile, "%d", &trackRowSearchRange ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"getErrors     ",  8) ) {
-			fscanf ( dataFile, "%d", &getErrors      ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"fillTracks    ",  8) ) {
-			fscanf ( dataFile, "%d", &fillTracks     ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"ghostFlag     ",  8) ) {
-			fscanf ( dataFile, "%d", &ghostFlag      ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"goBackwards   ",  8) ) {
-			fscanf ( dataFile, "%d", &goBackwards    ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"mergePrimaries",  8) ) {
-			fscanf ( dataFile, "%d", &mergePrimaries ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"minHitsPerTrack", 8) ) {
-			fscanf ( dataFile, "%d", &minHitsPerTrack ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"modRow",          6) ) {
-			fscanf ( dataFile, "%d", &modRow          ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"nHitsForSegment", 8) ) {
-			fscanf ( dataFile, "%d", &nHitsForSegment ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"minHitsForFit",   8) ) {
-			fscanf ( dataFile, "%d", &minHitsForFit   ) ;
-			continue ;
+	int  nErrors = 0 ;
+	char name[100] ;
+	double value ;
+	while ( fscanf ( dataFile, "%99s", name ) == 1 ) {
+		if ( fscanf ( dataFile, "%lf", &value ) != 1 ) {
+			printf ( "TrackFindingParameters::read: no value for %s in %s \n", name, inputFile ) ;
+			nErrors++ ;
+			break ;
 		}
-		if ( !strncmp(name,"nEtaTrack",   8) ) {
-			fscanf ( dataFile, "%i", &nEtaTrack     ) ;
-			continue;
-		}
-		if ( !strncmp(name,"nEta",   4) ) {
-			fscanf ( dataFile, "%d", &nEta          ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"nPhiTrack",   8) ) {
-			fscanf ( dataFile, "%d", &nPhiTrack     ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"nPhi",   4) ) {
-			fscanf ( dataFile, "%d", &nPhi          ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"detaMerge    ",   8) ) {
-			fscanf ( dataFile, "%e", &detaMerge     ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"deta         ",   4) ) {
-			fscanf ( dataFile, "%e", &deta          ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"dphiMerge    ",   8) ) {
-			fscanf ( dataFile, "%e", &dphiMerge     ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"dphi         ",   4) ) {
-			fscanf ( dataFile, "%e", &dphi          ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"etaMinTrack  ",   8) ) {
-			fscanf ( dataFile, "%e", &etaMinTrack   ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"etaMin",   6) ) {
-			fscanf ( dataFile, "%e", &etaMin        ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"etaMaxTrack  ",   8) ) {
-			fscanf ( dataFile, "%e", &etaMaxTrack   ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"etaMax       ",   6) ) {
-			fscanf ( dataFile, "%e", &etaMax        ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"phiMinTrack  ",   8) ) {
-			fscanf ( dataFile, "%e", &phiMinTrack   ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"phiMin       ",   6) ) {
-			fscanf ( dataFile, "%e", &phiMin        ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"phiMaxTrack  ",   8) ) {
-			fscanf ( dataFile, "%e", &phiMaxTrack   ) ;
-			continue ;
-		}
-		if ( !strncmp(name,"phiMax       ",   6) ) {
-			fscanf ( dataFile, "%e", &phiMax        ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"phiShift     ",   8) ) {
-			fscanf ( dataFile, "%e", &phiShift      ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"distanceMerge",   8) ) {
-			fscanf ( dataFile, "%e", &distanceMerge ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"nPrimaryPasses",  8) ) {
-			fscanf ( dataFile, "%d", &nPrimaryPasses ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"nSecondary",  8) ) {
-			fscanf ( dataFile, "%d", &nSecondaryPasses ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"vertexConstrainedFit",  8) ) {
-			fscanf ( dataFile, "%d", &vertexConstrainedFit ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"parameterLocation",  8) ) {
-			fscanf ( dataFile, "%d", &parameterLocation ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"rowInnerMost",  8) ) {
-			fscanf ( dataFile, "%d", &rowInnerMost ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"rowOuterMost",  8) ) {
-			fscanf ( dataFile, "%d", &rowOuterMost ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"rowStart",         8) ) {
-			fscanf ( dataFile, "%d", &rowStart ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"rowEnd",           6) ) {
-			fscanf ( dataFile, "%d", &rowEnd ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"szFitFlag",        8) ) {
-			fscanf ( dataFile, "%d", &szFitFlag ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"bField",       6) ) {
-			fscanf ( dataFile, "%e", &bField ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"maxChi2Primary",       12) ) {
-			fscanf ( dataFile, "%e", &maxChi2Primary ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"hitChi2Cut",           8) ) {
-			fscanf ( dataFile, "%e", &hitChi2Cut ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"goodHitChi2",           8) ) {
-			fscanf ( dataFile, "%e", &goodHitChi2 ) ;
-			continue ;
-		}  
-		if ( !strncmp(name,"trackChi2Cut",           8) ) {
-			fscanf ( dataFile, "%e", &trackChi2Cut ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"goodDistance",           8) ) {
-			fscanf ( dataFile, "%e", &goodDistance ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"ptMinHelixFit",           8) ) {
-			fscanf ( dataFile, "%e", &ptMinHelixFit ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"maxDistanceSegment",   15) ) {
-			fscanf ( dataFile, "%e", &maxDistanceSegment ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"xyErrorScale",   10) ) {
-			fscanf ( dataFile, "%e", &xyErrorScale ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"szErrorScale",   10) ) {
-			fscanf ( dataFile, "%e", &szErrorScale ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"xVertex",   7) ) {
-			fscanf ( dataFile, "%e", &xVertex ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"yVertex",   7) ) {
-			fscanf ( dataFile, "%e", &yVertex ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"zVertex",   7) ) {
-			fscanf ( dataFile, "%e", &zVertex ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"dxVertex",   8) ) {
-			fscanf ( dataFile, "%e", &dxVertex ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"dyVertex",   8) ) {
-			fscanf ( dataFile, "%e", &dyVertex ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"xyWeightVertex",   8) ) {
-			fscanf ( dataFile, "%e", &xyWeightVertex ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"phiVertex",   8) ) {
-			fscanf ( dataFile, "%e", &phiVertex ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"rVertex",   7) ) {
-			fscanf ( dataFile, "%e", &rVertex ) ;
-			continue ;
-		} 
-		if ( !strncmp(name,"maxTime",   7) ) {
-			fscanf ( dataFile, "%e", &maxTime ) ;
-			continue ;
-		} 
-		printf ( "TrackFindingParameters::read: parameter %s not found \n", name ) ;
-		float variable ; 
-		fscanf ( dataFile, "%e", &variable ) ;
-
+		if ( set ( name, value ) != 0 ) nErrors++ ;
 	}
 
 	fclose ( dataFile ) ;
 
+	return nErrors ;
 }
 
-void TrackFindingParameters::write ( char* outputFile ) 
+void TrackFindingParameters::write ( const char* outputFile ) 
 {
 	FILE* dataFile = fopen( outputFile, "w");
 	if (dataFile == NULL) {
@@ -274,64 +225,11 @@ void TrackFindingParameters::write ( char* outputFile )
 
 void TrackFindingParameters::write ( FILE* dataFile ) 
 {
-
-	fprintf ( dataFile, "infoLevel            %10d \n", infoLevel ) ;
-	fprintf ( dataFile, "segmentRowSearch     %10d  \n", segmentRowSearchRange ) ;
-	fprintf ( dataFile, "trackRowSearch       %10d  \n", trackRowSearchRange ) ;
-	fprintf ( dataFile, "getErrors            %10d  \n", getErrors ) ;
-	fprintf ( dataFile, "fillTracks           %10d  \n", fillTracks ) ;
-	fprintf ( dataFile, "ghostFlag            %10d  \n", ghostFlag ) ;
-	fprintf ( dataFile, "goBackwards          %10d  \n", goBackwards ) ;
-	fprintf ( dataFile, "mergePrimaries       %10d  \n", mergePrimaries ) ;
-	fprintf ( dataFile, "minHitsPerTrack      %10d  \n", minHitsPerTrack ) ;
-	fprintf ( dataFile, "modRow               %10d  \n", modRow ) ;
-	fprintf ( dataFile, "nHitsForSegment      %10d  \n", nHitsForSegment ) ;
-	fprintf ( dataFile, "minHitsForFit        %10d  \n", minHitsForFit   ) ;
-	fprintf ( dataFile, "nEta                 %10d  \n", nEta            ) ;
-	fprintf ( dataFile, "nPhi                 %10d  \n", nPhi            ) ;
-	fprintf ( dataFile, "deta                 %10.2e\n", deta         ) ;
-	fprintf ( dataFile, "dphi                 %10.2e\n", dphi         ) ;
-	fprintf ( dataFile, "etaMin               %10.2e\n", etaMin        ) ;
-	fprintf ( dataFile, "etaMax               %10.2e\n", etaMax        ) ;
-	fprintf ( dataFile, "phiMin               %10.2e\n", phiMin        ) ;
-	fprintf ( dataFile, "phiMax               %10.2e\n", phiMax        ) ;
-	fprintf ( dataFile, "phiShift             %10.2e\n", phiShift   ) ;
-	fprintf ( dataFile, "detaMerge            %10.2e\n", detaMerge    ) ;
-	fprintf ( dataFile, "distanceMerge        %10.2e\n", distanceMerge ) ;
-	fprintf ( dataFile, "nEtaTrack            %10d  \n", nEtaTrack       ) ;
-	fprintf ( dataFile, "nPhiTrack            %10d  \n", nPhiTrack       ) ;
-	fprintf ( dataFile, "etaMinTrack          %10.2e\n", etaMinTrack   ) ;
-	fprintf ( dataFile, "etaMaxTrack          %10.2e\n", etaMaxTrack   ) ;
-	fprintf ( dataFile, "phiMinTrack          %10.2e\n", phiMinTrack   ) ;
-	fprintf ( dataFile, "phiMaxTrack          %10.2e\n", phiMaxTrack   ) ;
-	fprintf ( dataFile, "nPrimaryPasses       %10d  \n", nPrimaryPasses  ) ;
-	fprintf ( dataFile, "nSecondaryPasses     %10d  \n", nSecondaryPasses  ) ;
-	fprintf ( dataFile, "vertexConstrainedFit %10d  \n", vertexConstrainedFit ) ;
-	fprintf ( dataFile, "parameterLocation    %10d  \n", parameterLocation ) ;
-	fprintf ( dataFile, "rowInnerMost         %10d  \n", rowInnerMost      ) ;
-	fprintf ( dataFile, "rowOuterMost         %10d  \n", rowOuterMost      ) ;
-	fprintf ( dataFile, "rowStart             %10d  \n", rowStart          ) ;
-	fprintf ( dataFile, "rowEnd               %10d  \n", rowEnd            ) ;
-	fprintf ( dataFile, "szFitFlag            %10d  \n", szFitFlag         ) ;
-	fprintf ( dataFile, "maxChi2Primary       %10.2e\n", maxChi2Primary    ) ;
-	fprintf ( dataFile, "bField               %10.2e\n", bField            ) ;
-	fprintf ( dataFile, "hitChi2Cut           %10.2e\n", hitChi2Cut ) ;
-	fprintf ( dataFile, "goodHitChi2          %10.2e\n", goodHitChi2 ) ;
-	fprintf ( dataFile, "trackChi2Cut         %10.2e\n", trackChi2Cut ) ;
-	fprintf ( dataFile, "goodDistance         %10.2e\n", goodDistance ) ;
-	fprintf ( dataFile, "ptMinHelixFit        %10.2e\n", ptMinHelixFit ) ;
-	fprintf ( dataFile, "maxDistanceSegment   %10.2e\n", maxDistanceSegment ) ;
-	fprintf ( dataFile, "xyErrorScale         %10.2e\n", xyErrorScale       ) ;
-	fprintf ( dataFile, "szErrorScale         %10.2e\n", szErrorScale       ) ;
-	fprintf ( dataFile, "xVertex              %10.2e\n", xVertex            ) ;
-	fprintf ( dataFile, "yVertex              %10.2e\n", yVertex            ) ;
-	fprintf ( dataFile, "dxVertex             %10.2e\n", dxVertex           ) ;
-	fprintf ( dataFile, "dyVertex             %10.2e\n", dyVertex           ) ;
-	fprintf ( dataFile, "zVertex              %10.2e\n", zVertex            ) ;
-	fprintf ( dataFile, "xyWeightVertex       %10.2e\n", xyWeightVertex     ) ;
-	fprintf ( dataFile, "phiVertex            %10.2e\n", phiVertex          ) ;
-	fprintf ( dataFile, "rVertex              %10.2e\n", rVertex            ) ;
-	fprintf ( dataFile, "maxTime              %10.2e\n", maxTime            ) ;
+	for ( int i = 0 ; i < nParameters ; i++ ) {
+		const Parameter& p = parameterTable[i] ;
+		if ( p.intValue != 0 ) fprintf ( dataFile, "%-20s %10d  \n", p.name, this->*(p.intValue) ) ;
+		else                   fprintf ( dataFile, "%-20s %24.16e\n", p.name, this->*(p.doubleValue) ) ;
+	}
 }
 
 void TrackFindingParameters::setDefaults (void)
@@ -386,6 +284,8 @@ void TrackFindingParameters::setDefaults (void)
 	rowEnd            =  0     ;
 	segmentMaxAngle   = 10.F/toDeg ;
 	szFitFlag         = 1      ;
+	floatHitSelection = 0      ;
+	nThreads          = 1      ;
 	xyErrorScale      = 1.0F   ;
 	szErrorScale      = 1.0F   ;
 	bField            = 0.5F   ;
@@ -408,62 +308,11 @@ void TrackFindingParameters::print()
 {
 	cout << "Track Finding Parameters: " << endl;
 
-	cout << "infoLevel        " << infoLevel<< endl;
-	cout << "segmentRowSearch  " << segmentRowSearchRange<< endl;
-	cout << "trackRowSearch    " << trackRowSearchRange << endl;
-	cout << "getErrors         " << getErrors << endl;
-	cout << "fillTracks        " << fillTracks << endl;
-	cout << "ghostFlag         " << ghostFlag << endl;
-	cout << "goBackwards       " << goBackwards << endl;
-	cout << "mergePrimaries    " << mergePrimaries << endl;
-	cout << "minHitsPerTrack   " << minHitsPerTrack << endl;
-	cout << "modRow            " << modRow << endl;
-	cout << "nHitsForSegment   " << nHitsForSegment << endl;
-    cout << "minHitsForFit     " << minHitsForFit   << endl;
-	cout << "nEta              " << nEta            << endl;
-	cout << "nPhi              " << nPhi            << endl;
-	cout << "deta              " <<  deta         << endl;
-	cout << "dphi              " <<  dphi         << endl;
-	cout << "etaMin            " <<  etaMin        << endl;
-	cout << "etaMax            " <<  etaMax        << endl;
-	cout << "phiMin            " <<  phiMin        << endl;
-	cout << "phiMax            " <<  phiMax        << endl;
-	cout << "phiShift          " <<  phiShift   << endl;
-	cout << "detaMerge         " <<  detaMerge    << endl;
-	cout << "distanceMerge     " <<  distanceMerge << endl;
-	cout << "nEtaTrack         " << nEtaTrack       << endl;
-	cout << "nPhiTrack         " << nPhiTrack       << endl;
-	cout << "etaMinTrack       " <<  etaMinTrack   << endl;
-	cout << "etaMaxTrack       " <<  etaMaxTrack   << endl;
-	cout << "phiMinTrack       " <<  phiMinTrack   << endl;
-	cout << "phiMaxTrack       " <<  phiMaxTrack   << endl;
-	cout << "nPrimaryPasses    " << nPrimaryPasses  << endl;
-	cout << "nSecondaryPasses  " << nSecondaryPasses  << endl;
-	cout << "vertexConstrainedFit "<< vertexConstrainedFit << endl;
-	cout << "parameterLocation " << parameterLocation << endl;
-	cout << "rowInnerMost      " << rowInnerMost      << endl;
-	cout << "rowOuterMost      " << rowOuterMost      << endl;
-	cout << "rowStart          " << rowStart          << endl;
-	cout << "rowEnd            " << rowEnd            << endl;
-	cout << "szFitFlag         " << szFitFlag         << endl;
-	cout << "maxChi2Primary    " <<  maxChi2Primary    << endl;
-	cout << "bField            " <<  bField            << endl;
-	cout << "hitChi2Cut        " <<  hitChi2Cut << endl;
-	cout << "goodHitChi2       " <<  goodHitChi2 << endl;
-	cout << "trackChi2Cut      " <<  trackChi2Cut << endl;
-	cout << "goodDistance      " <<  goodDistance << endl;
-	cout << "ptMinHelixFit     " <<  ptMinHelixFit << endl;
-	cout << "maxDistanceSegment" <<  maxDistanceSegment << endl;
-	cout << "xyErrorScale      " <<  xyErrorScale       << endl;
-	cout << "szErrorScale      " <<  szErrorScale       << endl;
-	cout << "xVertex           " <<  xVertex            << endl;
-	cout << "yVertex           " <<  yVertex            << endl;
-	cout << "dxVertex          " <<  dxVertex           << endl;
-	cout << "dyVertex          " <<  dyVertex           << endl;
-	cout << "zVertex           " <<  zVertex            << endl;
-	cout << "xyWeightVertex    " <<  xyWeightVertex     << endl;
-	cout << "phiVertex         " <<  phiVertex          << endl;
-	cout << "rVertex           " <<  rVertex            << endl;
-	cout << "maxTime           " <<  maxTime            << endl;
+	for ( int i = 0 ; i < nParameters ; i++ ) {
+		const Parameter& p = parameterTable[i] ;
+		cout << p.name << std::string( std::max( 1, 19 - (int)strlen(p.name) ), ' ' ) ;
+		if ( p.intValue != 0 ) cout << this->*(p.intValue)    << endl;
+		else                   cout << this->*(p.doubleValue) << endl;
+	}
 
 }